@@ -97,6 +97,8 @@ constexpr auto MESSAGE_HEADER_SRCADDR_BIT_SHIFT = 3;
 constexpr auto MESSAGE_HEADER_CNT_BIT_SHIFT = 2;
 
 constexpr auto ERROR_FLAG_BIT_SHIFT = 7;
+// responses echo the command of the request with this bit set (REQUEST_DATA_BYTE -> RESPONSE_REQUEST)
+constexpr auto RESPONSE_FLAG_BIT_SHIFT = 6;
 
 // FIXME (aw): unknown ValueTypes
 // CURRENT_ALARM_STATUS = 0x0040 (is this get or set?)
@@ -115,12 +117,22 @@ void request_data(struct can_frame&, def::ReadValueType);
 void set_data(struct can_frame&, def::SetValueType, const std::vector<uint8_t>& payload);
 
 uint8_t parse_source(const struct can_frame&);
+uint8_t parse_destination(const struct can_frame&);
 uint16_t parse_msg_type(const struct can_frame&);
 
 inline bool is_error_flag_set(const struct can_frame& frame) {
     return (frame.data[0] >> def::ERROR_FLAG_BIT_SHIFT);
 }
 
+inline bool is_response(const struct can_frame& frame) {
+    return (frame.data[0] >> def::RESPONSE_FLAG_BIT_SHIFT) & 0b1;
+}
+
+// command byte of a request or of the request a response belongs to, without the response and error flags
+inline uint8_t parse_command(const struct can_frame& frame) {
+    return frame.data[0] & ((1 << def::RESPONSE_FLAG_BIT_SHIFT) - 1);
+}
+
 } // namespace can::protocol::dpm1000
 
 #endif // CAN_PROTOCOL_DPM1000_HPP
@@ -71,6 +71,10 @@ uint8_t parse_source(const struct can_frame& frame) {
     return ((frame.can_id >> def::MESSAGE_HEADER_SRCADDR_BIT_SHIFT) & 0xFF);
 }
 
+uint8_t parse_destination(const struct can_frame& frame) {
+    return ((frame.can_id >> def::MESSAGE_HEADER_DSTADDR_BIT_SHIFT) & 0xFF);
+}
+
 uint16_t parse_msg_type(const struct can_frame& frame) {
     uint16_t retval;
     memcpy(&retval, &frame.data[2], sizeof(retval));
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef MCU_LINK_COBS_HPP
+#define MCU_LINK_COBS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mcu_link {
+
+///
+/// \brief maximum size of a COBS encoded frame of len bytes, including the 0x00 delimiter
+///
+constexpr std::size_t cobs_max_encoded_size(std::size_t len) {
+    return len + len / 254 + 2;
+}
+
+///
+/// \brief COBS encodes data and appends the 0x00 frame delimiter
+/// \param out buffer with space for at least cobs_max_encoded_size(len) bytes, must not overlap with data
+/// \return number of bytes written to out
+///
+std::size_t cobs_encode(const std::uint8_t* data, std::size_t len, std::uint8_t* out);
+
+///
+/// \brief decodes a COBS frame (without the 0x00 delimiter) in place. The decoded data is never longer than the
+/// encoded frame, so it is written to the beginning of frame.
+/// \param decoded_len set to the length of the decoded data
+/// \return false if the frame is malformed
+///
+bool cobs_decode_in_place(std::uint8_t* frame, std::size_t len, std::size_t& decoded_len);
+
+} // namespace mcu_link
+
+#endif // MCU_LINK_COBS_HPP
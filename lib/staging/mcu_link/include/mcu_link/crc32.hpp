@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef MCU_LINK_CRC32_HPP
+#define MCU_LINK_CRC32_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mcu_link {
+
+constexpr std::uint32_t crc32_init = 0xffffffff;
+
+///
+/// \brief CRC-32 (reflected polynomial 0xedb88320) without final inversion, as used by the MCU firmwares
+/// (CRC-32/JAMCRC). Appending the little endian CRC of a buffer to the buffer results in a CRC of 0 over both.
+/// \param data bytes to process
+/// \param len number of bytes
+/// \param crc start value, pass the result of a previous call to continue a calculation
+///
+std::uint32_t crc32(const std::uint8_t* data, std::size_t len, std::uint32_t crc = crc32_init);
+
+///
+/// \brief returns the name of the CRC32 implementation compiled in ("armv8-crc" or "slice-by-8")
+///
+const char* crc32_implementation();
+
+} // namespace mcu_link
+
+#endif // MCU_LINK_CRC32_HPP
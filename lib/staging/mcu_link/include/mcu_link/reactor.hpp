@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef MCU_LINK_REACTOR_HPP
+#define MCU_LINK_REACTOR_HPP
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include <mcu_link/serial_link.hpp>
+
+namespace mcu_link {
+
+/*
+ Single epoll based thread that reads from any number of SerialLinks and runs periodic timers (e.g. keep alive and
+ connection timeout detection), so a board does not need its own read and timeout threads.
+ Frame handlers, error handlers and timer callbacks are called from the reactor thread. They may add or remove links
+ and timers. remove() and remove_timer() called from another thread wait until a running callback has returned, so
+ the callback's objects can be destroyed afterwards.
+*/
+class Reactor {
+public:
+    using TimerCallback = std::function<void()>;
+
+    Reactor();
+    ~Reactor();
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    ///
+    /// \brief process wide reactor shared by all boards
+    ///
+    static Reactor& get_default();
+
+    ///
+    /// \brief starts reading from an opened link
+    /// \return false if the link is not open or cannot be watched
+    ///
+    bool add(SerialLink& link);
+    void remove(SerialLink& link);
+
+    ///
+    /// \brief calls callback every interval, the first time one interval from now
+    /// \return id to remove the timer
+    ///
+    int add_timer(std::chrono::milliseconds interval, TimerCallback callback);
+    void remove_timer(int id);
+
+private:
+    struct Timer {
+        std::chrono::milliseconds interval;
+        std::chrono::steady_clock::time_point next;
+        TimerCallback callback;
+    };
+
+    void loop();
+    int next_timeout_ms();
+    void run_timers();
+    std::unique_lock<std::mutex> lock_dispatch();
+
+    int epoll_fd{-1};
+    int event_fd{-1};
+
+    // guards links and timers
+    std::mutex mutex;
+    std::map<int, SerialLink*> links;
+    std::map<int, Timer> timers;
+    int next_timer_id{0};
+
+    // held by the reactor thread while calling handlers
+    std::mutex dispatch_mutex;
+    std::atomic_bool stop{false};
+    std::thread thread;
+};
+
+} // namespace mcu_link
+
+#endif // MCU_LINK_REACTOR_HPP
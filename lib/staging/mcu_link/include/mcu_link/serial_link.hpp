@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef MCU_LINK_SERIAL_LINK_HPP
+#define MCU_LINK_SERIAL_LINK_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include <everest/3rd_party/nanopb/pb.h>
+
+#include <mcu_link/cobs.hpp>
+
+namespace mcu_link {
+
+/*
+ Serial link to a MCU using COBS framed packets with a CRC32 trailer (see crc32.hpp) around nanopb messages.
+ Received bytes are read directly into the receive buffer, frames are COBS decoded in place and the payload is handed
+ to the frame handler without any further copy, so it can be passed to pb_istream_from_buffer directly.
+ Reading is driven by a Reactor (or by calling read_available()/receive() directly), writing can be done from any
+ thread.
+*/
+class SerialLink {
+public:
+    static constexpr std::size_t max_payload_size = 2048;
+
+    enum class Error {
+        Crc,      // CRC of a frame did not match
+        Framing,  // malformed COBS frame or frame too short for the CRC
+        Overflow, // frame exceeded the receive buffer, the data up to the next delimiter is dropped
+        Io,       // reading from the device failed or it hung up, the link is removed from the reactor
+    };
+
+    ///
+    /// \brief called for every received frame with a valid CRC. payload does not include the CRC and is only valid
+    /// during the call.
+    ///
+    using FrameHandler = std::function<void(const std::uint8_t* payload, std::size_t len)>;
+    using ErrorHandler = std::function<void(Error error)>;
+
+    struct Statistics {
+        std::uint64_t frames{0};
+        std::uint64_t crc_errors{0};
+        std::uint64_t framing_errors{0};
+        std::uint64_t overflows{0};
+    };
+
+    SerialLink() = default;
+    ~SerialLink();
+
+    SerialLink(const SerialLink&) = delete;
+    SerialLink& operator=(const SerialLink&) = delete;
+
+    ///
+    /// \brief opens a serial device in raw 8N1 mode
+    /// \param baud one of 9600, 19200, 38400, 57600, 115200, 230400
+    /// \return false if the device could not be opened or the baud rate is not supported
+    ///
+    bool open(const std::string& device, int baud);
+
+    ///
+    /// \brief uses an already opened file descriptor (e.g. a pty), the link takes ownership
+    ///
+    void open_fd(int fd);
+
+    void close();
+
+    bool is_open() const {
+        return fd >= 0;
+    }
+
+    int get_fd() const {
+        return fd;
+    }
+
+    // handlers have to be set before the link is added to a reactor
+    void set_frame_handler(FrameHandler handler) {
+        frame_handler = std::move(handler);
+    }
+
+    void set_error_handler(ErrorHandler handler) {
+        error_handler = std::move(handler);
+    }
+
+    ///
+    /// \brief encodes a nanopb message, appends the CRC and writes the COBS frame
+    /// \return false if the message could not be encoded or written
+    ///
+    bool write(const pb_msgdesc_t* fields, const void* message);
+
+    ///
+    /// \brief appends the CRC to payload and writes the COBS frame
+    ///
+    bool write_payload(const std::uint8_t* payload, std::size_t len);
+
+    ///
+    /// \brief reads the available bytes from the device and handles all complete frames. Must only be called when the
+    /// device is readable, reading nothing is reported as hang-up.
+    /// \return false if reading failed or the device hung up
+    ///
+    bool read_available();
+
+    ///
+    /// \brief handles received bytes as if they had been read from the device
+    ///
+    void receive(const std::uint8_t* data, std::size_t len);
+
+    Statistics get_statistics() const;
+
+private:
+    // receive buffer, large enough for one encoded frame of max_payload_size and its CRC
+    static constexpr std::size_t rx_buffer_size = cobs_max_encoded_size(max_payload_size + 4);
+
+    void handle_received(std::size_t len);
+    void handle_frame(std::uint8_t* frame, std::size_t len);
+    void report(Error error);
+    bool write_frame(std::size_t payload_len);
+
+    int fd{-1};
+
+    FrameHandler frame_handler;
+    ErrorHandler error_handler;
+
+    std::array<std::uint8_t, rx_buffer_size> rx_buffer;
+    std::size_t rx_fill{0};
+    bool rx_discard{false};
+
+    std::mutex tx_mutex;
+    std::array<std::uint8_t, max_payload_size + 4> tx_payload;
+    std::array<std::uint8_t, cobs_max_encoded_size(max_payload_size + 4)> tx_frame;
+
+    std::atomic<std::uint64_t> frames{0};
+    std::atomic<std::uint64_t> crc_errors{0};
+    std::atomic<std::uint64_t> framing_errors{0};
+    std::atomic<std::uint64_t> overflows{0};
+};
+
+} // namespace mcu_link
+
+#endif // MCU_LINK_SERIAL_LINK_HPP
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include <mcu_link/cobs.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace mcu_link {
+
+// Both encoder and decoder work on whole blocks (runs of up to 254 non zero bytes) with memchr/memcpy instead of
+// looking at every byte individually.
+
+std::size_t cobs_encode(const std::uint8_t* data, std::size_t len, std::uint8_t* out) {
+    const std::uint8_t* end = data + len;
+    std::size_t o = 0;
+
+    while (true) {
+        const std::size_t max = std::min<std::size_t>(end - data, 254);
+        const auto zero = static_cast<const std::uint8_t*>(std::memchr(data, 0, max));
+        const std::size_t n = (zero != nullptr) ? zero - data : max;
+
+        out[o++] = static_cast<std::uint8_t>(n + 1);
+        std::memcpy(out + o, data, n);
+        o += n;
+        data += n;
+
+        if (zero != nullptr) {
+            // the zero is represented by the code byte
+            data++;
+        } else if (data == end) {
+            break;
+        }
+        // else: full block of 254 bytes without an implicit zero
+    }
+
+    out[o++] = 0x00;
+    return o;
+}
+
+bool cobs_decode_in_place(std::uint8_t* frame, std::size_t len, std::size_t& decoded_len) {
+    std::size_t i = 0;
+    std::size_t o = 0;
+
+    while (i < len) {
+        const std::uint8_t code = frame[i];
+        if (code == 0x00) {
+            return false;
+        }
+        const std::size_t n = code - 1;
+        if (i + 1 + n > len) {
+            // truncated block
+            return false;
+        }
+        // o <= i always holds, so the block can be moved to the front
+        std::memmove(frame + o, frame + i + 1, n);
+        i += code;
+        o += n;
+        if (code != 0xff and i < len) {
+            frame[o++] = 0x00;
+        }
+    }
+
+    decoded_len = o;
+    return true;
+}
+
+} // namespace mcu_link
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include <mcu_link/crc32.hpp>
+
+#include <array>
+#include <cstring>
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace mcu_link {
+
+#if defined(__ARM_FEATURE_CRC32)
+
+// The ARMv8 CRC32 instructions use the same (reflected) polynomial. Note that the SSE4.2 crc32 instruction
+// implements CRC-32C (Castagnoli) and can therefore not be used for this protocol.
+std::uint32_t crc32(const std::uint8_t* data, std::size_t len, std::uint32_t crc) {
+    while (len > 0 and (reinterpret_cast<std::uintptr_t>(data) & 7) != 0) {
+        crc = __crc32b(crc, *data++);
+        len--;
+    }
+    while (len >= 8) {
+        std::uint64_t v;
+        std::memcpy(&v, data, sizeof(v));
+        crc = __crc32d(crc, v);
+        data += 8;
+        len -= 8;
+    }
+    while (len > 0) {
+        crc = __crc32b(crc, *data++);
+        len--;
+    }
+    return crc;
+}
+
+const char* crc32_implementation() {
+    return "armv8-crc";
+}
+
+#else
+
+namespace {
+
+constexpr std::uint32_t polynomial = 0xedb88320;
+
+using Tables = std::array<std::array<std::uint32_t, 256>, 8>;
+
+constexpr Tables make_tables() {
+    Tables t{};
+    for (std::uint32_t i = 0; i < 256; i++) {
+        std::uint32_t c = i;
+        for (int bit = 0; bit < 8; bit++) {
+            c = (c >> 1) ^ (polynomial & (0u - (c & 1)));
+        }
+        t[0][i] = c;
+    }
+    for (std::size_t i = 0; i < 256; i++) {
+        for (std::size_t k = 1; k < 8; k++) {
+            t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+        }
+    }
+    return t;
+}
+
+constexpr Tables tables = make_tables();
+
+} // namespace
+
+// slice-by-8: processes 8 bytes per iteration with 8 table lookups
+std::uint32_t crc32(const std::uint8_t* data, std::size_t len, std::uint32_t crc) {
+    while (len >= 8) {
+        const std::uint32_t lo =
+            crc ^ (data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<std::uint32_t>(data[3]) << 24));
+        crc = tables[7][lo & 0xff] ^ tables[6][(lo >> 8) & 0xff] ^ tables[5][(lo >> 16) & 0xff] ^
+              tables[4][lo >> 24] ^ tables[3][data[4]] ^ tables[2][data[5]] ^ tables[1][data[6]] ^
+              tables[0][data[7]];
+        data += 8;
+        len -= 8;
+    }
+    while (len > 0) {
+        crc = (crc >> 8) ^ tables[0][(crc ^ *data++) & 0xff];
+        len--;
+    }
+    return crc;
+}
+
+const char* crc32_implementation() {
+    return "slice-by-8";
+}
+
+#endif
+
+} // namespace mcu_link
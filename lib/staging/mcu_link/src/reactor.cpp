@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include <mcu_link/reactor.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace mcu_link {
+
+Reactor::Reactor() {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "epoll_create1 failed");
+    }
+
+    event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (event_fd < 0) {
+        const auto error = errno;
+        ::close(epoll_fd);
+        throw std::system_error(error, std::generic_category(), "eventfd failed");
+    }
+
+    struct epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.fd = event_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, event_fd, &ev);
+
+    thread = std::thread(&Reactor::loop, this);
+}
+
+Reactor::~Reactor() {
+    stop = true;
+    const std::uint64_t wake = 1;
+    (void)::write(event_fd, &wake, sizeof(wake));
+    if (thread.joinable()) {
+        thread.join();
+    }
+    ::close(event_fd);
+    ::close(epoll_fd);
+}
+
+Reactor& Reactor::get_default() {
+    static Reactor reactor;
+    return reactor;
+}
+
+std::unique_lock<std::mutex> Reactor::lock_dispatch() {
+    // callbacks may modify the reactor from within the reactor thread, which already holds the dispatch mutex
+    if (std::this_thread::get_id() == thread.get_id()) {
+        return std::unique_lock<std::mutex>();
+    }
+    return std::unique_lock<std::mutex>(dispatch_mutex);
+}
+
+bool Reactor::add(SerialLink& link) {
+    if (not link.is_open()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    struct epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.fd = link.get_fd();
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, link.get_fd(), &ev) != 0) {
+        return false;
+    }
+    links[link.get_fd()] = &link;
+    return true;
+}
+
+void Reactor::remove(SerialLink& link) {
+    const auto dispatch_lock = lock_dispatch();
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = links.begin(); it != links.end(); ++it) {
+        if (it->second == &link) {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, it->first, nullptr);
+            links.erase(it);
+            break;
+        }
+    }
+}
+
+int Reactor::add_timer(std::chrono::milliseconds interval, TimerCallback callback) {
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = next_timer_id++;
+        timers[id] = Timer{interval, std::chrono::steady_clock::now() + interval, std::move(callback)};
+    }
+    // wake up the reactor to recalculate its timeout
+    const std::uint64_t wake = 1;
+    (void)::write(event_fd, &wake, sizeof(wake));
+    return id;
+}
+
+void Reactor::remove_timer(int id) {
+    const auto dispatch_lock = lock_dispatch();
+    std::lock_guard<std::mutex> lock(mutex);
+    timers.erase(id);
+}
+
+int Reactor::next_timeout_ms() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (timers.empty()) {
+        return -1;
+    }
+
+    auto next = timers.begin()->second.next;
+    for (const auto& timer : timers) {
+        next = std::min(next, timer.second.next);
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (next <= now) {
+        return 0;
+    }
+    // round up, otherwise the timer would be polled several times shortly before it is due
+    return std::chrono::ceil<std::chrono::milliseconds>(next - now).count();
+}
+
+void Reactor::run_timers() {
+    const auto now = std::chrono::steady_clock::now();
+
+    std::vector<int> due;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& timer : timers) {
+            if (timer.second.next <= now) {
+                due.push_back(timer.first);
+                timer.second.next += timer.second.interval;
+                if (timer.second.next <= now) {
+                    // we are late, do not try to catch up
+                    timer.second.next = now + timer.second.interval;
+                }
+            }
+        }
+    }
+
+    for (const auto id : due) {
+        TimerCallback callback;
+        {
+            // an earlier callback may have removed this timer
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto it = timers.find(id);
+            if (it == timers.end()) {
+                continue;
+            }
+            callback = it->second.callback;
+        }
+        callback();
+    }
+}
+
+void Reactor::loop() {
+    constexpr int max_events = 16;
+    struct epoll_event events[max_events];
+
+    while (true) {
+        const int n = epoll_wait(epoll_fd, events, max_events, next_timeout_ms());
+        if ((n < 0 and errno != EINTR) or stop) {
+            break;
+        }
+
+        std::lock_guard<std::mutex> dispatch_lock(dispatch_mutex);
+        for (int i = 0; i < n; i++) {
+            const int fd = events[i].data.fd;
+            if (fd == event_fd) {
+                std::uint64_t value;
+                (void)::read(event_fd, &value, sizeof(value));
+                continue;
+            }
+
+            SerialLink* link = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                const auto it = links.find(fd);
+                if (it != links.end()) {
+                    link = it->second;
+                }
+            }
+
+            // EPOLLHUP and EPOLLERR are reported without EPOLLIN as well, the read then fails or returns nothing
+            if (link != nullptr and not link->read_available()) {
+                // do not spin on a broken device
+                std::lock_guard<std::mutex> lock(mutex);
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+                links.erase(fd);
+            }
+        }
+
+        run_timers();
+    }
+}
+
+} // namespace mcu_link
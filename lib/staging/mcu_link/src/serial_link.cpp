@@ -0,0 +1,271 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include <mcu_link/serial_link.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <everest/3rd_party/nanopb/pb_encode.h>
+
+#include <mcu_link/crc32.hpp>
+
+namespace mcu_link {
+
+namespace {
+
+bool baud_to_speed(int baud, speed_t& speed) {
+    switch (baud) {
+    case 9600:
+        speed = B9600;
+        return true;
+    case 19200:
+        speed = B19200;
+        return true;
+    case 38400:
+        speed = B38400;
+        return true;
+    case 57600:
+        speed = B57600;
+        return true;
+    case 115200:
+        speed = B115200;
+        return true;
+    case 230400:
+        speed = B230400;
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool set_serial_attributes(int fd, speed_t speed) {
+    struct termios tty;
+    if (tcgetattr(fd, &tty) != 0) {
+        return false;
+    }
+
+    cfsetospeed(&tty, speed);
+    cfsetispeed(&tty, speed);
+
+    tty.c_cflag = (tty.c_cflag & ~CSIZE) | CS8; // 8-bit chars
+    // disable IGNBRK for mismatched speed tests; otherwise receive break as \000 chars
+    tty.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON | IXOFF | IXANY);
+    tty.c_lflag = 0; // no signaling chars, no echo, no canonical processing
+    tty.c_oflag = 0; // no remapping, no delays
+    // reading is driven by epoll, so read() returns whatever is available and never waits
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 0;
+
+    tty.c_cflag |= (CLOCAL | CREAD);   // ignore modem controls, enable reading
+    tty.c_cflag &= ~(PARENB | PARODD); // shut off parity
+    tty.c_cflag &= ~CSTOPB;
+    tty.c_cflag &= ~CRTSCTS;
+
+    return tcsetattr(fd, TCSANOW, &tty) == 0;
+}
+
+} // namespace
+
+SerialLink::~SerialLink() {
+    close();
+}
+
+bool SerialLink::open(const std::string& device, int baud) {
+    speed_t speed;
+    if (not baud_to_speed(baud, speed)) {
+        return false;
+    }
+
+    close();
+    const int new_fd = ::open(device.c_str(), O_RDWR | O_NOCTTY | O_SYNC | O_CLOEXEC);
+    if (new_fd < 0) {
+        return false;
+    }
+
+    if (not set_serial_attributes(new_fd, speed)) {
+        const auto saved_errno = errno;
+        ::close(new_fd);
+        errno = saved_errno;
+        return false;
+    }
+
+    open_fd(new_fd);
+    return true;
+}
+
+void SerialLink::open_fd(int new_fd) {
+    close();
+    fd = new_fd;
+    rx_fill = 0;
+    rx_discard = false;
+}
+
+void SerialLink::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool SerialLink::write(const pb_msgdesc_t* fields, const void* message) {
+    std::lock_guard<std::mutex> lock(tx_mutex);
+    pb_ostream_t ostream = pb_ostream_from_buffer(tx_payload.data(), max_payload_size);
+    if (not pb_encode(&ostream, fields, message)) {
+        return false;
+    }
+    return write_frame(ostream.bytes_written);
+}
+
+bool SerialLink::write_payload(const std::uint8_t* payload, std::size_t len) {
+    if (len > max_payload_size) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(tx_mutex);
+    std::memcpy(tx_payload.data(), payload, len);
+    return write_frame(len);
+}
+
+bool SerialLink::write_frame(std::size_t payload_len) {
+    if (fd < 0) {
+        return false;
+    }
+
+    std::uint32_t crc = crc32(tx_payload.data(), payload_len);
+    for (int i = 0; i < 4; i++) {
+        tx_payload[payload_len++] = crc & 0xff;
+        crc >>= 8;
+    }
+
+    const std::size_t frame_len = cobs_encode(tx_payload.data(), payload_len, tx_frame.data());
+    std::size_t written = 0;
+    while (written < frame_len) {
+        const auto n = ::write(fd, tx_frame.data() + written, frame_len - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+bool SerialLink::read_available() {
+    if (fd < 0) {
+        return false;
+    }
+
+    const auto n = ::read(fd, rx_buffer.data() + rx_fill, rx_buffer.size() - rx_fill);
+    if (n < 0) {
+        if (errno == EINTR or errno == EAGAIN) {
+            return true;
+        }
+        report(Error::Io);
+        return false;
+    }
+    if (n == 0) {
+        // the device hung up (e.g. an unplugged USB adapter), it stays readable and would be polled forever
+        report(Error::Io);
+        return false;
+    }
+
+    handle_received(n);
+    return true;
+}
+
+void SerialLink::receive(const std::uint8_t* data, std::size_t len) {
+    while (len > 0) {
+        const std::size_t n = std::min(len, rx_buffer.size() - rx_fill);
+        std::memcpy(rx_buffer.data() + rx_fill, data, n);
+        handle_received(n);
+        data += n;
+        len -= n;
+    }
+}
+
+void SerialLink::handle_received(std::size_t len) {
+    // the bytes before rx_fill have already been searched for a delimiter
+    std::uint8_t* begin = rx_buffer.data();
+    std::uint8_t* scan = begin + rx_fill;
+    std::uint8_t* const end = scan + len;
+
+    while (auto delimiter = static_cast<std::uint8_t*>(std::memchr(scan, 0x00, end - scan))) {
+        if (rx_discard) {
+            // end of an oversized frame, we are in sync again
+            rx_discard = false;
+        } else {
+            handle_frame(begin, delimiter - begin);
+        }
+        begin = delimiter + 1;
+        scan = begin;
+    }
+
+    // keep the incomplete frame for the next read
+    rx_fill = end - begin;
+    if (rx_fill == rx_buffer.size()) {
+        report(Error::Overflow);
+        rx_fill = 0;
+        rx_discard = true;
+    } else if (begin != rx_buffer.data() and rx_fill > 0) {
+        std::memmove(rx_buffer.data(), begin, rx_fill);
+    }
+}
+
+void SerialLink::handle_frame(std::uint8_t* frame, std::size_t len) {
+    if (len == 0) {
+        // empty frames are used to resync, nothing to do
+        return;
+    }
+
+    std::size_t decoded_len = 0;
+    if (not cobs_decode_in_place(frame, len, decoded_len) or decoded_len < 4) {
+        report(Error::Framing);
+        return;
+    }
+
+    if (crc32(frame, decoded_len) != 0) {
+        report(Error::Crc);
+        return;
+    }
+
+    frames.fetch_add(1, std::memory_order_relaxed);
+    if (frame_handler) {
+        frame_handler(frame, decoded_len - 4);
+    }
+}
+
+void SerialLink::report(Error error) {
+    switch (error) {
+    case Error::Crc:
+        crc_errors.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case Error::Framing:
+        framing_errors.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case Error::Overflow:
+        overflows.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case Error::Io:
+        break;
+    }
+    if (error_handler) {
+        error_handler(error);
+    }
+}
+
+SerialLink::Statistics SerialLink::get_statistics() const {
+    Statistics s;
+    s.frames = frames.load(std::memory_order_relaxed);
+    s.crc_errors = crc_errors.load(std::memory_order_relaxed);
+    s.framing_errors = framing_errors.load(std::memory_order_relaxed);
+    s.overflows = overflows.load(std::memory_order_relaxed);
+    return s;
+}
+
+} // namespace mcu_link
@@ -0,0 +1,263 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+// Throughput and latency of the MCU link over a pty loopback. One side plays the MCU, the other side is read by the
+// Reactor like a board driver does. Also compares the frame decoding cost with the byte wise COBS decoder and the
+// bitwise CRC32 the board drivers used before.
+
+#include <mcu_link/cobs.hpp>
+#include <mcu_link/crc32.hpp>
+#include <mcu_link/reactor.hpp>
+#include <mcu_link/serial_link.hpp>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr int c_frames = 20000;
+constexpr int c_round_trips = 2000;
+
+// byte wise decoder and bitwise CRC as previously used by evSerial, kept here as reference
+class ReferenceDecoder {
+public:
+    int frames{0};
+
+    void decode(const std::uint8_t* buf, std::size_t len) {
+        for (std::size_t i = 0; i < len; i++) {
+            decode_byte(buf[i]);
+        }
+    }
+
+private:
+    static std::uint32_t crc32(const std::uint8_t* buf, std::size_t len) {
+        std::uint32_t crc = 0xffffffff;
+        for (std::size_t i = 0; i < len; i++) {
+            crc = crc ^ buf[i];
+            for (int j = 7; j >= 0; j--) {
+                const std::uint32_t msk = -(crc & 1);
+                crc = (crc >> 1) ^ (0xedb88320 & msk);
+            }
+        }
+        return crc;
+    }
+
+    void reset() {
+        code = 0xff;
+        block = 0;
+        decode_ptr = msg;
+    }
+
+    void decode_byte(std::uint8_t byte) {
+        if ((decode_ptr - msg == 2048 - 1) && byte != 0x00) {
+            reset();
+        }
+        if (block) {
+            if (byte == 0x00) {
+                reset();
+                return;
+            }
+            *decode_ptr++ = byte;
+        } else {
+            if (code != 0xff) {
+                *decode_ptr++ = 0;
+            }
+            block = code = byte;
+            if (code == 0x00) {
+                if (decode_ptr != msg and crc32(msg, decode_ptr - 1 - msg) == 0) {
+                    frames++;
+                }
+                reset();
+                return;
+            }
+        }
+        block--;
+    }
+
+    std::uint8_t msg[2048];
+    std::uint8_t code{0xff};
+    std::uint8_t block{0};
+    std::uint8_t* decode_ptr{msg};
+};
+
+std::vector<std::uint8_t> make_payload(std::size_t len) {
+    std::mt19937 rng(len);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<std::uint8_t> payload(len);
+    for (auto& b : payload) {
+        b = byte(rng);
+    }
+    return payload;
+}
+
+std::vector<std::uint8_t> make_stream(const std::vector<std::uint8_t>& payload, int count) {
+    std::vector<std::uint8_t> data(payload);
+    std::uint32_t crc = mcu_link::crc32(data.data(), data.size());
+    for (int i = 0; i < 4; i++) {
+        data.push_back(crc & 0xff);
+        crc >>= 8;
+    }
+    std::vector<std::uint8_t> frame(mcu_link::cobs_max_encoded_size(data.size()));
+    frame.resize(mcu_link::cobs_encode(data.data(), data.size(), frame.data()));
+
+    std::vector<std::uint8_t> stream;
+    for (int i = 0; i < count; i++) {
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+    return stream;
+}
+
+void decode_benchmark(std::size_t payload_len) {
+    const auto stream = make_stream(make_payload(payload_len), c_frames);
+
+    ReferenceDecoder reference;
+    auto t = clock_type::now();
+    for (std::size_t pos = 0; pos < stream.size(); pos += 2048) {
+        reference.decode(stream.data() + pos, std::min<std::size_t>(2048, stream.size() - pos));
+    }
+    const std::chrono::duration<double> reference_time = clock_type::now() - t;
+
+    mcu_link::SerialLink link;
+    t = clock_type::now();
+    for (std::size_t pos = 0; pos < stream.size(); pos += 2048) {
+        link.receive(stream.data() + pos, std::min<std::size_t>(2048, stream.size() - pos));
+    }
+    const std::chrono::duration<double> link_time = clock_type::now() - t;
+
+    if (reference.frames != c_frames or link.get_statistics().frames != c_frames) {
+        fmt::print("decode error: {} {}\n", reference.frames, link.get_statistics().frames);
+    }
+
+    const double mb = stream.size() / 1e6;
+    fmt::print("decode {:>5} byte frames: byte wise {:>8.1f} MB/s, mcu_link ({}) {:>8.1f} MB/s\n", payload_len,
+               mb / reference_time.count(), mcu_link::crc32_implementation(), mb / link_time.count());
+}
+
+struct Pty {
+    int master{-1};
+    int slave{-1};
+
+    Pty() {
+        master = posix_openpt(O_RDWR | O_NOCTTY);
+        grantpt(master);
+        unlockpt(master);
+        slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+        struct termios tty;
+        tcgetattr(slave, &tty);
+        cfmakeraw(&tty);
+        tcsetattr(slave, TCSANOW, &tty);
+    }
+};
+
+void throughput_benchmark(std::size_t payload_len) {
+    Pty pty;
+    mcu_link::SerialLink mcu;
+    mcu_link::SerialLink host;
+    mcu.open_fd(pty.master);
+    host.open_fd(pty.slave);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    int received = 0;
+    host.set_frame_handler([&](const std::uint8_t*, std::size_t) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (++received == c_frames) {
+            cv.notify_all();
+        }
+    });
+
+    mcu_link::Reactor reactor;
+    reactor.add(host);
+
+    const auto payload = make_payload(payload_len);
+    const auto t = clock_type::now();
+    for (int i = 0; i < c_frames; i++) {
+        mcu.write_payload(payload.data(), payload.size());
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait_for(lock, std::chrono::seconds(30), [&]() { return received == c_frames; });
+    const std::chrono::duration<double> d = clock_type::now() - t;
+    lock.unlock();
+    reactor.remove(host);
+
+    const auto stats = host.get_statistics();
+    fmt::print("pty {:>5} byte frames: {:>9.0f} frames/s {:>8.1f} MB/s (received {}, crc errors {}, overflows {})\n",
+               payload_len, received / d.count(), received * payload_len / d.count() / 1e6, received,
+               stats.crc_errors, stats.overflows);
+}
+
+void latency_benchmark(std::size_t payload_len) {
+    Pty pty;
+    mcu_link::SerialLink mcu;
+    mcu_link::SerialLink host;
+    mcu.open_fd(pty.master);
+    host.open_fd(pty.slave);
+
+    // the MCU echoes every frame, the host measures the round trip
+    mcu.set_frame_handler([&mcu](const std::uint8_t* payload, std::size_t len) { mcu.write_payload(payload, len); });
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool answered = false;
+    host.set_frame_handler([&](const std::uint8_t*, std::size_t) {
+        std::lock_guard<std::mutex> lock(mutex);
+        answered = true;
+        cv.notify_all();
+    });
+
+    mcu_link::Reactor reactor;
+    reactor.add(mcu);
+    reactor.add(host);
+
+    const auto payload = make_payload(payload_len);
+    std::vector<double> samples;
+    samples.reserve(c_round_trips);
+    for (int i = 0; i < c_round_trips; i++) {
+        const auto t = clock_type::now();
+        host.write_payload(payload.data(), payload.size());
+        std::unique_lock<std::mutex> lock(mutex);
+        if (not cv.wait_for(lock, std::chrono::seconds(1), [&]() { return answered; })) {
+            fmt::print("timeout\n");
+            break;
+        }
+        answered = false;
+        samples.push_back(std::chrono::duration<double, std::micro>(clock_type::now() - t).count());
+    }
+    reactor.remove(host);
+    reactor.remove(mcu);
+
+    std::sort(samples.begin(), samples.end());
+    const auto percentile = [&samples](double p) { return samples.at(samples.size() * p / 100); };
+    fmt::print("pty {:>5} byte round trip: p50 {:>7.1f}us p99 {:>7.1f}us max {:>7.1f}us\n", payload_len,
+               percentile(50), percentile(99), samples.back());
+}
+
+} // namespace
+
+int main() {
+    for (std::size_t len : {16, 64, 256, 1024}) {
+        decode_benchmark(len);
+    }
+    for (std::size_t len : {16, 64, 256, 1024}) {
+        throughput_benchmark(len);
+    }
+    for (std::size_t len : {16, 256}) {
+        latency_benchmark(len);
+    }
+    return 0;
+}
@@ -0,0 +1,293 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include <gtest/gtest.h>
+
+#include <mcu_link/cobs.hpp>
+#include <mcu_link/crc32.hpp>
+#include <mcu_link/reactor.hpp>
+#include <mcu_link/serial_link.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+// bitwise implementation the drivers used before
+std::uint32_t reference_crc32(const std::uint8_t* buf, std::size_t len) {
+    std::uint32_t crc = 0xffffffff;
+    for (std::size_t i = 0; i < len; i++) {
+        crc = crc ^ buf[i];
+        for (int j = 7; j >= 0; j--) {
+            const std::uint32_t msk = -(crc & 1);
+            crc = (crc >> 1) ^ (0xedb88320 & msk);
+        }
+    }
+    return crc;
+}
+
+std::vector<std::uint8_t> random_bytes(std::mt19937& rng, std::size_t len, int zero_percentage) {
+    std::vector<std::uint8_t> data(len);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::uniform_int_distribution<int> byte(1, 255);
+    for (auto& b : data) {
+        b = (percent(rng) < zero_percentage) ? 0 : byte(rng);
+    }
+    return data;
+}
+
+// payload with CRC, COBS encoded, including the delimiter
+std::vector<std::uint8_t> make_frame(const std::vector<std::uint8_t>& payload) {
+    std::vector<std::uint8_t> data(payload);
+    std::uint32_t crc = mcu_link::crc32(data.data(), data.size());
+    for (int i = 0; i < 4; i++) {
+        data.push_back(crc & 0xff);
+        crc >>= 8;
+    }
+    std::vector<std::uint8_t> frame(mcu_link::cobs_max_encoded_size(data.size()));
+    frame.resize(mcu_link::cobs_encode(data.data(), data.size(), frame.data()));
+    return frame;
+}
+
+} // namespace
+
+TEST(Crc32Test, matches_bitwise_implementation) {
+    std::mt19937 rng(1);
+    for (std::size_t len : {0, 1, 3, 7, 8, 9, 15, 16, 17, 63, 64, 255, 1000, 2048}) {
+        const auto data = random_bytes(rng, len, 10);
+        EXPECT_EQ(mcu_link::crc32(data.data(), data.size()), reference_crc32(data.data(), data.size())) << len;
+    }
+}
+
+TEST(Crc32Test, unaligned_and_incremental) {
+    std::mt19937 rng(2);
+    const auto data = random_bytes(rng, 100, 10);
+    for (std::size_t offset = 0; offset < 8; offset++) {
+        const auto expected = reference_crc32(data.data() + offset, data.size() - offset);
+        EXPECT_EQ(mcu_link::crc32(data.data() + offset, data.size() - offset), expected);
+        const auto part = mcu_link::crc32(data.data() + offset, 13);
+        EXPECT_EQ(mcu_link::crc32(data.data() + offset + 13, data.size() - offset - 13, part), expected);
+    }
+}
+
+TEST(Crc32Test, appended_crc_gives_zero) {
+    std::vector<std::uint8_t> data{'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    std::uint32_t crc = mcu_link::crc32(data.data(), data.size());
+    // CRC-32/JAMCRC check value
+    EXPECT_EQ(crc, 0x340bc6d9u);
+    for (int i = 0; i < 4; i++) {
+        data.push_back(crc & 0xff);
+        crc >>= 8;
+    }
+    EXPECT_EQ(mcu_link::crc32(data.data(), data.size()), 0u);
+}
+
+TEST(CobsTest, known_vectors) {
+    const std::vector<std::pair<std::vector<std::uint8_t>, std::vector<std::uint8_t>>> vectors = {
+        {{}, {0x01, 0x00}},
+        {{0x00}, {0x01, 0x01, 0x00}},
+        {{0x00, 0x00}, {0x01, 0x01, 0x01, 0x00}},
+        {{0x11, 0x22, 0x00, 0x33}, {0x03, 0x11, 0x22, 0x02, 0x33, 0x00}},
+        {{0x11, 0x00, 0x00, 0x00}, {0x02, 0x11, 0x01, 0x01, 0x01, 0x00}},
+    };
+    for (const auto& v : vectors) {
+        std::vector<std::uint8_t> out(mcu_link::cobs_max_encoded_size(v.first.size()));
+        out.resize(mcu_link::cobs_encode(v.first.data(), v.first.size(), out.data()));
+        EXPECT_EQ(out, v.second);
+    }
+}
+
+TEST(CobsTest, round_trip) {
+    std::mt19937 rng(3);
+    for (std::size_t len : {0, 1, 253, 254, 255, 256, 508, 509, 1000, 2052}) {
+        for (int zeros : {0, 1, 50}) {
+            const auto data = random_bytes(rng, len, zeros);
+            std::vector<std::uint8_t> frame(mcu_link::cobs_max_encoded_size(len));
+            const auto encoded_len = mcu_link::cobs_encode(data.data(), data.size(), frame.data());
+            ASSERT_LE(encoded_len, frame.size());
+            ASSERT_EQ(frame[encoded_len - 1], 0x00);
+            for (std::size_t i = 0; i + 1 < encoded_len; i++) {
+                ASSERT_NE(frame[i], 0x00);
+            }
+
+            std::size_t decoded_len = 0;
+            ASSERT_TRUE(mcu_link::cobs_decode_in_place(frame.data(), encoded_len - 1, decoded_len));
+            ASSERT_EQ(decoded_len, len);
+            EXPECT_TRUE(std::equal(data.begin(), data.end(), frame.begin())) << len << " " << zeros;
+        }
+    }
+}
+
+TEST(CobsTest, malformed) {
+    std::size_t decoded_len = 0;
+    std::uint8_t truncated[] = {0x05, 0x11, 0x22};
+    EXPECT_FALSE(mcu_link::cobs_decode_in_place(truncated, sizeof(truncated), decoded_len));
+    std::uint8_t zero[] = {0x02, 0x11, 0x00};
+    EXPECT_FALSE(mcu_link::cobs_decode_in_place(zero, sizeof(zero), decoded_len));
+}
+
+TEST(SerialLinkTest, frames_split_across_reads) {
+    std::mt19937 rng(4);
+    std::vector<std::vector<std::uint8_t>> payloads;
+    std::vector<std::uint8_t> stream{0x00};
+    for (std::size_t len : {1, 10, 254, 300, 2048, 5}) {
+        payloads.push_back(random_bytes(rng, len, 20));
+        const auto frame = make_frame(payloads.back());
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+
+    for (std::size_t chunk : {1, 7, 64, 4096}) {
+        mcu_link::SerialLink link;
+        std::vector<std::vector<std::uint8_t>> received;
+        link.set_frame_handler([&received](const std::uint8_t* payload, std::size_t len) {
+            received.emplace_back(payload, payload + len);
+        });
+        for (std::size_t pos = 0; pos < stream.size(); pos += chunk) {
+            link.receive(stream.data() + pos, std::min(chunk, stream.size() - pos));
+        }
+        EXPECT_EQ(received, payloads) << chunk;
+        EXPECT_EQ(link.get_statistics().frames, payloads.size());
+    }
+}
+
+TEST(SerialLinkTest, errors_and_resync) {
+    mcu_link::SerialLink link;
+    std::vector<mcu_link::SerialLink::Error> errors;
+    int frames = 0;
+    link.set_frame_handler([&frames](const std::uint8_t*, std::size_t) { frames++; });
+    link.set_error_handler([&errors](mcu_link::SerialLink::Error error) { errors.push_back(error); });
+
+    auto frame = make_frame({0x01, 0x02, 0x03});
+    frame[2] ^= 0x40;
+    link.receive(frame.data(), frame.size());
+    const std::vector<std::uint8_t> garbage{0x05, 0x11, 0x00};
+    link.receive(garbage.data(), garbage.size());
+    // longer than the receive buffer without a delimiter
+    const std::vector<std::uint8_t> noise(3 * mcu_link::SerialLink::max_payload_size, 0x42);
+    link.receive(noise.data(), noise.size());
+    const std::vector<std::uint8_t> delimiter{0x00};
+    link.receive(delimiter.data(), delimiter.size());
+
+    const auto good = make_frame({0x01, 0x02, 0x03});
+    link.receive(good.data(), good.size());
+
+    EXPECT_EQ(frames, 1);
+    ASSERT_GE(errors.size(), 3u);
+    EXPECT_EQ(errors[0], mcu_link::SerialLink::Error::Crc);
+    EXPECT_EQ(errors[1], mcu_link::SerialLink::Error::Framing);
+    EXPECT_EQ(errors[2], mcu_link::SerialLink::Error::Overflow);
+}
+
+// connects board (pty master) and host (pty slave in raw mode)
+void open_pty_pair(mcu_link::SerialLink& board, mcu_link::SerialLink& host) {
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    ASSERT_GE(master, 0);
+    ASSERT_EQ(grantpt(master), 0);
+    ASSERT_EQ(unlockpt(master), 0);
+    const int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    ASSERT_GE(slave, 0);
+    struct termios tty;
+    tcgetattr(slave, &tty);
+    cfmakeraw(&tty);
+    tcsetattr(slave, TCSANOW, &tty);
+
+    board.open_fd(master);
+    host.open_fd(slave);
+}
+
+TEST(ReactorTest, reads_links_and_runs_timers) {
+    mcu_link::SerialLink board;
+    mcu_link::SerialLink host;
+    ASSERT_NO_FATAL_FAILURE(open_pty_pair(board, host));
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::uint8_t> received;
+    int ticks = 0;
+    host.set_frame_handler([&](const std::uint8_t* payload, std::size_t len) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.insert(received.end(), payload, payload + len);
+        cv.notify_all();
+    });
+
+    mcu_link::Reactor reactor;
+    ASSERT_TRUE(reactor.add(host));
+    const auto timer = reactor.add_timer(std::chrono::milliseconds(10), [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        ticks++;
+        cv.notify_all();
+    });
+
+    const std::vector<std::uint8_t> payload{0x08, 0x01, 0x00, 0x10};
+    ASSERT_TRUE(board.write_payload(payload.data(), payload.size()));
+
+    std::unique_lock<std::mutex> lock(mutex);
+    EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&]() { return received.size() == payload.size(); }));
+    EXPECT_EQ(received, payload);
+    EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&]() { return ticks >= 3; }));
+    lock.unlock();
+
+    reactor.remove_timer(timer);
+    reactor.remove(host);
+    lock.lock();
+    const auto ticks_after_remove = ticks;
+    lock.unlock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    lock.lock();
+    EXPECT_EQ(ticks, ticks_after_remove);
+}
+
+TEST(ReactorTest, hung_up_link_is_removed) {
+    mcu_link::SerialLink unplugged_board;
+    mcu_link::SerialLink unplugged_host;
+    mcu_link::SerialLink board;
+    mcu_link::SerialLink host;
+    ASSERT_NO_FATAL_FAILURE(open_pty_pair(unplugged_board, unplugged_host));
+    ASSERT_NO_FATAL_FAILURE(open_pty_pair(board, host));
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<mcu_link::SerialLink::Error> errors;
+    std::size_t received = 0;
+    unplugged_host.set_error_handler([&](mcu_link::SerialLink::Error error) {
+        std::lock_guard<std::mutex> lock(mutex);
+        errors.push_back(error);
+        cv.notify_all();
+    });
+    host.set_frame_handler([&](const std::uint8_t*, std::size_t len) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received += len;
+        cv.notify_all();
+    });
+
+    mcu_link::Reactor reactor;
+    ASSERT_TRUE(reactor.add(unplugged_host));
+    ASSERT_TRUE(reactor.add(host));
+
+    // closing the master hangs up the slave like unplugging a USB serial adapter
+    unplugged_board.close();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&]() { return not errors.empty(); }));
+    EXPECT_EQ(errors[0], mcu_link::SerialLink::Error::Io);
+    lock.unlock();
+
+    // the other link is still served and the hung up one is not polled again
+    const std::vector<std::uint8_t> payload{0x08, 0x02};
+    ASSERT_TRUE(board.write_payload(payload.data(), payload.size()));
+    lock.lock();
+    EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&]() { return received == payload.size(); }));
+    lock.unlock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    lock.lock();
+    EXPECT_EQ(errors.size(), 1);
+}
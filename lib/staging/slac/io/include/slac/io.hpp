@@ -3,17 +3,16 @@
 #ifndef SLAC_IO_HPP
 #define SLAC_IO_HPP
 
-#include <condition_variable>
 #include <functional>
-#include <mutex>
+#include <memory>
 #include <string>
-#include <thread>
 
-#include <slac/channel.hpp>
+#include <slac/mux.hpp>
 
+// SLAC I/O of one state machine, all instances using the same interface share one SlacMux
 class SlacIO {
 public:
-    using InputHandlerFnType = void(slac::messages::HomeplugMessage&);
+    using InputHandlerFnType = SlacMux::InputHandlerFnType;
     void init(const std::string& if_name);
 
     void run(std::function<InputHandlerFnType> callback);
@@ -21,13 +20,8 @@ public:
     void quit();
 
 private:
-    void loop();
-    slac::Channel slac_channel;
-    slac::messages::HomeplugMessage incoming_msg;
-    std::function<InputHandlerFnType> input_handler;
-    std::thread loop_thread;
-
-    bool running{false};
+    std::shared_ptr<SlacMux> mux;
+    std::unique_ptr<SlacMux::Endpoint> endpoint;
 };
 
 #endif // SLAC_IO_HPP
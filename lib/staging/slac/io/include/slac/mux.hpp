@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef SLAC_MUX_HPP
+#define SLAC_MUX_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <slac/slac.hpp>
+
+//
+// SlacMux shares one HomePlug packet socket between several SLAC state machines (e.g. the EVSE FSMs of all
+// connectors behind one PLC interface).
+//
+// The socket only receives SLAC related MMEs (CM_* and vendor specific), everything else is dropped by a BPF filter
+// in the kernel. A single thread blocks in epoll on the socket and dispatches every frame to the endpoint it belongs
+// to:
+//   - frames carrying a run id go to the endpoint that used this run id first (an EVSE claims a run id by answering
+//     the CM_SLAC_PARM.REQ, an EV by sending it)
+//   - CM_ATTEN_PROFILE.IND goes to the endpoint that is sounding with the PEV MAC
+//   - confirmations of the local modem go to the endpoint that sent the request (in request order)
+//   - everything else is routed by the source MAC
+// Frames which cannot be assigned (e.g. the first CM_SLAC_PARM.REQ of an EV) are offered to all endpoints which are
+// currently not matching, or to all endpoints if all of them are busy. If several EVSE endpoints answer the same
+// CM_SLAC_PARM.REQ, only the first answer is sent, the others are dropped.
+//
+// Socket errors (e.g. ENETDOWN when the interface goes down) are cleared and the socket stays watched, so frames are
+// received again after a link flap.
+//
+class SlacMux : public std::enable_shared_from_this<SlacMux> {
+public:
+    using InputHandlerFnType = void(slac::messages::HomeplugMessage&);
+
+    struct Statistics {
+        std::uint64_t received{0};
+        std::uint64_t routed{0};     // delivered to exactly one endpoint
+        std::uint64_t offered{0};    // delivered to all (idle) endpoints
+        std::uint64_t sent{0};
+        std::uint64_t suppressed{0};  // answers which have not been sent, another endpoint is matching
+        std::uint64_t send_failed{0}; // could not be written to the socket
+    };
+
+    class Endpoint {
+    public:
+        ~Endpoint();
+
+        Endpoint(const Endpoint&) = delete;
+        Endpoint& operator=(const Endpoint&) = delete;
+
+        // returns false if the message could not be sent or has been suppressed
+        bool send(slac::messages::HomeplugMessage& msg);
+
+    private:
+        friend class SlacMux;
+        Endpoint(std::shared_ptr<SlacMux> mux, int id);
+
+        std::shared_ptr<SlacMux> mux;
+        int id;
+    };
+
+    // returns the multiplexer of the given interface, opens it if it is not yet used by this process
+    static std::shared_ptr<SlacMux> get(const std::string& if_name);
+
+    // uses an already connected datagram socket, e.g. for test setups, the fd is closed by the multiplexer
+    static std::shared_ptr<SlacMux> create(int fd, const uint8_t mac[ETH_ALEN]);
+
+    ~SlacMux();
+
+    SlacMux(const SlacMux&) = delete;
+    SlacMux& operator=(const SlacMux&) = delete;
+
+    // the handler is called from the multiplexer thread
+    std::unique_ptr<Endpoint> connect(std::function<InputHandlerFnType> handler);
+
+    Statistics get_statistics() const;
+
+    // time after which an EVSE endpoint that answered a CM_SLAC_PARM.REQ but did not confirm the match is considered
+    // idle again
+    static constexpr auto MATCHING_CLAIM_TIMEOUT = std::chrono::seconds(5);
+
+    // number of recently used run ids and MAC addresses remembered per endpoint
+    static constexpr std::size_t MAX_REMEMBERED = 8;
+
+private:
+    using RunId = std::array<uint8_t, slac::defs::RUN_ID_LEN>;
+    using MacAddress = std::array<uint8_t, ETH_ALEN>;
+
+    struct EndpointState {
+        int id;
+        std::function<InputHandlerFnType> handler;
+        std::deque<RunId> run_ids;
+        std::deque<MacAddress> macs;
+        // run id of the CM_SLAC_PARM.CNF this endpoint is matching with until busy_until
+        RunId claimed_run_id{};
+        std::chrono::steady_clock::time_point busy_until{};
+    };
+
+    SlacMux(int fd, const uint8_t mac[ETH_ALEN]);
+
+    static int open_socket(const std::string& if_name, uint8_t mac[ETH_ALEN]);
+
+    void disconnect(int id);
+    bool send(int id, slac::messages::HomeplugMessage& msg);
+
+    void loop();
+    void dispatch(slac::messages::HomeplugMessage& msg);
+
+    // all of these expect the mutex to be held
+    EndpointState* find_by_run_id(const RunId& run_id);
+    EndpointState* find_by_mac(const uint8_t* mac);
+    void remember_run_id(EndpointState& endpoint, const RunId& run_id);
+    void remember_mac(EndpointState& endpoint, const uint8_t* mac);
+    std::vector<std::function<InputHandlerFnType>> select_handlers(slac::messages::HomeplugMessage& msg);
+
+    std::unique_lock<std::mutex> lock_dispatch();
+
+    int socket_fd{-1};
+    int epoll_fd{-1};
+    int event_fd{-1};
+    MacAddress if_mac{};
+
+    mutable std::mutex mutex;
+    std::vector<EndpointState> endpoints;
+    int next_endpoint_id{0};
+    // endpoints waiting for a confirmation of the local modem, per request MMTYPE
+    std::map<uint16_t, std::deque<int>> pending_requests;
+    Statistics statistics;
+
+    // held while handlers are called, so an endpoint can be disconnected safely from other threads
+    std::mutex dispatch_mutex;
+
+    std::atomic_bool stop{false};
+    std::thread thread;
+};
+
+#endif // SLAC_MUX_HPP
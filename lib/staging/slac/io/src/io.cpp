@@ -3,42 +3,29 @@
 #include <slac/io.hpp>
 
 #include <stdexcept>
-#include <thread>
 
 void SlacIO::init(const std::string& if_name) {
-    if (!slac_channel.open(if_name)) {
-        throw std::runtime_error(slac_channel.get_error());
-    }
+    // throws if the interface cannot be opened
+    mux = SlacMux::get(if_name);
 }
 
 void SlacIO::run(std::function<InputHandlerFnType> callback) {
-    input_handler = callback;
-
-    running = true;
+    if (!mux) {
+        throw std::runtime_error("SlacIO::run called before init");
+    }
 
-    loop_thread = std::thread(&SlacIO::loop, this);
+    endpoint = mux->connect(callback);
 }
 
 void SlacIO::quit() {
-    if (!running) {
-        return;
-    }
-
-    running = false;
-
-    loop_thread.join();
+    endpoint.reset();
 }
 
-void SlacIO::loop() {
-
-    while (running) {
-        if (slac_channel.read(incoming_msg, 10)) {
-            input_handler(incoming_msg);
-        }
+void SlacIO::send(slac::messages::HomeplugMessage& msg) {
+    if (!endpoint) {
+        return;
     }
-}
 
-void SlacIO::send(slac::messages::HomeplugMessage& msg) {
     // FIXME (aw): handle errors
-    slac_channel.write(msg, 1);
+    endpoint->send(msg);
 }
@@ -0,0 +1,501 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include <slac/mux.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_packet.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// the two lowest bits of the MMTYPE are the mode (REQ, CNF, IND, RSP)
+constexpr uint16_t MMTYPE_MODE_BITS = 0x0003;
+
+constexpr uint16_t mmtype_base(uint16_t mmtype) {
+    return mmtype & ~MMTYPE_MODE_BITS;
+}
+
+constexpr uint16_t mmtype_mode(uint16_t mmtype) {
+    return mmtype & MMTYPE_MODE_BITS;
+}
+
+// the HomePlug MMTYPE is little endian at offset 15, its upper byte is the category
+constexpr uint32_t MMTYPE_HIGH_BYTE_OFFSET = ETH_HLEN + 2;
+constexpr uint32_t MMTYPE_CATEGORY_CM = 0x60;
+constexpr uint32_t MMTYPE_CATEGORY_VENDOR_FIRST = 0xA0;
+constexpr uint32_t MMTYPE_CATEGORY_VENDOR_LAST = 0xBF;
+
+// accepts HomePlug CM_* (SLAC, SET_KEY) and vendor specific MMEs
+struct sock_filter homeplug_slac_filter[] = {
+    BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 12),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, slac::defs::ETH_P_HOMEPLUG_GREENPHY, 0, 5),
+    BPF_STMT(BPF_LD | BPF_B | BPF_ABS, MMTYPE_HIGH_BYTE_OFFSET),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, MMTYPE_CATEGORY_CM, 2, 0),
+    BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, MMTYPE_CATEGORY_VENDOR_FIRST, 0, 2),
+    BPF_JUMP(BPF_JMP | BPF_JGT | BPF_K, MMTYPE_CATEGORY_VENDOR_LAST, 1, 0),
+    BPF_STMT(BPF_RET | BPF_K, 0xffff),
+    BPF_STMT(BPF_RET | BPF_K, 0),
+};
+
+// returns the run id of all SLAC messages that carry one
+std::optional<std::array<uint8_t, slac::defs::RUN_ID_LEN>> get_run_id(slac::messages::HomeplugMessage& msg) {
+    std::array<uint8_t, slac::defs::RUN_ID_LEN> run_id;
+    const uint8_t* src = nullptr;
+
+    using namespace slac::defs;
+    switch (msg.get_mmtype()) {
+    case MMTYPE_CM_SLAC_PARAM | MMTYPE_MODE_REQ:
+        src = msg.get_payload<slac::messages::cm_slac_parm_req>().run_id;
+        break;
+    case MMTYPE_CM_SLAC_PARAM | MMTYPE_MODE_CNF:
+        src = msg.get_payload<slac::messages::cm_slac_parm_cnf>().run_id;
+        break;
+    case MMTYPE_CM_START_ATTEN_CHAR | MMTYPE_MODE_IND:
+        src = msg.get_payload<slac::messages::cm_start_atten_char_ind>().run_id;
+        break;
+    case MMTYPE_CM_MNBC_SOUND | MMTYPE_MODE_IND:
+        src = msg.get_payload<slac::messages::cm_mnbc_sound_ind>().run_id;
+        break;
+    case MMTYPE_CM_ATTEN_CHAR | MMTYPE_MODE_IND:
+        src = msg.get_payload<slac::messages::cm_atten_char_ind>().run_id;
+        break;
+    case MMTYPE_CM_ATTEN_CHAR | MMTYPE_MODE_RSP:
+        src = msg.get_payload<slac::messages::cm_atten_char_rsp>().run_id;
+        break;
+    case MMTYPE_CM_SLAC_MATCH | MMTYPE_MODE_REQ:
+        src = msg.get_payload<slac::messages::cm_slac_match_req>().run_id;
+        break;
+    case MMTYPE_CM_SLAC_MATCH | MMTYPE_MODE_CNF:
+        src = msg.get_payload<slac::messages::cm_slac_match_cnf>().run_id;
+        break;
+    default:
+        return std::nullopt;
+    }
+
+    std::copy(src, src + run_id.size(), run_id.begin());
+    return run_id;
+}
+
+bool is_unicast(const uint8_t* mac) {
+    return (mac[0] & 0x01) == 0;
+}
+
+template <typename T> void push_bounded(std::deque<T>& list, const T& value, std::size_t max_size) {
+    const auto it = std::find(list.begin(), list.end(), value);
+    if (it != list.end()) {
+        list.erase(it);
+    }
+    list.push_front(value);
+    if (list.size() > max_size) {
+        list.pop_back();
+    }
+}
+
+// time after which a socket with a persisting error condition is watched again
+constexpr auto ERROR_BACKOFF = std::chrono::seconds(1);
+
+std::mutex registry_mutex;
+std::map<std::string, std::weak_ptr<SlacMux>> registry;
+
+} // namespace
+
+SlacMux::Endpoint::Endpoint(std::shared_ptr<SlacMux> mux_, int id_) : mux(std::move(mux_)), id(id_) {
+}
+
+SlacMux::Endpoint::~Endpoint() {
+    mux->disconnect(id);
+}
+
+bool SlacMux::Endpoint::send(slac::messages::HomeplugMessage& msg) {
+    return mux->send(id, msg);
+}
+
+std::shared_ptr<SlacMux> SlacMux::get(const std::string& if_name) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto mux = registry[if_name].lock();
+    if (mux) {
+        return mux;
+    }
+
+    uint8_t mac[ETH_ALEN];
+    const auto fd = open_socket(if_name, mac);
+    mux = std::shared_ptr<SlacMux>(new SlacMux(fd, mac));
+    registry[if_name] = mux;
+    return mux;
+}
+
+std::shared_ptr<SlacMux> SlacMux::create(int fd, const uint8_t mac[ETH_ALEN]) {
+    return std::shared_ptr<SlacMux>(new SlacMux(fd, mac));
+}
+
+int SlacMux::open_socket(const std::string& if_name, uint8_t mac[ETH_ALEN]) {
+    const auto if_index = if_nametoindex(if_name.c_str());
+    if (if_index == 0) {
+        throw std::system_error(errno, std::generic_category(), "Unknown interface " + if_name);
+    }
+
+    const uint16_t protocol = htons(slac::defs::ETH_P_HOMEPLUG_GREENPHY);
+    const auto fd = socket(AF_PACKET, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, protocol);
+    if (fd == -1) {
+        throw std::system_error(errno, std::generic_category(), "Couldn't create the packet socket");
+    }
+
+    const auto fail = [fd](const char* what) {
+        const auto error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), what);
+    };
+
+    struct sock_fprog filter {};
+    filter.len = sizeof(homeplug_slac_filter) / sizeof(homeplug_slac_filter[0]);
+    filter.filter = homeplug_slac_filter;
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter)) == -1) {
+        fail("Couldn't attach the HomePlug filter");
+    }
+
+    struct sockaddr_ll sock_addr {};
+    sock_addr.sll_family = AF_PACKET;
+    sock_addr.sll_protocol = protocol;
+    sock_addr.sll_ifindex = if_index;
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&sock_addr), sizeof(sock_addr)) == -1) {
+        fail("Couldn't bind the packet socket");
+    }
+
+    struct ifreq ifr {};
+    strncpy(ifr.ifr_name, if_name.c_str(), IFNAMSIZ - 1);
+    if (ioctl(fd, SIOCGIFHWADDR, &ifr) == -1) {
+        fail("Couldn't get the MAC address");
+    }
+    memcpy(mac, ifr.ifr_hwaddr.sa_data, ETH_ALEN);
+
+    // frames received before the filter was attached may still be queued
+    uint8_t drain[ETH_FRAME_LEN];
+    while (recv(fd, drain, sizeof(drain), 0) > 0) {
+    }
+
+    return fd;
+}
+
+SlacMux::SlacMux(int fd, const uint8_t mac[ETH_ALEN]) : socket_fd(fd) {
+    std::copy(mac, mac + ETH_ALEN, if_mac.begin());
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epoll_fd == -1 || event_fd == -1) {
+        const auto error = errno;
+        close(socket_fd);
+        if (epoll_fd != -1) {
+            close(epoll_fd);
+        }
+        if (event_fd != -1) {
+            close(event_fd);
+        }
+        throw std::system_error(error, std::generic_category(), "Couldn't set up the SLAC multiplexer");
+    }
+
+    struct epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.fd = socket_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket_fd, &ev);
+    ev.data.fd = event_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, event_fd, &ev);
+
+    thread = std::thread(&SlacMux::loop, this);
+}
+
+SlacMux::~SlacMux() {
+    stop = true;
+    const uint64_t wake = 1;
+    (void)write(event_fd, &wake, sizeof(wake));
+    thread.join();
+
+    close(event_fd);
+    close(epoll_fd);
+    close(socket_fd);
+}
+
+std::unique_ptr<SlacMux::Endpoint> SlacMux::connect(std::function<InputHandlerFnType> handler) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto id = next_endpoint_id++;
+    endpoints.push_back(EndpointState{id, std::move(handler), {}, {}, {}, {}});
+    return std::unique_ptr<Endpoint>(new Endpoint(shared_from_this(), id));
+}
+
+std::unique_lock<std::mutex> SlacMux::lock_dispatch() {
+    // handlers may disconnect from within the multiplexer thread, which already holds the dispatch mutex
+    if (std::this_thread::get_id() == thread.get_id()) {
+        return std::unique_lock<std::mutex>();
+    }
+    return std::unique_lock<std::mutex>(dispatch_mutex);
+}
+
+void SlacMux::disconnect(int id) {
+    const auto dispatch_lock = lock_dispatch();
+    std::lock_guard<std::mutex> lock(mutex);
+    endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(), [id](const auto& e) { return e.id == id; }),
+                    endpoints.end());
+    for (auto& pending : pending_requests) {
+        auto& ids = pending.second;
+        ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+    }
+}
+
+SlacMux::Statistics SlacMux::get_statistics() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return statistics;
+}
+
+SlacMux::EndpointState* SlacMux::find_by_run_id(const RunId& run_id) {
+    for (auto& endpoint : endpoints) {
+        if (std::find(endpoint.run_ids.begin(), endpoint.run_ids.end(), run_id) != endpoint.run_ids.end()) {
+            return &endpoint;
+        }
+    }
+    return nullptr;
+}
+
+SlacMux::EndpointState* SlacMux::find_by_mac(const uint8_t* mac) {
+    MacAddress address;
+    std::copy(mac, mac + ETH_ALEN, address.begin());
+    for (auto& endpoint : endpoints) {
+        if (std::find(endpoint.macs.begin(), endpoint.macs.end(), address) != endpoint.macs.end()) {
+            return &endpoint;
+        }
+    }
+    return nullptr;
+}
+
+void SlacMux::remember_run_id(EndpointState& endpoint, const RunId& run_id) {
+    push_bounded(endpoint.run_ids, run_id, MAX_REMEMBERED);
+}
+
+void SlacMux::remember_mac(EndpointState& endpoint, const uint8_t* mac) {
+    if (!is_unicast(mac)) {
+        return;
+    }
+
+    MacAddress address;
+    std::copy(mac, mac + ETH_ALEN, address.begin());
+    // an EV (MAC) can only be handled by one endpoint at a time
+    for (auto& other : endpoints) {
+        if (&other != &endpoint) {
+            other.macs.erase(std::remove(other.macs.begin(), other.macs.end(), address), other.macs.end());
+        }
+    }
+    push_bounded(endpoint.macs, address, MAX_REMEMBERED);
+}
+
+bool SlacMux::send(int id, slac::messages::HomeplugMessage& msg) {
+    auto raw = msg.get_raw_message_ptr();
+    if (!msg.keep_source_mac()) {
+        memcpy(raw->ethernet_header.ether_shost, if_mac.data(), ETH_ALEN);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto self = std::find_if(endpoints.begin(), endpoints.end(), [id](const auto& e) { return e.id == id; });
+        if (self == endpoints.end()) {
+            return false;
+        }
+
+        const auto mmtype = msg.get_mmtype();
+        const auto run_id = get_run_id(msg);
+        if (run_id.has_value()) {
+            const auto owner = find_by_run_id(*run_id);
+            if (owner != nullptr && owner != &*self) {
+                // another endpoint already answered this run id
+                statistics.suppressed++;
+                return false;
+            }
+        }
+
+        if (mmtype == (slac::defs::MMTYPE_CM_SLAC_PARAM | slac::defs::MMTYPE_MODE_CNF)) {
+            const auto now = std::chrono::steady_clock::now();
+            if (self->busy_until > now && self->claimed_run_id != *run_id) {
+                // this endpoint is already matching with another EV, leave the new one to the others
+                statistics.suppressed++;
+                return false;
+            }
+            self->busy_until = now + MATCHING_CLAIM_TIMEOUT;
+            self->claimed_run_id = *run_id;
+        } else if (mmtype == (slac::defs::MMTYPE_CM_SLAC_MATCH | slac::defs::MMTYPE_MODE_CNF)) {
+            self->busy_until = {};
+        }
+
+        if (run_id.has_value()) {
+            remember_run_id(*self, *run_id);
+        }
+
+        remember_mac(*self, raw->ethernet_header.ether_dhost);
+
+        if (mmtype_mode(mmtype) == slac::defs::MMTYPE_MODE_REQ && run_id.has_value() == false) {
+            // requests to the local modem, e.g. CM_SET_KEY.REQ or vendor specific ones
+            auto& pending = pending_requests[mmtype_base(mmtype)];
+            pending.push_back(id);
+            if (pending.size() > MAX_REMEMBERED) {
+                pending.pop_front();
+            }
+        }
+    }
+
+    // a frame which cannot be sent right away is dropped and counted, just like a frame lost on the line
+    const auto result = ::send(socket_fd, raw, msg.get_raw_msg_len(), MSG_DONTWAIT);
+    const auto success = result == static_cast<ssize_t>(msg.get_raw_msg_len());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (success) {
+        statistics.sent++;
+    } else {
+        statistics.send_failed++;
+    }
+    return success;
+}
+
+std::vector<std::function<SlacMux::InputHandlerFnType>>
+SlacMux::select_handlers(slac::messages::HomeplugMessage& msg) {
+    const auto mmtype = msg.get_mmtype();
+    const auto src_mac = msg.get_src_mac();
+    EndpointState* target = nullptr;
+
+    const auto run_id = get_run_id(msg);
+    if (run_id.has_value()) {
+        target = find_by_run_id(*run_id);
+        if (target != nullptr) {
+            remember_mac(*target, src_mac);
+        }
+    } else if (mmtype == (slac::defs::MMTYPE_CM_ATTEN_PROFILE | slac::defs::MMTYPE_MODE_IND)) {
+        target = find_by_mac(msg.get_payload<slac::messages::cm_atten_profile_ind>().pev_mac);
+    } else if (mmtype_mode(mmtype) == slac::defs::MMTYPE_MODE_CNF) {
+        auto& pending = pending_requests[mmtype_base(mmtype)];
+        if (!pending.empty()) {
+            const auto id = pending.front();
+            pending.pop_front();
+            const auto it =
+                std::find_if(endpoints.begin(), endpoints.end(), [id](const auto& e) { return e.id == id; });
+            if (it != endpoints.end()) {
+                target = &*it;
+            }
+        }
+    } else {
+        target = find_by_mac(src_mac);
+    }
+
+    if (target != nullptr) {
+        statistics.routed++;
+        return {target->handler};
+    }
+
+    // unknown so far, offer it to all endpoints which are not busy with matching
+    const auto now = std::chrono::steady_clock::now();
+    std::vector<std::function<InputHandlerFnType>> handlers;
+    for (const auto& endpoint : endpoints) {
+        if (endpoint.busy_until <= now) {
+            handlers.push_back(endpoint.handler);
+        }
+    }
+    if (handlers.empty()) {
+        for (const auto& endpoint : endpoints) {
+            handlers.push_back(endpoint.handler);
+        }
+    }
+
+    statistics.offered++;
+    return handlers;
+}
+
+void SlacMux::dispatch(slac::messages::HomeplugMessage& msg) {
+    std::vector<std::function<InputHandlerFnType>> handlers;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        statistics.received++;
+        handlers = select_handlers(msg);
+    }
+
+    for (auto& handler : handlers) {
+        handler(msg);
+    }
+}
+
+void SlacMux::loop() {
+    constexpr int max_events = 2;
+    struct epoll_event events[max_events];
+    slac::messages::HomeplugMessage msg;
+
+    // set while the socket is not watched because of a persisting error
+    std::optional<std::chrono::steady_clock::time_point> backoff_until;
+
+    while (!stop) {
+        int timeout_ms = -1;
+        if (backoff_until.has_value()) {
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= *backoff_until) {
+                struct epoll_event ev {};
+                ev.events = EPOLLIN;
+                ev.data.fd = socket_fd;
+                epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket_fd, &ev);
+                backoff_until.reset();
+            } else {
+                timeout_ms = std::chrono::ceil<std::chrono::milliseconds>(*backoff_until - now).count();
+            }
+        }
+
+        const auto n = epoll_wait(epoll_fd, events, max_events, timeout_ms);
+        if (n == -1 && errno != EINTR) {
+            break;
+        }
+
+        std::lock_guard<std::mutex> dispatch_lock(dispatch_mutex);
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.fd == event_fd) {
+                uint64_t value;
+                (void)read(event_fd, &value, sizeof(value));
+                continue;
+            }
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                // reading the error clears it, e.g. the ENETDOWN of a link flap, frames are received again once the
+                // interface is up
+                int error = 0;
+                socklen_t len = sizeof(error);
+                (void)getsockopt(socket_fd, SOL_SOCKET, SO_ERROR, &error, &len);
+
+                struct pollfd pfd {};
+                pfd.fd = socket_fd;
+                if (poll(&pfd, 1, 0) == 1 && (pfd.revents & (POLLERR | POLLHUP))) {
+                    // the condition persists, do not spin on it but keep trying
+                    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, socket_fd, nullptr);
+                    backoff_until = std::chrono::steady_clock::now() + ERROR_BACKOFF;
+                }
+            }
+
+            // read everything that is queued, the socket is non-blocking
+            while (!stop) {
+                const auto bytes = recv(socket_fd, msg.get_raw_message_ptr(), sizeof(slac::messages::homeplug_message),
+                                        MSG_DONTWAIT);
+                if (bytes <= 0) {
+                    break;
+                }
+                if (bytes < static_cast<ssize_t>(ETH_HLEN + 3)) {
+                    // too short for a HomePlug header
+                    continue;
+                }
+                dispatch(msg);
+            }
+        }
+    }
+}
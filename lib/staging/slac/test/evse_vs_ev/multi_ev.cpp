@@ -0,0 +1,322 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+// Measures the matching time of several EVs which are connected at the same time to a charger with one PLC modem for
+// all connectors. All EVSE state machines share one SlacMux.
+//
+// usage: evse_vs_multi_ev [min number of EVs] [max number of EVs]
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <slac/fsm/ev/fsm.hpp>
+#include <slac/fsm/ev/states/others.hpp>
+#include <slac/fsm/evse/fsm.hpp>
+#include <slac/fsm/evse/states/others.hpp>
+#include <slac/mux.hpp>
+
+#include "plc_emu.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr static uint8_t EVSE_MUX_MAC_ADDR[ETH_ALEN] = {0x6e, 0x3f, 0x46, 0x32, 0xbf, 0xc6};
+
+constexpr auto MATCHING_DEADLINE = std::chrono::seconds(30);
+
+class EvseFsmController {
+public:
+    EvseFsmController(SlacMux& mux, Clock::time_point& start_time);
+
+    void trigger_enter_bcd();
+    void run();
+    void stop();
+
+    std::optional<Clock::duration> get_matching_time();
+    std::string get_matched_ev_mac();
+
+private:
+    void signal_simple_event(slac::fsm::evse::Event ev);
+
+    slac::fsm::evse::ContextCallbacks callbacks;
+    slac::fsm::evse::Context ctx{callbacks};
+    slac::fsm::evse::FSM fsm;
+
+    std::unique_ptr<SlacMux::Endpoint> endpoint;
+    Clock::time_point& start_time;
+
+    std::mutex feed_mtx;
+    std::condition_variable new_event_cv;
+    bool new_event{false};
+    bool stopped{false};
+
+    std::optional<Clock::duration> matching_time;
+    std::string matched_ev_mac;
+};
+
+EvseFsmController::EvseFsmController(SlacMux& mux, Clock::time_point& start_time_) : start_time(start_time_) {
+    ctx.slac_config.chip_reset.enabled = false;
+    ctx.slac_config.generate_nmk();
+
+    callbacks.send_raw_slac = [this](slac::messages::HomeplugMessage& msg) { endpoint->send(msg); };
+    callbacks.signal_state = [this](const std::string& state) {
+        if (state == "MATCHED") {
+            matching_time = Clock::now() - start_time;
+        }
+    };
+    callbacks.signal_ev_mac_address_match_cnf = [this](const std::string& mac) { matched_ev_mac = mac; };
+
+    fsm.reset<slac::fsm::evse::ResetState>(ctx);
+
+    endpoint = mux.connect([this](slac::messages::HomeplugMessage& msg) {
+        {
+            const std::lock_guard<std::mutex> feed_lck(feed_mtx);
+            ctx.slac_message_payload = msg;
+            fsm.handle_event(slac::fsm::evse::Event::SLAC_MESSAGE);
+            new_event = true;
+        }
+        new_event_cv.notify_all();
+    });
+}
+
+void EvseFsmController::trigger_enter_bcd() {
+    signal_simple_event(slac::fsm::evse::Event::ENTER_BCD);
+}
+
+void EvseFsmController::stop() {
+    {
+        const std::lock_guard<std::mutex> feed_lck(feed_mtx);
+        stopped = true;
+    }
+    new_event_cv.notify_all();
+}
+
+void EvseFsmController::signal_simple_event(slac::fsm::evse::Event ev) {
+    {
+        const std::lock_guard<std::mutex> feed_lck(feed_mtx);
+        fsm.handle_event(ev);
+        new_event = true;
+    }
+    new_event_cv.notify_all();
+}
+
+std::optional<Clock::duration> EvseFsmController::get_matching_time() {
+    const std::lock_guard<std::mutex> feed_lck(feed_mtx);
+    return matching_time;
+}
+
+std::string EvseFsmController::get_matched_ev_mac() {
+    const std::lock_guard<std::mutex> feed_lck(feed_mtx);
+    return matched_ev_mac;
+}
+
+void EvseFsmController::run() {
+    std::unique_lock<std::mutex> feed_lck(feed_mtx);
+
+    while (not stopped) {
+        auto feed_result = fsm.feed();
+
+        if (feed_result.transition()) {
+            // call immediately again
+            continue;
+        } else if (feed_result.internal_error() || feed_result.unhandled_event()) {
+            throw std::runtime_error("Evse fsm: internal error / unhandled event");
+        } else if (feed_result.has_value()) {
+            const auto timeout = *feed_result;
+            if (timeout == 0) {
+                continue;
+            }
+            new_event_cv.wait_for(feed_lck, std::chrono::milliseconds(timeout),
+                                  [this] { return new_event or stopped; });
+        } else {
+            new_event_cv.wait(feed_lck, [this] { return new_event or stopped; });
+        }
+
+        new_event = false;
+    }
+
+    // the endpoint must not be released while the multiplexer thread waits for the feed lock
+    feed_lck.unlock();
+    endpoint.reset();
+}
+
+class EvFsmController {
+public:
+    EvFsmController(int ev_fd, const uint8_t* plc_mac);
+    ~EvFsmController();
+
+    void run();
+    void stop();
+
+private:
+    slac::fsm::ev::ContextCallbacks callbacks;
+    slac::fsm::ev::Context ctx{callbacks};
+    slac::fsm::ev::FSM fsm;
+
+    std::array<struct pollfd, 2> pollfds;
+};
+
+EvFsmController::EvFsmController(int ev_fd, const uint8_t* plc_mac) {
+    pollfds = {{
+        {ev_fd, POLLIN, 0},
+        {eventfd(0, 0), POLLIN, 0},
+    }};
+
+    memcpy(ctx.plc_mac, plc_mac, sizeof(ctx.plc_mac));
+
+    callbacks.send_raw_slac = [ev_fd](slac::messages::HomeplugMessage& msg) {
+        write(ev_fd, msg.get_raw_message_ptr(), msg.get_raw_msg_len());
+    };
+
+    fsm.reset<slac::fsm::ev::ResetState>(ctx);
+}
+
+EvFsmController::~EvFsmController() {
+    close(pollfds[1].fd);
+}
+
+void EvFsmController::stop() {
+    uint64_t event_value = 0x1;
+    write(pollfds[1].fd, &event_value, sizeof(event_value));
+}
+
+void EvFsmController::run() {
+    fsm.handle_event(slac::fsm::ev::Event::TRIGGER_MATCHING);
+    while (true) {
+        auto feed_result = fsm.feed();
+
+        if (feed_result.transition()) {
+            continue;
+        } else if (feed_result.internal_error() || feed_result.unhandled_event()) {
+            throw std::runtime_error("Ev fsm: internal error / unhandled event");
+        }
+        const auto timeout = (feed_result.has_value()) ? *feed_result : -1;
+
+        if (timeout == 0) {
+            continue;
+        }
+
+        const auto poll_result = poll(pollfds.data(), pollfds.size(), timeout);
+
+        if (poll_result <= 0) {
+            continue;
+        }
+
+        if (pollfds[1].revents & POLLIN) {
+            return;
+        }
+
+        if (pollfds[0].revents & POLLIN) {
+            auto raw_msg = ctx.slac_message.get_raw_message_ptr();
+            read(pollfds[0].fd, raw_msg, sizeof(slac::messages::homeplug_message));
+            fsm.handle_event(slac::fsm::ev::Event::SLAC_MESSAGE);
+        }
+    }
+}
+
+static double to_ms(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+static void measure_matching(int number_of_evs) {
+    MultiEvPlcEmu plc_emu(number_of_evs);
+
+    auto mux = SlacMux::create(plc_emu.release_evse_socket(), EVSE_MUX_MAC_ADDR);
+
+    Clock::time_point start_time;
+
+    std::vector<std::unique_ptr<EvseFsmController>> evse_ctrls;
+    std::vector<std::unique_ptr<EvFsmController>> ev_ctrls;
+    for (int i = 0; i < number_of_evs; ++i) {
+        evse_ctrls.push_back(std::make_unique<EvseFsmController>(*mux, start_time));
+        ev_ctrls.push_back(std::make_unique<EvFsmController>(plc_emu.get_ev_socket(i), plc_emu.get_ev_mac(i)));
+    }
+
+    std::vector<std::thread> threads;
+    for (auto& evse_ctrl : evse_ctrls) {
+        threads.emplace_back(&EvseFsmController::run, evse_ctrl.get());
+    }
+
+    // give the EVSEs some time to get ready
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    start_time = Clock::now();
+    for (auto& evse_ctrl : evse_ctrls) {
+        evse_ctrl->trigger_enter_bcd();
+    }
+    for (auto& ev_ctrl : ev_ctrls) {
+        threads.emplace_back(&EvFsmController::run, ev_ctrl.get());
+    }
+
+    std::vector<Clock::duration> matching_times;
+    std::set<std::string> matched_evs;
+    const auto deadline = start_time + MATCHING_DEADLINE;
+    while (Clock::now() < deadline) {
+        matching_times.clear();
+        matched_evs.clear();
+        for (auto& evse_ctrl : evse_ctrls) {
+            const auto matching_time = evse_ctrl->get_matching_time();
+            if (matching_time) {
+                matching_times.push_back(*matching_time);
+                matched_evs.insert(evse_ctrl->get_matched_ev_mac());
+            }
+        }
+
+        if (matching_times.size() == static_cast<std::size_t>(number_of_evs)) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    for (auto& evse_ctrl : evse_ctrls) {
+        evse_ctrl->stop();
+    }
+    for (auto& ev_ctrl : ev_ctrls) {
+        ev_ctrl->stop();
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const auto statistics = mux->get_statistics();
+
+    printf("%d EVs: %zu matched (%zu distinct EVs)", number_of_evs, matching_times.size(), matched_evs.size());
+    if (not matching_times.empty()) {
+        std::sort(matching_times.begin(), matching_times.end());
+        printf(", matching time min %.1f ms, median %.1f ms, max %.1f ms", to_ms(matching_times.front()),
+               to_ms(matching_times[matching_times.size() / 2]), to_ms(matching_times.back()));
+    }
+    printf("\n        mux: %llu received, %llu routed, %llu offered, %llu sent, %llu suppressed, %llu send failed\n",
+           static_cast<unsigned long long>(statistics.received), static_cast<unsigned long long>(statistics.routed),
+           static_cast<unsigned long long>(statistics.offered), static_cast<unsigned long long>(statistics.sent),
+           static_cast<unsigned long long>(statistics.suppressed),
+           static_cast<unsigned long long>(statistics.send_failed));
+}
+
+auto main(int argc, char* argv[]) -> int {
+    const int min_evs = (argc > 1) ? std::atoi(argv[1]) : 2;
+    const int max_evs = (argc > 2) ? std::atoi(argv[2]) : std::max(min_evs, 8);
+
+    for (int number_of_evs = min_evs; number_of_evs <= max_evs; ++number_of_evs) {
+        measure_matching(number_of_evs);
+    }
+
+    return 0;
+}
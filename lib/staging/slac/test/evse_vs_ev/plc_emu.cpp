@@ -5,7 +5,12 @@
 #include <cstdio>
 #include <cstring>
 #include <random>
+#include <stdexcept>
+#include <vector>
 
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
 #include <slac/slac.hpp>
@@ -19,25 +24,25 @@ constexpr static uint8_t EVSE_MAC_ADDR[ETH_ALEN] = {0x6e, 0x3f, 0x46, 0x32, 0xbf
 
 constexpr static uint8_t PLC_SRC_MAC_ADDR[ETH_ALEN] = {0x00, 0x01, 0x87, 0x0e, 0xa3, 0x55};
 
-static void handle_set_key_req(int origin_fd) {
+static void handle_set_key_req(slac::messages::HomeplugMessage& message, int origin_fd) {
     slac::messages::cm_set_key_cnf set_key_cnf;
     // FIXME (aw): proper message and mac header setup!
-    homeplug_message.setup_payload(&set_key_cnf, sizeof(set_key_cnf),
-                                   (slac::defs::MMTYPE_CM_SET_KEY | slac::defs::MMTYPE_MODE_CNF),
-                                   slac::defs::MMV::AV_1_1);
+    message.setup_payload(&set_key_cnf, sizeof(set_key_cnf),
+                          (slac::defs::MMTYPE_CM_SET_KEY | slac::defs::MMTYPE_MODE_CNF), slac::defs::MMV::AV_1_1);
 
-    auto raw = homeplug_message.get_raw_message_ptr();
+    auto raw = message.get_raw_message_ptr();
     memcpy(raw->ethernet_header.ether_dhost, raw->ethernet_header.ether_shost,
            sizeof(raw->ethernet_header.ether_dhost));
     memcpy(raw->ethernet_header.ether_shost, PLC_SRC_MAC_ADDR, sizeof(PLC_SRC_MAC_ADDR));
 
-    write(origin_fd, raw, homeplug_message.get_raw_msg_len());
+    write(origin_fd, raw, message.get_raw_msg_len());
 }
 
-static void attach_atten_profile(int evse_bridge_fd) {
+static void attach_atten_profile(slac::messages::HomeplugMessage& message, const uint8_t* pev_mac,
+                                 int evse_bridge_fd) {
     slac::messages::cm_atten_profile_ind atten_profile;
 
-    memcpy(atten_profile.pev_mac, homeplug_message.get_src_mac(), sizeof(atten_profile.pev_mac));
+    memcpy(atten_profile.pev_mac, pev_mac, sizeof(atten_profile.pev_mac));
     atten_profile.num_groups = slac::defs::AAG_LIST_LEN;
 
     std::random_device rnd_dev;
@@ -48,15 +53,15 @@ static void attach_atten_profile(int evse_bridge_fd) {
         atten_profile.aag[i] = db_dist(rng);
     }
 
-    homeplug_message.setup_payload(&atten_profile, sizeof(atten_profile),
-                                   (slac::defs::MMTYPE_CM_ATTEN_PROFILE | slac::defs::MMTYPE_MODE_IND),
-                                   slac::defs::MMV::AV_1_1);
+    message.setup_payload(&atten_profile, sizeof(atten_profile),
+                          (slac::defs::MMTYPE_CM_ATTEN_PROFILE | slac::defs::MMTYPE_MODE_IND),
+                          slac::defs::MMV::AV_1_1);
 
-    auto raw = homeplug_message.get_raw_message_ptr();
+    auto raw = message.get_raw_message_ptr();
 
     memcpy(raw->ethernet_header.ether_shost, PLC_SRC_MAC_ADDR, sizeof(PLC_SRC_MAC_ADDR));
 
-    write(evse_bridge_fd, raw, homeplug_message.get_raw_msg_len());
+    write(evse_bridge_fd, raw, message.get_raw_msg_len());
 }
 
 void handle_ev_input(int ev_bridge_fd, int evse_bridge_fd) {
@@ -71,7 +76,7 @@ void handle_ev_input(int ev_bridge_fd, int evse_bridge_fd) {
     memcpy(raw_hp_message->ethernet_header.ether_shost, EV_MAC_ADDR, sizeof(EV_MAC_ADDR));
 
     if (mmtype == (slac::defs::MMTYPE_CM_SET_KEY | slac::defs::MMTYPE_MODE_REQ)) {
-        handle_set_key_req(ev_bridge_fd);
+        handle_set_key_req(homeplug_message, ev_bridge_fd);
     } else {
         // default: forward message
         write(evse_bridge_fd, raw_hp_message, bytes_read);
@@ -79,7 +84,7 @@ void handle_ev_input(int ev_bridge_fd, int evse_bridge_fd) {
 
     if (mmtype == (slac::defs::MMTYPE_CM_MNBC_SOUND | slac::defs::MMTYPE_MODE_IND)) {
         // also attach CM_ATTEN_PROFILE.IND
-        attach_atten_profile(evse_bridge_fd);
+        attach_atten_profile(homeplug_message, EV_MAC_ADDR, evse_bridge_fd);
     }
 }
 
@@ -93,9 +98,138 @@ void handle_evse_input(int evse_bridge_fd, int ev_bridge_fd) {
     memcpy(raw_hp_message->ethernet_header.ether_shost, EVSE_MAC_ADDR, sizeof(EVSE_MAC_ADDR));
 
     if (mmtype == (slac::defs::MMTYPE_CM_SET_KEY | slac::defs::MMTYPE_MODE_REQ)) {
-        handle_set_key_req(evse_bridge_fd);
+        handle_set_key_req(homeplug_message, evse_bridge_fd);
     } else {
         // default: forward message
         write(ev_bridge_fd, raw_hp_message, bytes_read);
     }
 }
+
+MultiEvPlcEmu::MultiEvPlcEmu(int number_of_evs) {
+    std::array<int, 2> fd_pair;
+
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, fd_pair.data())) {
+        throw std::runtime_error("evse socketpair creation failed");
+    }
+    evse_fd = fd_pair.at(0);
+    evse_bridge_fd = fd_pair.at(1);
+
+    for (int i = 0; i < number_of_evs; ++i) {
+        if (socketpair(AF_UNIX, SOCK_DGRAM, 0, fd_pair.data())) {
+            throw std::runtime_error("ev socketpair creation failed");
+        }
+
+        Ev ev{fd_pair.at(0), fd_pair.at(1), {}};
+        memcpy(ev.mac.data(), EV_MAC_ADDR, ETH_ALEN);
+        ev.mac[ETH_ALEN - 1] += i;
+        evs.push_back(ev);
+    }
+
+    event_fd = eventfd(0, 0);
+    if (event_fd == -1) {
+        throw std::runtime_error("eventfd failed");
+    }
+
+    loop_thread = std::thread(&MultiEvPlcEmu::loop, this);
+}
+
+MultiEvPlcEmu::~MultiEvPlcEmu() {
+    uint64_t event_value = 0x1;
+    write(event_fd, &event_value, sizeof(event_value));
+
+    loop_thread.join();
+
+    close(event_fd);
+    close(evse_bridge_fd);
+    if (evse_fd != -1) {
+        close(evse_fd);
+    }
+    for (const auto& ev : evs) {
+        close(ev.bridge_fd);
+        close(ev.fd);
+    }
+}
+
+int MultiEvPlcEmu::release_evse_socket() {
+    const auto fd = evse_fd;
+    evse_fd = -1;
+    return fd;
+}
+
+void MultiEvPlcEmu::loop() {
+    std::vector<struct pollfd> pollfds;
+    pollfds.push_back({event_fd, POLLIN, 0});
+    pollfds.push_back({evse_bridge_fd, POLLIN, 0});
+    for (const auto& ev : evs) {
+        pollfds.push_back({ev.bridge_fd, POLLIN, 0});
+    }
+
+    while (true) {
+        if (poll(pollfds.data(), pollfds.size(), -1) == -1) {
+            continue;
+        }
+
+        if (pollfds[0].revents & POLLIN) {
+            return;
+        }
+
+        if (pollfds[1].revents & POLLIN) {
+            handle_evse_input();
+        }
+
+        for (std::size_t i = 0; i < evs.size(); ++i) {
+            if (pollfds[i + 2].revents & POLLIN) {
+                handle_ev_input(evs[i]);
+            }
+        }
+    }
+}
+
+void MultiEvPlcEmu::handle_ev_input(const Ev& ev) {
+    auto raw_hp_message = message.get_raw_message_ptr();
+    const auto bytes_read = read(ev.bridge_fd, raw_hp_message, sizeof(slac::messages::homeplug_message));
+    if (bytes_read <= 0) {
+        return;
+    }
+
+    const auto mmtype = message.get_mmtype();
+
+    // every EV has its own modem
+    memcpy(raw_hp_message->ethernet_header.ether_shost, ev.mac.data(), ETH_ALEN);
+
+    if (mmtype == (slac::defs::MMTYPE_CM_SET_KEY | slac::defs::MMTYPE_MODE_REQ)) {
+        handle_set_key_req(message, ev.bridge_fd);
+        return;
+    }
+
+    // all EVs are heard by the one EVSE modem
+    write(evse_bridge_fd, raw_hp_message, bytes_read);
+
+    if (mmtype == (slac::defs::MMTYPE_CM_MNBC_SOUND | slac::defs::MMTYPE_MODE_IND)) {
+        attach_atten_profile(message, ev.mac.data(), evse_bridge_fd);
+    }
+}
+
+void MultiEvPlcEmu::handle_evse_input() {
+    auto raw_hp_message = message.get_raw_message_ptr();
+    const auto bytes_read = read(evse_bridge_fd, raw_hp_message, sizeof(slac::messages::homeplug_message));
+    if (bytes_read <= 0) {
+        return;
+    }
+
+    const auto mmtype = message.get_mmtype();
+
+    memcpy(raw_hp_message->ethernet_header.ether_shost, EVSE_MAC_ADDR, sizeof(EVSE_MAC_ADDR));
+
+    if (mmtype == (slac::defs::MMTYPE_CM_SET_KEY | slac::defs::MMTYPE_MODE_REQ)) {
+        handle_set_key_req(message, evse_bridge_fd);
+        return;
+    }
+
+    const auto dest = raw_hp_message->ethernet_header.ether_dhost;
+    for (const auto& ev : evs) {
+        if ((dest[0] & 0x01) || memcmp(dest, ev.mac.data(), ETH_ALEN) == 0) {
+            write(ev.bridge_fd, raw_hp_message, bytes_read);
+        }
+    }
+}
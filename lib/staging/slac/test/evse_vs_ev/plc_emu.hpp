@@ -3,10 +3,59 @@
 #ifndef TESTS_EVSE_VS_EV_PLC_EMU_HPP
 #define TESTS_EVSE_VS_EV_PLC_EMU_HPP
 
+#include <array>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <slac/slac.hpp>
+
 #include "socket_pair_bridge.hpp"
 
 void handle_ev_input(int ev_bridge_fd, int evse_bridge_fd);
 
 void handle_evse_input(int evse_bridge_fd, int ev_bridge_fd);
 
+// Emulates a charger with one PLC modem for all connectors and one modem per EV, so the EVSE modem hears all EVs.
+// Every EV is connected by its own datagram socket, all EVSE state machines share one socket.
+class MultiEvPlcEmu {
+public:
+    explicit MultiEvPlcEmu(int number_of_evs);
+    ~MultiEvPlcEmu();
+
+    MultiEvPlcEmu(const MultiEvPlcEmu&) = delete;
+    MultiEvPlcEmu& operator=(const MultiEvPlcEmu&) = delete;
+
+    int get_ev_socket(int ev) const {
+        return evs.at(ev).fd;
+    }
+
+    const uint8_t* get_ev_mac(int ev) const {
+        return evs.at(ev).mac.data();
+    }
+
+    // the socket of the EVSE modem, the caller takes the ownership
+    int release_evse_socket();
+
+private:
+    struct Ev {
+        int fd;
+        int bridge_fd;
+        std::array<uint8_t, ETH_ALEN> mac;
+    };
+
+    void loop();
+    void handle_ev_input(const Ev& ev);
+    void handle_evse_input();
+
+    std::vector<Ev> evs;
+    int evse_fd{-1};
+    int evse_bridge_fd{-1};
+    int event_fd{-1};
+
+    slac::messages::HomeplugMessage message;
+
+    std::thread loop_thread;
+};
+
 #endif // TESTS_EVSE_VS_EV_PLC_EMU_HPP
@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+// Checks that the SlacMux keeps receiving after an error was raised on its socket, like the ENETDOWN of a link flap.
+// The mux uses a connected UDP socket on the loopback interface, sending to the closed peer port raises
+// ECONNREFUSED on it.
+//
+// usage: mux_socket_error
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <slac/mux.hpp>
+
+using Clock = std::chrono::steady_clock;
+
+constexpr static uint8_t MUX_MAC_ADDR[ETH_ALEN] = {0x6e, 0x3f, 0x46, 0x32, 0xbf, 0xc6};
+constexpr static uint8_t EV_MAC_ADDR[ETH_ALEN] = {0x6e, 0x3f, 0x46, 0x32, 0xbf, 0x01};
+
+static int open_udp_socket(struct sockaddr_in& addr) {
+    const auto fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (fd == -1 || bind(fd, reinterpret_cast<struct sockaddr*>(&addr), len) == -1 ||
+        getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &len) == -1) {
+        perror("Couldn't open the UDP socket");
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+static void connect_to(int fd, const struct sockaddr_in& addr) {
+    if (connect(fd, reinterpret_cast<const struct sockaddr*>(&addr), sizeof(addr)) == -1) {
+        perror("Couldn't connect the UDP socket");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void send_slac_parm_req(int fd) {
+    slac::messages::cm_slac_parm_req req{};
+    slac::messages::HomeplugMessage msg;
+    msg.setup_ethernet_header(MUX_MAC_ADDR, EV_MAC_ADDR);
+    msg.setup_payload(&req, sizeof(req), slac::defs::MMTYPE_CM_SLAC_PARAM | slac::defs::MMTYPE_MODE_REQ,
+                      slac::defs::MMV::AV_1_0);
+    (void)send(fd, msg.get_raw_message_ptr(), msg.get_raw_msg_len(), 0);
+}
+
+static bool wait_for(const std::atomic<int>& value, int expected) {
+    const auto deadline = Clock::now() + std::chrono::seconds(5);
+    while (value < expected) {
+        if (Clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+auto main() -> int {
+    struct sockaddr_in mux_addr {};
+    struct sockaddr_in ev_addr {};
+    const auto mux_fd = open_udp_socket(mux_addr);
+    auto ev_fd = open_udp_socket(ev_addr);
+    connect_to(mux_fd, ev_addr);
+    connect_to(ev_fd, mux_addr);
+
+    auto mux = SlacMux::create(mux_fd, MUX_MAC_ADDR);
+    std::atomic<int> received{0};
+    auto endpoint = mux->connect([&received](slac::messages::HomeplugMessage&) { received++; });
+
+    send_slac_parm_req(ev_fd);
+    if (not wait_for(received, 1)) {
+        printf("FAILED: no frame received\n");
+        return EXIT_FAILURE;
+    }
+
+    // the EV goes away, the next frame sent by the mux is answered with an ICMP port unreachable
+    close(ev_fd);
+    slac::messages::cm_slac_parm_cnf cnf{};
+    slac::messages::HomeplugMessage msg;
+    msg.setup_ethernet_header(EV_MAC_ADDR);
+    msg.setup_payload(&cnf, sizeof(cnf), slac::defs::MMTYPE_CM_SLAC_PARAM | slac::defs::MMTYPE_MODE_CNF,
+                      slac::defs::MMV::AV_1_0);
+    endpoint->send(msg);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // and comes back on the same port
+    ev_fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (bind(ev_fd, reinterpret_cast<struct sockaddr*>(&ev_addr), sizeof(ev_addr)) == -1) {
+        perror("Couldn't bind the EV socket again");
+        return EXIT_FAILURE;
+    }
+    connect_to(ev_fd, mux_addr);
+
+    send_slac_parm_req(ev_fd);
+    const auto received_after_error = wait_for(received, 2);
+    close(ev_fd);
+
+    if (not received_after_error) {
+        printf("FAILED: no frame received after the socket error\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("OK: frames are received after the socket error\n");
+    return EXIT_SUCCESS;
+}
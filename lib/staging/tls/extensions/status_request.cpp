@@ -63,55 +63,44 @@ struct ocsp_cache_ctx {
 
 // ----------------------------------------------------------------------------
 // OcspCache
-OcspCache::OcspCache() : m_context(std::make_unique<ocsp_cache_ctx>()) {
+OcspCache::OcspCache() : m_context(std::make_shared<const ocsp_cache_ctx>()) {
 }
 
 OcspCache::~OcspCache() = default;
 
 bool OcspCache::load(const ocsp_entry_list_t& filenames) {
-    assert(m_context != nullptr);
-
     bool bResult{true};
 
-    if (filenames.empty()) {
-        // clear the cache
-        std::lock_guard lock(mux);
-        m_context->cache.clear();
-    } else {
-        std::map<digest_t, OCSP_RESPONSE_ptr> updates;
-        for (const auto& entry : filenames) {
-            const auto& digest = std::get<digest_t>(entry);
-            const auto* filename = std::get<const char*>(entry);
-
-            OCSP_RESPONSE* resp{nullptr};
+    // the new snapshot, an empty list clears the cache
+    auto updates = std::make_shared<ocsp_cache_ctx>();
+    for (const auto& entry : filenames) {
+        const auto& digest = std::get<digest_t>(entry);
+        const auto* filename = std::get<const char*>(entry);
 
-            if (filename != nullptr) {
-                resp = load_ocsp(filename);
-                if (resp == nullptr) {
-                    bResult = false;
-                }
-            }
+        OCSP_RESPONSE* resp{nullptr};
 
-            if (resp != nullptr) {
-                updates[digest] = std::shared_ptr<OCSP_RESPONSE>(resp, &::OCSP_RESPONSE_free);
+        if (filename != nullptr) {
+            resp = load_ocsp(filename);
+            if (resp == nullptr) {
+                bResult = false;
             }
         }
 
-        {
-            std::lock_guard lock(mux);
-            m_context->cache.swap(updates);
+        if (resp != nullptr) {
+            updates->cache[digest] = std::shared_ptr<OCSP_RESPONSE>(resp, &::OCSP_RESPONSE_free);
         }
     }
 
+    std::atomic_store(&m_context, std::shared_ptr<const ocsp_cache_ctx>(std::move(updates)));
     return bResult;
 }
 
 OcspCache::OcspResponse_t OcspCache::lookup(const digest_t& digest) {
-    assert(m_context != nullptr);
+    const auto snapshot = std::atomic_load(&m_context);
+    assert(snapshot != nullptr);
 
     OcspResponse_t resp;
-    std::lock_guard lock(mux);
-    if (const auto itt = m_context->cache.find(digest); itt != m_context->cache.end()) {
+    if (const auto itt = snapshot->cache.find(digest); itt != snapshot->cache.end()) {
         resp = itt->second;
     } else {
         log_error("OcspCache::lookup: not in cache: " + to_string(digest));
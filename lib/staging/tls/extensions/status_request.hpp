@@ -9,7 +9,6 @@
 
 #include <cstddef>
 #include <memory>
-#include <mutex>
 
 namespace tls {
 
@@ -21,6 +20,10 @@ struct ocsp_cache_ctx;
 /**
  * \brief cache of OCSP responses
  * \note responses can be updated at any time via load()
+ *
+ * The cached responses are an immutable snapshot that load() replaces as a
+ * whole. lookup() only takes a reference to the current snapshot so that
+ * handshakes never wait for responses being loaded.
  */
 class OcspCache {
 public:
@@ -30,8 +33,7 @@ public:
     using OcspResponse_t = std::shared_ptr<OcspResponse>;
 
 private:
-    std::unique_ptr<ocsp_cache_ctx> m_context; //!< opaque cache data
-    std::mutex mux;                            //!< protects the cached OCSP responses
+    std::shared_ptr<const ocsp_cache_ctx> m_context; //!< opaque cache data, access via std::atomic_load/store
 
 public:
     OcspCache();
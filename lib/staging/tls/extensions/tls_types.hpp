@@ -8,6 +8,7 @@
 
 #include <EnumFlags.hpp>
 
+union bio_addr_st;
 struct ocsp_response_st;
 struct ssl_ctx_st;
 struct ssl_st;
@@ -51,6 +52,7 @@ public:
 
 // opaque types
 
+using BioAddress = union ::bio_addr_st;
 using Certificate = struct ::x509_st;
 using OcspResponse = struct ::ocsp_response_st;
 using PKey = struct ::evp_pkey_st;
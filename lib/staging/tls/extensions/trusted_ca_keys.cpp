@@ -314,7 +314,7 @@ const chain_t* select(const trusted_ca_keys_t& extension, const chain_list& chai
 
 int ServerTrustedCaKeys::s_index{-1};
 
-ServerTrustedCaKeys::ServerTrustedCaKeys() {
+ServerTrustedCaKeys::ServerTrustedCaKeys() : m_chains(std::make_shared<const chain_list>()) {
     if (s_index == -1) {
         s_index = CRYPTO_get_ex_new_index(CRYPTO_EX_INDEX_SSL, 0, nullptr, nullptr, nullptr, nullptr);
     }
@@ -337,16 +337,12 @@ bool ServerTrustedCaKeys::init_ssl(SslContext* ctx) {
 }
 
 void ServerTrustedCaKeys::update(chain_list&& new_chains) {
-    std::lock_guard lock(m_mux);
-    m_chains = std::move(new_chains);
+    std::atomic_store(&m_chains,
+                      std::shared_ptr<const chain_list>(std::make_shared<chain_list>(std::move(new_chains))));
 }
 
-const chain_t* ServerTrustedCaKeys::select(const trusted_ca_keys_t& extension) {
-    return trusted_ca_keys::select(extension, m_chains);
-}
-
-const chain_t* ServerTrustedCaKeys::select_default() {
-    return (m_chains.empty()) ? nullptr : m_chains.data();
+std::shared_ptr<const chain_list> ServerTrustedCaKeys::chains() const {
+    return std::atomic_load(&m_chains);
 }
 
 int ServerTrustedCaKeys::trusted_ca_keys_cb(SSL* ctx, unsigned int ext_type, unsigned int context,
@@ -386,14 +382,14 @@ int ServerTrustedCaKeys::handle_certificate_cb(SSL* ssl, void* arg) {
      */
 
     if ((tck_p != nullptr) && (keys_p != nullptr) && (keys_p->flags.has_trusted_ca_keys())) {
-        // prevent update() from changing pointers
-        std::lock_guard lock(tck_p->m_mux);
+        // the snapshot keeps the chains valid while they are used
+        const auto chains = tck_p->chains();
 
-        const auto* selected = tck_p->select(keys_p->tck);
+        const auto* selected = trusted_ca_keys::select(keys_p->tck, *chains);
         if (selected != nullptr) {
             if (!use_certificate_and_key(ssl, *selected)) {
                 // setting failed - try and use the default
-                selected = tck_p->select_default();
+                selected = (chains->empty()) ? nullptr : chains->data();
                 if (selected != nullptr) {
                     if (!use_certificate_and_key(ssl, *selected)) {
                         // there has been a problem setting the server
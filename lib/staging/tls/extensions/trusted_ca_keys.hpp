@@ -7,7 +7,7 @@
 #include <extensions/tls_types.hpp>
 #include <openssl_util.hpp>
 
-#include <mutex>
+#include <memory>
 
 namespace tls::trusted_ca_keys {
 
@@ -128,9 +128,8 @@ struct server_trusted_ca_keys_t {
 /// \brief trusted_ca_keys extension handler for a TLS server
 class ServerTrustedCaKeys {
 private:
-    static int s_index;  //!< index used for storing per connection data
-    chain_list m_chains; //!< known certificate chains
-    std::mutex m_mux;    //!< protects m_chains
+    static int s_index;                        //!< index used for storing per connection data
+    std::shared_ptr<const chain_list> m_chains; //!< known certificate chains, access via std::atomic_load/store
 
 public:
     ServerTrustedCaKeys();
@@ -152,23 +151,15 @@ public:
      * \param[in] new_chains the chains to support
      * \note new_chains is moved to m_chains and hence will be empty after
      *       calling update()
+     * \note handshakes in progress keep using the previous chains
      */
     void update(chain_list&& new_chains);
 
     /**
-     * \brief select chain to use based on parsed extension
-     * \param[in] extension is the parsed extension
-     * \return a pointer to the chain (in m_chains) or nullptr when none match
-     * \note pointer will be invalid if update() called before it is used
+     * \brief obtain the current certificate chains
+     * \return the chains, they remain valid when update() is called
      */
-    const chain_t* select(const trusted_ca_keys_t& extension);
-
-    /**
-     * \brief select the default chain to use (first entry in m_chains)
-     * \return a pointer to the first chain (in m_chains) or nullptr on error
-     * \note pointer will be invalid if update() called before it is used
-     */
-    const chain_t* select_default();
+    [[nodiscard]] std::shared_ptr<const chain_list> chains() const;
 
     /**
      * \brief the OpenSSL callback for the trusted_ca_keys extension
@@ -198,8 +189,8 @@ public:
      * \param[in] arg A ServerTrustedCaKeys object
      * \return success = 1, error = zero or negative
      *
-     * Calls select() and select_default() after acquiring the mutex to ensure
-     * that calls to update() don't invalidate the pointers.
+     * Selects the chain from a snapshot of m_chains so that calls to update()
+     * don't invalidate it and don't block the handshake.
      */
     static int handle_certificate_cb(Ssl* ssl, void* arg);
 
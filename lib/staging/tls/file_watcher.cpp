@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#include "file_watcher.hpp"
+#include "openssl_util.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace {
+
+using ::openssl::log_error;
+
+constexpr std::uint32_t c_watch_mask = IN_CLOSE_WRITE | IN_MOVED_TO;
+
+/**
+ * \brief watch the directories containing files
+ * \note files may be replaced or not exist yet, hence the directories are watched
+ */
+bool add_watches(int inotify_fd, const std::vector<std::string>& files) {
+    for (const auto& file : files) {
+        const auto pos = file.find_last_of('/');
+        const auto directory =
+            (pos == std::string::npos) ? std::string(".") : file.substr(0, std::max<std::size_t>(pos, 1));
+        if (inotify_add_watch(inotify_fd, directory.c_str(), c_watch_mask) == -1) {
+            log_error("FileWatcher::inotify_add_watch: " + directory + " " + std::to_string(errno));
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+namespace tls {
+
+FileWatcher::~FileWatcher() {
+    stop();
+}
+
+bool FileWatcher::start(const std::vector<std::string>& files, const Callback& callback, std::uint32_t settle_ms) {
+    stop();
+    std::lock_guard lock(m_mutex);
+
+    const int inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd == -1) {
+        log_error("FileWatcher::inotify_init1: " + std::to_string(errno));
+        return false;
+    }
+
+    bool result = !files.empty() && add_watches(inotify_fd, files);
+
+    if (result) {
+        m_wakeup_fd = eventfd(0, EFD_CLOEXEC);
+        if (m_wakeup_fd == -1) {
+            log_error("FileWatcher::eventfd: " + std::to_string(errno));
+            result = false;
+        }
+    }
+
+    if (result) {
+        {
+            std::lock_guard watch_lock(m_watch_mutex);
+            m_inotify_fd = inotify_fd;
+        }
+        m_thread = std::thread(&FileWatcher::run, this, inotify_fd, callback, settle_ms);
+    } else {
+        close(inotify_fd);
+    }
+    return result;
+}
+
+bool FileWatcher::watch(const std::vector<std::string>& files) {
+    std::lock_guard lock(m_watch_mutex);
+    return (m_inotify_fd != -1) && add_watches(m_inotify_fd, files);
+}
+
+void FileWatcher::stop() {
+    std::lock_guard lock(m_mutex);
+    if (m_thread.joinable()) {
+        const std::uint64_t value{1};
+        (void)write(m_wakeup_fd, &value, sizeof(value));
+        m_thread.join();
+    }
+    if (m_wakeup_fd != -1) {
+        close(m_wakeup_fd);
+        m_wakeup_fd = -1;
+    }
+    std::lock_guard watch_lock(m_watch_mutex);
+    if (m_inotify_fd != -1) {
+        close(m_inotify_fd);
+        m_inotify_fd = -1;
+    }
+}
+
+void FileWatcher::run(int inotify_fd, Callback callback, std::uint32_t settle_ms) {
+    using clock = std::chrono::steady_clock;
+
+    bool changed{false};
+    clock::time_point deadline{};
+    alignas(inotify_event) std::array<char, 4096> buffer{};
+    std::array<pollfd, 2> fds = {{{inotify_fd, POLLIN, 0}, {m_wakeup_fd, POLLIN, 0}}};
+
+    for (;;) {
+        int timeout_ms{-1};
+        if (changed) {
+            const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - clock::now()).count();
+            timeout_ms = static_cast<int>(std::max<std::int64_t>(remaining, 0));
+        }
+
+        const auto res = poll(fds.data(), fds.size(), timeout_ms);
+        if ((res == -1) && (errno != EINTR)) {
+            log_error("FileWatcher::poll: " + std::to_string(errno));
+            break;
+        }
+
+        if ((res > 0) && ((fds[1].revents & POLLIN) != 0)) {
+            // stop()
+            break;
+        }
+
+        if ((res > 0) && ((fds[0].revents & POLLIN) != 0)) {
+            ssize_t len{0};
+            while ((len = read(inotify_fd, buffer.data(), buffer.size())) > 0) {
+                for (ssize_t offset = 0; offset < len;) {
+                    const auto* event = reinterpret_cast<const inotify_event*>(&buffer[offset]);
+                    offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+                    if (event->len > 0) {
+                        // restart the settle time on every change
+                        changed = true;
+                        deadline = clock::now() + std::chrono::milliseconds(settle_ms);
+                    }
+                }
+            }
+        }
+
+        if (changed && (clock::now() >= deadline)) {
+            changed = false;
+            callback();
+        }
+    }
+}
+
+} // namespace tls
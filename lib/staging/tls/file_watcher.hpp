@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#ifndef FILE_WATCHER_HPP_
+#define FILE_WATCHER_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tls {
+
+// ----------------------------------------------------------------------------
+// FileWatcher - notification when files change
+
+/**
+ * \brief call a function after files have been changed
+ *
+ * Uses inotify on the directories containing the files so that files which
+ * are replaced (written to a temporary file and renamed) or don't exist yet
+ * are detected. Any file written or moved into a watched directory counts as
+ * a change, e.g. a certificate that is renewed under a new filename.
+ *
+ * Changes are collected until there hasn't been a further change for
+ * settle_ms, then the callback is called once from the watcher thread.
+ */
+class FileWatcher {
+public:
+    using Callback = std::function<void()>;
+
+private:
+    std::thread m_thread;     //!< watcher thread
+    int m_wakeup_fd{-1};      //!< eventfd used by stop()
+    int m_inotify_fd{-1};     //!< inotify instance of the running watch
+    std::mutex m_mutex;       //!< serialises start() and stop()
+    std::mutex m_watch_mutex; //!< protects m_inotify_fd, watch() may be called from the callback
+
+    /**
+     * \brief wait for changes until stop() is called
+     * \param[in] inotify_fd inotify instance
+     * \param[in] callback called after changes
+     * \param[in] settle_ms time without further changes before calling callback
+     */
+    void run(int inotify_fd, Callback callback, std::uint32_t settle_ms);
+
+public:
+    FileWatcher() = default;
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher(FileWatcher&&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+    FileWatcher& operator=(FileWatcher&&) = delete;
+    ~FileWatcher();
+
+    /**
+     * \brief start watching files
+     * \param[in] files the files to watch, their directories must exist
+     * \param[in] callback called from the watcher thread after files changed
+     * \param[in] settle_ms time without further changes before calling callback
+     * \return true when watching started
+     * \note a previous watch is stopped
+     */
+    bool start(const std::vector<std::string>& files, const Callback& callback, std::uint32_t settle_ms);
+
+    /**
+     * \brief additionally watch the directories of further files
+     * \param[in] files the files to watch, their directories must exist
+     * \return true when the files are being watched
+     * \note can be called from the callback, e.g. when files have been moved
+     *       to another directory
+     */
+    bool watch(const std::vector<std::string>& files);
+
+    /**
+     * \brief stop watching files
+     * \note waits for a running callback to complete, must not be called from the callback
+     */
+    void stop();
+};
+
+} // namespace tls
+
+#endif // FILE_WATCHER_HPP_
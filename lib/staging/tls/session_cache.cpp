@@ -0,0 +1,398 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#include "session_cache.hpp"
+#include "openssl_util.hpp"
+
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/ssl.h>
+
+using ::openssl::log_error;
+
+namespace {
+
+/// all server contexts share the same session ID context so that sessions
+/// remain valid when the SSL context is replaced
+constexpr std::array<unsigned char, 19> c_session_id_context = {'E', 'V', 'e', 'r', 'e', 's', 't', ' ', 't', 'l',
+                                                                's', ':', ':', 'S', 'e', 'r', 'v', 'e', 'r'};
+
+constexpr std::size_t c_ticket_key_name_size = 16;
+constexpr std::size_t c_ticket_aes_key_size = 32;
+constexpr std::size_t c_ticket_hmac_key_size = 32;
+
+struct SslSessionDeleter {
+    void operator()(SSL_SESSION* ptr) const {
+        ::SSL_SESSION_free(ptr);
+    }
+};
+
+using SSL_SESSION_ptr = std::unique_ptr<SSL_SESSION, SslSessionDeleter>;
+
+struct ticket_key_t {
+    std::array<unsigned char, c_ticket_key_name_size> name{};
+    std::array<unsigned char, c_ticket_aes_key_size> aes_key{};
+    std::array<unsigned char, c_ticket_hmac_key_size> hmac_key{};
+    std::chrono::steady_clock::time_point created;
+
+    ticket_key_t() = default;
+    ticket_key_t(const ticket_key_t&) = delete;
+    ticket_key_t(ticket_key_t&&) = default;
+    ticket_key_t& operator=(const ticket_key_t&) = delete;
+    ticket_key_t& operator=(ticket_key_t&&) = default;
+    ~ticket_key_t() {
+        OPENSSL_cleanse(aes_key.data(), aes_key.size());
+        OPENSSL_cleanse(hmac_key.data(), hmac_key.size());
+    }
+};
+
+/**
+ * \brief initialise the HMAC used to authenticate a session ticket
+ * \param[in] mac_ctx the HMAC to initialise
+ * \param[in] key the ticket key
+ * \return true on success
+ */
+bool init_ticket_mac(EVP_MAC_CTX* mac_ctx, ticket_key_t& key) {
+    std::array<char, 7> digest{"SHA256"};
+    const std::array<OSSL_PARAM, 3> params = {{
+        OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.hmac_key.data(), key.hmac_key.size()),
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest.data(), 0),
+        OSSL_PARAM_construct_end(),
+    }};
+    return EVP_MAC_CTX_set_params(mac_ctx, params.data()) == 1;
+}
+
+} // namespace
+
+namespace tls {
+
+struct session_cache_ctx {
+    using session_id_t = std::vector<unsigned char>;
+    struct entry_t {
+        SSL_SESSION_ptr session;
+        std::list<session_id_t>::iterator lru;
+    };
+
+    ServerSessionCache::config_t config;
+    bool cache_enabled{false};
+    bool tickets_enabled{false};
+    openssl::sha_1_digest_t certificate{};
+
+    std::map<session_id_t, entry_t> sessions;
+    std::list<session_id_t> lru;          //!< most recently used session first
+    std::deque<ticket_key_t> ticket_keys; //!< current key first
+
+    void clear_sessions() {
+        sessions.clear();
+        lru.clear();
+    }
+
+    void erase(std::map<session_id_t, entry_t>::iterator it) {
+        lru.erase(it->second.lru);
+        sessions.erase(it);
+    }
+};
+
+namespace {
+
+ServerSessionCache* get_cache(const SSL_CTX* ctx, int index) {
+    if ((ctx == nullptr) || (index == -1)) {
+        return nullptr;
+    }
+    return reinterpret_cast<ServerSessionCache*>(SSL_CTX_get_ex_data(ctx, index));
+}
+
+std::once_flag s_index_once; //!< caches can be created concurrently by several servers
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+// ServerSessionCache
+
+int ServerSessionCache::s_index{-1};
+
+ServerSessionCache::ServerSessionCache() : m_context(std::make_unique<session_cache_ctx>()) {
+    std::call_once(s_index_once, []() {
+        s_index = CRYPTO_get_ex_new_index(CRYPTO_EX_INDEX_SSL_CTX, 0, nullptr, nullptr, nullptr, nullptr);
+    });
+}
+
+ServerSessionCache::~ServerSessionCache() = default;
+
+bool ServerSessionCache::init_ssl(SSL_CTX* ctx, const config_t& config) {
+    assert(ctx != nullptr);
+    bool result{true};
+
+    const bool enabled = config.session_timeout_s > 0;
+    const bool use_cache = enabled && (config.cache_size > 0);
+    const bool use_tickets = enabled && config.tickets;
+
+    openssl::sha_1_digest_t certificate{};
+    const auto* cert = SSL_CTX_get0_certificate(ctx);
+    if ((cert == nullptr) || !openssl::certificate_sha_1(certificate, cert)) {
+        certificate = {};
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        if ((certificate != m_context->certificate) || !use_cache) {
+            m_context->clear_sessions();
+        }
+        if ((certificate != m_context->certificate) || !use_tickets) {
+            m_context->ticket_keys.clear();
+        }
+        m_context->certificate = certificate;
+        m_context->config = config;
+        m_context->cache_enabled = use_cache;
+        m_context->tickets_enabled = use_tickets;
+    }
+
+    if (SSL_CTX_set_ex_data(ctx, s_index, this) != 1) {
+        log_error("SSL_CTX_set_ex_data");
+        result = false;
+    }
+
+    if (SSL_CTX_set_session_id_context(ctx, c_session_id_context.data(), c_session_id_context.size()) != 1) {
+        log_error("SSL_CTX_set_session_id_context");
+        result = false;
+    }
+
+    if (enabled) {
+        SSL_CTX_set_timeout(ctx, static_cast<long>(config.session_timeout_s));
+    }
+
+    if (use_cache) {
+        // only use the external cache so that sessions survive a new SSL context
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL |
+                                                SSL_SESS_CACHE_NO_AUTO_CLEAR);
+        SSL_CTX_sess_set_new_cb(ctx, &new_session_cb);
+        SSL_CTX_sess_set_get_cb(ctx, &get_session_cb);
+        SSL_CTX_sess_set_remove_cb(ctx, &remove_session_cb);
+    } else {
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+    }
+
+    if (use_tickets) {
+        SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+        if (SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, &ticket_key_cb) != 1) {
+            log_error("SSL_CTX_set_tlsext_ticket_key_evp_cb");
+            result = false;
+        }
+    } else {
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+    }
+
+    // TLS 1.3 tickets are stateful (held in the cache) when SSL_OP_NO_TICKET is set
+    const std::size_t tls13_tickets = (use_tickets || use_cache) ? config.tls13_tickets : 0;
+    if (SSL_CTX_set_num_tickets(ctx, tls13_tickets) != 1) {
+        log_error("SSL_CTX_set_num_tickets");
+        result = false;
+    }
+
+    return result;
+}
+
+void ServerSessionCache::flush() {
+    std::lock_guard lock(m_mutex);
+    m_context->clear_sessions();
+    m_context->ticket_keys.clear();
+}
+
+ServerSessionCache::statistics_t ServerSessionCache::statistics() const {
+    statistics_t result;
+    result.full_handshakes = m_full;
+    result.resumed_handshakes = m_resumed;
+    std::lock_guard lock(m_mutex);
+    result.cached_sessions = m_context->sessions.size();
+    result.ticket_keys = m_context->ticket_keys.size();
+    return result;
+}
+
+void ServerSessionCache::expire() {
+    const auto now = std::time(nullptr);
+    for (auto it = m_context->sessions.begin(); it != m_context->sessions.end();) {
+        const auto* session = it->second.session.get();
+        if ((SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session)) <= now) {
+            auto tmp = it++;
+            m_context->erase(tmp);
+        } else {
+            ++it;
+        }
+    }
+
+    // a key is used for ticket_key_rotation_s and then accepted for the lifetime of its last ticket
+    const auto key_lifetime = std::chrono::seconds(m_context->config.ticket_key_rotation_s) +
+                              std::chrono::seconds(m_context->config.session_timeout_s);
+    const auto steady_now = std::chrono::steady_clock::now();
+    auto& keys = m_context->ticket_keys;
+    while (!keys.empty() && ((steady_now - keys.back().created) >= key_lifetime)) {
+        keys.pop_back();
+    }
+}
+
+void ServerSessionCache::handshake_complete(SSL* ctx) {
+    assert(ctx != nullptr);
+    auto* cache = get_cache(SSL_get_SSL_CTX(ctx), s_index);
+    if (cache != nullptr) {
+        if (SSL_session_reused(ctx) == 1) {
+            cache->m_resumed++;
+        } else {
+            cache->m_full++;
+        }
+    }
+}
+
+int ServerSessionCache::new_session_cb(SSL* ctx, SSL_SESSION* session) {
+    auto* cache = get_cache(SSL_get_SSL_CTX(ctx), s_index);
+    if (cache == nullptr) {
+        return 0;
+    }
+
+    unsigned int length{0};
+    const auto* id = SSL_SESSION_get_id(session, &length);
+    if ((id == nullptr) || (length == 0)) {
+        return 0;
+    }
+
+    std::lock_guard lock(cache->m_mutex);
+    auto& context = *cache->m_context;
+    if (!context.cache_enabled) {
+        return 0;
+    }
+
+    cache->expire();
+
+    session_cache_ctx::session_id_t key(id, id + length);
+    if (const auto it = context.sessions.find(key); it != context.sessions.end()) {
+        context.erase(it);
+    }
+    while (!context.lru.empty() && (context.sessions.size() >= context.config.cache_size)) {
+        context.erase(context.sessions.find(context.lru.back()));
+    }
+
+    context.lru.push_front(key);
+    context.sessions.emplace(std::move(key), session_cache_ctx::entry_t{SSL_SESSION_ptr(session), context.lru.begin()});
+    return 1;
+}
+
+SSL_SESSION* ServerSessionCache::get_session_cb(SSL* ctx, const unsigned char* id, int len, int* copy) {
+    auto* cache = get_cache(SSL_get_SSL_CTX(ctx), s_index);
+    if ((cache == nullptr) || (id == nullptr) || (len <= 0)) {
+        return nullptr;
+    }
+
+    std::lock_guard lock(cache->m_mutex);
+    auto& context = *cache->m_context;
+    const auto it = context.sessions.find(session_cache_ctx::session_id_t(id, id + len));
+    if (it == context.sessions.end()) {
+        return nullptr;
+    }
+
+    if (SSL_version(ctx) >= TLS1_3_VERSION) {
+        // TLS 1.3 tickets are single use, the reference is passed to OpenSSL
+        auto* session = it->second.session.release();
+        context.erase(it);
+        *copy = 0;
+        return session;
+    }
+
+    context.lru.splice(context.lru.begin(), context.lru, it->second.lru);
+    // OpenSSL takes its own reference
+    *copy = 1;
+    return it->second.session.get();
+}
+
+void ServerSessionCache::remove_session_cb(SSL_CTX* ctx, SSL_SESSION* session) {
+    auto* cache = get_cache(ctx, s_index);
+    if (cache == nullptr) {
+        return;
+    }
+
+    unsigned int length{0};
+    const auto* id = SSL_SESSION_get_id(session, &length);
+
+    std::lock_guard lock(cache->m_mutex);
+    auto& context = *cache->m_context;
+    const auto it = context.sessions.find(session_cache_ctx::session_id_t(id, id + length));
+    if ((it != context.sessions.end()) && (it->second.session.get() == session)) {
+        context.erase(it);
+    }
+}
+
+int ServerSessionCache::ticket_key_cb(SSL* ctx, unsigned char* key_name, unsigned char* iv,
+                                      EVP_CIPHER_CTX* cipher_ctx, EVP_MAC_CTX* mac_ctx, int enc) {
+    auto* cache = get_cache(SSL_get_SSL_CTX(ctx), s_index);
+    if (cache == nullptr) {
+        return -1;
+    }
+
+    const auto* cipher = EVP_aes_256_cbc();
+    std::lock_guard lock(cache->m_mutex);
+    auto& context = *cache->m_context;
+    auto& keys = context.ticket_keys;
+    const auto rotation = std::chrono::seconds(context.config.ticket_key_rotation_s);
+    const auto now = std::chrono::steady_clock::now();
+
+    if (enc == 1) {
+        cache->expire();
+        if (keys.empty() || ((now - keys.front().created) >= rotation)) {
+            ticket_key_t key;
+            if ((RAND_bytes(key.name.data(), key.name.size()) != 1) ||
+                (RAND_priv_bytes(key.aes_key.data(), key.aes_key.size()) != 1) ||
+                (RAND_priv_bytes(key.hmac_key.data(), key.hmac_key.size()) != 1)) {
+                log_error("ticket_key_cb::RAND_bytes");
+                return -1;
+            }
+            key.created = now;
+            keys.push_front(std::move(key));
+        }
+
+        auto& key = keys.front();
+        std::memcpy(key_name, key.name.data(), key.name.size());
+        if (RAND_bytes(iv, EVP_CIPHER_get_iv_length(cipher)) != 1) {
+            log_error("ticket_key_cb::RAND_bytes");
+            return -1;
+        }
+        if (EVP_EncryptInit_ex(cipher_ctx, cipher, nullptr, key.aes_key.data(), iv) != 1) {
+            log_error("ticket_key_cb::EVP_EncryptInit_ex");
+            return -1;
+        }
+        if (!init_ticket_mac(mac_ctx, key)) {
+            log_error("ticket_key_cb::EVP_MAC_CTX_set_params");
+            return -1;
+        }
+        return 1;
+    }
+
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        if (std::memcmp(key_name, it->name.data(), it->name.size()) == 0) {
+            if ((EVP_DecryptInit_ex(cipher_ctx, cipher, nullptr, it->aes_key.data(), iv) != 1) ||
+                !init_ticket_mac(mac_ctx, *it)) {
+                log_error("ticket_key_cb::EVP_DecryptInit_ex");
+                return -1;
+            }
+            // renew tickets that were not issued with the current key, TLS 1.3
+            // clients use a ticket once so it is always replaced
+            const bool current = (it == keys.begin()) && ((now - it->created) < rotation);
+            return (current && (SSL_version(ctx) <= TLS1_2_VERSION)) ? 1 : 2;
+        }
+    }
+
+    // unknown or expired key - full handshake
+    return 0;
+}
+
+} // namespace tls
@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#ifndef SESSION_CACHE_HPP_
+#define SESSION_CACHE_HPP_
+
+#include "extensions/tls_types.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+struct ssl_session_st;
+struct evp_cipher_ctx_st;
+struct evp_mac_ctx_st;
+
+namespace tls {
+
+struct session_cache_ctx;
+
+// ----------------------------------------------------------------------------
+// TLS session resumption (server side)
+
+/**
+ * \brief session resumption support for a TLS server
+ *
+ * Supports TLS 1.2 resumption via session IDs (RFC 5246) and session tickets
+ * (RFC 5077) and TLS 1.3 resumption via PSK tickets (RFC 8446).
+ *
+ * Sessions and ticket keys are held outside of the SSL context so that they
+ * survive Server::update() which creates a new SSL context. They are discarded
+ * when the server certificate changes.
+ *
+ * Ticket keys are rotated after ticket_key_rotation_s. Older keys are kept for
+ * session_timeout_s so that tickets issued with them can still be used, these
+ * tickets are renewed on use.
+ */
+class ServerSessionCache {
+public:
+    struct config_t {
+        std::uint32_t session_timeout_s{0};        //!< lifetime of resumable sessions, 0 disables resumption
+        std::size_t cache_size{256};               //!< maximum number of cached sessions, 0 disables the cache
+        bool tickets{true};                        //!< stateless TLS 1.2 session tickets and TLS 1.3 PSK tickets
+        std::uint32_t ticket_key_rotation_s{3600}; //!< lifetime of a ticket encryption key
+        std::size_t tls13_tickets{1};              //!< number of TLS 1.3 tickets sent after a full handshake
+    };
+
+    struct statistics_t {
+        std::uint64_t full_handshakes{0};    //!< handshakes including certificate exchange
+        std::uint64_t resumed_handshakes{0}; //!< abbreviated handshakes
+        std::size_t cached_sessions{0};      //!< sessions in the cache
+        std::size_t ticket_keys{0};          //!< ticket keys that are still accepted
+    };
+
+private:
+    static int s_index;                          //!< index used for storing the cache in the SSL context
+    std::unique_ptr<session_cache_ctx> m_context; //!< opaque cache data
+    mutable std::mutex m_mutex;                  //!< protects m_context
+    std::atomic<std::uint64_t> m_full{0};        //!< number of full handshakes
+    std::atomic<std::uint64_t> m_resumed{0};     //!< number of resumed handshakes
+
+    /**
+     * \brief remove expired sessions and ticket keys
+     * \note m_mutex must be held
+     */
+    void expire();
+
+public:
+    ServerSessionCache();
+    ServerSessionCache(const ServerSessionCache&) = delete;
+    ServerSessionCache(ServerSessionCache&&) = delete;
+    ServerSessionCache& operator=(const ServerSessionCache&) = delete;
+    ServerSessionCache& operator=(ServerSessionCache&&) = delete;
+    ~ServerSessionCache();
+
+    /**
+     * \brief configure session resumption for the SSL context
+     * \param[inout] ctx the context to configure, the server certificate must
+     *               already be set
+     * \param[in] config session resumption configuration
+     * \return true on success
+     * \note cached sessions and ticket keys are discarded when the server
+     *       certificate differs from the one of the previous context
+     */
+    bool init_ssl(SslContext* ctx, const config_t& config);
+
+    /**
+     * \brief remove all cached sessions and ticket keys
+     */
+    void flush();
+
+    /**
+     * \brief obtain handshake counters and cache usage
+     * \return the current statistics
+     */
+    [[nodiscard]] statistics_t statistics() const;
+
+    /**
+     * \brief update handshake counters once the handshake has completed
+     * \param[in] ctx the connection context
+     */
+    static void handshake_complete(Ssl* ctx);
+
+    /**
+     * \brief the OpenSSL callback when a new session has been established
+     * \param[in] ctx the connection context
+     * \param[in] session the new session
+     * \return 1 when the session is cached (a reference is kept)
+     */
+    static int new_session_cb(Ssl* ctx, struct ::ssl_session_st* session);
+
+    /**
+     * \brief the OpenSSL callback to look up a session by ID
+     * \param[in] ctx the connection context
+     * \param[in] id the session ID
+     * \param[in] len length of the session ID
+     * \param[out] copy set to 1 so that OpenSSL takes a reference
+     * \return the session or nullptr
+     */
+    static struct ::ssl_session_st* get_session_cb(Ssl* ctx, const unsigned char* id, int len, int* copy);
+
+    /**
+     * \brief the OpenSSL callback when a session is no longer valid
+     * \param[in] ctx the SSL context
+     * \param[in] session the invalid session
+     */
+    static void remove_session_cb(SslContext* ctx, struct ::ssl_session_st* session);
+
+    /**
+     * \brief the OpenSSL callback to encrypt and decrypt session tickets
+     * \param[in] ctx the connection context
+     * \param[inout] key_name name of the key, set when encrypting
+     * \param[inout] iv initialisation vector, set when encrypting
+     * \param[in] cipher_ctx cipher to initialise
+     * \param[in] mac_ctx HMAC to initialise
+     * \param[in] enc 1 when encrypting a new ticket, 0 when decrypting
+     * \return 1 success, 2 success and the ticket should be renewed,
+     *         0 ticket key not found, -1 error
+     */
+    static int ticket_key_cb(Ssl* ctx, unsigned char* key_name, unsigned char* iv,
+                             struct ::evp_cipher_ctx_st* cipher_ctx, struct ::evp_mac_ctx_st* mac_ctx, int enc);
+};
+
+} // namespace tls
+
+#endif // SESSION_CACHE_HPP_
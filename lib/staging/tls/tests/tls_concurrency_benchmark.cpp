@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+/*
+ * concurrent handshakes per second
+ *
+ * Several client threads repeatedly connect to a server on localhost, run the
+ * TLS handshake and echo one byte. The server runs either one thread per
+ * connection (Server::serve() with a ConnectionHandler) or the event driven
+ * Server::serve() where one thread serves all connections.
+ *
+ * needs the test PKI (see pki.sh) in the working directory
+ */
+
+#include <tls.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using result_t = tls::Connection::result_t;
+
+const char* short_opts = "hc:d:3";
+int clients{16};
+int duration_s{3};
+bool use_tls1_3{false};
+
+void parse_options(int argc, char** argv) {
+    int c;
+
+    while ((c = getopt(argc, argv, short_opts)) != -1) {
+        switch (c) {
+        case 'c':
+            clients = std::max(1, std::atoi(optarg));
+            break;
+        case 'd':
+            duration_s = std::max(1, std::atoi(optarg));
+            break;
+        case '3':
+            use_tls1_3 = true;
+            break;
+        case 'h':
+        case '?':
+            std::cout << "Usage: " << argv[0] << " [-c clients] [-d seconds] [-3]" << std::endl;
+            std::cout << "       -c number of concurrent clients (default 16)" << std::endl;
+            std::cout << "       -d duration of each run in seconds (default 3)" << std::endl;
+            std::cout << "       -3 use TLS 1.3 (TLS 1.2 otherwise)" << std::endl;
+            exit(1);
+            break;
+        default:
+            exit(2);
+        }
+    }
+}
+
+// thread per connection
+void handle_connection(tls::Server::ConnectionPtr&& con) {
+    std::thread([connection = std::move(con)]() {
+        if (connection->accept() == result_t::success) {
+            std::array<std::byte, 64> buffer{};
+            std::size_t readbytes = 0;
+            std::size_t writebytes = 0;
+            while (connection->read(buffer.data(), buffer.size(), readbytes) == result_t::success) {
+                if (connection->write(buffer.data(), readbytes, writebytes) != result_t::success) {
+                    break;
+                }
+            }
+            connection->shutdown();
+        }
+    }).detach();
+}
+
+// event driven
+void event_echo(tls::ServerConnection& connection) {
+    std::array<std::byte, 64> buffer{};
+    std::size_t readbytes = 0;
+    while (connection.read(buffer.data(), buffer.size(), readbytes, 0) == result_t::success) {
+        connection.queue_write(buffer.data(), readbytes);
+    }
+}
+
+void client_loop(const tls::Client::config_t& config, Clock::time_point end, std::atomic_uint64_t& handshakes,
+                 std::atomic_uint64_t& failed) {
+    tls::Client client;
+    client.init(config);
+    while (Clock::now() < end) {
+        auto connection = client.connect("localhost", "8444", false, 1000);
+        bool success{false};
+        if (connection && (connection->connect() == result_t::success)) {
+            const std::byte data{0x5a};
+            std::byte buf{0};
+            std::size_t bytes = 0;
+            success = (connection->write(&data, sizeof(data), bytes) == result_t::success) &&
+                      (connection->read(&buf, sizeof(buf), bytes) == result_t::success) && (buf == data);
+            connection->shutdown();
+        }
+        if (success) {
+            handshakes++;
+        } else {
+            failed++;
+        }
+    }
+}
+
+void run(bool event_driven) {
+    tls::Server server;
+    tls::Server::config_t server_config;
+
+    server_config.cipher_list = "ECDHE-ECDSA-AES128-SHA256";
+    server_config.ciphersuites = (use_tls1_3) ? "TLS_AES_128_GCM_SHA256" : "";
+    auto& ref0 = server_config.chains.emplace_back();
+    ref0.certificate_chain_file = "server_chain.pem";
+    ref0.private_key_file = "server_priv.pem";
+    ref0.trust_anchor_file = "server_root_cert.pem";
+    ref0.ocsp_response_files = {"ocsp_response.der", "ocsp_response.der"};
+    server_config.host = "localhost";
+    server_config.service = "8444";
+    server_config.ipv6_only = false;
+    server_config.verify_client = false;
+    server_config.io_timeout_ms = 1000;
+
+    tls::Client::config_t client_config;
+    client_config.cipher_list = "ECDHE-ECDSA-AES128-SHA256";
+    client_config.ciphersuites = (use_tls1_3) ? "TLS_AES_128_GCM_SHA256" : "";
+    client_config.verify_locations_file = "server_root_cert.pem";
+    client_config.io_timeout_ms = 1000;
+    client_config.verify_server = true;
+
+    using state_t = tls::Server::state_t;
+    const auto res = server.init(server_config, nullptr);
+    if ((res != state_t::init_complete) && (res != state_t::init_socket)) {
+        std::cerr << "server init failed" << std::endl;
+        return;
+    }
+
+    tls::Server::event_handlers_t handlers;
+    handlers.readable = &event_echo;
+    std::thread server_thread([&server, &handlers, event_driven]() {
+        if (event_driven) {
+            server.serve(handlers);
+        } else {
+            server.serve(&handle_connection);
+        }
+    });
+    server.wait_running();
+
+    std::atomic_uint64_t handshakes{0};
+    std::atomic_uint64_t failed{0};
+    const auto start = Clock::now();
+    const auto end = start + std::chrono::seconds(duration_s);
+    std::vector<std::thread> client_threads;
+    for (int i = 0; i < clients; i++) {
+        client_threads.emplace_back(&client_loop, std::cref(client_config), end, std::ref(handshakes),
+                                    std::ref(failed));
+    }
+    for (auto& thread : client_threads) {
+        thread.join();
+    }
+    const auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    server.stop();
+    server.wait_stopped();
+    server_thread.join();
+    tls::ServerConnection::wait_all_closed();
+
+    std::cout << ((event_driven) ? "event driven         : " : "thread per connection: ") << clients << " clients, "
+              << static_cast<double>(handshakes) / elapsed << " handshakes/s";
+    if (failed > 0) {
+        std::cout << ", " << failed << " failed";
+    }
+    std::cout << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    parse_options(argc, argv);
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &action, nullptr);
+    tls::Server::configure_signal_handler(SIGUSR1);
+
+    std::cout << ((use_tls1_3) ? "TLS 1.3" : "TLS 1.2") << std::endl;
+    run(false);
+    run(true);
+
+    return 0;
+}
@@ -17,9 +17,16 @@
 
 #include "tls_connection_test.hpp"
 
+#include <arpa/inet.h>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
 #include <memory>
 #include <mutex>
+#include <netinet/in.h>
 #include <poll.h>
+#include <sys/socket.h>
+#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -60,6 +67,28 @@ tls::Server::OptionalConfig ssl_init() {
     return {{std::move(server_config)}};
 }
 
+/**
+ * \brief connect, exchange data with the echo handler and disconnect
+ * \param[in] connection the client connection
+ * \param[out] reused set when the session was resumed
+ * \return true when data was echoed
+ * \note the exchange makes sure that TLS 1.3 tickets have been received
+ */
+bool echo_check_reused(tls::Client::ConnectionPtr& connection, bool& reused) {
+    bool result{false};
+    if (connection && (connection->connect() == result_t::success)) {
+        reused = connection->session_reused();
+        const std::byte data{0xa5};
+        std::byte buf{0};
+        std::size_t writebytes{0};
+        std::size_t readbytes{0};
+        result = (connection->write(&data, sizeof(data), writebytes) == result_t::success) &&
+                 (connection->read(&buf, sizeof(buf), readbytes) == result_t::success) && (buf == data);
+        connection->shutdown();
+    }
+    return result;
+}
+
 // ----------------------------------------------------------------------------
 // The tests
 
@@ -826,4 +855,426 @@ TEST_F(TlsTest, TCKeysInvalid) {
     EXPECT_EQ(subject["CN"], server_root_CN);
 }
 
+TEST_F(TlsTest, SessionResumptionDisabled) {
+    // resumption is disabled by default
+    client_config.session_resumption = true;
+    start();
+
+    bool reused{true};
+    bool echoed{false};
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+    EXPECT_FALSE(reused);
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+    EXPECT_FALSE(reused);
+
+    const auto stats = server.session_statistics();
+    EXPECT_EQ(stats.full_handshakes, 2);
+    EXPECT_EQ(stats.resumed_handshakes, 0);
+    EXPECT_EQ(stats.cached_sessions, 0);
+    EXPECT_EQ(stats.ticket_keys, 0);
+}
+
+TEST_F(TlsTest, SessionIdTLS12) {
+    server_config.session_resumption.session_timeout_s = 300;
+    server_config.session_resumption.tickets = false;
+    client_config.session_resumption = true;
+    start();
+
+    bool reused{true};
+    bool echoed{false};
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+    EXPECT_FALSE(reused);
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+    EXPECT_TRUE(reused);
+
+    const auto stats = server.session_statistics();
+    EXPECT_EQ(stats.full_handshakes, 1);
+    EXPECT_EQ(stats.resumed_handshakes, 1);
+    EXPECT_EQ(stats.cached_sessions, 1);
+    EXPECT_EQ(stats.ticket_keys, 0);
+
+    // a client that doesn't offer the session gets a full handshake
+    client_config.session_resumption = false;
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+    EXPECT_FALSE(reused);
+}
+
+TEST_F(TlsTest, SessionTicketTLS12) {
+    server_config.session_resumption.session_timeout_s = 300;
+    server_config.session_resumption.cache_size = 0;
+    client_config.session_resumption = true;
+    start();
+
+    bool reused{true};
+    bool echoed{false};
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+    EXPECT_FALSE(reused);
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+    EXPECT_TRUE(reused);
+
+    const auto stats = server.session_statistics();
+    EXPECT_EQ(stats.full_handshakes, 1);
+    EXPECT_EQ(stats.resumed_handshakes, 1);
+    EXPECT_EQ(stats.cached_sessions, 0);
+    EXPECT_EQ(stats.ticket_keys, 1);
+}
+
+TEST_F(TlsTest, SessionTicketTLS13) {
+    server_config.ciphersuites = "TLS_AES_128_GCM_SHA256:TLS_AES_256_GCM_SHA384";
+    server_config.session_resumption.session_timeout_s = 300;
+    client_config.session_resumption = true;
+    start();
+
+    bool reused{true};
+    bool echoed{false};
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+    EXPECT_FALSE(reused);
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+    EXPECT_TRUE(reused);
+
+    const auto stats = server.session_statistics();
+    EXPECT_EQ(stats.full_handshakes, 1);
+    EXPECT_EQ(stats.resumed_handshakes, 1);
+    EXPECT_EQ(stats.ticket_keys, 1);
+}
+
+TEST_F(TlsTest, SessionStatefulTicketTLS13) {
+    // without stateless tickets TLS 1.3 tickets refer to the session cache
+    server_config.ciphersuites = "TLS_AES_128_GCM_SHA256:TLS_AES_256_GCM_SHA384";
+    server_config.session_resumption.session_timeout_s = 300;
+    server_config.session_resumption.tickets = false;
+    client_config.session_resumption = true;
+    start();
+
+    bool reused{true};
+    bool echoed{false};
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+    EXPECT_FALSE(reused);
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+    EXPECT_TRUE(reused);
+
+    const auto stats = server.session_statistics();
+    EXPECT_EQ(stats.full_handshakes, 1);
+    EXPECT_EQ(stats.resumed_handshakes, 1);
+    EXPECT_EQ(stats.ticket_keys, 0);
+}
+
+TEST_F(TlsTest, SessionTicketKeyRotation) {
+    // every ticket is issued with a new key, older keys are still accepted
+    server_config.session_resumption.session_timeout_s = 300;
+    server_config.session_resumption.ticket_key_rotation_s = 0;
+    server_config.session_resumption.cache_size = 0;
+    client_config.session_resumption = true;
+    start();
+
+    bool reused{true};
+    bool echoed{false};
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+    EXPECT_FALSE(reused);
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+    EXPECT_TRUE(reused);
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+    EXPECT_TRUE(reused);
+
+    const auto stats = server.session_statistics();
+    EXPECT_EQ(stats.full_handshakes, 1);
+    EXPECT_EQ(stats.resumed_handshakes, 2);
+    EXPECT_EQ(stats.ticket_keys, 3);
+}
+
+TEST_F(TlsTest, SessionResumptionAfterUpdate) {
+    // sessions and ticket keys survive a new SSL context with the same certificate
+    server_config.session_resumption.session_timeout_s = 300;
+    client_config.session_resumption = true;
+    start();
+
+    bool reused{true};
+    bool echoed{false};
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+    EXPECT_FALSE(reused);
+
+    EXPECT_TRUE(server.update(server_config));
+
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+    EXPECT_TRUE(reused);
+}
+
+// ----------------------------------------------------------------------------
+// event driven server
+
+void event_echo(tls::ServerConnection& connection) {
+    std::array<std::byte, 1024> buffer{};
+    std::size_t readbytes{0};
+    while (connection.read(buffer.data(), buffer.size(), readbytes, 0) == result_t::success) {
+        connection.queue_write(buffer.data(), readbytes);
+    }
+}
+
+TEST_F(TlsTest, EventServerEcho) {
+    constexpr int client_count{8};
+    constexpr int connect_count{5};
+    std::atomic_int connected{0};
+    std::atomic_int closed{0};
+
+    tls::Server::event_handlers_t handlers;
+    handlers.connected = [&connected](auto&) { connected++; };
+    handlers.readable = &event_echo;
+    handlers.closed = [&closed](auto&) { closed++; };
+    start(handlers);
+
+    std::atomic_int echoed{0};
+    std::vector<std::thread> clients;
+    for (int i = 0; i < client_count; i++) {
+        clients.emplace_back([this, &echoed]() {
+            tls::Client client;
+            client.init(client_config);
+            for (int j = 0; j < connect_count; j++) {
+                bool reused{false};
+                auto connection = client.connect("localhost", "8444", false, 1000);
+                if (echo_check_reused(connection, reused)) {
+                    echoed++;
+                }
+            }
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+
+    EXPECT_EQ(echoed, client_count * connect_count);
+    EXPECT_EQ(connected, client_count * connect_count);
+
+    // the server sees the closed connections shortly afterwards
+    for (int i = 0; (i < 100) && (closed != connected); i++) {
+        std::this_thread::sleep_for(10ms);
+    }
+    EXPECT_EQ(closed, connected);
+}
+
+TEST_F(TlsTest, EventServerHandshakeTimeout) {
+    server_config.io_timeout_ms = 500;
+    tls::Server::event_handlers_t handlers;
+    handlers.readable = &event_echo;
+    start(handlers);
+
+    // TCP connection that never starts the TLS handshake
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(8444);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    const int soc = ::socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_NE(soc, -1);
+    ASSERT_EQ(::connect(soc, reinterpret_cast<const sockaddr*>(&address), sizeof(address)), 0);
+
+    // other connections are served in the meantime
+    bool reused{false};
+    bool echoed{false};
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+
+    // the stalled connection is closed by the server
+    pollfd fds{soc, POLLIN, 0};
+    EXPECT_EQ(poll(&fds, 1, 3000), 1);
+    std::array<char, 16> buffer{};
+    EXPECT_EQ(::recv(soc, buffer.data(), buffer.size(), 0), 0);
+    ::close(soc);
+}
+
+TEST_F(TlsTest, EventServerSlowReader) {
+    std::atomic_int writable{0};
+    tls::Server::event_handlers_t handlers;
+    handlers.readable = &event_echo;
+    handlers.writable = [&writable](auto&) { writable++; };
+    start(handlers);
+
+    // a client that sends more than the socket buffers hold and doesn't read the echo yet
+    tls::Client slow_client;
+    slow_client.init(client_config);
+    auto slow = slow_client.connect("localhost", "8444", false, 1000);
+    ASSERT_TRUE(slow);
+    ASSERT_EQ(slow->connect(), result_t::success);
+    std::vector<std::byte> data(16 * 1024 * 1024);
+    for (std::size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<std::byte>(i % 251);
+    }
+    std::size_t writebytes{0};
+    ASSERT_EQ(slow->write(data.data(), data.size(), writebytes), result_t::success);
+
+    // other connections are served in the meantime
+    bool reused{false};
+    bool echoed{false};
+    const auto start_time = std::chrono::steady_clock::now();
+    connect([&](auto& connection) { echoed = echo_check_reused(connection, reused); });
+    EXPECT_TRUE(echoed);
+    EXPECT_LT(std::chrono::steady_clock::now() - start_time, 500ms);
+
+    // the queued echo is delivered completely once the client reads
+    std::vector<std::byte> received(data.size());
+    std::size_t total{0};
+    while (total < received.size()) {
+        std::size_t readbytes{0};
+        if (slow->read(received.data() + total, received.size() - total, readbytes) != result_t::success) {
+            break;
+        }
+        total += readbytes;
+    }
+    EXPECT_EQ(total, data.size());
+    EXPECT_TRUE(received == data);
+    for (int i = 0; (i < 100) && (writable == 0); i++) {
+        std::this_thread::sleep_for(10ms);
+    }
+    EXPECT_GT(writable, 0);
+    slow->shutdown();
+}
+
+TEST_F(TlsTest, EventServerRequiresReadable) {
+    using state_t = tls::Server::state_t;
+    ASSERT_EQ(server.init(server_config, nullptr), state_t::init_complete);
+
+    // stops at once instead of serving
+    tls::Server::event_handlers_t handlers;
+    handlers.connected = [](auto&) {};
+    EXPECT_EQ(server.serve(handlers), state_t::stopped);
+}
+
+// ----------------------------------------------------------------------------
+// certificate hot reload
+
+bool copy_file(const std::string& from, const std::string& to) {
+    // write a temporary file and rename it, as done when certificates are rotated
+    std::ifstream in(from, std::ios::binary);
+    const auto tmp = to + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out << in.rdbuf();
+    }
+    return std::rename(tmp.c_str(), to.c_str()) == 0;
+}
+
+openssl::sha_1_digest_t peer_digest(tls::Client& client, const tls::Client::config_t& config) {
+    openssl::sha_1_digest_t digest{};
+    client.init(config);
+    auto connection = client.connect("localhost", "8444", false, 1000);
+    if (connection && (connection->connect() == result_t::success)) {
+        const auto* cert = connection->peer_certificate();
+        if (cert != nullptr) {
+            openssl::certificate_sha_1(digest, cert);
+        }
+        connection->shutdown();
+    }
+    return digest;
+}
+
+TEST_F(TlsTest, UpdateOnChange) {
+    std::array<char, 32> dir_template{"/tmp/tls_test_XXXXXX"};
+    ASSERT_NE(mkdtemp(dir_template.data()), nullptr);
+    const std::string dir(dir_template.data());
+    const auto chain_file = dir + "/server_chain.pem";
+    const auto key_file = dir + "/server_priv.pem";
+    ASSERT_TRUE(copy_file("server_chain.pem", chain_file));
+    ASSERT_TRUE(copy_file("server_priv.pem", key_file));
+
+    server_config.chains.clear();
+    auto& ref = server_config.chains.emplace_back();
+    ref.certificate_chain_file = chain_file.c_str();
+    ref.private_key_file = key_file.c_str();
+    ref.trust_anchor_file = "server_root_cert.pem";
+    start();
+    ASSERT_TRUE(server.update_on_change(server_config, 100));
+
+    openssl::sha_1_digest_t server_digest{};
+    openssl::sha_1_digest_t alt_server_digest{};
+    ASSERT_TRUE(openssl::certificate_sha_1(server_digest, openssl::load_certificates("server_cert.pem")[0].get()));
+    ASSERT_TRUE(
+        openssl::certificate_sha_1(alt_server_digest, openssl::load_certificates("alt_server_cert.pem")[0].get()));
+
+    client_config.verify_server = false;
+    EXPECT_EQ(peer_digest(client, client_config), server_digest);
+
+    // rotate the certificate and key
+    ASSERT_TRUE(copy_file("alt_server_chain.pem", chain_file));
+    ASSERT_TRUE(copy_file("alt_server_priv.pem", key_file));
+
+    bool updated{false};
+    for (int i = 0; (i < 50) && !updated; i++) {
+        std::this_thread::sleep_for(100ms);
+        updated = peer_digest(client, client_config) == alt_server_digest;
+    }
+    EXPECT_TRUE(updated);
+
+    server.stop_update_on_change();
+    std::remove(chain_file.c_str());
+    std::remove(key_file.c_str());
+    rmdir(dir.c_str());
+}
+
+TEST_F(TlsTest, UpdateOnChangeNewFilename) {
+    std::array<char, 32> dir_template{"/tmp/tls_test_XXXXXX"};
+    ASSERT_NE(mkdtemp(dir_template.data()), nullptr);
+    const std::string dir(dir_template.data());
+    const auto chain_file = dir + "/server_chain.pem";
+    const auto key_file = dir + "/server_priv.pem";
+    const auto alt_chain_file = dir + "/alt_server_chain.pem";
+    const auto alt_key_file = dir + "/alt_server_priv.pem";
+    ASSERT_TRUE(copy_file("server_chain.pem", chain_file));
+    ASSERT_TRUE(copy_file("server_priv.pem", key_file));
+
+    // the configuration is rebuilt from the newest files, like a module querying its certificate store
+    const auto build_config = [&]() -> tls::Server::OptionalConfig {
+        auto config = std::make_unique<tls::Server::config_t>(server_config);
+        config->chains.clear();
+        auto& ref = config->chains.emplace_back();
+        const bool renewed = std::ifstream(alt_chain_file).good();
+        ref.certificate_chain_file = renewed ? alt_chain_file.c_str() : chain_file.c_str();
+        ref.private_key_file = renewed ? alt_key_file.c_str() : key_file.c_str();
+        ref.trust_anchor_file = "server_root_cert.pem";
+        return {std::move(config)};
+    };
+    server_config = *build_config().value();
+    start();
+    ASSERT_TRUE(server.update_on_change(server_config, build_config, 100));
+
+    openssl::sha_1_digest_t server_digest{};
+    openssl::sha_1_digest_t alt_server_digest{};
+    ASSERT_TRUE(openssl::certificate_sha_1(server_digest, openssl::load_certificates("server_cert.pem")[0].get()));
+    ASSERT_TRUE(
+        openssl::certificate_sha_1(alt_server_digest, openssl::load_certificates("alt_server_cert.pem")[0].get()));
+
+    client_config.verify_server = false;
+    EXPECT_EQ(peer_digest(client, client_config), server_digest);
+
+    // renew the certificate and key under new filenames
+    ASSERT_TRUE(copy_file("alt_server_priv.pem", alt_key_file));
+    ASSERT_TRUE(copy_file("alt_server_chain.pem", alt_chain_file));
+
+    bool updated{false};
+    for (int i = 0; (i < 50) && !updated; i++) {
+        std::this_thread::sleep_for(100ms);
+        updated = peer_digest(client, client_config) == alt_server_digest;
+    }
+    EXPECT_TRUE(updated);
+
+    server.stop_update_on_change();
+    for (const auto& file : {chain_file, key_file, alt_chain_file, alt_key_file}) {
+        std::remove(file.c_str());
+    }
+    rmdir(dir.c_str());
+}
+
 } // namespace
@@ -224,6 +224,15 @@ protected:
         }
     }
 
+    void start(const tls::Server::event_handlers_t& handlers) {
+        using state_t = tls::Server::state_t;
+        const auto res = server.init(server_config, nullptr);
+        if ((res == state_t::init_complete) || (res == state_t::init_socket)) {
+            server_thread = std::thread([this, handlers]() { this->server.serve(handlers); });
+            server.wait_running();
+        }
+    }
+
     void connect(const std::function<void(tls::Client::ConnectionPtr& con)>& handler = nullptr) {
         client.init(client_config);
         client.reset();
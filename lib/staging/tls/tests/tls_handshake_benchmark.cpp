@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+/*
+ * handshake latency with and without session resumption
+ *
+ * Runs a server and a client on localhost and measures the time from the TCP
+ * connect until the TLS handshake has completed on the client side for
+ * full handshakes, TLS 1.2 session ID and ticket resumption, and TLS 1.3
+ * PSK ticket resumption. The "rotating" scenarios call Server::update()
+ * every 10 ms from a background thread, as done when certificates and OCSP
+ * responses are rotated, to check that handshakes are not stalled.
+ *
+ * needs the test PKI (see pki.sh) in the working directory
+ */
+
+#include <tls.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* short_opts = "hn:";
+std::size_t iterations{200};
+
+struct scenario_t {
+    const char* name;
+    bool tls1_3;
+    std::uint32_t session_timeout_s;
+    bool tickets;
+    std::size_t cache_size;
+    bool rotate;
+};
+
+void parse_options(int argc, char** argv) {
+    int c;
+
+    while ((c = getopt(argc, argv, short_opts)) != -1) {
+        switch (c) {
+        case 'n':
+            iterations = std::max<std::size_t>(1, std::strtoul(optarg, nullptr, 10));
+            break;
+        case 'h':
+        case '?':
+            std::cout << "Usage: " << argv[0] << " [-n iterations]" << std::endl;
+            std::cout << "       -n number of handshakes per scenario (default 200)" << std::endl;
+            exit(1);
+            break;
+        default:
+            exit(2);
+        }
+    }
+}
+
+void handle_connection(tls::Server::ConnectionPtr&& con) {
+    if (con->accept() == tls::Connection::result_t::success) {
+        // echo one byte, the client waits for it so that TLS 1.3 tickets are received
+        std::byte buffer{};
+        std::size_t readbytes = 0;
+        std::size_t writebytes = 0;
+        if (con->read(&buffer, sizeof(buffer), readbytes) == tls::Connection::result_t::success) {
+            (void)con->write(&buffer, readbytes, writebytes);
+        }
+        con->shutdown();
+    }
+}
+
+double to_us(Clock::duration duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+void run(const scenario_t& scenario) {
+    tls::Server server;
+    tls::Server::config_t server_config;
+
+    server_config.cipher_list = "ECDHE-ECDSA-AES128-SHA256";
+    server_config.ciphersuites = (scenario.tls1_3) ? "TLS_AES_128_GCM_SHA256" : "";
+    auto& ref0 = server_config.chains.emplace_back();
+    ref0.certificate_chain_file = "server_chain.pem";
+    ref0.private_key_file = "server_priv.pem";
+    ref0.trust_anchor_file = "server_root_cert.pem";
+    ref0.ocsp_response_files = {"ocsp_response.der", "ocsp_response.der"};
+    server_config.host = "localhost";
+    server_config.service = "8444";
+    server_config.ipv6_only = false;
+    server_config.verify_client = false;
+    server_config.io_timeout_ms = 1000;
+    server_config.session_resumption.session_timeout_s = scenario.session_timeout_s;
+    server_config.session_resumption.tickets = scenario.tickets;
+    server_config.session_resumption.cache_size = scenario.cache_size;
+
+    tls::Client client;
+    tls::Client::config_t client_config;
+    client_config.cipher_list = "ECDHE-ECDSA-AES128-SHA256";
+    client_config.ciphersuites = (scenario.tls1_3) ? "TLS_AES_128_GCM_SHA256" : "";
+    client_config.verify_locations_file = "server_root_cert.pem";
+    client_config.io_timeout_ms = 1000;
+    client_config.verify_server = true;
+    client_config.session_resumption = scenario.session_timeout_s > 0;
+
+    using state_t = tls::Server::state_t;
+    const auto res = server.init(server_config, nullptr);
+    if ((res != state_t::init_complete) && (res != state_t::init_socket)) {
+        std::cerr << scenario.name << ": server init failed" << std::endl;
+        return;
+    }
+    std::thread server_thread([&server]() { server.serve(&handle_connection); });
+    server.wait_running();
+
+    std::atomic_bool rotating{scenario.rotate};
+    std::size_t updates{0};
+    std::thread update_thread([&server, &server_config, &rotating, &updates]() {
+        while (rotating) {
+            server.update(server_config);
+            updates++;
+            std::this_thread::sleep_for(10ms);
+        }
+    });
+
+    if (!client.init(client_config)) {
+        std::cerr << scenario.name << ": client init failed" << std::endl;
+    } else {
+        std::vector<Clock::duration> durations;
+        std::size_t failed{0};
+        std::size_t reused{0};
+
+        // the first handshake is always a full one and not measured
+        for (std::size_t i = 0; i <= iterations; i++) {
+            const auto start = Clock::now();
+            auto connection = client.connect("localhost", "8444", false, 1000);
+            if (connection && (connection->connect() == tls::Connection::result_t::success)) {
+                const auto duration = Clock::now() - start;
+                if (i > 0) {
+                    durations.push_back(duration);
+                    reused += (connection->session_reused()) ? 1 : 0;
+                }
+                std::byte buffer{};
+                std::size_t bytes = 0;
+                if ((connection->write(&buffer, sizeof(buffer), bytes) != tls::Connection::result_t::success) ||
+                    (connection->read(&buffer, sizeof(buffer), bytes) != tls::Connection::result_t::success)) {
+                    failed++;
+                }
+                connection->shutdown();
+            } else {
+                failed++;
+            }
+        }
+
+        std::sort(durations.begin(), durations.end());
+        Clock::duration total{0};
+        for (const auto& duration : durations) {
+            total += duration;
+        }
+
+        std::cout << scenario.name << ": ";
+        if (durations.empty()) {
+            std::cout << "no successful handshakes";
+        } else {
+            std::cout << "average " << to_us(total) / durations.size() << " us, median "
+                      << to_us(durations[durations.size() / 2]) << " us, max " << to_us(durations.back()) << " us, "
+                      << reused << "/" << durations.size() << " resumed";
+        }
+        if (failed > 0) {
+            std::cout << ", " << failed << " failed";
+        }
+        std::cout << std::endl;
+        if (scenario.rotate) {
+            std::cout << "    " << updates << " updates during the measurement" << std::endl;
+        }
+
+        const auto stats = server.session_statistics();
+        std::cout << "    server: " << stats.full_handshakes << " full, " << stats.resumed_handshakes << " resumed, "
+                  << stats.cached_sessions << " cached sessions, " << stats.ticket_keys << " ticket keys"
+                  << std::endl;
+    }
+
+    rotating = false;
+    update_thread.join();
+    server.stop();
+    server.wait_stopped();
+    server_thread.join();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    parse_options(argc, argv);
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &action, nullptr);
+    tls::Server::configure_signal_handler(SIGUSR1);
+
+    const scenario_t scenarios[] = {
+        {"TLS 1.2 full handshake      ", false, 0, false, 0, false},
+        {"TLS 1.2 full, rotating      ", false, 0, false, 0, true},
+        {"TLS 1.2 session ID          ", false, 300, false, 256, false},
+        {"TLS 1.2 session ticket      ", false, 300, true, 0, false},
+        {"TLS 1.3 full handshake      ", true, 0, false, 0, false},
+        {"TLS 1.3 full, rotating      ", true, 0, false, 0, true},
+        {"TLS 1.3 PSK ticket          ", true, 300, true, 0, false},
+        {"TLS 1.3 PSK ticket (cached) ", true, 300, false, 256, false},
+    };
+
+    for (const auto& scenario : scenarios) {
+        run(scenario);
+    }
+
+    return 0;
+}
@@ -6,20 +6,27 @@
 #include "extensions/trusted_ca_keys.hpp"
 #include "openssl_util.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
 #include <csignal>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <fcntl.h>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <poll.h>
+#include <set>
 #include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
+#include <vector>
 
 #include <openssl/asn1.h>
 #include <openssl/bio.h>
@@ -48,6 +55,12 @@ public:
         ::SSL_CTX_free(ptr);
     }
 };
+template <> class default_delete<SSL_SESSION> {
+public:
+    void operator()(SSL_SESSION* ptr) const {
+        ::SSL_SESSION_free(ptr);
+    }
+};
 template <> class default_delete<BIO_ADDR> {
 public:
     void operator()(BIO_ADDR* ptr) const {
@@ -483,12 +496,35 @@ bool configure_ssl_ctx(SSL_CTX* ctx, const char* ciphersuites, const char* ciphe
     return result;
 }
 
+/**
+ * \brief the certificate, key and OCSP response files of a server configuration
+ */
+std::vector<std::string> config_files(const tls::Server::config_t& cfg) {
+    std::vector<std::string> files;
+    const auto add = [&files](const char* filename) {
+        if (filename != nullptr) {
+            files.emplace_back(filename);
+        }
+    };
+    for (const auto& chain : cfg.chains) {
+        add(chain.certificate_chain_file);
+        add(chain.trust_anchor_file);
+        add(chain.private_key_file);
+        for (const auto& ocsp : chain.ocsp_response_files) {
+            add(ocsp);
+        }
+    }
+    add(cfg.verify_locations_file);
+    return files;
+}
+
 } // namespace
 
 namespace tls {
 
 using SSL_ptr = std::unique_ptr<SSL>;
 using SSL_CTX_ptr = std::unique_ptr<SSL_CTX>;
+using SSL_SESSION_ptr = std::unique_ptr<SSL_SESSION>;
 using OCSP_RESPONSE_ptr = std::shared_ptr<OCSP_RESPONSE>;
 
 struct connection_ctx {
@@ -502,13 +538,58 @@ struct ocsp_cache_ctx {
 };
 
 struct server_ctx {
-    SSL_CTX_ptr ctx;
+    std::shared_ptr<SSL_CTX> ctx; //!< current context, access via std::atomic_load/store
 };
 
 struct client_ctx {
     SSL_CTX_ptr ctx;
+    std::mutex session_mutex;
+    SSL_SESSION_ptr session; //!< most recent session, offered on the next connection
 };
 
+namespace {
+
+int s_client_index{-1};             //!< index used for storing client_ctx in the SSL context
+std::once_flag s_client_index_once; //!< clients can be created concurrently
+
+void init_client_index() {
+    std::call_once(s_client_index_once, []() {
+        s_client_index = CRYPTO_get_ex_new_index(CRYPTO_EX_INDEX_SSL_CTX, 0, nullptr, nullptr, nullptr, nullptr);
+    });
+}
+
+/**
+ * \brief keep the most recent session for resumption (client)
+ * \param[in] ctx the connection context
+ * \param[in] session the new session
+ * \return 1 as the reference to the session is kept
+ */
+int client_new_session_cb(SSL* ctx, SSL_SESSION* session) {
+    auto* client = reinterpret_cast<client_ctx*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ctx), s_client_index));
+    if (client == nullptr) {
+        return 0;
+    }
+    std::lock_guard lock(client->session_mutex);
+    client->session = SSL_SESSION_ptr(session);
+    return 1;
+}
+
+/**
+ * \brief keep the session after a resumed TLS 1.2 handshake (client)
+ * \param[in] ctx the connection context
+ * \note a renewed TLS 1.2 ticket replaces the session without calling
+ *       client_new_session_cb, the original session is no longer resumable
+ */
+void client_update_session(SSL* ctx) {
+    auto* client = reinterpret_cast<client_ctx*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ctx), s_client_index));
+    if ((client != nullptr) && (SSL_session_reused(ctx) == 1) && (SSL_version(ctx) <= TLS1_2_VERSION)) {
+        std::lock_guard lock(client->session_mutex);
+        client->session = SSL_SESSION_ptr(SSL_get1_session(ctx));
+    }
+}
+
+} // namespace
+
 // ----------------------------------------------------------------------------
 // Connection represents a TLS connection (client and server)
 
@@ -681,6 +762,16 @@ const Certificate* Connection::peer_certificate() const {
     return SSL_get0_peer_certificate(m_context->ctx.get());
 }
 
+bool Connection::pending() const {
+    assert(m_context != nullptr);
+    return SSL_pending(m_context->ctx.get()) > 0;
+}
+
+bool Connection::session_reused() const {
+    assert(m_context != nullptr);
+    return SSL_session_reused(m_context->ctx.get()) == 1;
+}
+
 SSL* Connection::ssl_context() const {
     return m_context->ctx.get();
 }
@@ -701,6 +792,8 @@ ServerConnection::ServerConnection(SslContext* ctx, int soc, const char* ip_in,
     }
     if (m_context->soc_bio != nullptr) {
         SSL_set_accept_state(m_context->ctx.get());
+        // queue_write() may reallocate the queue while a write is blocked
+        SSL_set_mode(m_context->ctx.get(), SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
         ServerStatusRequestV2::set_data(m_context->ctx.get(), &m_flags);
         ServerTrustedCaKeys::set_data(m_context->ctx.get(), &m_tck_data);
     }
@@ -714,6 +807,31 @@ ServerConnection::~ServerConnection() {
     m_cv.notify_all();
 }
 
+void ServerConnection::queue_write(const std::byte* buf, std::size_t num) {
+    m_write_queue.insert(m_write_queue.end(), buf, buf + num);
+}
+
+Connection::result_t ServerConnection::write_queued() {
+    result_t result{result_t::success};
+    // data queued while a write was blocked is written by the next iteration
+    while (!m_write_queue.empty() && (result == result_t::success)) {
+        // a blocked write has to be retried with the same length
+        const auto num = (m_write_attempt != 0) ? m_write_attempt : m_write_queue.size();
+        std::size_t writebytes{0};
+        result = write(m_write_queue.data(), num, writebytes, 0);
+        if (result == result_t::success) {
+            m_write_queue.erase(m_write_queue.begin(), m_write_queue.begin() + writebytes);
+            m_write_attempt = 0;
+        } else if ((result == result_t::want_read) || (result == result_t::want_write)) {
+            m_write_attempt = num;
+        } else {
+            m_write_queue.clear();
+            m_write_attempt = 0;
+        }
+    }
+    return result;
+}
+
 Connection::result_t ServerConnection::accept(int timeout_ms) {
     assert(m_context != nullptr);
     ssl_result_t result{ssl_result_t::error};
@@ -727,6 +845,7 @@ Connection::result_t ServerConnection::accept(int timeout_ms) {
             switch (result) {
             case ssl_result_t::success:
                 m_state = state_t::connected;
+                ServerSessionCache::handshake_complete(ctx);
                 break;
             case ssl_result_t::want_read:
             case ssl_result_t::want_write:
@@ -785,6 +904,7 @@ Connection::result_t ClientConnection::connect(int timeout_ms) {
             switch (result) {
             case ssl_result_t::success:
                 m_state = state_t::connected;
+                client_update_session(ctx);
                 break;
             case ssl_result_t::want_read:
             case ssl_result_t::want_write:
@@ -817,11 +937,19 @@ Connection::result_t ClientConnection::connect(int timeout_ms) {
 int Server::s_sig_int{-1};
 
 Server::Server() : m_context(std::make_unique<server_ctx>()), m_status_request_v2(m_cache) {
+    m_wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_wakeup_fd == INVALID_SOCKET) {
+        log_error("Server::eventfd: " + std::to_string(errno));
+    }
 }
 
 Server::~Server() {
+    m_watcher.stop();
     stop();
     wait_stopped();
+    if (m_wakeup_fd != INVALID_SOCKET) {
+        close(m_wakeup_fd);
+    }
 }
 
 bool Server::init_socket(const config_t& cfg) {
@@ -865,9 +993,14 @@ bool Server::init_socket(const config_t& cfg) {
         }
     } else {
         // the code that sets cfg.socket is responsible for
-        // all socket initialisation
+        // all socket initialisation, except that accepting relies on a
+        // non-blocking socket
         m_socket = cfg.socket;
-        result = true;
+        result = BIO_socket_nbio(m_socket, 1) != 0;
+        if (!result) {
+            log_error("init_socket::BIO_socket_nbio");
+            m_socket = INVALID_SOCKET;
+        }
     }
 
     return result;
@@ -915,15 +1048,19 @@ bool Server::init_ssl(const config_t& cfg) {
 
             result = result && m_status_request_v2.init_ssl(ctx);
             result = result && m_server_trusted_ca_keys.init_ssl(ctx);
+            result = result && m_session_cache.init_ssl(ctx, cfg.session_resumption);
         }
     }
 
     if (!result) {
         SSL_CTX_free(ctx);
         ctx = nullptr;
+    } else {
+        // new connections use the new context, existing connections hold a
+        // reference to the previous one. On failure the previous context is kept
+        std::atomic_store(&m_context->ctx, std::shared_ptr<SSL_CTX>(ctx, &SSL_CTX_free));
     }
 
-    m_context->ctx = SSL_CTX_ptr(ctx);
     return ctx != nullptr;
 }
 
@@ -1031,22 +1168,6 @@ void Server::wait_for_connection(const ConnectionHandler& handler) {
             }
         };
 
-        // attempt to get SSL configuration when not set yet
-        if ((soc >= 0) && (m_state == state_t::init_socket)) {
-            auto new_config = m_init_callback();
-            bool success{false};
-            if (new_config && new_config.value()) {
-                success = update(*new_config.value());
-            }
-            if (success) {
-                m_state = state_t::running;
-            } else {
-                // updated configuration failed
-                BIO_closesocket(soc);
-                soc = INVALID_SOCKET;
-            }
-        }
-
         if (m_exit) {
             if (soc >= 0) {
                 BIO_closesocket(soc);
@@ -1056,18 +1177,255 @@ void Server::wait_for_connection(const ConnectionHandler& handler) {
                 log_error("serve::BIO_accept_ex");
             } else {
                 // new connection, pass to handler
-                auto* ip = BIO_ADDR_hostname_string(peer.get(), 1);
-                auto* service = BIO_ADDR_service_string(peer.get(), 1);
-                auto connection =
-                    std::make_unique<ServerConnection>(m_context->ctx.get(), soc, ip, service, m_timeout_ms);
-                handler(std::move(connection));
-                OPENSSL_free(ip);
-                OPENSSL_free(service);
+                auto connection = new_connection(soc, peer.get());
+                if (connection) {
+                    handler(std::move(connection));
+                }
             }
         }
     }
 }
 
+Server::ConnectionPtr Server::new_connection(int soc, const BIO_ADDR* peer) {
+    // attempt to get SSL configuration when not set yet
+    if (m_state == state_t::init_socket) {
+        auto new_config = m_init_callback();
+        bool success{false};
+        if (new_config && new_config.value()) {
+            success = update(*new_config.value());
+        }
+        if (success) {
+            m_state = state_t::running;
+        } else {
+            // updated configuration failed
+            BIO_closesocket(soc);
+            return nullptr;
+        }
+    }
+
+    auto* ip = BIO_ADDR_hostname_string(peer, 1);
+    auto* service = BIO_ADDR_service_string(peer, 1);
+    const auto ctx = std::atomic_load(&m_context->ctx);
+    auto connection = std::make_unique<ServerConnection>(ctx.get(), soc, ip, service, m_timeout_ms);
+    OPENSSL_free(ip);
+    OPENSSL_free(service);
+    return connection;
+}
+
+void Server::event_loop(const event_handlers_t& handlers) {
+    using clock = std::chrono::steady_clock;
+    using result_t = Connection::result_t;
+    using state_t = Connection::state_t;
+
+    struct entry_t {
+        ConnectionPtr connection;
+        result_t waiting{result_t::want_read}; //!< socket event being waited for
+        bool handshake{true};                  //!< TLS handshake in progress
+        clock::time_point deadline;            //!< handshake must complete by
+        bool write_blocked{false};             //!< queued data is waiting for the socket
+        bool want_write{false};                //!< EPOLLOUT is watched for queued data
+    };
+
+    std::unique_ptr<BIO_ADDR> peer(BIO_ADDR_new());
+    const int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if ((peer == nullptr) || (epoll_fd == -1)) {
+        log_error("serve::epoll_create1");
+        m_exit = true;
+        return;
+    }
+
+    const auto watch = [epoll_fd](int operation, int fd, std::uint32_t events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd, operation, fd, &event) == -1) {
+            log_error("serve::epoll_ctl: " + std::to_string(errno));
+            return false;
+        }
+        return true;
+    };
+
+    watch(EPOLL_CTL_ADD, m_socket, EPOLLIN);
+    if (m_wakeup_fd != INVALID_SOCKET) {
+        watch(EPOLL_CTL_ADD, m_wakeup_fd, EPOLLIN);
+    }
+
+    std::map<int, entry_t> connections;
+    std::set<std::pair<clock::time_point, int>> handshakes; // handshake deadlines
+    std::vector<int> pending; // connections with decrypted data that hasn't been read
+
+    const auto remove = [&](std::map<int, entry_t>::iterator it) {
+        // EPOLL_CTL_DEL may fail when the connection already closed the socket
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, it->first, nullptr);
+        auto& entry = it->second;
+        if (entry.handshake) {
+            handshakes.erase({entry.deadline, it->first});
+        } else {
+            if (entry.connection->state() == state_t::connected) {
+                entry.connection->shutdown(0);
+            }
+            if (handlers.closed != nullptr) {
+                handlers.closed(*entry.connection);
+            }
+        }
+        connections.erase(it);
+    };
+
+    // check the connection after a callback and write queued data, returns false when it has been removed
+    const auto check = [&](std::map<int, entry_t>::iterator it) {
+        auto& entry = it->second;
+        auto& connection = *entry.connection;
+        for (;;) {
+            const auto result =
+                (connection.state() == state_t::connected) ? connection.write_queued() : result_t::closed;
+            if (connection.state() != state_t::connected) {
+                remove(it);
+                return false;
+            }
+            const bool want_write = result == result_t::want_write;
+            if (want_write != entry.want_write) {
+                entry.want_write = want_write;
+                watch(EPOLL_CTL_MOD, it->first, want_write ? (EPOLLIN | EPOLLOUT) : EPOLLIN);
+            }
+            if (result != result_t::success) {
+                entry.write_blocked = true;
+                break;
+            }
+            if (!entry.write_blocked) {
+                break;
+            }
+            // the queue has been drained, the callback may queue more
+            entry.write_blocked = false;
+            if (handlers.writable == nullptr) {
+                break;
+            }
+            handlers.writable(connection);
+        }
+        if (connection.pending()) {
+            pending.push_back(it->first);
+        }
+        return true;
+    };
+
+    const auto handshake = [&](std::map<int, entry_t>::iterator it) {
+        auto& entry = it->second;
+        const auto result = entry.connection->accept(0);
+        switch (result) {
+        case result_t::success:
+            entry.handshake = false;
+            handshakes.erase({entry.deadline, it->first});
+            if (entry.waiting != result_t::want_read) {
+                entry.waiting = result_t::want_read;
+                watch(EPOLL_CTL_MOD, it->first, EPOLLIN);
+            }
+            if (handlers.connected != nullptr) {
+                handlers.connected(*entry.connection);
+            }
+            check(it);
+            break;
+        case result_t::want_read:
+        case result_t::want_write:
+            if (result != entry.waiting) {
+                entry.waiting = result;
+                watch(EPOLL_CTL_MOD, it->first, (result == result_t::want_write) ? EPOLLOUT : EPOLLIN);
+            }
+            break;
+        case result_t::closed:
+        case result_t::timeout:
+        default:
+            remove(it);
+            break;
+        }
+    };
+
+    const auto readable = [&](std::map<int, entry_t>::iterator it) {
+        if (handlers.readable != nullptr) {
+            handlers.readable(*it->second.connection);
+        }
+        return check(it);
+    };
+
+    const auto accept_all = [&]() {
+        for (;;) {
+            const int soc = BIO_accept_ex(m_socket, peer.get(), BIO_SOCK_NONBLOCK);
+            if (soc < 0) {
+                if (BIO_sock_should_retry(soc) == 0) {
+                    log_error("serve::BIO_accept_ex");
+                }
+                break;
+            }
+            auto connection = new_connection(soc, peer.get());
+            if (connection && watch(EPOLL_CTL_ADD, soc, EPOLLIN)) {
+                const auto deadline = (m_timeout_ms > 0) ? clock::now() + std::chrono::milliseconds(m_timeout_ms)
+                                                         : clock::time_point::max();
+                connections.emplace(soc, entry_t{std::move(connection), result_t::want_read, true, deadline});
+                handshakes.emplace(deadline, soc);
+            }
+        }
+    };
+
+    std::array<epoll_event, 64> events{};
+
+    while (!m_exit) {
+        int timeout_ms = c_serve_timeout_ms;
+        if (!pending.empty()) {
+            timeout_ms = 0;
+        } else if (!handshakes.empty() && (handshakes.begin()->first != clock::time_point::max())) {
+            const auto remaining =
+                std::chrono::ceil<std::chrono::milliseconds>(handshakes.begin()->first - clock::now()).count();
+            timeout_ms = static_cast<int>(std::clamp<std::int64_t>(remaining, 0, c_serve_timeout_ms));
+        }
+
+        const auto count = epoll_wait(epoll_fd, events.data(), events.size(), timeout_ms);
+        if ((count == -1) && (errno != EINTR)) {
+            log_error("serve::epoll_wait: " + std::to_string(errno));
+            m_exit = true;
+        }
+
+        for (int i = 0; (i < count) && !m_exit; i++) {
+            const int fd = events[i].data.fd;
+            if (fd == m_socket) {
+                accept_all();
+            } else if (fd == m_wakeup_fd) {
+                std::uint64_t value{0};
+                (void)::read(m_wakeup_fd, &value, sizeof(value));
+            } else if (auto it = connections.find(fd); it != connections.end()) {
+                const auto revents = events[i].events;
+                if (it->second.handshake) {
+                    handshake(it);
+                } else if (((revents & EPOLLOUT) != 0) && !check(it)) {
+                    // writing queued data failed, the connection has been removed
+                } else if (((revents & ~EPOLLOUT) != 0) && readable(it) && ((revents & (EPOLLHUP | EPOLLERR)) != 0)) {
+                    // the peer has gone and the callback didn't notice
+                    remove(it);
+                }
+            }
+        }
+
+        // decrypted data that the socket won't signal
+        auto ready = std::move(pending);
+        pending.clear();
+        for (const auto fd : ready) {
+            if (auto it = connections.find(fd); (it != connections.end()) && !m_exit) {
+                if (it->second.connection->pending()) {
+                    readable(it);
+                }
+            }
+        }
+
+        // abort handshakes that take too long
+        const auto now = clock::now();
+        while (!handshakes.empty() && (handshakes.begin()->first <= now)) {
+            remove(connections.find(handshakes.begin()->second));
+        }
+    }
+
+    while (!connections.empty()) {
+        remove(connections.begin());
+    }
+    close(epoll_fd);
+}
+
 void Server::configure_signal_handler(int interrupt_signal) {
     s_sig_int = interrupt_signal;
     struct sigaction action {};
@@ -1094,7 +1452,8 @@ Server::state_t Server::init(const config_t& cfg, const ConfigurationCallback& i
 
 bool Server::update(const config_t& cfg) {
     // does not change server socket settings, use init() if needed
-    std::vector<OcspCache::ocsp_entry_t> entries;
+    // handshakes aren't blocked, they use the previous configuration until it is replaced
+    std::lock_guard lock(m_update_mutex);
 
     m_timeout_ms = cfg.io_timeout_ms;
     // always try init_certificates() and init_ssl()
@@ -1105,7 +1464,56 @@ bool Server::update(const config_t& cfg) {
     return result;
 }
 
+bool Server::update_on_change(const config_t& cfg, std::uint32_t settle_ms) {
+    // the configuration is copied, ConfigItem holds copies of the strings
+    auto config = std::make_shared<const config_t>(cfg);
+    return update_on_change(
+        cfg, [config]() -> OptionalConfig { return {std::make_unique<config_t>(*config)}; }, settle_ms);
+}
+
+bool Server::update_on_change(const config_t& cfg, const ConfigurationCallback& build_config,
+                              std::uint32_t settle_ms) {
+    return m_watcher.start(
+        config_files(cfg),
+        [this, build_config]() {
+            const auto config = build_config();
+            if (!config.has_value() || (config.value() == nullptr)) {
+                log_warning("Server::update_on_change: no configuration");
+                return;
+            }
+            // a renewed certificate may be stored in another directory
+            if (!m_watcher.watch(config_files(*config.value()))) {
+                log_warning("Server::update_on_change: unable to watch the new files");
+            }
+            if (!update(*config.value())) {
+                log_warning("Server::update_on_change: update failed");
+            }
+        },
+        settle_ms);
+}
+
+void Server::stop_update_on_change() {
+    m_watcher.stop();
+}
+
 Server::state_t Server::serve(const ConnectionHandler& handler) {
+    return serve_loop([this, &handler]() {
+        while (!m_exit) {
+            wait_for_connection(handler);
+        }
+    });
+}
+
+Server::state_t Server::serve(const event_handlers_t& handlers) {
+    if (handlers.readable == nullptr) {
+        // received data would never be read and be signalled again and again
+        log_error("Server::serve: readable handler missing");
+        return serve_loop([]() {});
+    }
+    return serve_loop([this, &handlers]() { event_loop(handlers); });
+}
+
+Server::state_t Server::serve_loop(const std::function<void()>& loop) {
     assert(m_context != nullptr);
     // prevent init() or server() being called while serve is running
     std::lock_guard lock(m_mutex);
@@ -1140,9 +1548,7 @@ Server::state_t Server::serve(const ConnectionHandler& handler) {
     if (result) {
         m_exit = false;
         m_state = (m_state == state_t::init_complete) ? state_t::running : state_t::init_socket;
-        while (!m_exit) {
-            wait_for_connection(handler);
-        }
+        loop();
 
         BIO_closesocket(m_socket);
         m_socket = INVALID_SOCKET;
@@ -1160,6 +1566,10 @@ Server::state_t Server::serve(const ConnectionHandler& handler) {
 
 void Server::stop() {
     m_exit = true;
+    if (m_wakeup_fd != INVALID_SOCKET) {
+        const std::uint64_t value{1};
+        (void)::write(m_wakeup_fd, &value, sizeof(value));
+    }
     // raise a signal if a hander was installed
     if (m_running && (s_sig_int != -1)) {
         pthread_kill(m_server_thread, s_sig_int);
@@ -1181,10 +1591,12 @@ void Server::wait_stopped() {
 
 Client::Client() :
     m_context(std::make_unique<client_ctx>()), m_status_request_v2(std::make_unique<ClientStatusRequestV2>()) {
+    init_client_index();
 }
 
 Client::Client(std::unique_ptr<ClientStatusRequestV2>&& handler) :
     m_context(std::make_unique<client_ctx>()), m_status_request_v2(std::move(handler)) {
+    init_client_index();
 }
 
 Client::~Client() = default;
@@ -1257,6 +1669,18 @@ bool Client::init(const config_t& cfg, const override_t& override) {
             }
         }
 
+        if (cfg.session_resumption) {
+            SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+            SSL_CTX_sess_set_new_cb(ctx, &client_new_session_cb);
+            if (SSL_CTX_set_ex_data(ctx, s_client_index, m_context.get()) != 1) {
+                log_error("SSL_CTX_set_ex_data");
+                result = false;
+            }
+        } else {
+            std::lock_guard lock(m_context->session_mutex);
+            m_context->session.reset();
+        }
+
         if (cfg.trusted_ca_keys) {
             constexpr int context = SSL_EXT_TLS_ONLY | SSL_EXT_IGNORE_ON_RESUMPTION | SSL_EXT_CLIENT_HELLO;
             if (SSL_CTX_add_custom_ext(ctx, TLSEXT_TYPE_trusted_ca_keys, context, override.trusted_ca_keys_add,
@@ -1326,6 +1750,11 @@ std::unique_ptr<ClientConnection> Client::connect(const char* host, const char*
 
             if (connected) {
                 result = std::make_unique<ClientConnection>(m_context->ctx.get(), socket, host, service, m_timeout_ms);
+                std::lock_guard lock(m_context->session_mutex);
+                if (m_context->session) {
+                    // a session that can't be resumed results in a full handshake
+                    SSL_set_session(result->m_context->ctx.get(), m_context->session.get());
+                }
             }
         }
     }
@@ -7,6 +7,8 @@
 #include "extensions/status_request.hpp"
 #include "extensions/tls_types.hpp"
 #include "extensions/trusted_ca_keys.hpp"
+#include "file_watcher.hpp"
+#include "session_cache.hpp"
 
 #include <atomic>
 #include <condition_variable>
@@ -20,6 +22,7 @@
 #include <pthread.h>
 #include <string>
 #include <unistd.h>
+#include <vector>
 
 namespace tls {
 
@@ -223,6 +226,20 @@ public:
      */
     [[nodiscard]] const Certificate* peer_certificate() const;
 
+    /**
+     * \brief check whether received data has already been decrypted
+     * \returns true when read() can return data without waiting for the socket
+     * \note event driven code must call read() again when this is true since
+     *       the socket will not signal this data as readable
+     */
+    [[nodiscard]] bool pending() const;
+
+    /**
+     * \brief check whether the handshake resumed a previous session
+     * \returns true when the session was resumed (abbreviated handshake)
+     */
+    [[nodiscard]] bool session_reused() const;
+
     /**
      * \brief obtain the underlying SSL context
      * \returns the underlying SSL context pointer
@@ -251,12 +268,14 @@ private:
     using trusted_ca_keys_t = trusted_ca_keys::trusted_ca_keys_t;
     using server_trusted_ca_keys_t = trusted_ca_keys::server_trusted_ca_keys_t;
 
-    static std::uint32_t m_count;        //!< number of active connections
-    static std::mutex m_cv_mutex;        //!< used for wait_all_closed()
-    static std::condition_variable m_cv; //!< used for wait_all_closed()
-    trusted_ca_keys_t m_trusted_ca_keys; //!< trusted CA keys configuration
-    StatusFlags m_flags;                 //!< extension flags
-    server_trusted_ca_keys_t m_tck_data; //!< extension per connection data
+    static std::uint32_t m_count;         //!< number of active connections
+    static std::mutex m_cv_mutex;         //!< used for wait_all_closed()
+    static std::condition_variable m_cv;  //!< used for wait_all_closed()
+    trusted_ca_keys_t m_trusted_ca_keys;  //!< trusted CA keys configuration
+    StatusFlags m_flags;                  //!< extension flags
+    server_trusted_ca_keys_t m_tck_data;  //!< extension per connection data
+    std::vector<std::byte> m_write_queue; //!< data queued by queue_write()
+    std::size_t m_write_attempt{0};       //!< length of a blocked write that has to be retried
 
 public:
     ServerConnection(SslContext* ctx, int soc, const char* ip_in, const char* service_in, std::int32_t timeout_ms);
@@ -278,6 +297,29 @@ public:
         return accept(m_timeout_ms);
     }
 
+    /**
+     * \brief queue bytes to be written without blocking
+     * \param[in] buf pointer to input buffer
+     * \param[in] num size of input buffer
+     * \note used with the event driven Server::serve() which writes the
+     *       queued data when the socket is writable
+     */
+    void queue_write(const std::byte* buf, std::size_t num);
+
+    /**
+     * \brief number of queued bytes that have not been written yet
+     */
+    [[nodiscard]] std::size_t queued() const {
+        return m_write_queue.size();
+    }
+
+    /**
+     * \brief write queued bytes without waiting
+     * \return success when the queue is empty, want_read or want_write when
+     *         the socket isn't ready, otherwise see write()
+     */
+    [[nodiscard]] result_t write_queued();
+
     /**
      * \brief wait for all connections to be closed
      */
@@ -296,6 +338,9 @@ public:
  * \brief class representing a TLS connection (client side)
  */
 class ClientConnection : public Connection {
+private:
+    friend class Client;
+
 public:
     ClientConnection(SslContext* ctx, int soc, const char* ip_in, const char* service_in, std::int32_t timeout_ms);
     ClientConnection() = delete;
@@ -339,6 +384,10 @@ public:
  * list which is serviced by an event handler - i.e. one thread could manage
  * all connections.
  *
+ * serve() with event_handlers_t implements the event driven option: one
+ * thread accepts connections and runs the handshakes and reads of all
+ * connections using epoll.
+ *
  * Listens on either IPv4 or IPv6. OpenSSL recommends that two listen sockets
  * are used to support both IPv4 and IPv6. (not implemented)
  */
@@ -374,6 +423,8 @@ public:
         ConfigItem verify_locations_path{nullptr}; //!< for client certificate
         std::int32_t io_timeout_ms{-1};            //!< socket timeout in milliseconds (recommend > 1 sec)
         bool verify_client{true};                  //!< client certificate required
+        //!< session resumption, disabled unless session_timeout_s is set
+        ServerSessionCache::config_t session_resumption;
 
         // config not used on update()
         ConfigItem host{nullptr};    //!< see BIO_lookup_ex()
@@ -384,6 +435,24 @@ public:
 
     using ConnectionPtr = std::unique_ptr<ServerConnection>;
     using ConnectionHandler = std::function<void(ConnectionPtr&& ctx)>;
+    using ConnectionEvent = std::function<void(ServerConnection& connection)>;
+
+    /**
+     * \brief callbacks used by the event driven serve()
+     * \note callbacks are called from the thread running serve(). Connections
+     *       must only be used from within a callback, they are owned by serve()
+     * \note callbacks must not block: send with queue_write() rather than
+     *       write(), queued data is written when the socket is writable
+     * \note a callback closes a connection by calling shutdown() on it
+     */
+    struct event_handlers_t {
+        ConnectionEvent connected{nullptr}; //!< TLS handshake completed
+        //!< data has been received, call read() with timeout_ms 0 until it no longer returns success (required)
+        ConnectionEvent readable{nullptr};
+        //!< queued data that had to wait for the socket has been written, more can be queued
+        ConnectionEvent writable{nullptr};
+        ConnectionEvent closed{nullptr}; //!< connected connection closed, it is destroyed afterwards
+    };
     using OptionalConfig = std::optional<std::unique_ptr<config_t>>;
     using ConfigurationCallback = std::function<OptionalConfig()>;
 
@@ -395,18 +464,22 @@ private:
     std::unique_ptr<server_ctx> m_context;              //!< opaque object data
     int m_socket{INVALID_SOCKET};                       //!< server socket value
     volatile bool m_running{false};                     //!< server is listening for connections
-    std::int32_t m_timeout_ms{-1};                      //!< default operation timeout passed to new connections
+    std::atomic_int32_t m_timeout_ms{-1};               //!< default operation timeout passed to new connections
     std::atomic_bool m_exit{false};                     //!< stop listening for connections
     std::atomic<state_t> m_state{state_t::init_needed}; //!< server state
     std::mutex m_mutex;                                 //!< prevent multiple initialisation or serve requests
+    std::mutex m_update_mutex;                          //!< serialises update() calls
     std::mutex m_cv_mutex;                              //!< used by wait_running() and wait_stopped()
     std::condition_variable m_cv;                       //!< used by wait_running() and wait_stopped()
     OcspCache m_cache;                                  //!< cached OCSP responses
     ServerStatusRequestV2 m_status_request_v2;          //!< status request extension handler
     ServerTrustedCaKeys m_server_trusted_ca_keys;       //!< trusted ca keys extension handler
+    ServerSessionCache m_session_cache;                 //!< resumable sessions and ticket keys
     pthread_t m_server_thread{};                        //!< serve() POSIX threads ID
+    int m_wakeup_fd{INVALID_SOCKET};                    //!< eventfd used by stop() to wakeup the event loop
     static int s_sig_int;                               //!< signal to use to wakeup serve()
     ConfigurationCallback m_init_callback{nullptr};     //!< callback to retrieve SSL configuration
+    FileWatcher m_watcher;                              //!< calls update() when files change, destroyed first
 
     /**
      * \brief initialise the server socket
@@ -435,6 +508,28 @@ private:
      */
     void wait_for_connection(const ConnectionHandler& handler);
 
+    /**
+     * \brief create a connection for an accepted socket
+     * \param[in] soc the accepted socket, closed on failure
+     * \param[in] peer address of the peer
+     * \return the connection or nullptr when SSL isn't configured
+     * \note calls m_init_callback when SSL configuration is still needed
+     */
+    ConnectionPtr new_connection(int soc, const BioAddress* peer);
+
+    /**
+     * \brief accept connections and drive all of them from one epoll loop
+     * \param[in] handlers - event callbacks
+     */
+    void event_loop(const event_handlers_t& handlers);
+
+    /**
+     * \brief common part of both serve() variants
+     * \param[in] loop - run until m_exit is set
+     * \return see serve()
+     */
+    state_t serve_loop(const std::function<void()>& loop);
+
 public:
     Server();
     Server(const Server&) = delete;
@@ -474,9 +569,44 @@ public:
      * \return true on success
      * \note used to update OCSP caches and SSL certificates and keys.
      *       Does not change the listen socket settings
+     * \note can be called while serve() is running, handshakes in progress
+     *       are not blocked and complete with the previous configuration.
+     *       The previous SSL context is kept when a new one can't be created
      */
     bool update(const config_t& cfg);
 
+    /**
+     * \brief call update() when certificate, key or OCSP response files change
+     * \param[in] cfg server configuration, passed to update()
+     * \param[in] settle_ms time without further changes before updating, so
+     *            that a certificate and its key are replaced together
+     * \return true when the files are being watched
+     * \note update() is called from a background thread. Calling it again
+     *       replaces the watched configuration, stop_update_on_change() stops it
+     */
+    bool update_on_change(const config_t& cfg, std::uint32_t settle_ms = 1000);
+
+    /**
+     * \brief rebuild the configuration and call update() when a file in the
+     *        directories of the certificate, key or OCSP response files changes
+     * \param[in] cfg current server configuration, its files define the
+     *            directories to watch
+     * \param[in] build_config called from a background thread after a change,
+     *            returns the new configuration or nullopt to keep the current one
+     * \param[in] settle_ms time without further changes before updating
+     * \return true when the directories are being watched
+     * \note unlike update_on_change(cfg) a certificate renewed under a new
+     *       filename is loaded. The directories of the new configuration are
+     *       watched as well
+     */
+    bool update_on_change(const config_t& cfg, const ConfigurationCallback& build_config,
+                          std::uint32_t settle_ms = 1000);
+
+    /**
+     * \brief stop watching files
+     */
+    void stop_update_on_change();
+
     /**
      * \brief wait for incomming connections
      * \param[in] handler called when there is a new connection
@@ -491,6 +621,22 @@ public:
      */
     state_t serve(const ConnectionHandler& handler);
 
+    /**
+     * \brief serve connections event driven from the calling thread
+     * \param[in] handlers called on connection events
+     * \return see serve(const ConnectionHandler&)
+     *
+     * Unlike serve(const ConnectionHandler&) connections are not passed to
+     * the application. Accepting connections, TLS handshakes and waiting for
+     * received data are multiplexed for all connections using epoll so that
+     * many connections can be served by one thread. Handshakes that don't
+     * complete within io_timeout_ms are aborted. handlers.readable is
+     * required, serve() returns stopped without serving when it is missing.
+     *
+     * Active connections are closed when serve() returns.
+     */
+    state_t serve(const event_handlers_t& handlers);
+
     /**
      * \brief stop listening for new connections
      * \note returns immediately
@@ -512,6 +658,14 @@ public:
      */
     void wait_stopped();
 
+    /**
+     * \brief obtain the number of full and resumed handshakes and the cache usage
+     * \return session resumption statistics
+     */
+    [[nodiscard]] ServerSessionCache::statistics_t session_statistics() const {
+        return m_session_cache.statistics();
+    }
+
     /**
      * \brief return the current server state (indicative only)
      * \return current server state
@@ -578,6 +732,7 @@ public:
         bool status_request{false};                  //!< include a status request extension in the client hello
         bool status_request_v2{false};               //!< include a status request v2 extension in the client hello
         bool trusted_ca_keys{false};                 //!< include a trusted ca keys extension in the client hello
+        bool session_resumption{false};              //!< offer the session of the previous connection
     };
 
     using ConnectionPtr = std::unique_ptr<ClientConnection>;
@@ -16,6 +16,17 @@ void Auth::init() {
         string_to_selection_algorithm(this->config.selection_algorithm), this->config.connection_timeout,
         this->config.prioritize_authorization_over_stopping_transaction, this->config.ignore_connector_faults);
 
+    std::vector<TokenValidatorPool::Validator> validators;
+    for (const auto& token_validator : this->r_token_validator) {
+        validators.push_back({token_validator->module_id, [&token_validator](const ProvidedIdToken& provided_token) {
+                                  return token_validator->call_validate_token(provided_token);
+                              }});
+    }
+    // two workers per validator, so a validator that exceeded the timeout does not block the next token
+    this->token_validator_pool = std::make_unique<TokenValidatorPool>(
+        std::move(validators), conversions::string_to_validation_policy(this->config.validation_policy),
+        std::chrono::milliseconds(this->config.validation_timeout_ms), 2 * this->r_token_validator.size());
+
     for (const auto& token_provider : this->r_token_provider) {
         token_provider->subscribe_provided_token([this](ProvidedIdToken provided_token) {
             std::thread t([this, provided_token]() { this->auth_handler->on_token(provided_token); });
@@ -60,11 +71,7 @@ void Auth::ready() {
     this->auth_handler->register_withdraw_authorization_callback(
         [this](const int32_t evse_index) { this->r_evse_manager.at(evse_index)->call_withdraw_authorization(); });
     this->auth_handler->register_validate_token_callback([this](const ProvidedIdToken& provided_token) {
-        std::vector<ValidationResult> validation_results;
-        for (const auto& token_validator : this->r_token_validator) {
-            validation_results.push_back(token_validator->call_validate_token(provided_token));
-        }
-        return validation_results;
+        return this->token_validator_pool->validate(provided_token);
     });
     this->auth_handler->register_stop_transaction_callback(
         [this](const int32_t evse_index, const StopTransactionRequest& request) {
@@ -75,6 +82,12 @@ void Auth::ready() {
     });
     this->auth_handler->register_reservation_cancelled_callback(
         [this](const int32_t evse_index) { this->r_evse_manager.at(evse_index)->call_cancel_reservation(); });
+
+    if (this->config.validator_statistics_interval_s > 0) {
+        this->validator_statistics_timer =
+            std::make_unique<Everest::SteadyTimer>([this]() { this->log_validator_statistics(); });
+        this->validator_statistics_timer->interval(std::chrono::seconds(this->config.validator_statistics_interval_s));
+    }
 }
 
 void Auth::set_connection_timeout(int& connection_timeout) {
@@ -85,4 +98,18 @@ void Auth::set_master_pass_group_id(const std::string& master_pass_group_id) {
     this->auth_handler->set_master_pass_group_id(master_pass_group_id);
 }
 
+void Auth::log_validator_statistics() {
+    for (const auto& statistics : this->token_validator_pool->get_statistics()) {
+        const auto calls = statistics.responses + statistics.errors;
+        std::chrono::milliseconds average_latency{0};
+        if (calls > 0) {
+            average_latency = statistics.total_latency / calls;
+        }
+        EVLOG_info << "Token validator " << statistics.name << ": " << statistics.requests << " requests, "
+                   << statistics.responses << " responses (" << statistics.accepted << " accepted), "
+                   << statistics.errors << " errors, " << statistics.timeouts << " timeouts, latency average "
+                   << average_latency.count() << " ms, max " << statistics.max_latency.count() << " ms";
+    }
+}
+
 } // namespace module
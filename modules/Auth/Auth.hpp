@@ -22,6 +22,8 @@
 // ev@4bf81b14-a215-475c-a1d3-0a484ae48918:v1
 // insert your custom include headers here
 #include <AuthHandler.hpp>
+#include <TokenValidatorPool.hpp>
+#include <everest/timer.hpp>
 #include <memory>
 
 using namespace types::evse_manager;
@@ -36,6 +38,9 @@ struct Conf {
     std::string master_pass_group_id;
     bool prioritize_authorization_over_stopping_transaction;
     bool ignore_connector_faults;
+    std::string validation_policy;
+    int validation_timeout_ms;
+    int validator_statistics_interval_s;
 };
 
 class Auth : public Everest::ModuleBase {
@@ -64,6 +69,7 @@ public:
     // ev@1fce4c5e-0ab8-41bb-90f7-14277703d2ac:v1
     // insert your public definitions here
     std::unique_ptr<AuthHandler> auth_handler;
+    std::unique_ptr<TokenValidatorPool> token_validator_pool;
 
     /**
      * @brief Set the connection timeout for the auth handler
@@ -92,6 +98,9 @@ private:
 
     // ev@211cfdbe-f69a-4cd6-a4ec-f8aaa3d1b6c8:v1
     // insert your private definitions here
+    std::unique_ptr<Everest::SteadyTimer> validator_statistics_timer;
+
+    void log_validator_statistics();
     // ev@211cfdbe-f69a-4cd6-a4ec-f8aaa3d1b6c8:v1
 };
 
@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#ifndef _TOKEN_VALIDATOR_POOL_HPP_
+#define _TOKEN_VALIDATOR_POOL_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <generated/types/authorization.hpp>
+
+using namespace types::authorization;
+
+namespace module {
+
+/**
+ * @brief Defines when the validation of a token is finished
+ *
+ */
+enum class ValidationPolicy {
+    All,           ///< wait for all validators, results are in the order of the validators
+    FirstAccepted, ///< finish as soon as any validator accepts the token, results are in the order of their arrival
+    PriorityOrder  ///< results are in the order of the validators, finish as soon as all validators before the first
+                   ///< accepting validator have answered
+};
+
+namespace conversions {
+ValidationPolicy string_to_validation_policy(const std::string& policy);
+std::string validation_policy_to_string(const ValidationPolicy& policy);
+} // namespace conversions
+
+/**
+ * @brief Latency metrics of a single validator
+ *
+ */
+struct ValidatorStatistics {
+    std::string name;
+    std::size_t requests{0};  ///< number of tokens handed to the validator
+    std::size_t responses{0}; ///< number of results received, including late ones
+    std::size_t accepted{0};
+    std::size_t errors{0};   ///< number of calls that threw an exception
+    std::size_t timeouts{0}; ///< number of validations that were finished without waiting for this validator
+    std::chrono::milliseconds total_latency{0};
+    std::chrono::milliseconds max_latency{0};
+};
+
+/**
+ * @brief Validates tokens with all validators concurrently on a fixed pool of worker threads.
+ *
+ * Every validator is called on its own worker, so the latency of a validation is the latency of the slowest validator
+ * that is needed by the policy instead of the sum of all validators. Validators that do not respond within the
+ * timeout are not waited for, their call keeps its worker busy until it returns.
+ */
+class TokenValidatorPool {
+
+public:
+    struct Validator {
+        std::string name;
+        std::function<ValidationResult(const ProvidedIdToken& provided_token)> validate;
+    };
+
+    /**
+     * @brief Starts \p worker_threads workers for the given \p validators
+     *
+     * @param validators
+     * @param policy
+     * @param timeout maximum time to wait for each validator, zero waits without a timeout
+     * @param worker_threads
+     */
+    TokenValidatorPool(std::vector<Validator> validators, const ValidationPolicy& policy,
+                       const std::chrono::milliseconds& timeout, std::size_t worker_threads);
+    ~TokenValidatorPool();
+
+    TokenValidatorPool(const TokenValidatorPool&) = delete;
+    TokenValidatorPool& operator=(const TokenValidatorPool&) = delete;
+
+    /**
+     * @brief Validates the \p provided_token with all validators and waits for the results according to the policy.
+     * Validators that did not respond in time or threw an exception have no entry in the result.
+     *
+     * @param provided_token
+     * @return std::vector<ValidationResult>
+     */
+    std::vector<ValidationResult> validate(const ProvidedIdToken& provided_token);
+
+    /**
+     * @brief Returns the latency metrics of all validators
+     *
+     * @return std::vector<ValidatorStatistics>
+     */
+    std::vector<ValidatorStatistics> get_statistics() const;
+
+private:
+    struct Validation;
+
+    std::vector<Validator> validators;
+    ValidationPolicy policy;
+    std::chrono::milliseconds timeout;
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex jobs_mutex;
+    std::condition_variable jobs_cv;
+    bool running{true};
+
+    mutable std::mutex statistics_mutex;
+    std::vector<ValidatorStatistics> statistics;
+
+    void run_worker();
+    void call_validator(std::size_t index, const ProvidedIdToken& provided_token,
+                        const std::shared_ptr<Validation>& validation);
+    bool is_finished(const Validation& validation) const;
+};
+
+} // namespace module
+
+#endif //_TOKEN_VALIDATOR_POOL_HPP_
@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#include <TokenValidatorPool.hpp>
+
+#include <algorithm>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+#include <everest/logging.hpp>
+
+namespace module {
+
+namespace conversions {
+ValidationPolicy string_to_validation_policy(const std::string& policy) {
+    if (policy == "All") {
+        return ValidationPolicy::All;
+    } else if (policy == "FirstAccepted") {
+        return ValidationPolicy::FirstAccepted;
+    } else if (policy == "PriorityOrder") {
+        return ValidationPolicy::PriorityOrder;
+    }
+    throw std::out_of_range("Provided string " + policy + " could not be converted to enum of type ValidationPolicy");
+}
+
+std::string validation_policy_to_string(const ValidationPolicy& policy) {
+    switch (policy) {
+    case ValidationPolicy::All:
+        return "All";
+    case ValidationPolicy::FirstAccepted:
+        return "FirstAccepted";
+    case ValidationPolicy::PriorityOrder:
+        return "PriorityOrder";
+    default:
+        throw std::runtime_error("No known conversion for the given validation policy");
+    }
+}
+} // namespace conversions
+
+/// \brief state of the validation of one token, shared with the workers that might outlive the validation
+struct TokenValidatorPool::Validation {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::optional<ValidationResult>> results;
+    std::vector<bool> answered;     // result received or call failed
+    std::vector<std::size_t> order; // indices of the received results in the order of their arrival
+    std::vector<std::chrono::milliseconds> latencies;
+
+    explicit Validation(std::size_t validators) :
+        results(validators), answered(validators, false), latencies(validators) {
+    }
+};
+
+TokenValidatorPool::TokenValidatorPool(std::vector<Validator> validators, const ValidationPolicy& policy,
+                                       const std::chrono::milliseconds& timeout, std::size_t worker_threads) :
+    validators(std::move(validators)), policy(policy), timeout(timeout) {
+    for (const auto& validator : this->validators) {
+        ValidatorStatistics validator_statistics;
+        validator_statistics.name = validator.name;
+        this->statistics.push_back(validator_statistics);
+    }
+
+    if (worker_threads == 0) {
+        worker_threads = 1;
+    }
+    for (std::size_t i = 0; i < worker_threads; i++) {
+        this->workers.emplace_back([this]() { this->run_worker(); });
+    }
+}
+
+TokenValidatorPool::~TokenValidatorPool() {
+    {
+        std::lock_guard<std::mutex> lk(this->jobs_mutex);
+        this->running = false;
+    }
+    this->jobs_cv.notify_all();
+    for (auto& worker : this->workers) {
+        worker.join();
+    }
+}
+
+std::vector<ValidationResult> TokenValidatorPool::validate(const ProvidedIdToken& provided_token) {
+    const auto start = std::chrono::steady_clock::now();
+    auto validation = std::make_shared<Validation>(this->validators.size());
+
+    {
+        std::lock_guard<std::mutex> lk(this->jobs_mutex);
+        for (std::size_t i = 0; i < this->validators.size(); i++) {
+            this->jobs.emplace_back(
+                [this, i, provided_token, validation]() { this->call_validator(i, provided_token, validation); });
+        }
+    }
+    this->jobs_cv.notify_all();
+
+    std::unique_lock<std::mutex> lk(validation->mutex);
+    bool timed_out = false;
+    if (this->timeout.count() > 0) {
+        timed_out = !validation->cv.wait_until(lk, start + this->timeout,
+                                               [this, &validation]() { return this->is_finished(*validation); });
+    } else {
+        validation->cv.wait(lk, [this, &validation]() { return this->is_finished(*validation); });
+    }
+
+    std::vector<ValidationResult> validation_results;
+    if (this->policy == ValidationPolicy::FirstAccepted) {
+        for (const auto index : validation->order) {
+            validation_results.push_back(validation->results.at(index).value());
+        }
+    } else {
+        for (std::size_t i = 0; i < validation->results.size(); i++) {
+            // validators that timed out are skipped, the next validators in order take their place
+            if (validation->results.at(i).has_value()) {
+                validation_results.push_back(validation->results.at(i).value());
+                if (this->policy == ValidationPolicy::PriorityOrder &&
+                    validation_results.back().authorization_status == AuthorizationStatus::Accepted) {
+                    break;
+                }
+            }
+        }
+    }
+
+    const auto elapsed =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::stringstream summary;
+    {
+        std::lock_guard<std::mutex> statistics_lk(this->statistics_mutex);
+        for (std::size_t i = 0; i < this->validators.size(); i++) {
+            summary << " " << this->validators.at(i).name << ": ";
+            if (validation->results.at(i).has_value()) {
+                summary << authorization_status_to_string(validation->results.at(i).value().authorization_status)
+                        << " (" << validation->latencies.at(i).count() << "ms)";
+            } else if (validation->answered.at(i)) {
+                summary << "error (" << validation->latencies.at(i).count() << "ms)";
+            } else if (timed_out) {
+                summary << "timeout";
+                this->statistics.at(i).timeouts++;
+            } else {
+                summary << "not awaited";
+            }
+        }
+    }
+    lk.unlock();
+
+    if (timed_out) {
+        EVLOG_warning << "Not all validators responded within " << this->timeout.count() << "ms for token "
+                      << provided_token.id_token.value << ":" << summary.str();
+    } else {
+        EVLOG_debug << "Validation of token " << provided_token.id_token.value << " finished after "
+                    << elapsed.count() << "ms (" << conversions::validation_policy_to_string(this->policy)
+                    << "):" << summary.str();
+    }
+
+    return validation_results;
+}
+
+std::vector<ValidatorStatistics> TokenValidatorPool::get_statistics() const {
+    std::lock_guard<std::mutex> lk(this->statistics_mutex);
+    return this->statistics;
+}
+
+void TokenValidatorPool::run_worker() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lk(this->jobs_mutex);
+            this->jobs_cv.wait(lk, [this]() { return !this->running || !this->jobs.empty(); });
+            if (!this->running) {
+                return;
+            }
+            job = std::move(this->jobs.front());
+            this->jobs.pop_front();
+        }
+        job();
+    }
+}
+
+void TokenValidatorPool::call_validator(std::size_t index, const ProvidedIdToken& provided_token,
+                                        const std::shared_ptr<Validation>& validation) {
+    const auto& validator = this->validators.at(index);
+    {
+        std::lock_guard<std::mutex> lk(this->statistics_mutex);
+        this->statistics.at(index).requests++;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::optional<ValidationResult> result;
+    try {
+        result = validator.validate(provided_token);
+    } catch (const std::exception& e) {
+        EVLOG_warning << "Validator " << validator.name << " failed to validate token " << provided_token.id_token.value
+                      << ": " << e.what();
+    }
+    const auto latency =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    {
+        std::lock_guard<std::mutex> lk(this->statistics_mutex);
+        auto& validator_statistics = this->statistics.at(index);
+        if (result.has_value()) {
+            validator_statistics.responses++;
+            if (result.value().authorization_status == AuthorizationStatus::Accepted) {
+                validator_statistics.accepted++;
+            }
+        } else {
+            validator_statistics.errors++;
+        }
+        validator_statistics.total_latency += latency;
+        validator_statistics.max_latency = std::max(validator_statistics.max_latency, latency);
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(validation->mutex);
+        validation->results.at(index) = std::move(result);
+        validation->answered.at(index) = true;
+        validation->latencies.at(index) = latency;
+        if (validation->results.at(index).has_value()) {
+            validation->order.push_back(index);
+        }
+    }
+    validation->cv.notify_all();
+}
+
+bool TokenValidatorPool::is_finished(const Validation& validation) const {
+    switch (this->policy) {
+    case ValidationPolicy::FirstAccepted:
+        for (const auto index : validation.order) {
+            if (validation.results.at(index).value().authorization_status == AuthorizationStatus::Accepted) {
+                return true;
+            }
+        }
+        break;
+    case ValidationPolicy::PriorityOrder:
+        for (std::size_t i = 0; i < validation.results.size(); i++) {
+            if (!validation.answered.at(i)) {
+                return false;
+            }
+            if (validation.results.at(i).has_value() &&
+                validation.results.at(i).value().authorization_status == AuthorizationStatus::Accepted) {
+                return true;
+            }
+        }
+        return true;
+    case ValidationPolicy::All:
+        break;
+    }
+    return std::all_of(validation.answered.begin(), validation.answered.end(), [](bool answered) { return answered; });
+}
+
+} // namespace module
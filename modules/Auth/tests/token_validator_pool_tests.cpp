@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include <TokenValidatorPool.hpp>
+
+namespace module {
+
+using namespace std::chrono_literals;
+
+namespace {
+
+/// \brief validator that answers with \p status after \p delay , the parent id token identifies the validator
+TokenValidatorPool::Validator delayed_validator(const std::string& name, std::chrono::milliseconds delay,
+                                                AuthorizationStatus status) {
+    return {name, [name, delay, status](const ProvidedIdToken&) {
+                std::this_thread::sleep_for(delay);
+                ValidationResult result;
+                result.authorization_status = status;
+                result.parent_id_token = IdToken{name, IdTokenType::Central};
+                return result;
+            }};
+}
+
+ProvidedIdToken get_provided_token() {
+    ProvidedIdToken provided_token;
+    provided_token.id_token = {"VALID_RFID_1", IdTokenType::ISO14443};
+    provided_token.authorization_type = AuthorizationType::RFID;
+    return provided_token;
+}
+
+std::chrono::milliseconds measure(const std::function<void()>& f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+}
+
+} // namespace
+
+TEST(TokenValidatorPoolTest, validators_are_called_concurrently) {
+    TokenValidatorPool pool({delayed_validator("local", 200ms, AuthorizationStatus::Invalid),
+                             delayed_validator("ocpp", 200ms, AuthorizationStatus::Accepted),
+                             delayed_validator("custom", 200ms, AuthorizationStatus::Accepted)},
+                            ValidationPolicy::All, 0ms, 3);
+
+    std::vector<ValidationResult> results;
+    const auto elapsed = measure([&]() { results = pool.validate(get_provided_token()); });
+
+    EXPECT_LT(elapsed, 500ms);
+    ASSERT_EQ(results.size(), 3);
+    EXPECT_EQ(results.at(0).parent_id_token.value().value, "local");
+    EXPECT_EQ(results.at(1).parent_id_token.value().value, "ocpp");
+    EXPECT_EQ(results.at(2).parent_id_token.value().value, "custom");
+}
+
+TEST(TokenValidatorPoolTest, first_accepted_returns_fastest_accepting_validator) {
+    TokenValidatorPool pool({delayed_validator("ocpp", 1000ms, AuthorizationStatus::Accepted),
+                             delayed_validator("local", 10ms, AuthorizationStatus::Invalid),
+                             delayed_validator("custom", 100ms, AuthorizationStatus::Accepted)},
+                            ValidationPolicy::FirstAccepted, 0ms, 3);
+
+    std::vector<ValidationResult> results;
+    const auto elapsed = measure([&]() { results = pool.validate(get_provided_token()); });
+
+    EXPECT_LT(elapsed, 800ms);
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_EQ(results.at(0).parent_id_token.value().value, "local");
+    EXPECT_EQ(results.at(1).parent_id_token.value().value, "custom");
+    EXPECT_EQ(results.at(1).authorization_status, AuthorizationStatus::Accepted);
+}
+
+TEST(TokenValidatorPoolTest, priority_order_waits_for_higher_priority_validators) {
+    TokenValidatorPool pool({delayed_validator("local", 200ms, AuthorizationStatus::Invalid),
+                             delayed_validator("ocpp", 10ms, AuthorizationStatus::Accepted),
+                             delayed_validator("custom", 1000ms, AuthorizationStatus::Accepted)},
+                            ValidationPolicy::PriorityOrder, 0ms, 3);
+
+    std::vector<ValidationResult> results;
+    const auto elapsed = measure([&]() { results = pool.validate(get_provided_token()); });
+
+    EXPECT_GE(elapsed, 200ms);
+    EXPECT_LT(elapsed, 800ms);
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_EQ(results.at(0).parent_id_token.value().value, "local");
+    EXPECT_EQ(results.at(1).parent_id_token.value().value, "ocpp");
+}
+
+TEST(TokenValidatorPoolTest, priority_order_exits_early_on_first_validator) {
+    TokenValidatorPool pool({delayed_validator("local", 10ms, AuthorizationStatus::Accepted),
+                             delayed_validator("ocpp", 1000ms, AuthorizationStatus::Accepted)},
+                            ValidationPolicy::PriorityOrder, 0ms, 2);
+
+    std::vector<ValidationResult> results;
+    const auto elapsed = measure([&]() { results = pool.validate(get_provided_token()); });
+
+    EXPECT_LT(elapsed, 800ms);
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results.at(0).parent_id_token.value().value, "local");
+}
+
+TEST(TokenValidatorPoolTest, validators_exceeding_the_timeout_are_skipped) {
+    TokenValidatorPool pool({delayed_validator("ocpp", 1000ms, AuthorizationStatus::Accepted),
+                             delayed_validator("local", 10ms, AuthorizationStatus::Accepted)},
+                            ValidationPolicy::PriorityOrder, 200ms, 4);
+
+    std::vector<ValidationResult> results;
+    const auto elapsed = measure([&]() { results = pool.validate(get_provided_token()); });
+
+    EXPECT_GE(elapsed, 200ms);
+    EXPECT_LT(elapsed, 800ms);
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results.at(0).parent_id_token.value().value, "local");
+
+    // the hanging validator occupies one worker, the next token is still validated
+    results = pool.validate(get_provided_token());
+    EXPECT_EQ(results.size(), 1);
+
+    const auto statistics = pool.get_statistics();
+    EXPECT_EQ(statistics.at(0).name, "ocpp");
+    EXPECT_EQ(statistics.at(0).timeouts, 2);
+    EXPECT_EQ(statistics.at(1).timeouts, 0);
+}
+
+TEST(TokenValidatorPoolTest, failing_validator_has_no_result) {
+    TokenValidatorPool pool({{"broken",
+                              [](const ProvidedIdToken&) -> ValidationResult {
+                                  throw std::runtime_error("validator not reachable");
+                              }},
+                             delayed_validator("local", 10ms, AuthorizationStatus::Invalid)},
+                            ValidationPolicy::All, 0ms, 2);
+
+    const auto results = pool.validate(get_provided_token());
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results.at(0).parent_id_token.value().value, "local");
+    EXPECT_EQ(pool.get_statistics().at(0).errors, 1);
+}
+
+TEST(TokenValidatorPoolTest, latency_statistics) {
+    TokenValidatorPool pool({delayed_validator("local", 10ms, AuthorizationStatus::Accepted),
+                             delayed_validator("ocpp", 100ms, AuthorizationStatus::Invalid)},
+                            ValidationPolicy::All, 0ms, 2);
+
+    for (int i = 0; i < 3; i++) {
+        pool.validate(get_provided_token());
+    }
+
+    const auto statistics = pool.get_statistics();
+    ASSERT_EQ(statistics.size(), 2);
+    EXPECT_EQ(statistics.at(0).requests, 3);
+    EXPECT_EQ(statistics.at(0).responses, 3);
+    EXPECT_EQ(statistics.at(0).accepted, 3);
+    EXPECT_EQ(statistics.at(1).accepted, 0);
+    EXPECT_GE(statistics.at(0).total_latency, 30ms);
+    EXPECT_GE(statistics.at(1).total_latency, 300ms);
+    EXPECT_GE(statistics.at(1).max_latency, 100ms);
+    EXPECT_LT(statistics.at(0).max_latency, statistics.at(1).max_latency);
+}
+
+} // namespace module
@@ -22,6 +22,7 @@ namespace module {
 struct Conf {
     std::string device;
     int device_address;
+    std::string parallel_device_addresses;
     double power_limit_W;
     double current_limit_A;
     double voltage_limit_V;
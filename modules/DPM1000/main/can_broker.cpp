@@ -17,8 +17,8 @@ static void throw_with_error(const std::string& msg) {
     throw std::runtime_error(msg + ": (" + std::string(strerror(errno)) + ")");
 }
 
-CanBroker::CanBroker(const std::string& interface_name, uint8_t _device_src) : device_src(_device_src) {
-    can_fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+int open_can_socket(const std::string& interface_name) {
+    const auto can_fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
 
     if (can_fd == -1) {
         throw_with_error("Failed to open socket");
@@ -47,6 +47,41 @@ CanBroker::CanBroker(const std::string& interface_name, uint8_t _device_src) : d
         throw_with_error("Failed with bind");
     }
 
+    return can_fd;
+}
+
+// requests and their responses are matched on (device, command, value type)
+static uint32_t request_key(uint8_t device, uint8_t command, uint16_t value_type) {
+    return (static_cast<uint32_t>(device) << 24) | (static_cast<uint32_t>(command) << 16) | value_type;
+}
+
+static uint32_t request_key(const struct can_frame& request) {
+    return request_key(dpm1000::parse_destination(request), dpm1000::parse_command(request),
+                       dpm1000::parse_msg_type(request));
+}
+
+// the module expects the value in big endian byte order
+static std::vector<uint8_t> to_payload(uint32_t value) {
+    return {static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 8),
+            static_cast<uint8_t>(value)};
+}
+
+static uint32_t float_to_raw(float value) {
+    uint32_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+    return raw;
+}
+
+float CanBroker::ReadRequest::value_float() const {
+    float result;
+    memcpy(&result, &value, sizeof(result));
+    return result;
+}
+
+CanBroker::CanBroker(const std::string& interface_name) : CanBroker(open_can_socket(interface_name)) {
+}
+
+CanBroker::CanBroker(int _can_fd) : can_fd(_can_fd) {
     event_fd = eventfd(0, 0);
 
     loop_thread = std::thread(&CanBroker::loop, this);
@@ -91,108 +126,196 @@ void CanBroker::loop() {
     }
 }
 
-void CanBroker::set_state(bool enabled) {
+void CanBroker::set_state(uint8_t device, bool enabled) {
     struct can_frame frame;
     dpm1000::power_on(frame, enabled, enabled);
-    dpm1000::set_header(frame, monitor_id, device_src);
+    dpm1000::set_header(frame, monitor_id, device);
 
     write_to_can(frame);
 
     // Do an extra module ON command as sometimes the bits in the header are not enough to actually switch on
-    set_data_int(dpm1000::def::SetValueType::SWITCH_ON_OFF_SETTING, (enabled ? 0 : 1));
+    set_data_int(device, dpm1000::def::SetValueType::SWITCH_ON_OFF_SETTING, (enabled ? 0 : 1));
 }
 
-CanBroker::AccessReturnType CanBroker::dispatch_frame(const struct can_frame& frame, uint16_t id,
-                                                      uint32_t* return_payload) {
-    // wait until we get access
-    std::lock_guard<std::mutex> access_lock(access_mtx);
+void CanBroker::dispatch_frames(std::vector<Access>& accesses) {
+    const auto deadline = std::chrono::steady_clock::now() + ACCESS_TIMEOUT;
 
-    std::unique_lock<std::mutex> request_lock(request.mutex);
-    write_to_can(frame);
-    request.msg_type = id;
-    request.state = CanRequest::State::ISSUED;
+    std::unique_lock<std::mutex> lock(requests_mtx);
+    const auto batch = ++last_batch;
 
-    const auto finished = request.cv.wait_for(request_lock, ACCESS_TIMEOUT,
-                                              [this]() { return request.state != CanRequest::State::ISSUED; });
+    const auto is_ours = [this, batch](uint32_t key) {
+        const auto request = requests.find(key);
+        return request != requests.end() and request->second.batch == batch;
+    };
+
+    const auto in_flight = [this, batch]() {
+        std::size_t count = 0;
+        for (const auto& [key, request] : requests) {
+            if ((request.batch == batch) and (request.state == CanRequest::State::ISSUED)) {
+                count++;
+            }
+        }
+        return count;
+    };
+
+    for (const auto& access : accesses) {
+        const auto key = request_key(access.frame);
+
+        // wait until an outstanding request with the same key from another caller is answered and a response of
+        // this batch freed a slot in the transmit queue
+        const auto can_send = requests_cv.wait_until(lock, deadline, [this, &key, &is_ours, &in_flight]() {
+            if (is_ours(key)) {
+                return true;
+            }
+            return (requests.find(key) == requests.end()) and (in_flight() < MAX_FRAMES_IN_FLIGHT);
+        });
+
+        if (not can_send) {
+            continue;
+        }
 
-    if (not finished) {
-        return AccessReturnType::TIMEOUT;
+        // the same key twice in one batch is sent once, both get the same result
+        const auto request = requests.emplace(key, CanRequest{CanRequest::State::ISSUED, batch, {}});
+        if (request.second) {
+            stat_requests++;
+            if (not write_to_can(access.frame)) {
+                request.first->second.state = CanRequest::State::FAILED;
+                stat_failed++;
+            }
+        }
     }
 
-    if (request.state == CanRequest::State::FAILED) {
-        return AccessReturnType::FAILED;
+    const auto all_answered = [this, &accesses, &is_ours]() {
+        for (const auto& access : accesses) {
+            const auto key = request_key(access.frame);
+            if (is_ours(key) and requests.at(key).state == CanRequest::State::ISSUED) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    requests_cv.wait_until(lock, deadline, all_answered);
+
+    // all results are collected before the requests are removed, so duplicates within the batch get the same result
+    for (auto& access : accesses) {
+        const auto key = request_key(access.frame);
+        if (not is_ours(key)) {
+            // timed out waiting for an outstanding request with the same key
+            access.status = AccessReturnType::TIMEOUT;
+            continue;
+        }
+
+        const auto& request = requests.at(key);
+        switch (request.state) {
+        case CanRequest::State::ISSUED:
+            access.status = AccessReturnType::TIMEOUT;
+            break;
+        case CanRequest::State::FAILED:
+            access.status = AccessReturnType::FAILED;
+            break;
+        case CanRequest::State::COMPLETED:
+            access.status = AccessReturnType::SUCCESS;
+            memcpy(&access.payload, request.response.data(), sizeof(access.payload));
+            break;
+        }
     }
 
-    // success
-    if (return_payload) {
-        memcpy(return_payload, request.response.data(), sizeof(std::remove_pointer_t<decltype(return_payload)>));
+    for (const auto& access : accesses) {
+        const auto key = request_key(access.frame);
+        if (is_ours(key)) {
+            if (requests.at(key).state == CanRequest::State::ISSUED) {
+                stat_timeouts++;
+            }
+            requests.erase(key);
+        }
     }
 
-    return AccessReturnType::SUCCESS;
+    lock.unlock();
+    // wake up callers waiting for one of the keys
+    requests_cv.notify_all();
 }
 
-CanBroker::AccessReturnType CanBroker::read_data(dpm1000::def::ReadValueType value_type, float& result) {
-    const auto id = static_cast<std::underlying_type_t<decltype(value_type)>>(value_type);
-
-    struct can_frame frame;
-    dpm1000::request_data(frame, value_type);
-    dpm1000::set_header(frame, monitor_id, device_src);
+void CanBroker::read_batch(std::vector<ReadRequest>& read_requests) {
+    std::vector<Access> accesses(read_requests.size());
+    for (std::size_t i = 0; i < read_requests.size(); ++i) {
+        dpm1000::request_data(accesses[i].frame, read_requests[i].value_type);
+        dpm1000::set_header(accesses[i].frame, monitor_id, read_requests[i].device);
+    }
 
-    uint32_t tmp;
-    const auto status = dispatch_frame(frame, id, &tmp);
+    dispatch_frames(accesses);
 
-    if (status == AccessReturnType::SUCCESS) {
-        memcpy(&result, &tmp, sizeof(result));
+    for (std::size_t i = 0; i < read_requests.size(); ++i) {
+        read_requests[i].status = accesses[i].status;
+        if (accesses[i].status == AccessReturnType::SUCCESS) {
+            read_requests[i].value = accesses[i].payload;
+        }
     }
-
-    return status;
 }
 
-CanBroker::AccessReturnType CanBroker::read_data_int(dpm1000::def::ReadValueType value_type, uint32_t& result) {
-    const auto id = static_cast<std::underlying_type_t<decltype(value_type)>>(value_type);
+void CanBroker::set_batch(std::vector<SetRequest>& set_requests) {
+    std::vector<Access> accesses(set_requests.size());
+    for (std::size_t i = 0; i < set_requests.size(); ++i) {
+        dpm1000::set_data(accesses[i].frame, set_requests[i].value_type,
+                          to_payload(float_to_raw(set_requests[i].value)));
+        dpm1000::set_header(accesses[i].frame, monitor_id, set_requests[i].device);
+    }
 
-    struct can_frame frame;
-    dpm1000::request_data(frame, value_type);
-    dpm1000::set_header(frame, monitor_id, device_src);
+    dispatch_frames(accesses);
+
+    for (std::size_t i = 0; i < set_requests.size(); ++i) {
+        set_requests[i].status = accesses[i].status;
+    }
+}
 
-    uint32_t tmp;
-    const auto status = dispatch_frame(frame, id, &tmp);
+CanBroker::AccessReturnType CanBroker::read_data(uint8_t device, dpm1000::def::ReadValueType value_type,
+                                                 float& result) {
+    std::vector<ReadRequest> read_requests{{device, value_type}};
+    read_batch(read_requests);
 
-    if (status == AccessReturnType::SUCCESS) {
-        result = tmp;
+    if (read_requests[0].status == AccessReturnType::SUCCESS) {
+        result = read_requests[0].value_float();
     }
 
-    return status;
+    return read_requests[0].status;
 }
 
-CanBroker::AccessReturnType CanBroker::set_data(dpm1000::def::SetValueType value_type, float payload) {
-    const auto id = static_cast<std::underlying_type_t<decltype(value_type)>>(value_type);
+CanBroker::AccessReturnType CanBroker::read_data_int(uint8_t device, dpm1000::def::ReadValueType value_type,
+                                                     uint32_t& result) {
+    std::vector<ReadRequest> read_requests{{device, value_type}};
+    read_batch(read_requests);
+
+    if (read_requests[0].status == AccessReturnType::SUCCESS) {
+        result = read_requests[0].value;
+    }
 
-    uint8_t raw_payload[sizeof(payload)];
-    memcpy(raw_payload, &payload, sizeof(payload));
+    return read_requests[0].status;
+}
 
-    struct can_frame frame;
-    dpm1000::set_data(frame, value_type, {raw_payload[3], raw_payload[2], raw_payload[1], raw_payload[0]});
-    dpm1000::set_header(frame, monitor_id, device_src);
+CanBroker::AccessReturnType CanBroker::set_data(uint8_t device, dpm1000::def::SetValueType value_type, float payload) {
+    std::vector<SetRequest> set_requests{{device, value_type, payload}};
+    set_batch(set_requests);
 
-    return dispatch_frame(frame, id);
+    return set_requests[0].status;
 }
 
-CanBroker::AccessReturnType CanBroker::set_data_int(dpm1000::def::SetValueType value_type, uint32_t payload) {
-    const auto id = static_cast<std::underlying_type_t<decltype(value_type)>>(value_type);
+CanBroker::AccessReturnType CanBroker::set_data_int(uint8_t device, dpm1000::def::SetValueType value_type,
+                                                    uint32_t payload) {
+    std::vector<Access> accesses(1);
+    dpm1000::set_data(accesses[0].frame, value_type, to_payload(payload));
+    dpm1000::set_header(accesses[0].frame, monitor_id, device);
 
-    uint8_t raw_payload[sizeof(payload)];
-    memcpy(raw_payload, &payload, sizeof(payload));
+    dispatch_frames(accesses);
 
-    struct can_frame frame;
-    dpm1000::set_data(frame, value_type, {raw_payload[3], raw_payload[2], raw_payload[1], raw_payload[0]});
-    dpm1000::set_header(frame, monitor_id, device_src);
+    return accesses[0].status;
+}
 
-    return dispatch_frame(frame, id);
+CanBroker::Statistics CanBroker::get_statistics() const {
+    return {stat_requests, stat_responses, stat_failed, stat_timeouts};
 }
 
-void CanBroker::write_to_can(const struct can_frame& frame) {
-    write(can_fd, &frame, sizeof(frame));
+bool CanBroker::write_to_can(const struct can_frame& frame) {
+    return write(can_fd, &frame, sizeof(frame)) == sizeof(frame);
 }
 
 void CanBroker::handle_can_input(const struct can_frame& frame) {
@@ -201,21 +324,31 @@ void CanBroker::handle_can_input(const struct can_frame& frame) {
         return;
     }
 
-    std::unique_lock<std::mutex> request_lock(request.mutex);
-    if ((request.state != CanRequest::State::ISSUED) or (request.msg_type != dpm1000::parse_msg_type(frame))) {
+    if (not dpm1000::is_response(frame)) {
+        return;
+    }
+
+    const auto key =
+        request_key(dpm1000::parse_source(frame), dpm1000::parse_command(frame), dpm1000::parse_msg_type(frame));
+
+    std::unique_lock<std::mutex> lock(requests_mtx);
+    const auto request = requests.find(key);
+    if ((request == requests.end()) or (request->second.state != CanRequest::State::ISSUED)) {
         return;
     }
 
+    stat_responses++;
     if (dpm1000::is_error_flag_set(frame)) {
-        request.state = CanRequest::State::FAILED;
+        request->second.state = CanRequest::State::FAILED;
+        stat_failed++;
     } else {
         // this is ugly
-        for (auto i = 0; i < request.response.size(); ++i) {
-            request.response[i] = frame.data[7 - i];
+        for (auto i = 0; i < request->second.response.size(); ++i) {
+            request->second.response[i] = frame.data[7 - i];
         }
-        request.state = CanRequest::State::COMPLETED;
+        request->second.state = CanRequest::State::COMPLETED;
     }
 
-    request_lock.unlock();
-    request.cv.notify_one();
+    lock.unlock();
+    requests_cv.notify_all();
 }
@@ -3,29 +3,40 @@
 #ifndef DPM1000_MAIN_DC_CAN_BROKER_HPP
 #define DPM1000_MAIN_DC_CAN_BROKER_HPP
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <functional>
+#include <map>
 #include <mutex>
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include <can/protocol/dpm1000.hpp>
 
 struct CanRequest {
     enum class State {
-        IDLE,
         ISSUED,
         COMPLETED,
         FAILED,
-    } state{State::IDLE};
+    } state{State::ISSUED};
 
-    uint16_t msg_type;
+    uint64_t batch;
     std::array<uint8_t, 4> response;
-    std::condition_variable cv;
-    std::mutex mutex;
 };
 
+/*
+ Access to any number of DPM1000 modules on one CAN bus.
+
+ Requests are keyed by (device, command, value type): requests with different keys are outstanding at the same time,
+ a request with the same key as an outstanding one waits until that one is answered, as the responses cannot be told
+ apart. The batch functions issue up to MAX_FRAMES_IN_FLIGHT frames at once and wait for all responses, so reading N
+ values takes about N / MAX_FRAMES_IN_FLIGHT round-trips instead of N. A frame that cannot be sent fails its request
+ at once instead of waiting for the timeout.
+*/
 class CanBroker {
 public:
     enum class AccessReturnType {
@@ -34,30 +45,79 @@ public:
         TIMEOUT,
         NOT_READY,
     };
-    CanBroker(const std::string& interface_name, uint8_t _device_src);
 
-    AccessReturnType read_data(can::protocol::dpm1000::def::ReadValueType, float& result);
-    AccessReturnType read_data_int(can::protocol::dpm1000::def::ReadValueType, uint32_t& result);
+    struct ReadRequest {
+        uint8_t device;
+        can::protocol::dpm1000::def::ReadValueType value_type;
+        AccessReturnType status{AccessReturnType::NOT_READY};
+        uint32_t value{0};
+
+        float value_float() const;
+    };
+
+    struct SetRequest {
+        uint8_t device;
+        can::protocol::dpm1000::def::SetValueType value_type;
+        float value;
+        AccessReturnType status{AccessReturnType::NOT_READY};
+    };
+
+    struct Statistics {
+        uint64_t requests{0};
+        uint64_t responses{0};
+        uint64_t failed{0};
+        uint64_t timeouts{0};
+    };
+
+    // frames of a batch sent before their responses arrive, the transmit queue of a CAN interface is short (10 frames
+    // by default) and frames exceeding it are dropped with ENOBUFS
+    constexpr static std::size_t MAX_FRAMES_IN_FLIGHT = 8;
 
-    AccessReturnType set_data(can::protocol::dpm1000::def::SetValueType, float value);
-    AccessReturnType set_data_int(can::protocol::dpm1000::def::SetValueType, uint32_t value);
-    void set_state(bool enabled);
+    explicit CanBroker(const std::string& interface_name);
+    // takes ownership of an already bound CAN socket
+    explicit CanBroker(int can_fd);
+
+    AccessReturnType read_data(uint8_t device, can::protocol::dpm1000::def::ReadValueType, float& result);
+    AccessReturnType read_data_int(uint8_t device, can::protocol::dpm1000::def::ReadValueType, uint32_t& result);
+
+    AccessReturnType set_data(uint8_t device, can::protocol::dpm1000::def::SetValueType, float value);
+    AccessReturnType set_data_int(uint8_t device, can::protocol::dpm1000::def::SetValueType, uint32_t value);
+    void set_state(uint8_t device, bool enabled);
+
+    // pipelined accesses, the status of every request is set when the function returns
+    void read_batch(std::vector<ReadRequest>& requests);
+    void set_batch(std::vector<SetRequest>& requests);
+
+    Statistics get_statistics() const;
 
     ~CanBroker();
 
 private:
     constexpr static auto ACCESS_TIMEOUT = std::chrono::milliseconds(250);
+
+    struct Access {
+        struct can_frame frame;
+        AccessReturnType status{AccessReturnType::TIMEOUT};
+        uint32_t payload{0};
+    };
+
     void loop();
 
-    void write_to_can(const struct can_frame& frame);
-    AccessReturnType dispatch_frame(const struct can_frame& frame, uint16_t id, uint32_t* result = nullptr);
+    // false if the frame could not be sent
+    bool write_to_can(const struct can_frame& frame);
+    void dispatch_frames(std::vector<Access>& accesses);
 
     void handle_can_input(const struct can_frame& frame);
 
-    uint8_t device_src;
+    std::mutex requests_mtx;
+    std::condition_variable requests_cv;
+    std::map<uint32_t, CanRequest> requests;
+    uint64_t last_batch{0};
 
-    std::mutex access_mtx;
-    CanRequest request;
+    std::atomic<uint64_t> stat_requests{0};
+    std::atomic<uint64_t> stat_responses{0};
+    std::atomic<uint64_t> stat_failed{0};
+    std::atomic<uint64_t> stat_timeouts{0};
 
     const uint8_t monitor_id{0xf0};
 
@@ -67,4 +127,7 @@ private:
     int can_fd{-1};
 };
 
+// opens a raw CAN socket bound to the interface, throws on failure
+int open_can_socket(const std::string& interface_name);
+
 #endif // DPM1000_MAIN_DC_CAN_BROKER_HPP
@@ -2,10 +2,13 @@
 // Copyright Pionix GmbH and Contributors to EVerest
 #include "power_supply_DCImpl.hpp"
 
+#include <algorithm>
 #include <memory>
+#include <sstream>
 
 #include "can_broker.hpp"
 
+#include <boost/algorithm/string/trim.hpp>
 #include <fmt/core.h>
 #include <utils/formatter.hpp>
 
@@ -95,13 +98,60 @@ static std::string alarm_to_string(uint32_t alarm) {
     return alarmflags;
 }
 
+static std::vector<uint8_t> parse_device_addresses(int device_address, const std::string& parallel_device_addresses) {
+    std::vector<uint8_t> devices{static_cast<uint8_t>(device_address)};
+
+    std::stringstream stream(parallel_device_addresses);
+    std::string address;
+    while (std::getline(stream, address, ',')) {
+        boost::algorithm::trim(address);
+        if (address.empty()) {
+            continue;
+        }
+        int value = -1;
+        try {
+            value = std::stoi(address);
+        } catch (const std::exception&) {
+        }
+        if (value < 0 or value > 0xFF) {
+            EVLOG_AND_THROW(Everest::EverestConfigError("Invalid device address in parallel_device_addresses: " +
+                                                        address));
+        }
+        if (std::find(devices.begin(), devices.end(), value) == devices.end()) {
+            devices.push_back(static_cast<uint8_t>(value));
+        }
+    }
+
+    return devices;
+}
+
+// additional values read from every module with debug_print_all_telemetry
+static const std::vector<std::pair<dpm1000::def::ReadValueType, const char*>> debug_telemetry = {
+    {dpm1000::def::ReadValueType::CURRENT_REAL_PART, "current_real_part"},
+    {dpm1000::def::ReadValueType::CURRENT_LIMIT, "current_limit"},
+    {dpm1000::def::ReadValueType::DCDC_TEMPERATURE, "dcdc_temperature"},
+    {dpm1000::def::ReadValueType::AC_VOLTAGE, "ac_voltage"},
+    {dpm1000::def::ReadValueType::VOLTAGE_LIMIT, "voltage_limit"},
+    {dpm1000::def::ReadValueType::PFC0_VOLTAGE, "pfc0_voltage"},
+    {dpm1000::def::ReadValueType::PFC1_VOLTAGE, "pfc1_voltage"},
+    {dpm1000::def::ReadValueType::ENV_TEMPERATURE, "env_temperature"},
+    {dpm1000::def::ReadValueType::AC_VOLTAGE_PHASE_A, "ac_voltage_phase_a"},
+    {dpm1000::def::ReadValueType::AC_VOLTAGE_PHASE_B, "ac_voltage_phase_b"},
+    {dpm1000::def::ReadValueType::AC_VOLTAGE_PHASE_C, "ac_voltage_phase_c"},
+    {dpm1000::def::ReadValueType::PFC_TEMPERATURE, "pfc_temperature"},
+    {dpm1000::def::ReadValueType::POWER_LIMIT, "power_limit"},
+};
+
 void power_supply_DCImpl::init() {
     current = 0;
     voltage = 300;
 
-    config_current_limit = mod->config.current_limit_A;
+    devices = parse_device_addresses(mod->config.device_address, mod->config.parallel_device_addresses);
+
+    // the limits of the configuration are per module
+    config_current_limit = mod->config.current_limit_A * devices.size();
     config_voltage_limit = mod->config.voltage_limit_V;
-    config_power_limit = mod->config.power_limit_W;
+    config_power_limit = mod->config.power_limit_W * devices.size();
 
     if (!mod->config.discharge_gpio_chip.empty()) {
         discharge_gpio.open(mod->config.discharge_gpio_chip, mod->config.discharge_gpio_line,
@@ -109,10 +159,12 @@ void power_supply_DCImpl::init() {
         discharge_gpio.set_output(false);
     }
 
-    can_broker = std::make_unique<CanBroker>(mod->config.device, mod->config.device_address);
+    can_broker = std::make_unique<CanBroker>(mod->config.device);
 
-    // ensure the module is switched off
-    can_broker->set_state(false);
+    // ensure the modules are switched off
+    for (const auto device : devices) {
+        can_broker->set_state(device, false);
+    }
 
     // Configure module for series or parallel mode
     // 0 is automatic switching mode
@@ -131,8 +183,14 @@ void power_supply_DCImpl::init() {
     }
 
     // WTF: This really uses a float to set one of the three modes automatic, series or parallel.
-    auto status = can_broker->set_data(dpm1000::def::SetValueType::SERIES_PARALLEL_MODE, series_parallel_mode);
-    log_status_on_fail("Set current limit failed", status);
+    std::vector<CanBroker::SetRequest> modes;
+    for (const auto device : devices) {
+        modes.push_back({device, dpm1000::def::SetValueType::SERIES_PARALLEL_MODE, series_parallel_mode});
+    }
+    can_broker->set_batch(modes);
+    for (const auto& mode : modes) {
+        log_status_on_fail(fmt::format("Set series parallel mode of module {} failed", mode.device), mode.status);
+    }
 }
 
 void power_supply_DCImpl::ready() {
@@ -151,62 +209,93 @@ void power_supply_DCImpl::ready() {
 
     while (true) {
         std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        const auto cycle_start = std::chrono::steady_clock::now();
+
+        // Send voltage, current and power limits to all modules at once
+        std::vector<CanBroker::SetRequest> setpoints;
+        for (const auto device : devices) {
+            setpoints.push_back({device, dpm1000::def::SetValueType::CURRENT_LIMIT, current});
+            setpoints.push_back({device, dpm1000::def::SetValueType::DEFAULT_CURRENT_LIMIT, 1.0});
+            setpoints.push_back({device, dpm1000::def::SetValueType::VOLTAGE, voltage});
+            setpoints.push_back({device, dpm1000::def::SetValueType::POWER_LIMIT, 1.0});
+        }
+        can_broker->set_batch(setpoints);
+        for (const auto& setpoint : setpoints) {
+            log_status_on_fail(fmt::format("Set value 0x{:04x} of module {} failed",
+                                           static_cast<uint16_t>(setpoint.value_type), setpoint.device),
+                               setpoint.status);
+        }
 
-        // Send voltage, current and power limits
-
-        auto status = can_broker->set_data(dpm1000::def::SetValueType::CURRENT_LIMIT, current);
-        log_status_on_fail("Set current limit failed", status);
-
-        status = can_broker->set_data(dpm1000::def::SetValueType::DEFAULT_CURRENT_LIMIT, 1.0);
-        log_status_on_fail("Set default current limit failed", status);
-
-        status = can_broker->set_data(dpm1000::def::SetValueType::VOLTAGE, voltage);
-        log_status_on_fail("Set voltage failed", status);
+        // Read voltage, current, alarm flags and optionally all other telemetry of all modules in one batch
+        std::vector<CanBroker::ReadRequest> telemetry;
+        for (const auto device : devices) {
+            telemetry.push_back({device, dpm1000::def::ReadValueType::VOLTAGE});
+            telemetry.push_back({device, dpm1000::def::ReadValueType::CURRENT});
+            telemetry.push_back({device, dpm1000::def::ReadValueType::ALARM});
+            if (mod->config.debug_print_all_telemetry) {
+                for (const auto& value : debug_telemetry) {
+                    telemetry.push_back({device, value.first});
+                }
+            }
+        }
+        can_broker->read_batch(telemetry);
 
-        status = can_broker->set_data(dpm1000::def::SetValueType::POWER_LIMIT, 1.0);
-        log_status_on_fail("Set current limit failed", status);
+        const auto find = [&telemetry](uint8_t device, dpm1000::def::ReadValueType value_type) {
+            return std::find_if(telemetry.begin(), telemetry.end(), [device, value_type](const auto& request) {
+                return request.device == device and request.value_type == value_type;
+            });
+        };
 
-        // Read voltage and current
-        float tmp;
         types::power_supply_DC::VoltageCurrent vc;
+        vc.voltage_V = 0;
+        vc.current_A = 0;
+        bool complete = true;
+
+        for (const auto device : devices) {
+            const auto module_voltage = find(device, dpm1000::def::ReadValueType::VOLTAGE);
+            log_status_on_fail(fmt::format("Read voltage of module {} failed", device), module_voltage->status);
+            const auto module_current = find(device, dpm1000::def::ReadValueType::CURRENT);
+            log_status_on_fail(fmt::format("Read current of module {} failed", device), module_current->status);
+
+            if (module_voltage->status != CanBroker::AccessReturnType::SUCCESS or
+                module_current->status != CanBroker::AccessReturnType::SUCCESS) {
+                complete = false;
+                continue;
+            }
 
-        status = can_broker->read_data(dpm1000::def::ReadValueType::VOLTAGE, tmp);
-        log_status_on_fail("Read voltage failed", status);
-        if (status != CanBroker::AccessReturnType::SUCCESS) {
-            continue;
+            // the outputs are connected in parallel, so the highest voltage is the one on the output
+            vc.voltage_V = std::max<float>(vc.voltage_V, module_voltage->value_float());
+            vc.current_A += module_current->value_float();
+
+            // read alarm flags
+            const auto alarm = find(device, dpm1000::def::ReadValueType::ALARM);
+            log_status_on_fail(fmt::format("Read alarm of module {} failed", device), alarm->status);
+            if (alarm->status == CanBroker::AccessReturnType::SUCCESS) {
+                if (last_alarm_flags[device] != alarm->value) {
+                    auto alarmflags = alarm_to_string(alarm->value);
+                    if (alarmflags != "") {
+                        EVLOG_warning << "Alarm flags of module " << static_cast<int>(device)
+                                      << " changed: " << alarmflags;
+                    } else {
+                        EVLOG_info << "All Alarm flags of module " << static_cast<int>(device) << " cleared.";
+                    }
+                    last_alarm_flags[device] = alarm->value;
+                }
+            }
         }
-        vc.voltage_V = tmp;
 
-        status = can_broker->read_data(dpm1000::def::ReadValueType::CURRENT, tmp);
-        log_status_on_fail("Read current failed", status);
-        if (status != CanBroker::AccessReturnType::SUCCESS) {
+        // Without the current of every module the output current would be too low
+        if (not complete) {
             continue;
         }
 
         // Publish voltage and current var
         // Current scaling depends on series/parallel mode operation.
-        vc.current_A = tmp;
         if (parallel_mode) {
             vc.current_A *= 2.;
         }
         publish_voltage_current(vc);
 
-        // read alarm flags
-        uint32_t alarm = 0;
-        status = can_broker->read_data_int(dpm1000::def::ReadValueType::ALARM, alarm);
-        log_status_on_fail("Read alarm failed", status);
-        if (status == CanBroker::AccessReturnType::SUCCESS) {
-            if (last_alarm_flags != alarm) {
-                auto alarmflags = alarm_to_string(alarm);
-                if (alarmflags != "") {
-                    EVLOG_warning << "Alarm flags changed: " << alarmflags;
-                } else {
-                    EVLOG_info << "All Alarm flags cleared.";
-                }
-                last_alarm_flags = alarm;
-            }
-        }
-
         // Discharge output if it is higher then setpoint voltage.
         // Note that this has no timeout, so HW must be designed to sustain the worst case load (e.g. 1000V) continously
         if (vc.voltage_V > (voltage + 10)) {
@@ -216,71 +305,41 @@ void power_supply_DCImpl::ready() {
         }
 
         if (mod->config.debug_print_all_telemetry) {
-            // read additional meta data
-            float current_real_part = 0, current_limit = 0, dcdc_temperature = 0, ac_voltage = 0, voltage_limit = 0,
-                  pfc0_voltage = 0, pfc1_voltage = 0, env_temperature = 0, ac_voltage_phase_a = 0,
-                  ac_voltage_phase_b = 0, ac_voltage_phase_c = 0, pfc_temperature = 0, power_limit = 0;
-            status = can_broker->read_data(dpm1000::def::ReadValueType::CURRENT_REAL_PART, current_real_part);
-            log_status_on_fail("Read CURRENT_REAL_PART failed", status);
-            status = can_broker->read_data(dpm1000::def::ReadValueType::CURRENT_LIMIT, current_limit);
-            log_status_on_fail("Read CURRENT_LIMIT failed", status);
-
-            status = can_broker->read_data(dpm1000::def::ReadValueType::DCDC_TEMPERATURE, dcdc_temperature);
-            log_status_on_fail("Read DCDC_TEMPERATURE failed", status);
-            status = can_broker->read_data(dpm1000::def::ReadValueType::AC_VOLTAGE, ac_voltage);
-            log_status_on_fail("Read AC_VOLTAGE failed", status);
-            status = can_broker->read_data(dpm1000::def::ReadValueType::VOLTAGE_LIMIT, voltage_limit);
-            log_status_on_fail("Read VOLTAGE_LIMIT failed", status);
-            status = can_broker->read_data(dpm1000::def::ReadValueType::PFC0_VOLTAGE, pfc0_voltage);
-            log_status_on_fail("Read PFC0_VOLTAGE failed", status);
-            status = can_broker->read_data(dpm1000::def::ReadValueType::PFC1_VOLTAGE, pfc1_voltage);
-            log_status_on_fail("Read PFC1_VOLTAGE failed", status);
-            status = can_broker->read_data(dpm1000::def::ReadValueType::ENV_TEMPERATURE, env_temperature);
-            log_status_on_fail("Read ENV_TEMPERATURE failed", status);
-
-            status = can_broker->read_data(dpm1000::def::ReadValueType::AC_VOLTAGE_PHASE_A, ac_voltage_phase_a);
-            log_status_on_fail("Read AC_VOLTAGE_PHASE_A failed", status);
-            status = can_broker->read_data(dpm1000::def::ReadValueType::AC_VOLTAGE_PHASE_B, ac_voltage_phase_b);
-            log_status_on_fail("Read AC_VOLTAGE_PHASE_B failed", status);
-
-            status = can_broker->read_data(dpm1000::def::ReadValueType::AC_VOLTAGE_PHASE_C, ac_voltage_phase_c);
-            log_status_on_fail("Read AC_VOLTAGE_PHASE_C failed", status);
-
-            status = can_broker->read_data(dpm1000::def::ReadValueType::PFC_TEMPERATURE, pfc_temperature);
-            log_status_on_fail("Read PFC_TEMPERATURE failed", status);
-
-            status = can_broker->read_data(dpm1000::def::ReadValueType::POWER_LIMIT, power_limit);
-            log_status_on_fail("Read POWER_LIMIT failed", status);
-
-            status = can_broker->read_data(dpm1000::def::ReadValueType::ENV_TEMPERATURE, env_temperature);
-            log_status_on_fail("Read ENV_TEMPERATURE failed", status);
-
-            EVLOG_info << fmt::format(
-                "set_voltage {} set_current {} vc.current_A {} vc.voltage_V {} current_real_part {} current_limit {} "
-                "dcdc_temperature {} ac_voltage {} "
-                "voltage_limit "
-                "{} pfc0_voltage {} pfc1_voltage {} env_temperature {} ac_voltage_phase_a {} ac_voltage_phase_b {} "
-                "ac_voltage_phase_c {} pfc_temperature {} power_limit {}",
-                voltage, current, vc.current_A, vc.voltage_V, current_real_part, current_limit, dcdc_temperature,
-                ac_voltage, voltage_limit, pfc0_voltage, pfc1_voltage, env_temperature, ac_voltage_phase_a,
-                ac_voltage_phase_b, ac_voltage_phase_c, pfc_temperature, power_limit);
+            const auto cycle_time =
+                std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - cycle_start);
+            const auto statistics = can_broker->get_statistics();
+            EVLOG_info << fmt::format("set_voltage {} set_current {} vc.current_A {} vc.voltage_V {} telemetry of {} "
+                                      "modules refreshed in {} ms (requests {} responses {} failed {} timeouts {})",
+                                      voltage, current, vc.current_A, vc.voltage_V, devices.size(), cycle_time.count(),
+                                      statistics.requests, statistics.responses, statistics.failed,
+                                      statistics.timeouts);
+
+            for (const auto device : devices) {
+                std::string values;
+                for (const auto& value : debug_telemetry) {
+                    const auto request = find(device, value.first);
+                    log_status_on_fail(fmt::format("Read {} of module {} failed", value.second, device),
+                                       request->status);
+                    values += fmt::format(" {} {}", value.second, request->value_float());
+                }
+                EVLOG_info << fmt::format("module {}:{}", device, values);
+            }
         }
     }
 }
 
 void power_supply_DCImpl::handle_setMode(types::power_supply_DC::Mode& mode,
                                          types::power_supply_DC::ChargingPhase& phase) {
-    if (mode == types::power_supply_DC::Mode::Export) {
-        can_broker->set_state(true);
-    } else {
-        can_broker->set_state(false);
+    for (const auto device : devices) {
+        can_broker->set_state(device, mode == types::power_supply_DC::Mode::Export);
     }
 }
 
 void power_supply_DCImpl::handle_setExportVoltageCurrent(double& voltage, double& current) {
     if (voltage <= config_voltage_limit && voltage >= config_min_voltage_limit && current <= config_current_limit) {
         this->voltage = voltage;
-        this->current = current / 100.;
+        // equal share of the current for every module
+        this->current = current / 100. / devices.size();
     } else {
         EVLOG_error << fmt::format("Out of range voltage/current settings ignored: {}V / {}A", voltage, current);
     }
@@ -14,6 +14,8 @@
 
 // ev@75ac1216-19eb-4182-a85c-820f1fc2c091:v1
 #include <atomic>
+#include <map>
+#include <vector>
 
 #include <gpio.hpp>
 // ev@75ac1216-19eb-4182-a85c-820f1fc2c091:v1
@@ -54,7 +56,7 @@ private:
     // ev@3370e4dd-95f4-47a9-aaec-ea76f34a66c9:v1
     std::atomic<float> voltage;
     std::atomic<float> current;
-    std::atomic<uint32_t> last_alarm_flags{0};
+    std::map<uint8_t, uint32_t> last_alarm_flags;
 
     float config_current_limit{0};
     float config_voltage_limit{0};
@@ -63,6 +65,8 @@ private:
 
     Everest::Gpio discharge_gpio;
     bool parallel_mode{false};
+    // device_address first, then parallel_device_addresses
+    std::vector<uint8_t> devices;
     // ev@3370e4dd-95f4-47a9-aaec-ea76f34a66c9:v1
 };
 
@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <memory>
+#include <thread>
+
+#include <sys/socket.h>
+
+#include "can_broker.hpp"
+#include "simulated_modules.hpp"
+
+namespace {
+
+namespace dpm1000 = can::protocol::dpm1000;
+using ReturnStatus = CanBroker::AccessReturnType;
+
+constexpr auto c_interface = "vcan0";
+constexpr auto c_latency = std::chrono::milliseconds(20);
+
+class CanBrokerTest : public ::testing::Test {
+protected:
+    void start(const std::vector<uint8_t>& devices, std::chrono::microseconds latency = c_latency) {
+        const auto sockets = open_test_sockets(c_interface);
+        modules = std::make_unique<SimulatedModules>(sockets.second, devices, latency);
+        broker = std::make_unique<CanBroker>(sockets.first);
+    }
+
+    void TearDown() override {
+        broker.reset();
+        modules.reset();
+    }
+
+    std::unique_ptr<SimulatedModules> modules;
+    std::unique_ptr<CanBroker> broker;
+};
+
+TEST_F(CanBrokerTest, read_and_set_single_module) {
+    start({3});
+    modules->set_value(3, dpm1000::def::ReadValueType::VOLTAGE, 400.5);
+    modules->set_value_int(3, dpm1000::def::ReadValueType::ALARM, 0x12345678);
+
+    float voltage = 0;
+    EXPECT_EQ(broker->read_data(3, dpm1000::def::ReadValueType::VOLTAGE, voltage), ReturnStatus::SUCCESS);
+    EXPECT_FLOAT_EQ(voltage, 400.5);
+
+    uint32_t alarm = 0;
+    EXPECT_EQ(broker->read_data_int(3, dpm1000::def::ReadValueType::ALARM, alarm), ReturnStatus::SUCCESS);
+    EXPECT_EQ(alarm, 0x12345678);
+
+    EXPECT_EQ(broker->set_data(3, dpm1000::def::SetValueType::VOLTAGE, 650), ReturnStatus::SUCCESS);
+    EXPECT_FLOAT_EQ(modules->get_setpoint(3, dpm1000::def::SetValueType::VOLTAGE), 650);
+
+    // a module that is not on the bus
+    EXPECT_EQ(broker->read_data(4, dpm1000::def::ReadValueType::VOLTAGE, voltage), ReturnStatus::TIMEOUT);
+}
+
+TEST_F(CanBrokerTest, batch_of_several_modules) {
+    const std::vector<uint8_t> devices{0, 1, 2};
+    start(devices);
+
+    std::vector<CanBroker::ReadRequest> requests;
+    for (const auto device : devices) {
+        modules->set_value(device, dpm1000::def::ReadValueType::VOLTAGE, 500 + device);
+        modules->set_value(device, dpm1000::def::ReadValueType::CURRENT, 0.1 * device);
+        modules->set_value_int(device, dpm1000::def::ReadValueType::ALARM, device);
+        requests.push_back({device, dpm1000::def::ReadValueType::VOLTAGE});
+        requests.push_back({device, dpm1000::def::ReadValueType::CURRENT});
+        requests.push_back({device, dpm1000::def::ReadValueType::ALARM});
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+    broker->read_batch(requests);
+    const auto duration = std::chrono::steady_clock::now() - start_time;
+
+    for (const auto& request : requests) {
+        ASSERT_EQ(request.status, ReturnStatus::SUCCESS);
+        switch (request.value_type) {
+        case dpm1000::def::ReadValueType::VOLTAGE:
+            EXPECT_FLOAT_EQ(request.value_float(), 500 + request.device);
+            break;
+        case dpm1000::def::ReadValueType::CURRENT:
+            EXPECT_FLOAT_EQ(request.value_float(), 0.1f * request.device);
+            break;
+        default:
+            EXPECT_EQ(request.value, request.device);
+            break;
+        }
+    }
+
+    // the requests are pipelined, sequential requests would take 9 times the latency
+    EXPECT_LT(duration, 4 * c_latency);
+    EXPECT_EQ(modules->received_requests(), requests.size());
+
+    std::vector<CanBroker::SetRequest> setpoints;
+    for (const auto device : devices) {
+        setpoints.push_back({device, dpm1000::def::SetValueType::VOLTAGE, 400});
+        setpoints.push_back({device, dpm1000::def::SetValueType::CURRENT_LIMIT, 0.25});
+    }
+    broker->set_batch(setpoints);
+    for (const auto& setpoint : setpoints) {
+        EXPECT_EQ(setpoint.status, ReturnStatus::SUCCESS);
+        EXPECT_FLOAT_EQ(modules->get_setpoint(setpoint.device, setpoint.value_type), setpoint.value);
+    }
+}
+
+TEST_F(CanBrokerTest, failing_and_missing_modules) {
+    start({0, 1, 2});
+    for (const uint8_t device : {0, 1, 2}) {
+        modules->set_value(device, dpm1000::def::ReadValueType::VOLTAGE, 300);
+    }
+    modules->set_failing(1, true);
+    modules->set_silent(2, true);
+
+    std::vector<CanBroker::ReadRequest> requests{
+        {0, dpm1000::def::ReadValueType::VOLTAGE},
+        {1, dpm1000::def::ReadValueType::VOLTAGE},
+        {2, dpm1000::def::ReadValueType::VOLTAGE},
+        // not known by the simulated module
+        {0, dpm1000::def::ReadValueType::PFC_TEMPERATURE},
+    };
+    broker->read_batch(requests);
+
+    EXPECT_EQ(requests[0].status, ReturnStatus::SUCCESS);
+    EXPECT_EQ(requests[1].status, ReturnStatus::FAILED);
+    EXPECT_EQ(requests[2].status, ReturnStatus::TIMEOUT);
+    EXPECT_EQ(requests[3].status, ReturnStatus::FAILED);
+
+    const auto statistics = broker->get_statistics();
+    EXPECT_EQ(statistics.requests, 4);
+    EXPECT_EQ(statistics.responses, 3);
+    EXPECT_EQ(statistics.failed, 2);
+    EXPECT_EQ(statistics.timeouts, 1);
+
+    // the silent module must not block later requests
+    modules->set_silent(2, false);
+    float voltage = 0;
+    EXPECT_EQ(broker->read_data(2, dpm1000::def::ReadValueType::VOLTAGE, voltage), ReturnStatus::SUCCESS);
+    EXPECT_FLOAT_EQ(voltage, 300);
+}
+
+TEST_F(CanBrokerTest, frames_in_flight_are_capped) {
+    const std::vector<uint8_t> devices{0, 1, 2, 3};
+    start(devices, std::chrono::milliseconds(2));
+
+    // like the telemetry of all modules with debug_print_all_telemetry
+    const std::vector<dpm1000::def::ReadValueType> value_types{
+        dpm1000::def::ReadValueType::VOLTAGE,          dpm1000::def::ReadValueType::CURRENT_REAL_PART,
+        dpm1000::def::ReadValueType::CURRENT_LIMIT,    dpm1000::def::ReadValueType::DCDC_TEMPERATURE,
+        dpm1000::def::ReadValueType::AC_VOLTAGE,       dpm1000::def::ReadValueType::VOLTAGE_LIMIT,
+        dpm1000::def::ReadValueType::CURRENT,          dpm1000::def::ReadValueType::PFC0_VOLTAGE,
+        dpm1000::def::ReadValueType::PFC1_VOLTAGE,     dpm1000::def::ReadValueType::ENV_TEMPERATURE,
+        dpm1000::def::ReadValueType::PFC_TEMPERATURE,  dpm1000::def::ReadValueType::POWER_LIMIT,
+        dpm1000::def::ReadValueType::ALARM,
+    };
+    std::vector<CanBroker::ReadRequest> requests;
+    for (const auto device : devices) {
+        for (const auto value_type : value_types) {
+            modules->set_value_int(device, value_type, device);
+            requests.push_back({device, value_type});
+        }
+    }
+
+    broker->read_batch(requests);
+    for (const auto& request : requests) {
+        ASSERT_EQ(request.status, ReturnStatus::SUCCESS);
+        EXPECT_EQ(request.value, request.device);
+    }
+    EXPECT_EQ(modules->received_requests(), requests.size());
+    EXPECT_LE(modules->max_pending_responses(), CanBroker::MAX_FRAMES_IN_FLIGHT);
+}
+
+TEST_F(CanBrokerTest, frames_that_cannot_be_sent_fail_at_once) {
+    std::array<int, 2> fds;
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds.data()), 0);
+    modules = std::make_unique<SimulatedModules>(fds[1], std::vector<uint8_t>{0}, c_latency);
+    broker = std::make_unique<CanBroker>(fds[0]);
+    modules->set_value(0, dpm1000::def::ReadValueType::VOLTAGE, 200);
+
+    // every write fails, like with ENOBUFS on a full transmit queue
+    std::signal(SIGPIPE, SIG_IGN);
+    ASSERT_EQ(shutdown(fds[0], SHUT_WR), 0);
+
+    std::vector<CanBroker::ReadRequest> requests{
+        {0, dpm1000::def::ReadValueType::VOLTAGE},
+        {0, dpm1000::def::ReadValueType::CURRENT},
+    };
+    const auto start_time = std::chrono::steady_clock::now();
+    broker->read_batch(requests);
+    const auto duration = std::chrono::steady_clock::now() - start_time;
+
+    EXPECT_EQ(requests[0].status, ReturnStatus::FAILED);
+    EXPECT_EQ(requests[1].status, ReturnStatus::FAILED);
+    EXPECT_LT(duration, c_latency);
+    EXPECT_EQ(broker->get_statistics().failed, 2);
+    EXPECT_EQ(modules->received_requests(), 0);
+}
+
+TEST_F(CanBrokerTest, same_key_is_not_outstanding_twice) {
+    start({0});
+    modules->set_value(0, dpm1000::def::ReadValueType::VOLTAGE, 200);
+
+    // the same value twice in one batch is requested once
+    std::vector<CanBroker::ReadRequest> requests{
+        {0, dpm1000::def::ReadValueType::VOLTAGE},
+        {0, dpm1000::def::ReadValueType::VOLTAGE},
+    };
+    broker->read_batch(requests);
+    EXPECT_EQ(requests[0].status, ReturnStatus::SUCCESS);
+    EXPECT_EQ(requests[1].status, ReturnStatus::SUCCESS);
+    EXPECT_FLOAT_EQ(requests[1].value_float(), 200);
+    EXPECT_EQ(modules->received_requests(), 1);
+
+    // concurrent callers with the same key wait for each other instead of sharing a response
+    std::vector<std::thread> callers;
+    std::vector<ReturnStatus> results(4);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        callers.emplace_back([this, &results, i]() {
+            float voltage;
+            results[i] = broker->read_data(0, dpm1000::def::ReadValueType::VOLTAGE, voltage);
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+    for (const auto result : results) {
+        EXPECT_EQ(result, ReturnStatus::SUCCESS);
+    }
+    EXPECT_EQ(modules->received_requests(), 1 + results.size());
+}
+
+TEST_F(CanBrokerTest, read_and_set_of_the_same_value_type) {
+    start({0});
+    // DEFAULT_CURRENT_LIMIT has the same value type for reading and setting
+    modules->set_value(0, dpm1000::def::ReadValueType::DEFAULT_CURRENT_LIMIT, 0.5);
+
+    std::thread setter([this]() {
+        EXPECT_EQ(broker->set_data(0, dpm1000::def::SetValueType::DEFAULT_CURRENT_LIMIT, 1.0), ReturnStatus::SUCCESS);
+    });
+    float limit = 0;
+    EXPECT_EQ(broker->read_data(0, dpm1000::def::ReadValueType::DEFAULT_CURRENT_LIMIT, limit), ReturnStatus::SUCCESS);
+    EXPECT_FLOAT_EQ(limit, 0.5);
+    setter.join();
+    EXPECT_FLOAT_EQ(modules->get_setpoint(0, dpm1000::def::SetValueType::DEFAULT_CURRENT_LIMIT), 1.0);
+}
+
+} // namespace
@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include "simulated_modules.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#include <endian.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "can_broker.hpp"
+
+namespace dpm1000 = can::protocol::dpm1000;
+
+template <typename EnumType> static inline auto to_underlying(EnumType value) {
+    return static_cast<std::underlying_type_t<EnumType>>(value);
+}
+
+static uint32_t float_to_raw(float value) {
+    uint32_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+    return raw;
+}
+
+SimulatedModules::SimulatedModules(int _can_fd, const std::vector<uint8_t>& _devices,
+                                   std::chrono::microseconds _latency) :
+    can_fd(_can_fd), devices(_devices), latency(_latency) {
+    event_fd = eventfd(0, 0);
+    loop_thread = std::thread(&SimulatedModules::loop, this);
+}
+
+SimulatedModules::~SimulatedModules() {
+    uint64_t quit_value = 1;
+    write(event_fd, &quit_value, sizeof(quit_value));
+
+    loop_thread.join();
+
+    close(can_fd);
+    close(event_fd);
+}
+
+void SimulatedModules::set_value(uint8_t device, dpm1000::def::ReadValueType value_type, float value) {
+    set_value_int(device, value_type, float_to_raw(value));
+}
+
+void SimulatedModules::set_value_int(uint8_t device, dpm1000::def::ReadValueType value_type, uint32_t value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    values[{device, to_underlying(value_type)}] = value;
+}
+
+float SimulatedModules::get_setpoint(uint8_t device, dpm1000::def::SetValueType value_type) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto setpoint = setpoints.find({device, to_underlying(value_type)});
+    if (setpoint == setpoints.end()) {
+        return NAN;
+    }
+
+    float value;
+    memcpy(&value, &setpoint->second, sizeof(value));
+    return value;
+}
+
+void SimulatedModules::set_failing(uint8_t device, bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (enabled) {
+        failing.insert(device);
+    } else {
+        failing.erase(device);
+    }
+}
+
+void SimulatedModules::set_silent(uint8_t device, bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (enabled) {
+        silent.insert(device);
+    } else {
+        silent.erase(device);
+    }
+}
+
+uint64_t SimulatedModules::received_requests() const {
+    return requests;
+}
+
+std::size_t SimulatedModules::max_pending_responses() const {
+    return max_pending;
+}
+
+void SimulatedModules::loop() {
+    std::array<struct pollfd, 2> pollfds = {{
+        {can_fd, POLLIN, 0},
+        {event_fd, POLLIN, 0},
+    }};
+
+    while (true) {
+        int timeout_ms = -1;
+        if (not pending_responses.empty()) {
+            const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(pending_responses.front().first -
+                                                                                std::chrono::steady_clock::now());
+            timeout_ms = std::max<int>(0, remaining.count());
+        }
+
+        poll(pollfds.data(), pollfds.size(), timeout_ms);
+
+        if (pollfds[0].revents & POLLIN) {
+            struct can_frame frame;
+            if (read(can_fd, &frame, sizeof(frame)) == sizeof(frame)) {
+                handle_request(frame);
+            }
+        }
+
+        if (pollfds[1].revents & POLLIN) {
+            return;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        while (not pending_responses.empty() and pending_responses.front().first <= now) {
+            write(can_fd, &pending_responses.front().second, sizeof(struct can_frame));
+            pending_responses.pop_front();
+        }
+    }
+}
+
+void SimulatedModules::handle_request(const struct can_frame& request) {
+    if (((request.can_id >> dpm1000::def::MESSAGE_HEADER_BIT_SHIFT) & dpm1000::def::MESSAGE_HEADER_MASK) !=
+            dpm1000::def::MESSAGE_HEADER or
+        dpm1000::is_response(request)) {
+        return;
+    }
+
+    const auto device = dpm1000::parse_destination(request);
+    if (std::find(devices.begin(), devices.end(), device) == devices.end()) {
+        return;
+    }
+
+    requests++;
+
+    const auto command = dpm1000::parse_command(request);
+    const auto value_type = dpm1000::parse_msg_type(request);
+
+    struct can_frame response;
+    memset(&response, 0, sizeof(response));
+    dpm1000::set_header(response, device, dpm1000::parse_source(request));
+    response.can_dlc = sizeof(response.data);
+    response.data[0] = command | (1 << dpm1000::def::RESPONSE_FLAG_BIT_SHIFT);
+    memcpy(&response.data[2], &request.data[2], 2);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (silent.count(device)) {
+            return;
+        }
+
+        uint32_t value = 0;
+        bool error = failing.count(device);
+
+        if (command == to_underlying(dpm1000::def::MessageType::REQUEST_DATA_BYTE)) {
+            const auto stored = values.find({device, value_type});
+            if (stored == values.end()) {
+                error = true;
+            } else {
+                value = stored->second;
+            }
+        } else if (command == to_underlying(dpm1000::def::MessageType::SET_DATA)) {
+            uint32_t raw;
+            memcpy(&raw, &request.data[4], sizeof(raw));
+            value = be32toh(raw);
+            if (not error) {
+                setpoints[{device, value_type}] = value;
+            }
+        } else {
+            // power on/off requests are not answered
+            return;
+        }
+
+        if (error) {
+            response.data[0] |= (1 << dpm1000::def::ERROR_FLAG_BIT_SHIFT);
+            response.data[1] = to_underlying(dpm1000::def::ErrorType::INVALID_COMMAND);
+        }
+
+        const auto raw = htobe32(value);
+        memcpy(&response.data[4], &raw, sizeof(raw));
+    }
+
+    pending_responses.emplace_back(std::chrono::steady_clock::now() + latency, response);
+    max_pending = std::max(max_pending.load(), pending_responses.size());
+}
+
+std::pair<int, int> open_test_sockets(const std::string& interface_name) {
+    if (if_nametoindex(interface_name.c_str()) != 0) {
+        return {open_can_socket(interface_name), open_can_socket(interface_name)};
+    }
+
+    std::array<int, 2> fds;
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds.data()) == -1) {
+        throw std::runtime_error("Failed to create socketpair");
+    }
+    return {fds[0], fds[1]};
+}
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef DPM1000_TESTS_SIMULATED_MODULES_HPP
+#define DPM1000_TESTS_SIMULATED_MODULES_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <can/protocol/dpm1000.hpp>
+
+/*
+ DPM1000 modules answering read and set requests on a CAN socket (vcan or one end of a socketpair).
+
+ Every response is sent after the configured latency, independent of other requests, like modules on a real bus
+ which answer while further requests are already on the way.
+*/
+class SimulatedModules {
+public:
+    // takes ownership of the socket
+    SimulatedModules(int can_fd, const std::vector<uint8_t>& devices, std::chrono::microseconds latency);
+    ~SimulatedModules();
+
+    void set_value(uint8_t device, can::protocol::dpm1000::def::ReadValueType value_type, float value);
+    void set_value_int(uint8_t device, can::protocol::dpm1000::def::ReadValueType value_type, uint32_t value);
+    // last value set by the broker, NaN if never set
+    float get_setpoint(uint8_t device, can::protocol::dpm1000::def::SetValueType value_type);
+
+    // answer requests of the device with the error flag set
+    void set_failing(uint8_t device, bool failing);
+    // do not answer requests of the device at all
+    void set_silent(uint8_t device, bool silent);
+
+    uint64_t received_requests() const;
+    // largest number of requests that were waiting for their response at the same time
+    std::size_t max_pending_responses() const;
+
+private:
+    void loop();
+    void handle_request(const struct can_frame& frame);
+
+    int can_fd;
+    int event_fd{-1};
+    const std::vector<uint8_t> devices;
+    const std::chrono::microseconds latency;
+
+    std::mutex mutex;
+    std::map<std::pair<uint8_t, uint16_t>, uint32_t> values;
+    std::map<std::pair<uint8_t, uint16_t>, uint32_t> setpoints;
+    std::set<uint8_t> failing;
+    std::set<uint8_t> silent;
+
+    // owned by the loop thread
+    std::deque<std::pair<std::chrono::steady_clock::time_point, struct can_frame>> pending_responses;
+
+    std::atomic<uint64_t> requests{0};
+    std::atomic<std::size_t> max_pending{0};
+    std::thread loop_thread;
+};
+
+/*
+ Two connected sockets for a CanBroker and the SimulatedModules: two sockets on the CAN interface if it exists
+ (e.g. after "ip link add dev vcan0 type vcan"), otherwise a socketpair that passes the can_frames directly.
+*/
+std::pair<int, int> open_test_sockets(const std::string& interface_name);
+
+#endif // DPM1000_TESTS_SIMULATED_MODULES_HPP
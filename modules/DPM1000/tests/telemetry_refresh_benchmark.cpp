@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+// Telemetry refresh rate of the DPM1000 module: voltage, current and alarm flags of every module on the bus, with and
+// without the additional debug telemetry. Compares one request at a time with batched requests.
+// Runs on vcan0 if it exists, otherwise on a socketpair. Pass the simulated response latency in us as argument.
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "can_broker.hpp"
+#include "simulated_modules.hpp"
+
+namespace dpm1000 = can::protocol::dpm1000;
+
+namespace {
+
+constexpr auto c_cycles = 20;
+
+std::vector<CanBroker::ReadRequest> telemetry(uint8_t modules, bool all_values) {
+    std::vector<dpm1000::def::ReadValueType> value_types{
+        dpm1000::def::ReadValueType::VOLTAGE,
+        dpm1000::def::ReadValueType::CURRENT,
+        dpm1000::def::ReadValueType::ALARM,
+    };
+    if (all_values) {
+        value_types.insert(value_types.end(), {
+                                                  dpm1000::def::ReadValueType::CURRENT_REAL_PART,
+                                                  dpm1000::def::ReadValueType::CURRENT_LIMIT,
+                                                  dpm1000::def::ReadValueType::DCDC_TEMPERATURE,
+                                                  dpm1000::def::ReadValueType::AC_VOLTAGE,
+                                                  dpm1000::def::ReadValueType::VOLTAGE_LIMIT,
+                                                  dpm1000::def::ReadValueType::PFC0_VOLTAGE,
+                                                  dpm1000::def::ReadValueType::PFC1_VOLTAGE,
+                                                  dpm1000::def::ReadValueType::ENV_TEMPERATURE,
+                                                  dpm1000::def::ReadValueType::AC_VOLTAGE_PHASE_A,
+                                                  dpm1000::def::ReadValueType::AC_VOLTAGE_PHASE_B,
+                                                  dpm1000::def::ReadValueType::AC_VOLTAGE_PHASE_C,
+                                                  dpm1000::def::ReadValueType::PFC_TEMPERATURE,
+                                                  dpm1000::def::ReadValueType::POWER_LIMIT,
+                                              });
+    }
+
+    std::vector<CanBroker::ReadRequest> requests;
+    for (uint8_t device = 0; device < modules; ++device) {
+        for (const auto value_type : value_types) {
+            requests.push_back({device, value_type});
+        }
+    }
+    return requests;
+}
+
+void run(uint8_t modules, bool all_values, std::chrono::microseconds latency) {
+    std::vector<uint8_t> devices;
+    for (uint8_t device = 0; device < modules; ++device) {
+        devices.push_back(device);
+    }
+
+    const auto sockets = open_test_sockets("vcan0");
+    SimulatedModules simulation(sockets.second, devices, latency);
+    CanBroker broker(sockets.first);
+
+    auto requests = telemetry(modules, all_values);
+    for (const auto& request : requests) {
+        simulation.set_value(request.device, request.value_type, 1.0);
+    }
+
+    const auto measure = [&](const auto& refresh) {
+        const auto start = std::chrono::steady_clock::now();
+        for (auto cycle = 0; cycle < c_cycles; ++cycle) {
+            refresh();
+        }
+        const auto duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+        return c_cycles / duration.count();
+    };
+
+    const auto sequential = measure([&]() {
+        for (auto& request : requests) {
+            float value;
+            request.status = broker.read_data(request.device, request.value_type, value);
+        }
+    });
+    const auto batched = measure([&]() { broker.read_batch(requests); });
+
+    const auto statistics = broker.get_statistics();
+    fmt::print("{} modules, {:>2} values: {:>8.1f} refreshes/s sequential, {:>8.1f} refreshes/s batched, {} "
+               "timeouts\n",
+               modules, requests.size() / modules, sequential, batched, statistics.timeouts);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const auto latency = std::chrono::microseconds(argc > 1 ? std::atoi(argv[1]) : 2000);
+    fmt::print("simulated response latency {} us\n", latency.count());
+
+    for (const uint8_t modules : {1, 2, 4}) {
+        run(modules, false, latency);
+        run(modules, true, latency);
+    }
+    return 0;
+}
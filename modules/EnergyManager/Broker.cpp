@@ -9,10 +9,11 @@ namespace module {
 
 Broker::Broker(Market& _market, BrokerContext& _context) :
     local_market(_market),
-    context(_context),
-    first_trade(globals.schedule_length, true),
-    slot_type(globals.schedule_length, SlotType::Undecided),
-    num_phases(globals.schedule_length, 0) {
+    optimizer_context(_market.context()),
+    first_trade(_market.context().schedule_length, true),
+    slot_type(_market.context().schedule_length, SlotType::Undecided),
+    num_phases(_market.context().schedule_length, 0),
+    context(_context) {
 }
 
 Market& Broker::get_local_market() {
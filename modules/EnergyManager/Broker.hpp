@@ -42,6 +42,7 @@ public:
 protected:
     // reference to local market at the broker's node
     Market& local_market;
+    const OptimizerContext& optimizer_context;
     std::vector<bool> first_trade;
     std::vector<SlotType> slot_type;
     std::vector<int> num_phases;
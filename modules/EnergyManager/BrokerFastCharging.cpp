@@ -11,33 +11,8 @@ BrokerFastCharging::BrokerFastCharging(Market& _market, BrokerContext& _context,
     Broker(_market, _context), config(_config) {
 }
 
-static auto to_timestamp(const types::energy::ScheduleReqEntry& entry) {
-    return Everest::Date::from_rfc3339(entry.timestamp);
-}
-
-static bool time_slot_active(const int i, const ScheduleReq& offer) {
-    const auto& now = globals.start_time;
-    const auto t_i = to_timestamp(offer[i]);
-
-    int active_slot = 0;
-    // Get active slot:
-    if (now < to_timestamp(offer[0])) {
-        // First element already in the future
-        active_slot = 0;
-    } else if (now > to_timestamp(offer[offer.size() - 1])) {
-        // Last element in the past
-        active_slot = offer.size() - 1;
-    } else {
-        // Somewhere in between
-        for (int n = 0; n < offer.size() - 1; n++) {
-            if (now > to_timestamp(offer[n]) and now < to_timestamp(offer[n + 1])) {
-                active_slot = n;
-                break;
-            }
-        }
-    }
-
-    return active_slot == i;
+static bool time_slot_active(const OptimizerContext& optimizer_context, const int i) {
+    return optimizer_context.active_slot == i;
 }
 
 bool BrokerFastCharging::trade(Offer& _offer) {
@@ -45,15 +20,15 @@ bool BrokerFastCharging::trade(Offer& _offer) {
     // we can now buy from/sell to according to the offer at our local market place for this evse
     // our strategy is to charge if we can, and only discharge if charging is not possible.
     offer = &_offer;
-    if (globals.debug)
+    if (optimizer_context.debug)
         EVLOG_info << local_market.energy_flow_request.uuid << " Broker: " << *offer;
 
     // create a new schedules that contains everything we want to buy
-    trading = globals.empty_schedule_res;
+    trading = optimizer_context.empty_schedule_res;
 
     // buy/sell nothing in the beginning
 
-    for (int i = 0; i < globals.schedule_length; i++) {
+    for (int i = 0; i < optimizer_context.schedule_length; i++) {
         // make this more readable
         auto& max_current = offer->import_offer[i].limits_to_root.ac_max_current_A;
         auto& total_power = offer->import_offer[i].limits_to_root.total_power_W;
@@ -73,9 +48,9 @@ bool BrokerFastCharging::trade(Offer& _offer) {
     }
 
     // if we have not bought anything, we first need to buy the minimal limits for ac_amp if any.
-    for (int i = 0; i < globals.schedule_length; i++) {
+    for (int i = 0; i < optimizer_context.schedule_length; i++) {
 
-        bool time_slot_is_active = time_slot_active(i, offer->import_offer);
+        bool time_slot_is_active = time_slot_active(optimizer_context, i);
 
         // make this more readable
         auto& max_current_import = offer->import_offer[i].limits_to_root.ac_max_current_A;
@@ -177,7 +152,7 @@ bool BrokerFastCharging::trade(Offer& _offer) {
                             // other slots in the future or past.
                             // Only allow an actual change to 3ph if the time exceeds the configured hysteresis limit.
                             const auto stable_3ph = std::chrono::duration_cast<std::chrono::seconds>(
-                                                        globals.start_time - context.ts_1ph_optimal)
+                                                        optimizer_context.start_time - context.ts_1ph_optimal)
                                                         .count();
 
                             if (stable_3ph < config.time_hysteresis_s and number_of_phases == max_phases_import) {
@@ -217,13 +192,13 @@ bool BrokerFastCharging::trade(Offer& _offer) {
                 } else {
                     // EVLOG_info << "I: Not first trade or nor min current needed.";
                     //  try to buy a slice but allow less to be bought
-                    buy_ampere_import(i, globals.slice_ampere, true, num_phases[i]);
+                    buy_ampere_import(i, optimizer_context.slice_ampere, true, num_phases[i]);
                 }
 
             } else if (total_power_import.has_value()) {
                 // only a watt limit is available
                 // EVLOG_info << "I: Only watt limit is set." << total_power_import.value();
-                buy_watt_import(i, globals.slice_watt, true);
+                buy_watt_import(i, optimizer_context.slice_watt, true);
             }
         } else if (slot_type[i] == SlotType::Export) {
             // EVLOG_info << "We can export.";
@@ -238,12 +213,12 @@ bool BrokerFastCharging::trade(Offer& _offer) {
                 } else {
                     // EVLOG_info << "E: Not first trade or nor min current needed.";
                     //  try to buy a slice but allow less to be bought
-                    buy_ampere_export(i, globals.slice_ampere, true, 3);
+                    buy_ampere_export(i, optimizer_context.slice_ampere, true, 3);
                 }
             } else if (total_power_export.has_value()) {
                 // only a watt limit is available
                 // EVLOG_info << "E: Only watt limit is set." << total_power_export.value();
-                buy_watt_export(i, globals.slice_watt, true);
+                buy_watt_export(i, optimizer_context.slice_watt, true);
             }
         } else {
             // EVLOG_info << "We can neither import nor export.";
@@ -252,7 +227,7 @@ bool BrokerFastCharging::trade(Offer& _offer) {
 
     // if we want to buy anything:
     if (traded) {
-        if (globals.debug) {
+        if (optimizer_context.debug) {
             EVLOG_info << fmt::format("\033[1;33m                                {}A {}W \033[1;0m",
                                       (trading[0].limits_to_root.ac_max_current_A.has_value()
                                            ? std::to_string(trading[0].limits_to_root.ac_max_current_A.value())
@@ -265,7 +240,7 @@ bool BrokerFastCharging::trade(Offer& _offer) {
         local_market.trade(trading);
         return true;
     } else {
-        if (globals.debug)
+        if (optimizer_context.debug)
             EVLOG_info << fmt::format("\033[1;33m                               NO TRADE \033[1;0m");
 
         //   execute the zero trade on the market
@@ -290,7 +265,7 @@ bool BrokerFastCharging::buy_watt_export(int index, float watt, bool allow_less)
     return buy_watt(offer->export_offer[index], index, watt, allow_less, false);
 }
 
-bool BrokerFastCharging::buy_ampere(const types::energy::ScheduleReqEntry& _offer, int index, float ampere,
+bool BrokerFastCharging::buy_ampere(const ScheduleReqSlot& _offer, int index, float ampere,
                                     bool allow_less, bool import, int number_of_phases) {
     // make this more readable
     auto& max_current = _offer.limits_to_root.ac_max_current_A;
@@ -366,7 +341,7 @@ bool BrokerFastCharging::buy_ampere(const types::energy::ScheduleReqEntry& _offe
     return false;
 }
 
-bool BrokerFastCharging::buy_watt(const types::energy::ScheduleReqEntry& _offer, int index, float watt, bool allow_less,
+bool BrokerFastCharging::buy_watt(const ScheduleReqSlot& _offer, int index, float watt, bool allow_less,
                                   bool import) {
     // make this more readable
     auto& total_power = _offer.limits_to_root.total_power_W;
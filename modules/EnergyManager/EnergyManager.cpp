@@ -4,8 +4,11 @@
 #include "Broker.hpp"
 #include "BrokerFastCharging.hpp"
 #include "Market.hpp"
+#include <algorithm>
+#include <atomic>
 #include <fmt/core.h>
 #include <optional>
+#include <thread>
 
 using namespace std::literals::chrono_literals;
 
@@ -32,9 +35,16 @@ void EnergyManager::ready() {
     // start thread to update energy optimization
     std::thread([this] {
         while (true) {
-            globals.init(date::utc_clock::now(), config.schedule_interval_duration, config.schedule_total_duration,
-                         config.slice_ampere, config.slice_watt, config.debug, energy_flow_request);
-            auto optimized_values = run_optimizer(energy_flow_request);
+            types::energy::EnergyFlowRequest request;
+            {
+                std::scoped_lock lock(energy_mutex);
+                request = energy_flow_request;
+            }
+            const OptimizerContext context(date::utc_clock::now(), config.schedule_interval_duration,
+                                           config.schedule_total_duration, config.slice_ampere, config.slice_watt,
+                                           config.debug, request);
+            auto optimized_values = config.incremental_optimizer ? run_optimizer_incremental(context, request)
+                                                                 : run_optimizer(context, request);
             enforce_limits(optimized_values);
             {
                 std::unique_lock<std::mutex> lock(mainloop_sleep_mutex);
@@ -65,7 +75,7 @@ bool EnergyManager::is_priority_request(const types::energy::EnergyFlowRequest&
 
 void EnergyManager::enforce_limits(const std::vector<types::energy::EnforcedLimits>& limits) {
     for (const auto& it : limits) {
-        if (globals.debug)
+        if (config.debug)
             EVLOG_info << fmt::format("\033[1;92m{} Enforce limits {}A {}W {} ph\033[1;0m", it.uuid,
                                       it.limits_root_side.value().ac_max_current_A.value_or(-9999),
                                       it.limits_root_side.value().total_power_W.value_or(-9999),
@@ -106,40 +116,118 @@ static BrokerFastCharging::Config to_broker_fast_charging_config(const Conf& mod
     return broker_conf;
 }
 
-std::vector<types::energy::EnforcedLimits> EnergyManager::run_optimizer(types::energy::EnergyFlowRequest request) {
+std::vector<types::energy::EnforcedLimits> EnergyManager::run_optimizer(const OptimizerContext& context,
+                                                                        types::energy::EnergyFlowRequest request) {
 
     std::scoped_lock lock(energy_mutex);
 
     time_probe optimizer_start;
     optimizer_start.start();
-    if (globals.debug)
+    if (context.debug)
         EVLOG_info << "\033[1;44m---------------- Run energy optimizer ---------------- \033[1;0m";
 
     time_probe market_tp;
 
     //  create market for trading energy based on the request tree
     market_tp.start();
-    Market market(request, config.nominal_ac_voltage);
+    Market market(context, request, config.nominal_ac_voltage);
     market_tp.pause();
 
+    auto evse_markets = market.get_list_of_evses();
+
+    trade(context, evse_markets, contexts);
+
+    if (context.debug) {
+        EVLOG_info << fmt::format("\033[1;44m---------------- End energy optimizer (market {}ms total {}ms) "
+                                  "---------------- \033[1;0m",
+                                  market_tp.stop(), optimizer_start.stop());
+    }
+
+    return get_enforced_limits(context, evse_markets);
+}
+
+std::vector<types::energy::EnforcedLimits>
+EnergyManager::run_optimizer_incremental(const OptimizerContext& context,
+                                         const types::energy::EnergyFlowRequest& request) {
+
+    std::scoped_lock lock(energy_mutex);
+
+    time_probe optimizer_start;
+    optimizer_start.start();
+
+    // the time slots of all schedules need to be the same as in the last run, otherwise
+    // nothing of the old market tree can be reused
+    bool full_solve = not incremental_market or context.timestamps != incremental_context->timestamps;
+
+    if (not full_solve and config.incremental_optimizer_full_solve_interval > 0 and
+        context.start_time - incremental_last_full_solve >=
+            std::chrono::seconds(config.incremental_optimizer_full_solve_interval)) {
+        full_solve = true;
+    }
+
+    // the market tree keeps a reference to the context, so it needs to stay alive until the next run
+    auto previous_context = std::move(incremental_context);
+    incremental_context = std::make_unique<OptimizerContext>(context);
+
+    std::vector<Market*> dirty;
+    if (not full_solve and not incremental_market->update(*incremental_context, request, dirty)) {
+        // topology of the tree changed
+        full_solve = true;
+    }
+
+    if (full_solve) {
+        if (context.debug)
+            EVLOG_info << "\033[1;44m---------------- Run energy optimizer (full) ---------------- \033[1;0m";
+
+        incremental_market.reset();
+        incremental_request = request;
+        incremental_last_full_solve = context.start_time;
+        incremental_market =
+            std::make_unique<Market>(*incremental_context, incremental_request, config.nominal_ac_voltage);
+        trade(*incremental_context, incremental_market->get_list_of_evses(), contexts);
+    } else if (not dirty.empty()) {
+        // Only the subtree that contains all changed nodes is traded again. All other evses keep the energy
+        // they bought in the last run, it stays booked at all nodes on their path to the root.
+        auto subtree = Market::common_ancestor(dirty);
+
+        if (context.debug)
+            EVLOG_info << fmt::format("\033[1;44m---------------- Run energy optimizer (incremental, {} dirty, "
+                                      "subtree {}) ---------------- \033[1;0m",
+                                      dirty.size(), subtree->energy_flow_request.uuid);
+
+        subtree->reset_sold_energy();
+        trade(*incremental_context, subtree->get_list_of_evses(), contexts);
+    }
+
+    auto optimized_values = get_enforced_limits(*incremental_context, incremental_market->get_list_of_evses());
+
+    if (context.debug) {
+        EVLOG_info << fmt::format("\033[1;44m---------------- End energy optimizer (total {}ms) ---------------- "
+                                  "\033[1;0m",
+                                  optimizer_start.stop());
+    }
+
+    return optimized_values;
+}
+
+void EnergyManager::trade(const OptimizerContext& context, const std::vector<Market*>& evse_markets,
+                          std::map<std::string, BrokerContext>& broker_contexts) {
     // create brokers for all evses (they buy/sell energy on behalf of EvseManagers)
     std::vector<std::shared_ptr<Broker>> brokers;
 
-    auto evse_markets = market.get_list_of_evses();
-
     for (auto m : evse_markets) {
         // Check if we need to clear the context
         // Note that context is created here if it does not exist implicitly by operator[] of the map
         if (m->energy_flow_request.evse_state == types::energy::EvseState::Unplugged or
             m->energy_flow_request.evse_state == types::energy::EvseState::Finished) {
-            contexts[m->energy_flow_request.uuid].clear();
-            contexts[m->energy_flow_request.uuid].ts_1ph_optimal =
-                globals.start_time - std::chrono::seconds(config.switch_3ph1ph_time_hysteresis_s);
+            broker_contexts[m->energy_flow_request.uuid].clear();
+            broker_contexts[m->energy_flow_request.uuid].ts_1ph_optimal =
+                context.start_time - std::chrono::seconds(config.switch_3ph1ph_time_hysteresis_s);
         }
 
         // FIXME: check for actual optimizer_targets and create correct broker for this evse
         // For now always create simple FastCharging broker
-        brokers.push_back(std::make_shared<BrokerFastCharging>(*m, contexts[m->energy_flow_request.uuid],
+        brokers.push_back(std::make_shared<BrokerFastCharging>(*m, broker_contexts[m->energy_flow_request.uuid],
                                                                to_broker_fast_charging_config(config)));
         // EVLOG_info << fmt::format("Created broker for {}", m->energy_flow_request.uuid);
     }
@@ -175,46 +263,50 @@ std::vector<types::energy::EnforcedLimits> EnergyManager::run_optimizer(types::e
         EVLOG_error << "Trading: Maximum number of trading rounds reached.";
     }
 
-    if (globals.debug) {
-        EVLOG_info << fmt::format("\033[1;44m---------------- End energy optimizer ({} rounds, offer {}ms market {}ms "
-                                  "broker {}ms total {}ms) ---------------- \033[1;0m",
-                                  100 - max_number_of_trading_rounds, offer_tp.stop(), market_tp.stop(),
-                                  broker_tp.stop(), optimizer_start.stop());
+    if (context.debug) {
+        EVLOG_info << fmt::format("Trading: {} brokers, {} rounds, offer {}ms broker {}ms", brokers.size(),
+                                  100 - max_number_of_trading_rounds, offer_tp.stop(), broker_tp.stop());
     }
+}
 
+std::vector<types::energy::EnforcedLimits>
+EnergyManager::get_enforced_limits(const OptimizerContext& context, const std::vector<Market*>& evse_markets) {
     std::vector<types::energy::EnforcedLimits> optimized_values;
-    optimized_values.reserve(brokers.size());
+    optimized_values.reserve(evse_markets.size());
+
+    // RFC3339 strings are only created here once for all published schedules
+    const auto timestamps = context.timestamps_rfc3339();
+    const auto valid_until =
+        Everest::Date::to_rfc3339(context.start_time + std::chrono::seconds(config.update_interval * 10));
 
-    for (auto& broker : brokers) {
-        auto& local_market = broker->get_local_market();
+    for (auto m : evse_markets) {
+        auto& local_market = *m;
         const auto sold_energy = local_market.get_sold_energy();
 
         if (sold_energy.size() > 0) {
 
             types::energy::EnforcedLimits l;
             l.uuid = local_market.energy_flow_request.uuid;
-            l.valid_until =
-                Everest::Date::to_rfc3339(globals.start_time + std::chrono::seconds(config.update_interval * 10));
+            l.valid_until = valid_until;
 
-            l.schedule = sold_energy;
+            l.schedule = context.to_schedule_res_entries(sold_energy, timestamps);
 
-            // select root limit from schedule based on globals.start_time
+            // select root limit from schedule based on context.start_time
             l.limits_root_side = sold_energy[0].limits_to_root;
 
-            for (const auto& s : sold_energy) {
-                const auto schedule_time = Everest::Date::from_rfc3339(s.timestamp);
-                if (globals.start_time < schedule_time) {
+            for (ScheduleRes::size_type i = 0; i < sold_energy.size(); i++) {
+                if (context.start_time < context.timestamps[i]) {
                     // all further schedules will be further into the future
                     break;
                 } else {
                     // use this schedule as the starting point
-                    l.limits_root_side = s.limits_to_root;
+                    l.limits_root_side = sold_energy[i].limits_to_root;
                 }
             }
 
             optimized_values.push_back(l);
 
-            if (globals.debug && l.limits_root_side.has_value()) {
+            if (context.debug && l.limits_root_side.has_value()) {
                 EVLOG_info << "Sending enforced limits (import) to :" << l.uuid << " " << l.limits_root_side.value();
             }
         }
@@ -222,4 +314,64 @@ std::vector<types::energy::EnforcedLimits> EnergyManager::run_optimizer(types::e
 
     return optimized_values;
 }
+ScenarioResult EnergyManager::run_scenarios(const OptimizerContext& context,
+                                            const std::vector<types::energy::EnergyFlowRequest>& scenarios,
+                                            const ScenarioRating& rating, unsigned int number_of_threads) {
+    ScenarioResult best;
+    if (scenarios.empty()) {
+        return best;
+    }
+
+    // every scenario trades on its own copy of the broker contexts, the persistent ones are left untouched
+    std::map<std::string, BrokerContext> initial_broker_contexts;
+    {
+        std::scoped_lock lock(energy_mutex);
+        initial_broker_contexts = contexts;
+    }
+
+    std::vector<std::vector<types::energy::EnforcedLimits>> results(scenarios.size());
+    std::atomic<std::size_t> next_scenario{0};
+
+    auto worker = [&]() {
+        for (auto i = next_scenario++; i < scenarios.size(); i = next_scenario++) {
+            auto request = scenarios[i];
+            auto broker_contexts = initial_broker_contexts;
+            Market market(context, request, config.nominal_ac_voltage);
+            auto evse_markets = market.get_list_of_evses();
+            trade(context, evse_markets, broker_contexts);
+            results[i] = get_enforced_limits(context, evse_markets);
+        }
+    };
+
+    if (number_of_threads == 0) {
+        number_of_threads = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    number_of_threads = std::min<std::size_t>(number_of_threads, scenarios.size());
+
+    std::vector<std::thread> pool;
+    pool.reserve(number_of_threads);
+    for (unsigned int t = 0; t < number_of_threads; t++) {
+        pool.emplace_back(worker);
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const float r = rating ? rating(results[i]) : rate_total_power(results[i], config.nominal_ac_voltage);
+        if (i == 0 or r > best.rating) {
+            best.index = i;
+            best.rating = r;
+        }
+    }
+    best.limits = std::move(results[best.index]);
+
+    if (context.debug) {
+        EVLOG_info << fmt::format("Scenarios: evaluated {} scenarios on {} threads, best is #{} ({})", scenarios.size(),
+                                  number_of_threads, best.index, best.rating);
+    }
+
+    return best;
+}
+
 } // namespace module
@@ -23,15 +23,18 @@
 #include <date/tz.h>
 #include <utils/date.hpp>
 
+#include <memory>
 #include <mutex>
 
 #include "Broker.hpp"
+#include "Scenario.hpp"
 
 #ifdef BUILD_TESTING_MODULE_ENERGY_MANAGER
 #include <gtest/gtest_prod.h>
 namespace module::test {
 void schedule_test(const types::energy::EnergyFlowRequest& energy_flow_request, const std::string& start_time_str,
                    float expected_limit);
+void optimizer_benchmark(int number_of_leaves);
 }
 
 #endif
@@ -52,6 +55,8 @@ struct Conf {
     std::string switch_3ph1ph_switch_limit_stickyness;
     int switch_3ph1ph_power_hysteresis_W;
     int switch_3ph1ph_time_hysteresis_s;
+    bool incremental_optimizer;
+    int incremental_optimizer_full_solve_interval;
 };
 
 class EnergyManager : public Everest::ModuleBase {
@@ -67,6 +72,14 @@ public:
 
     // ev@1fce4c5e-0ab8-41bb-90f7-14277703d2ac:v1
     // insert your public definitions here
+
+    // Run the optimizer for several alternative energy flow requests (e.g. different 1ph/3ph decisions) in parallel
+    // and return the result of the best one. The persistent state of the energy manager is not modified.
+    // All scenarios must use the time slots of the given context.
+    // number_of_threads: size of the worker pool, 0 uses one thread per CPU core.
+    ScenarioResult run_scenarios(const OptimizerContext& context,
+                                 const std::vector<types::energy::EnergyFlowRequest>& scenarios,
+                                 const ScenarioRating& rating = nullptr, unsigned int number_of_threads = 0);
     // ev@1fce4c5e-0ab8-41bb-90f7-14277703d2ac:v1
 
 protected:
@@ -88,7 +101,20 @@ private:
     types::energy::EnergyFlowRequest energy_flow_request;
 
     void enforce_limits(const std::vector<types::energy::EnforcedLimits>& limits);
-    std::vector<types::energy::EnforcedLimits> run_optimizer(types::energy::EnergyFlowRequest request);
+    std::vector<types::energy::EnforcedLimits> run_optimizer(const OptimizerContext& context,
+                                                             types::energy::EnergyFlowRequest request);
+    std::vector<types::energy::EnforcedLimits>
+    run_optimizer_incremental(const OptimizerContext& context, const types::energy::EnergyFlowRequest& request);
+    void trade(const OptimizerContext& context, const std::vector<Market*>& evse_markets,
+               std::map<std::string, BrokerContext>& broker_contexts);
+    std::vector<types::energy::EnforcedLimits> get_enforced_limits(const OptimizerContext& context,
+                                                                   const std::vector<Market*>& evse_markets);
+
+    // context, market tree and its request tree that are kept in between incremental optimizer runs
+    std::unique_ptr<OptimizerContext> incremental_context;
+    types::energy::EnergyFlowRequest incremental_request;
+    std::unique_ptr<Market> incremental_market;
+    date::utc_clock::time_point incremental_last_full_solve;
 
     std::condition_variable mainloop_sleep_condvar;
     std::mutex mainloop_sleep_mutex;
@@ -99,6 +125,10 @@ private:
     FRIEND_TEST(EnergyManagerTest, empty);
     FRIEND_TEST(EnergyManagerTest, noSchedules);
     FRIEND_TEST(EnergyManagerTest, schedules);
+    FRIEND_TEST(EnergyManagerTest, incremental);
+    FRIEND_TEST(EnergyManagerTest, incremental_topology_change);
+    FRIEND_TEST(EnergyManagerTest, scenarios);
+    friend void test::optimizer_benchmark(int number_of_leaves);
     friend void test::schedule_test(const types::energy::EnergyFlowRequest& energy_flow_request,
                                     const std::string& start_time_str, float expected_limit);
 #endif
@@ -7,40 +7,39 @@
 
 namespace module {
 
-globals_t globals;
-
-void globals_t::init(date::utc_clock::time_point _start_time, int _interval_duration, int _schedule_duration,
-                     float _slice_ampere, float _slice_watt, bool _debug,
-                     const types::energy::EnergyFlowRequest& energy_flow_request) {
-    start_time = _start_time;
-    interval_duration = std::chrono::minutes(_interval_duration);
-    schedule_length = std::chrono::hours(_schedule_duration) / interval_duration;
-    slice_ampere = _slice_ampere;
-    slice_watt = _slice_watt;
-    debug = _debug;
+OptimizerContext::OptimizerContext(date::utc_clock::time_point _start_time, int _interval_duration,
+                                   int _schedule_duration, float _slice_ampere, float _slice_watt, bool _debug,
+                                   const types::energy::EnergyFlowRequest& energy_flow_request) :
+    start_time(_start_time),
+    interval_duration(std::chrono::minutes(_interval_duration)),
+    schedule_length(std::chrono::hours(_schedule_duration) / interval_duration),
+    slice_ampere(_slice_ampere),
+    slice_watt(_slice_watt),
+    debug(_debug) {
 
     create_timestamps(energy_flow_request);
+    find_active_slot();
 
-    zero_schedule_req = create_empty_schedule_req();
+    zero_schedule_req = ScheduleReq(schedule_length);
 
     for (auto& a : zero_schedule_req) {
         a.limits_to_root.ac_max_current_A = 0.;
         a.limits_to_root.total_power_W = 0.;
     }
 
-    empty_schedule_req = create_empty_schedule_req();
+    empty_schedule_req = ScheduleReq(schedule_length);
 
-    zero_schedule_res = create_empty_schedule_res();
+    zero_schedule_res = ScheduleRes(schedule_length);
 
     for (auto& a : zero_schedule_res) {
         a.limits_to_root.ac_max_current_A = 0.;
         a.limits_to_root.total_power_W = 0.;
     }
 
-    empty_schedule_res = create_empty_schedule_res();
+    empty_schedule_res = ScheduleRes(schedule_length);
 }
 
-void globals_t::create_timestamps(const types::energy::EnergyFlowRequest& energy_flow_request) {
+void OptimizerContext::create_timestamps(const types::energy::EnergyFlowRequest& energy_flow_request) {
 
     timestamps.clear();
     timestamps.reserve(schedule_length);
@@ -70,19 +69,24 @@ void globals_t::create_timestamps(const types::energy::EnergyFlowRequest& energy
     schedule_length = timestamps.size();
 }
 
-void globals_t::add_timestamps(const types::energy::EnergyFlowRequest& energy_flow_request) {
-    // add local timestamps
-    if (energy_flow_request.schedule_import.has_value()) {
-        for (auto t : energy_flow_request.schedule_import.value()) {
+void OptimizerContext::add_timestamps(const types::energy::EnergyFlowRequest& energy_flow_request) {
+    // add local timestamps, every distinct timestamp is parsed only once
+    const auto add = [this](const std::vector<types::energy::ScheduleReqEntry>& schedule) {
+        for (const auto& t : schedule) {
+            auto parsed = request_timestamps.find(t.timestamp);
+            if (parsed == request_timestamps.end()) {
+                parsed = request_timestamps.emplace(t.timestamp, Everest::Date::from_rfc3339(t.timestamp)).first;
+            }
             // insert current timestamp
-            timestamps.push_back(Everest::Date::from_rfc3339(t.timestamp));
+            timestamps.push_back(parsed->second);
         }
+    };
+
+    if (energy_flow_request.schedule_import.has_value()) {
+        add(energy_flow_request.schedule_import.value());
     }
     if (energy_flow_request.schedule_export.has_value()) {
-        for (auto t : energy_flow_request.schedule_export.value()) {
-            // insert current timestamp
-            timestamps.push_back(Everest::Date::from_rfc3339(t.timestamp));
-        }
+        add(energy_flow_request.schedule_export.value());
     }
 
     // recurse to all children
@@ -90,28 +94,54 @@ void globals_t::add_timestamps(const types::energy::EnergyFlowRequest& energy_fl
         add_timestamps(c);
 }
 
-ScheduleReq globals_t::create_empty_schedule_req() {
-    // initialize schedule with correct size
-    types::energy::ScheduleReqEntry e;
-    ScheduleReq s(schedule_length, e);
-
-    for (int i = 0; i < schedule_length; i++) {
-        s[i].timestamp = Everest::Date::to_rfc3339(timestamps[i]);
+void OptimizerContext::find_active_slot() {
+    active_slot = 0;
+    if (timestamps.empty() or start_time < timestamps.front()) {
+        // First element already in the future
+        active_slot = 0;
+    } else if (start_time > timestamps.back()) {
+        // Last element in the past
+        active_slot = timestamps.size() - 1;
+    } else {
+        // Somewhere in between
+        for (std::size_t n = 0; n + 1 < timestamps.size(); n++) {
+            if (start_time > timestamps[n] and start_time < timestamps[n + 1]) {
+                active_slot = n;
+                break;
+            }
+        }
     }
-
-    return s;
 }
 
-ScheduleRes globals_t::create_empty_schedule_res() {
-    // initialize schedule with correct size
-    types::energy::ScheduleResEntry e;
-    ScheduleRes s(schedule_length, e);
+std::vector<std::string> OptimizerContext::timestamps_rfc3339() const {
+    std::vector<std::string> ts;
+    ts.reserve(timestamps.size());
+    for (const auto& t : timestamps) {
+        ts.push_back(Everest::Date::to_rfc3339(t));
+    }
+    return ts;
+}
 
-    for (int i = 0; i < schedule_length; i++) {
-        s[i].timestamp = Everest::Date::to_rfc3339(timestamps[i]);
+date::utc_clock::time_point OptimizerContext::to_time_point(const std::string& rfc3339) const {
+    const auto parsed = request_timestamps.find(rfc3339);
+    if (parsed != request_timestamps.end()) {
+        return parsed->second;
     }
+    return Everest::Date::from_rfc3339(rfc3339);
+}
 
-    return s;
+std::vector<types::energy::ScheduleResEntry>
+OptimizerContext::to_schedule_res_entries(const ScheduleRes& s, const std::vector<std::string>& ts) const {
+    std::vector<types::energy::ScheduleResEntry> entries;
+    entries.reserve(s.size());
+    for (ScheduleRes::size_type i = 0; i < s.size() and i < ts.size(); i++) {
+        types::energy::ScheduleResEntry e;
+        e.timestamp = ts[i];
+        e.limits_to_root = s[i].limits_to_root;
+        e.price_per_kwh = s[i].price_per_kwh;
+        entries.push_back(e);
+    }
+    return entries;
 }
 
 int time_probe::stop() {
@@ -132,25 +162,33 @@ void time_probe::pause() {
     }
 }
 
-ScheduleReq Market::get_max_available_energy(const ScheduleReq& request) {
+ScheduleReq Market::get_max_available_energy(const std::vector<types::energy::ScheduleReqEntry>& request) {
 
-    ScheduleReq available = globals.empty_schedule_req;
+    ScheduleReq available = _context->empty_schedule_req;
 
-    // First resample request to the timestamps in available and merge all limits on root sides
-    for (auto& a : available) {
+    // the timestamps of the request were already parsed when the context was created
+    std::vector<date::utc_clock::time_point> request_timestamps;
+    request_timestamps.reserve(request.size());
+    for (const auto& r : request) {
+        request_timestamps.push_back(_context->to_time_point(r.timestamp));
+    }
+
+    // First resample request to the time slots in available and merge all limits on root sides
+    for (ScheduleReq::size_type i = 0; i < available.size(); i++) {
+        auto& a = available[i];
 
         // find corresponding entry in request
         auto r = request.begin();
-        auto tp_a = Everest::Date::from_rfc3339(a.timestamp);
-        for (auto ir = request.begin(); ir != request.end(); ir++) {
-            auto tp_r_1 = Everest::Date::from_rfc3339((*ir).timestamp);
-            if ((ir + 1 == request.end())) {
-                r = ir;
+        const auto& tp_a = _context->timestamps[i];
+        for (std::size_t ir = 0; ir < request.size(); ir++) {
+            const auto& tp_r_1 = request_timestamps[ir];
+            if (ir + 1 == request.size()) {
+                r = request.begin() + ir;
                 break;
             }
-            auto tp_r_2 = Everest::Date::from_rfc3339((*(ir + 1)).timestamp);
-            if ((tp_a >= tp_r_1 && tp_a < tp_r_2) || (ir == request.begin() && tp_a < tp_r_1)) {
-                r = ir;
+            const auto& tp_r_2 = request_timestamps[ir + 1];
+            if ((tp_a >= tp_r_1 && tp_a < tp_r_2) || (ir == 0 && tp_a < tp_r_1)) {
+                r = request.begin() + ir;
                 break;
             }
         }
@@ -221,32 +259,140 @@ ScheduleReq Market::get_available_energy_export() {
     return get_available_energy(export_max_available, true);
 }
 
-Market::Market(types::energy::EnergyFlowRequest& _energy_flow_request, const float __nominal_ac_voltage,
-               Market* __parent) :
-    energy_flow_request(_energy_flow_request), _parent(__parent), _nominal_ac_voltage(__nominal_ac_voltage) {
+Market::Market(const OptimizerContext& __context, types::energy::EnergyFlowRequest& _energy_flow_request,
+               const float __nominal_ac_voltage, Market* __parent) :
+    energy_flow_request(_energy_flow_request),
+    _context(&__context),
+    _parent(__parent),
+    _nominal_ac_voltage(__nominal_ac_voltage) {
 
     // EVLOG_info << "Create market for " << _energy_flow_request.uuid;
 
-    sold_root = globals.empty_schedule_res;
+    sold_root = _context->empty_schedule_res;
 
+    update_max_available_energy();
+
+    // Recursion: create one Market for each child
+    for (auto& flow_child : _energy_flow_request.children) {
+        _children.emplace_back(*_context, flow_child, _nominal_ac_voltage, this);
+    }
+}
+
+void Market::update_max_available_energy() {
     if (energy_flow_request.schedule_import.has_value()) {
         import_max_available = get_max_available_energy(energy_flow_request.schedule_import.value());
     } else {
         // nothing is available as nothing was requested
-        import_max_available = globals.zero_schedule_req;
+        import_max_available = _context->zero_schedule_req;
     }
 
     if (energy_flow_request.schedule_export.has_value()) {
         export_max_available = get_max_available_energy(energy_flow_request.schedule_export.value());
     } else {
         // nothing is available as nothing was requested
-        export_max_available = globals.zero_schedule_req;
+        export_max_available = _context->zero_schedule_req;
     }
+}
 
-    // Recursion: create one Market for each child
-    for (auto& flow_child : _energy_flow_request.children) {
-        _children.emplace_back(flow_child, _nominal_ac_voltage, this);
+template <class T> static bool optional_equal(const std::optional<T>& a, const std::optional<T>& b) {
+    return a.has_value() == b.has_value() and (not a.has_value() or a.value() == b.value());
+}
+
+static bool limits_equal(const types::energy::LimitsReq& a, const types::energy::LimitsReq& b) {
+    return optional_equal(a.total_power_W, b.total_power_W) and
+           optional_equal(a.ac_max_current_A, b.ac_max_current_A) and
+           optional_equal(a.ac_min_current_A, b.ac_min_current_A) and
+           optional_equal(a.ac_max_phase_count, b.ac_max_phase_count) and
+           optional_equal(a.ac_min_phase_count, b.ac_min_phase_count) and
+           optional_equal(a.ac_supports_changing_phases_during_charging,
+                          b.ac_supports_changing_phases_during_charging) and
+           optional_equal(a.ac_number_of_active_phases, b.ac_number_of_active_phases);
+}
+
+static bool price_equal(const std::optional<types::energy_price_information::PricePerkWh>& a,
+                        const std::optional<types::energy_price_information::PricePerkWh>& b) {
+    if (a.has_value() != b.has_value()) {
+        return false;
+    }
+    return not a.has_value() or (a.value().timestamp == b.value().timestamp and a.value().value == b.value().value and
+                                 a.value().currency == b.value().currency);
+}
+
+static bool schedule_equal(const std::optional<std::vector<types::energy::ScheduleReqEntry>>& a,
+                           const std::optional<std::vector<types::energy::ScheduleReqEntry>>& b) {
+    if (a.has_value() != b.has_value()) {
+        return false;
+    }
+    if (not a.has_value()) {
+        return true;
+    }
+    if (a.value().size() != b.value().size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.value().size(); i++) {
+        const auto& ea = a.value()[i];
+        const auto& eb = b.value()[i];
+        if (ea.timestamp != eb.timestamp or not limits_equal(ea.limits_to_root, eb.limits_to_root) or
+            not limits_equal(ea.limits_to_leaves, eb.limits_to_leaves) or
+            not optional_equal(ea.conversion_efficiency, eb.conversion_efficiency) or
+            not price_equal(ea.price_per_kwh, eb.price_per_kwh)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool optimizer_target_equal(const std::optional<types::energy::OptimizerTarget>& a,
+                                   const std::optional<types::energy::OptimizerTarget>& b) {
+    if (a.has_value() != b.has_value()) {
+        return false;
+    }
+    return not a.has_value() or
+           (optional_equal(a.value().energy_amount_needed, b.value().energy_amount_needed) and
+            optional_equal(a.value().charge_to_max_percent, b.value().charge_to_max_percent) and
+            optional_equal(a.value().car_battery_soc, b.value().car_battery_soc) and
+            optional_equal(a.value().leave_time, b.value().leave_time) and
+            optional_equal(a.value().price_limit, b.value().price_limit) and
+            optional_equal(a.value().full_autonomy, b.value().full_autonomy));
+}
+
+bool Market::update(const OptimizerContext& new_context, const types::energy::EnergyFlowRequest& new_request,
+                    std::vector<Market*>& dirty) {
+    _context = &new_context;
+
+    if (energy_flow_request.uuid != new_request.uuid or energy_flow_request.node_type != new_request.node_type or
+        _children.size() != new_request.children.size()) {
+        return false;
+    }
+
+    // Only the data that is used for trading is compared here, energy usage measurements
+    // change on every powermeter update but do not influence the result.
+    if (not schedule_equal(energy_flow_request.schedule_import, new_request.schedule_import) or
+        not schedule_equal(energy_flow_request.schedule_export, new_request.schedule_export) or
+        not optional_equal(energy_flow_request.evse_state, new_request.evse_state) or
+        not optimizer_target_equal(energy_flow_request.optimizer_target, new_request.optimizer_target)) {
+
+        energy_flow_request.schedule_import = new_request.schedule_import;
+        energy_flow_request.schedule_export = new_request.schedule_export;
+        energy_flow_request.evse_state = new_request.evse_state;
+        energy_flow_request.optimizer_target = new_request.optimizer_target;
+        update_max_available_energy();
+        dirty.push_back(this);
+    }
+
+    energy_flow_request.priority_request = new_request.priority_request;
+    energy_flow_request.energy_usage_root = new_request.energy_usage_root;
+    energy_flow_request.energy_usage_leaves = new_request.energy_usage_leaves;
+
+    auto child = _children.begin();
+    for (const auto& new_child : new_request.children) {
+        if (not child->update(new_context, new_child, dirty)) {
+            return false;
+        }
+        child++;
     }
+
+    return true;
 }
 
 ScheduleRes Market::get_sold_energy() {
@@ -312,6 +458,75 @@ static void schedule_add(ScheduleRes& a, const ScheduleRes& b) {
     }
 }
 
+static void schedule_subtract(ScheduleRes& a, const ScheduleRes& b) {
+    if (a.size() != b.size()) {
+        EVLOG_critical << "schedule_subtract: Schedules are not of the same size: a: " << a.size()
+                       << " b: " << b.size();
+        return;
+    }
+
+    // Phase count is the maximum of all sold phase counts, it cannot be subtracted and is left untouched.
+    for (ScheduleRes::size_type i = 0; i < a.size(); i++) {
+        if (b[i].limits_to_root.ac_max_current_A.has_value()) {
+            a[i].limits_to_root.ac_max_current_A =
+                a[i].limits_to_root.ac_max_current_A.value_or(0) - b[i].limits_to_root.ac_max_current_A.value();
+        }
+
+        if (b[i].limits_to_root.total_power_W.has_value()) {
+            a[i].limits_to_root.total_power_W =
+                a[i].limits_to_root.total_power_W.value_or(0) - b[i].limits_to_root.total_power_W.value();
+        }
+    }
+}
+
+void Market::clear_sold_energy() {
+    sold_root = _context->empty_schedule_res;
+    for (auto& child : _children) {
+        child.clear_sold_energy();
+    }
+}
+
+void Market::reset_sold_energy() {
+    for (auto p = _parent; p != nullptr; p = p->_parent) {
+        schedule_subtract(p->sold_root, sold_root);
+    }
+    clear_sold_energy();
+}
+
+int Market::depth() {
+    int d = 0;
+    for (auto p = _parent; p != nullptr; p = p->_parent) {
+        d++;
+    }
+    return d;
+}
+
+Market* Market::common_ancestor(const std::vector<Market*>& markets) {
+    if (markets.empty()) {
+        return nullptr;
+    }
+
+    Market* ancestor = markets[0];
+    for (auto m : markets) {
+        // walk up both paths until they meet
+        int depth_ancestor = ancestor->depth();
+        int depth_m = m->depth();
+        while (depth_m > depth_ancestor) {
+            m = m->_parent;
+            depth_m--;
+        }
+        while (depth_ancestor > depth_m) {
+            ancestor = ancestor->_parent;
+            depth_ancestor--;
+        }
+        while (ancestor != m) {
+            ancestor = ancestor->_parent;
+            m = m->_parent;
+        }
+    }
+    return ancestor;
+}
+
 void Market::trade(const ScheduleRes& traded) {
     schedule_add(sold_root, traded);
 
@@ -325,4 +540,8 @@ float Market::nominal_ac_voltage() {
     return _nominal_ac_voltage;
 }
 
+const OptimizerContext& Market::context() const {
+    return *_context;
+}
+
 } // namespace module
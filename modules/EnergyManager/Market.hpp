@@ -5,6 +5,9 @@
 
 // headers for required interface implementations
 #include <generated/interfaces/energy/Interface.hpp>
+#include <optional>
+#include <string>
+#include <unordered_map>
 #include <utils/date.hpp>
 #include <vector>
 
@@ -12,32 +15,57 @@ using namespace std::chrono_literals;
 
 namespace module {
 
-typedef std::vector<types::energy::ScheduleReqEntry> ScheduleReq;
-typedef std::vector<types::energy::ScheduleResEntry> ScheduleRes;
+// Internal schedule representation used for trading. All schedules of one optimizer run share the same time slots
+// (OptimizerContext::timestamps), so a slot is addressed by its index and does not carry its own timestamp.
+// RFC3339 strings are only created when the results are published.
+struct ScheduleReqSlot {
+    types::energy::LimitsReq limits_to_root;
+    types::energy::LimitsReq limits_to_leaves;
+    std::optional<float> conversion_efficiency;
+    std::optional<types::energy_price_information::PricePerkWh> price_per_kwh;
+};
+
+struct ScheduleResSlot {
+    types::energy::LimitsRes limits_to_root;
+    std::optional<types::energy_price_information::PricePerkWh> price_per_kwh;
+};
 
-class globals_t {
+typedef std::vector<ScheduleReqSlot> ScheduleReq;
+typedef std::vector<ScheduleResSlot> ScheduleRes;
+
+// Data that is common to all markets, offers and brokers of one optimizer run. It is created once before the
+// optimizer runs and not modified afterwards, so several optimizer runs can use their own contexts in parallel.
+class OptimizerContext {
 public:
-    void init(date::utc_clock::time_point _start_time, int _interval_duration, int _schedule_duration,
-              float _slice_ampere, float _slice_watt, bool _debug,
-              const types::energy::EnergyFlowRequest& energy_flow_request);
+    OptimizerContext(date::utc_clock::time_point _start_time, int _interval_duration, int _schedule_duration,
+                     float _slice_ampere, float _slice_watt, bool _debug,
+                     const types::energy::EnergyFlowRequest& energy_flow_request);
     date::utc_clock::time_point start_time; // common start point
     std::chrono::minutes interval_duration; // interval duration
     int schedule_length;                    // total forcast length (in counts of (non-regular) intervals)
     float slice_ampere;                     // ampere_slices for trades
     float slice_watt;                       // ampere_slices for trades
     bool debug{false};
+    std::vector<date::utc_clock::time_point> timestamps; // start of each time slot, sorted
+    int active_slot;                                     // time slot that is active at start_time
     ScheduleReq zero_schedule_req, empty_schedule_req;
     ScheduleRes zero_schedule_res, empty_schedule_res;
 
+    std::vector<types::energy::ScheduleResEntry> to_schedule_res_entries(const ScheduleRes& s,
+                                                                         const std::vector<std::string>& ts) const;
+    std::vector<std::string> timestamps_rfc3339() const;
+
+    // Time point of an RFC3339 timestamp of the request. All timestamps of the request were parsed when the context
+    // was created, others (e.g. of alternative scenarios) are parsed on demand.
+    date::utc_clock::time_point to_time_point(const std::string& rfc3339) const;
+
 private:
     void create_timestamps(const types::energy::EnergyFlowRequest& energy_flow_request);
     void add_timestamps(const types::energy::EnergyFlowRequest& energy_flow_request);
-    ScheduleReq create_empty_schedule_req();
-    ScheduleRes create_empty_schedule_res();
-    std::vector<date::utc_clock::time_point> timestamps;
-};
+    void find_active_slot();
 
-extern globals_t globals;
+    std::unordered_map<std::string, date::utc_clock::time_point> request_timestamps;
+};
 
 class time_probe {
 public:
@@ -53,8 +81,8 @@ private:
 
 class Market {
 public:
-    Market(types::energy::EnergyFlowRequest& _energy_flow_request, const float __nominal_ac_voltage,
-           Market* __parent = nullptr);
+    Market(const OptimizerContext& __context, types::energy::EnergyFlowRequest& _energy_flow_request,
+           const float __nominal_ac_voltage, Market* __parent = nullptr);
 
     void trade(const ScheduleRes& s);
 
@@ -71,10 +99,26 @@ public:
 
     float nominal_ac_voltage();
 
+    const OptimizerContext& context() const;
+
+    // Incremental optimization: apply the node local data of a new request tree to this (already existing) market
+    // tree and use the new context from now on. The time slots of the new context must be the same as before.
+    // All nodes whose local request changed are appended to dirty. Returns false if the topology of the tree
+    // changed, in this case the market tree needs to be rebuilt from scratch.
+    bool update(const OptimizerContext& new_context, const types::energy::EnergyFlowRequest& new_request,
+                std::vector<Market*>& dirty);
+
+    // Remove all energy sold in this subtree, also from the sold energy of all parent nodes.
+    void reset_sold_energy();
+
+    // Find the lowest node that contains all of the given markets in its subtree
+    static Market* common_ancestor(const std::vector<Market*>& markets);
+
     // local request only for this node
     types::energy::EnergyFlowRequest& energy_flow_request;
 
 private:
+    const OptimizerContext* _context;
     Market* _parent;
     std::list<Market> _children;
     float _nominal_ac_voltage;
@@ -84,8 +128,11 @@ private:
     ScheduleRes sold_root;
     std::vector<ScheduleRes> sold_leaves;
 
-    ScheduleReq get_max_available_energy(const ScheduleReq& request);
+    ScheduleReq get_max_available_energy(const std::vector<types::energy::ScheduleReqEntry>& request);
     ScheduleReq get_available_energy(const ScheduleReq& available, bool add_sold);
+    void update_max_available_energy();
+    void clear_sold_energy();
+    int depth();
 };
 
 } // namespace module
@@ -80,8 +80,8 @@ void Offer::create_offer_for_local_market(Market& market) {
         create_offer_for_local_market(*market.parent());
     } else {
         // initialize time slots
-        import_offer = globals.empty_schedule_req;
-        export_offer = globals.empty_schedule_req;
+        import_offer = market.context().empty_schedule_req;
+        export_offer = market.context().empty_schedule_req;
     }
 
     // limit offer with limits at this market place
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#include "Scenario.hpp"
+
+namespace module {
+
+float rate_total_power(const std::vector<types::energy::EnforcedLimits>& limits, float nominal_ac_voltage) {
+    float total_power_W = 0.;
+
+    for (const auto& l : limits) {
+        if (not l.limits_root_side.has_value()) {
+            continue;
+        }
+
+        const auto& root_side = l.limits_root_side.value();
+        float power_W = 0.;
+
+        if (root_side.ac_max_current_A.has_value()) {
+            power_W =
+                root_side.ac_max_current_A.value() * root_side.ac_max_phase_count.value_or(3) * nominal_ac_voltage;
+            if (root_side.total_power_W.has_value() and root_side.total_power_W.value() < power_W) {
+                power_W = root_side.total_power_W.value();
+            }
+        } else if (root_side.total_power_W.has_value()) {
+            power_W = root_side.total_power_W.value();
+        }
+
+        total_power_W += power_W;
+    }
+
+    return total_power_W;
+}
+
+} // namespace module
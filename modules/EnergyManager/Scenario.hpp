@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef SCENARIO_HPP
+#define SCENARIO_HPP
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include <generated/interfaces/energy/Interface.hpp>
+
+namespace module {
+
+// Rates the result of one optimizer run, higher is better
+using ScenarioRating = std::function<float(const std::vector<types::energy::EnforcedLimits>& limits)>;
+
+// Result of the evaluation of several alternative energy flow requests
+struct ScenarioResult {
+    std::size_t index{0}; // index of the best scenario
+    float rating{0.};     // rating of the best scenario
+    std::vector<types::energy::EnforcedLimits> limits;
+};
+
+// Default rating: Total power in Watt that is granted to all EVSEs right now.
+// Ampere limits are converted to Watt with the number of phases (3 if not limited) and the nominal voltage.
+float rate_total_power(const std::vector<types::energy::EnforcedLimits>& limits, float nominal_ac_voltage);
+
+} // namespace module
+
+#endif // SCENARIO_HPP
@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+// Compares the run time of a full optimizer run with an incremental optimizer run
+// on synthetic energy trees. Only one evse changes its request in between two runs.
+
+#include "EnergyManager.hpp"
+#include "EnergyManagerImplStub.hpp"
+#include "Market.hpp"
+
+#include <fmt/core.h>
+#include <utils/date.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+constexpr int c_evses_per_node = 10;
+constexpr int c_iterations = 20;
+
+const ModuleInfo c_module_info{
+    "EnergyManager",
+    {},               // authors
+    "MIT",            // license
+    "energy_manager", // ID
+    {
+        // path etc
+        "",
+        // path libexec
+        "",
+        // path share
+        "",
+    },
+    false, // telemetry_enabled
+    false, // global_errors_enabled
+};
+
+types::energy::ScheduleReqEntry schedule_entry(float max_current) {
+    types::energy::ScheduleReqEntry e;
+    e.timestamp = "2024-03-27T12:00:00.000Z";
+    e.limits_to_leaves.ac_max_current_A = max_current;
+    return e;
+}
+
+types::energy::EnergyFlowRequest create_tree(int number_of_leaves) {
+    types::energy::EnergyFlowRequest root;
+    root.uuid = "root";
+    root.node_type = types::energy::NodeType::Generic;
+    root.schedule_import = {{schedule_entry(number_of_leaves * 8.)}};
+
+    for (int i = 0; i < number_of_leaves; i++) {
+        if (i % c_evses_per_node == 0) {
+            types::energy::EnergyFlowRequest node;
+            node.uuid = fmt::format("node_{}", i / c_evses_per_node);
+            node.node_type = types::energy::NodeType::Generic;
+            node.schedule_import = {{schedule_entry(c_evses_per_node * 10.)}};
+            root.children.push_back(node);
+        }
+
+        types::energy::EnergyFlowRequest evse;
+        evse.uuid = fmt::format("evse_{}", i);
+        evse.node_type = types::energy::NodeType::Evse;
+        evse.evse_state = types::energy::EvseState::Charging;
+        auto entry = schedule_entry(16.);
+        entry.limits_to_root.ac_min_current_A = 6.;
+        entry.limits_to_root.ac_max_phase_count = 3;
+        entry.limits_to_root.ac_min_phase_count = 3;
+        evse.schedule_import = {{entry}};
+        root.children.back().children.push_back(evse);
+    }
+
+    return root;
+}
+
+} // namespace
+
+namespace module::test {
+
+void optimizer_benchmark(int number_of_leaves) {
+    struct module::Conf config {
+        230.0,     // nominal_ac_voltage
+            1,     // update_interval
+            60,    // schedule_interval_duration
+            1,     // schedule_total_duration
+            0.5,   // slice_ampere
+            500,   // slice_watt
+            false, // debug
+    };
+    config.incremental_optimizer = true;
+    config.incremental_optimizer_full_solve_interval = 0;
+
+    std::unique_ptr<energyIntf> energy;
+    auto energy_managerImpl = std::make_unique<module::stub::energy_managerImplStub>();
+
+    module::EnergyManager manager(c_module_info, std::move(energy_managerImpl), std::move(energy), config);
+
+    auto request = create_tree(number_of_leaves);
+    const auto start_time = Everest::Date::from_rfc3339("2024-03-27T12:10:00.000Z");
+    const module::OptimizerContext context(start_time, config.schedule_interval_duration,
+                                           config.schedule_total_duration, config.slice_ampere, config.slice_watt,
+                                           config.debug, request);
+
+    // initial full solve for the incremental optimizer
+    manager.run_optimizer_incremental(context, request);
+
+    std::chrono::nanoseconds full{0};
+    std::chrono::nanoseconds incremental{0};
+
+    for (int i = 0; i < c_iterations; i++) {
+        // change one evse in a different sub tree in every iteration
+        auto& evse = request.children[i % request.children.size()].children[0];
+        evse.schedule_import.value()[0].limits_to_leaves.ac_max_current_A = (i % 2) ? 16. : 10.;
+
+        auto t = std::chrono::steady_clock::now();
+        manager.run_optimizer(context, request);
+        full += std::chrono::steady_clock::now() - t;
+
+        t = std::chrono::steady_clock::now();
+        manager.run_optimizer_incremental(context, request);
+        incremental += std::chrono::steady_clock::now() - t;
+    }
+
+    const auto to_ms = [](std::chrono::nanoseconds d) {
+        return std::chrono::duration<double, std::milli>(d).count() / c_iterations;
+    };
+
+    std::cout << fmt::format("{:>6} leaves: full {:>10.3f}ms incremental {:>10.3f}ms speedup {:>6.1f}x\n",
+                             number_of_leaves, to_ms(full), to_ms(incremental),
+                             to_ms(full) / std::max(to_ms(incremental), 1e-6));
+}
+
+} // namespace module::test
+
+int main() {
+    for (int leaves : {10, 50, 100, 500, 1000}) {
+        module::test::optimizer_benchmark(leaves);
+    }
+    return 0;
+}
@@ -640,9 +640,10 @@ void schedule_test(const types::energy::EnergyFlowRequest& energy_flow_request,
     module::EnergyManager manager(c_module_info, std::move(energy_managerImpl), std::move(energy), config);
 
     const auto start_time = Everest::Date::from_rfc3339(start_time_str);
-    module::globals.init(start_time, config.schedule_interval_duration, config.schedule_total_duration,
-                         config.slice_ampere, config.slice_watt, config.debug, energy_flow_request);
-    auto optimized_values = manager.run_optimizer(energy_flow_request);
+    const module::OptimizerContext context(start_time, config.schedule_interval_duration,
+                                           config.schedule_total_duration, config.slice_ampere, config.slice_watt,
+                                           config.debug, energy_flow_request);
+    auto optimized_values = manager.run_optimizer(context, energy_flow_request);
 
     // check result
     // std::cout << optimized_values << std::endl;
@@ -733,9 +734,10 @@ TEST(EnergyManagerTest, empty) {
     module::EnergyManager manager(c_module_info, std::move(energy_managerImpl), std::move(energy), config);
 
     types::energy::EnergyFlowRequest energy_flow_request;
-    module::globals.init(date::utc_clock::now(), config.schedule_interval_duration, config.schedule_total_duration,
-                         config.slice_ampere, config.slice_watt, config.debug, energy_flow_request);
-    auto optimized_values = manager.run_optimizer(energy_flow_request);
+    const module::OptimizerContext context(date::utc_clock::now(), config.schedule_interval_duration,
+                                           config.schedule_total_duration, config.slice_ampere, config.slice_watt,
+                                           config.debug, energy_flow_request);
+    auto optimized_values = manager.run_optimizer(context, energy_flow_request);
     std::cout << optimized_values << std::endl;
     EXPECT_EQ(optimized_values.size(), 0);
 }
@@ -770,9 +772,10 @@ TEST(EnergyManagerTest, noSchedules) {
 
     // use a fixed time for repeatable tests
     const auto start_time = Everest::Date::from_rfc3339("2024-01-01T12:00:00.000Z");
-    module::globals.init(start_time, config.schedule_interval_duration, config.schedule_total_duration,
-                         config.slice_ampere, config.slice_watt, config.debug, energy_flow_request);
-    auto optimized_values = manager.run_optimizer(energy_flow_request);
+    const module::OptimizerContext context(start_time, config.schedule_interval_duration,
+                                           config.schedule_total_duration, config.slice_ampere, config.slice_watt,
+                                           config.debug, energy_flow_request);
+    auto optimized_values = manager.run_optimizer(context, energy_flow_request);
 
     // check result
     // std::cout << optimized_values << std::endl;
@@ -840,9 +843,10 @@ TEST(EnergyManagerTest, schedules) {
 
     // start a little ahead of the 1st schedule
     const auto start_time = Everest::Date::from_rfc3339("2024-03-27T12:40:40.000Z");
-    module::globals.init(start_time, config.schedule_interval_duration, config.schedule_total_duration,
-                         config.slice_ampere, config.slice_watt, config.debug, energy_flow_request);
-    auto optimized_values = manager.run_optimizer(energy_flow_request);
+    const module::OptimizerContext context(start_time, config.schedule_interval_duration,
+                                           config.schedule_total_duration, config.slice_ampere, config.slice_watt,
+                                           config.debug, energy_flow_request);
+    auto optimized_values = manager.run_optimizer(context, energy_flow_request);
 
     // check result
     // std::cout << optimized_values << std::endl;
@@ -979,4 +983,177 @@ TEST(EnergyManagerTest, gcp_after) {
     test::schedule_test(grid_connection_point::c_efr_grid_connection_point, "2024-03-28T14:45:00.557Z", 0.0);
 }
 
+// ----------------------------------------------------------------------------
+// incremental optimizer
+
+types::energy::EnergyFlowRequest evse_request(const std::string& uuid, float max_current) {
+    return {
+        {},                            // children, std::vector<types::energy::EnergyFlowRequest>
+        uuid,                          // UUID for this node
+        types::energy::NodeType::Evse, // node_type
+        false,                         // optional - bool priority_request
+        std::nullopt,                  // optional - EvseState
+        std::nullopt,                  // optional - types::energy::OptimizerTarget
+        std::nullopt,                  // optional - types::powermeter::Powermeter - root
+        std::nullopt,                  // optional - types::powermeter::Powermeter - leaf
+        {{{"2024-03-27T12:00:00.000Z", limit(32.0, 6.0), limit(max_current), std::nullopt, std::nullopt}}}, // import
+        {c_schedule_export}, // optional - std::vector<types::energy::ScheduleReqEntry> - export
+    };
+}
+
+types::energy::EnergyFlowRequest node_request(const std::string& uuid, float max_current,
+                                              std::vector<types::energy::EnergyFlowRequest> children) {
+    return {
+        std::move(children),              // children, std::vector<types::energy::EnergyFlowRequest>
+        uuid,                             // UUID for this node
+        types::energy::NodeType::Generic, // node_type
+        std::nullopt,                     // optional - bool priority_request
+        std::nullopt,                     // optional - EvseState
+        std::nullopt,                     // optional - types::energy::OptimizerTarget
+        std::nullopt,                     // optional - types::powermeter::Powermeter - root
+        std::nullopt,                     // optional - types::powermeter::Powermeter - leaf
+        {{{"2024-03-27T12:00:00.000Z", limit(), limit_no_phase(max_current), std::nullopt, std::nullopt}}},
+        std::nullopt, // optional - std::vector<types::energy::ScheduleReqEntry> - export
+    };
+}
+
+std::map<std::string, float> limits_by_uuid(const std::vector<types::energy::EnforcedLimits>& limits) {
+    std::map<std::string, float> result;
+    for (const auto& l : limits) {
+        result[l.uuid] = l.limits_root_side.value().ac_max_current_A.value_or(-1);
+    }
+    return result;
+}
+
+TEST(EnergyManagerTest, incremental) {
+    struct module::Conf config {
+        230.0,     // nominal_ac_voltage
+            1,     // update_interval
+            60,    // schedule_interval_duration
+            1,     // schedule_total_duration
+            0.5,   // slice_ampere
+            500,   // slice_watt
+            false, // debug
+    };
+    config.incremental_optimizer = true;
+    config.incremental_optimizer_full_solve_interval = 0;
+
+    std::unique_ptr<energyIntf> energy;
+    auto energy_managerImpl = std::make_unique<module::stub::energy_managerImplStub>();
+
+    module::EnergyManager manager(c_module_info, std::move(energy_managerImpl), std::move(energy), config);
+
+    auto request = node_request("root", 64.0,
+                                {node_request("a", 32.0, {evse_request("a1", 16.0), evse_request("a2", 16.0)}),
+                                 node_request("b", 32.0, {evse_request("b1", 16.0), evse_request("b2", 16.0)})});
+
+    const auto start_time = Everest::Date::from_rfc3339("2024-03-27T12:10:00.000Z");
+    const module::OptimizerContext context(start_time, config.schedule_interval_duration,
+                                           config.schedule_total_duration, config.slice_ampere, config.slice_watt,
+                                           config.debug, request);
+
+    // first run is always a full solve
+    auto full = limits_by_uuid(manager.run_optimizer(context, request));
+    auto incremental = limits_by_uuid(manager.run_optimizer_incremental(context, request));
+    EXPECT_EQ(full, incremental);
+    EXPECT_EQ(incremental["a1"], 16.0);
+    EXPECT_EQ(incremental["b2"], 16.0);
+
+    // nothing changed, result must stay the same
+    EXPECT_EQ(limits_by_uuid(manager.run_optimizer_incremental(context, request)), full);
+
+    // change one leaf, only subtree a is traded again
+    request.children[0].children[0].schedule_import.value()[0].limits_to_leaves.ac_max_current_A = 8.0;
+    incremental = limits_by_uuid(manager.run_optimizer_incremental(context, request));
+    full = limits_by_uuid(manager.run_optimizer(context, request));
+    EXPECT_EQ(full, incremental);
+    EXPECT_EQ(incremental["a1"], 8.0);
+    EXPECT_EQ(incremental["a2"], 16.0);
+
+    // change a leaf back and lower the limit of its parent node
+    request.children[0].children[0].schedule_import.value()[0].limits_to_leaves.ac_max_current_A = 16.0;
+    request.children[0].schedule_import.value()[0].limits_to_leaves.ac_max_current_A = 20.0;
+    incremental = limits_by_uuid(manager.run_optimizer_incremental(context, request));
+    full = limits_by_uuid(manager.run_optimizer(context, request));
+    EXPECT_EQ(full, incremental);
+    EXPECT_EQ(incremental["a1"] + incremental["a2"], 20.0);
+    EXPECT_EQ(incremental["b1"], 16.0);
+}
+
+TEST(EnergyManagerTest, incremental_topology_change) {
+    struct module::Conf config {
+        230.0,     // nominal_ac_voltage
+            1,     // update_interval
+            60,    // schedule_interval_duration
+            1,     // schedule_total_duration
+            0.5,   // slice_ampere
+            500,   // slice_watt
+            false, // debug
+    };
+    config.incremental_optimizer = true;
+    config.incremental_optimizer_full_solve_interval = 0;
+
+    std::unique_ptr<energyIntf> energy;
+    auto energy_managerImpl = std::make_unique<module::stub::energy_managerImplStub>();
+
+    module::EnergyManager manager(c_module_info, std::move(energy_managerImpl), std::move(energy), config);
+
+    auto request = node_request("root", 32.0, {evse_request("a1", 32.0)});
+
+    const auto start_time = Everest::Date::from_rfc3339("2024-03-27T12:10:00.000Z");
+    const module::OptimizerContext context(start_time, config.schedule_interval_duration,
+                                           config.schedule_total_duration, config.slice_ampere, config.slice_watt,
+                                           config.debug, request);
+
+    auto incremental = limits_by_uuid(manager.run_optimizer_incremental(context, request));
+    ASSERT_EQ(incremental.size(), 1);
+    EXPECT_EQ(incremental["a1"], 32.0);
+
+    // a new evse shows up, the tree needs to be rebuilt
+    request.children.push_back(evse_request("a2", 32.0));
+    incremental = limits_by_uuid(manager.run_optimizer_incremental(context, request));
+    ASSERT_EQ(incremental.size(), 2);
+    EXPECT_EQ(incremental, limits_by_uuid(manager.run_optimizer(context, request)));
+    EXPECT_EQ(incremental["a1"] + incremental["a2"], 32.0);
+}
+
+TEST(EnergyManagerTest, scenarios) {
+    struct module::Conf config {
+        230.0,     // nominal_ac_voltage
+            1,     // update_interval
+            60,    // schedule_interval_duration
+            1,     // schedule_total_duration
+            0.5,   // slice_ampere
+            500,   // slice_watt
+            false, // debug
+    };
+    std::unique_ptr<energyIntf> energy;
+    auto energy_managerImpl = std::make_unique<module::stub::energy_managerImplStub>();
+
+    module::EnergyManager manager(c_module_info, std::move(energy_managerImpl), std::move(energy), config);
+
+    // same tree with different limits for evse a1
+    std::vector<types::energy::EnergyFlowRequest> scenarios;
+    for (float a1 : {8.0, 32.0, 16.0, 24.0}) {
+        scenarios.push_back(node_request("root", 64.0, {evse_request("a1", a1), evse_request("a2", 16.0)}));
+    }
+
+    const auto start_time = Everest::Date::from_rfc3339("2024-03-27T12:10:00.000Z");
+    const module::OptimizerContext context(start_time, config.schedule_interval_duration,
+                                           config.schedule_total_duration, config.slice_ampere, config.slice_watt,
+                                           config.debug, scenarios[0]);
+
+    auto best = manager.run_scenarios(context, scenarios, nullptr, 2);
+    EXPECT_EQ(best.index, 1);
+    EXPECT_EQ(limits_by_uuid(best.limits), limits_by_uuid(manager.run_optimizer(context, scenarios[1])));
+    EXPECT_FLOAT_EQ(best.rating, (32.0 + 16.0) * 3 * 230.0);
+
+    // custom rating: prefer the lowest current for evse a1
+    best = manager.run_scenarios(context, scenarios, [](const std::vector<types::energy::EnforcedLimits>& limits) {
+        return -limits_by_uuid(limits)["a1"];
+    });
+    EXPECT_EQ(best.index, 0);
+    EXPECT_EQ(limits_by_uuid(best.limits)["a1"], 8.0);
+}
+
 } // namespace module
@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include "PublishCoalescer.hpp"
+
+namespace module {
+
+PublishCoalescer::PublishCoalescer(clock::duration _interval) : interval(_interval) {
+}
+
+bool PublishCoalescer::update(bool priority) {
+    const bool wake_up = not pending or (priority and not priority_pending);
+    pending = true;
+    priority_pending = priority_pending or priority;
+    return wake_up;
+}
+
+bool PublishCoalescer::due(clock::time_point now) const {
+    if (not pending) {
+        return false;
+    }
+    return priority_pending or not last_publish.has_value() or now >= last_publish.value() + interval;
+}
+
+void PublishCoalescer::published(clock::time_point now) {
+    pending = false;
+    priority_pending = false;
+    last_publish = now;
+}
+
+std::optional<PublishCoalescer::clock::time_point> PublishCoalescer::next_publish() const {
+    if (not pending) {
+        return std::nullopt;
+    }
+    if (priority_pending or not last_publish.has_value()) {
+        return clock::time_point::min();
+    }
+    return last_publish.value() + interval;
+}
+
+} // namespace module
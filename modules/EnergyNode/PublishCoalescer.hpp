@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef ENERGY_NODE_PUBLISH_COALESCER_HPP
+#define ENERGY_NODE_PUBLISH_COALESCER_HPP
+
+#include <chrono>
+#include <optional>
+
+namespace module {
+
+/*
+ Decides when the energy flow request is published to the parent if updates are coalesced.
+
+ The first update after a quiet period is published right away, all further updates are collected until the interval
+ since the last publication has passed and are then published together. Priority updates are always published right
+ away. The class does not lock, the caller protects it together with the data that is published.
+*/
+class PublishCoalescer {
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit PublishCoalescer(clock::duration interval);
+
+    // an update arrived, returns true if the publishing thread needs to be woken up to check due() again
+    bool update(bool priority);
+
+    // true if the pending update needs to be published now
+    bool due(clock::time_point now) const;
+
+    // the pending update was published at now
+    void published(clock::time_point now);
+
+    // time at which the pending update becomes due, std::nullopt if nothing is pending
+    std::optional<clock::time_point> next_publish() const;
+
+private:
+    const clock::duration interval;
+    std::optional<clock::time_point> last_publish;
+    bool pending{false};
+    bool priority_pending{false};
+};
+
+} // namespace module
+
+#endif // ENERGY_NODE_PUBLISH_COALESCER_HPP
@@ -5,12 +5,17 @@
 #include <chrono>
 #include <date/date.h>
 #include <date/tz.h>
+#include <fmt/core.h>
+#include <thread>
 #include <utils/date.hpp>
 
 namespace module {
 namespace energy_grid {
 
 void energyImpl::init() {
+    if (mod->config.request_publish_interval_ms > 0) {
+        coalescer.emplace(std::chrono::milliseconds(mod->config.request_publish_interval_ms));
+    }
 
     // UUID must be unique also beyond this charging station -> will be handled on framework level and above later
     energy_flow_request.uuid = mod->info.id;
@@ -26,19 +31,16 @@ void energyImpl::init() {
             // Received new energy_flow_request object from a child. Update in the cached object and republish.
             std::scoped_lock lock(energy_mutex);
 
-            bool child_found = false;
-            for (auto& child : energy_flow_request.children) {
-                if (child.uuid == e.uuid) {
-                    child = e;
-                    child_found = true;
-                }
-            }
-
-            if (!child_found) {
-                energy_flow_request.children.push_back(e);
+            const bool priority = e.priority_request.value_or(false);
+            const auto it = child_index.find(e.uuid);
+            if (it != child_index.end()) {
+                energy_flow_request.children[it->second] = std::move(e);
+            } else {
+                child_index.emplace(e.uuid, energy_flow_request.children.size());
+                energy_flow_request.children.push_back(std::move(e));
             }
 
-            publish_complete_energy_object();
+            request_publish(priority);
         });
     }
 
@@ -46,8 +48,8 @@ void energyImpl::init() {
         mod->r_powermeter[0]->subscribe_powermeter([this](types::powermeter::Powermeter p) {
             EVLOG_debug << "Incoming powermeter readings: " << p;
             std::scoped_lock lock(energy_mutex);
-            energy_flow_request.energy_usage_root = p;
-            publish_complete_energy_object();
+            energy_flow_request.energy_usage_root = std::move(p);
+            request_publish(false);
         });
     }
 
@@ -56,8 +58,8 @@ void energyImpl::init() {
             [this](types::energy_price_information::EnergyPriceSchedule p) {
                 EVLOG_debug << "Incoming price schedule: " << p;
                 std::scoped_lock lock(energy_mutex);
-                energy_pricing = p;
-                publish_complete_energy_object();
+                energy_pricing = std::move(p);
+                request_publish(false);
             });
     }
 }
@@ -123,15 +125,84 @@ void energyImpl::set_external_limits(types::energy::ExternalLimits& l) {
     }
 }
 
+// needs to be called with energy_mutex held
+void energyImpl::request_publish(bool priority) {
+    updates_received++;
+
+    if (not coalescer.has_value()) {
+        publish_complete_energy_object();
+        return;
+    }
+
+    // coalesce updates, the publish thread sends out the latest state
+    if (coalescer->update(priority)) {
+        publish_cv.notify_one();
+    }
+}
+
+void energyImpl::publish_thread() {
+    using namespace std::chrono;
+    constexpr auto statistics_interval = seconds(10);
+
+    auto next_statistics = steady_clock::now() + statistics_interval;
+
+    std::unique_lock lock(energy_mutex);
+    while (true) {
+        const auto now = steady_clock::now();
+        if (coalescer->due(now)) {
+            publish_complete_energy_object();
+            coalescer->published(now);
+        }
+
+        if (now >= next_statistics) {
+            publish_statistics();
+            next_statistics = now + statistics_interval;
+        }
+
+        // request_publish wakes this thread up if an update arrives while nothing is pending,
+        // so the first update after a quiet period is published without delay
+        publish_cv.wait_until(lock, std::min(coalescer->next_publish().value_or(next_statistics), next_statistics));
+    }
+}
+
+// needs to be called with energy_mutex held
+void energyImpl::publish_statistics() {
+    const auto coalesced = updates_received > requests_published ? updates_received - requests_published : 0;
+    EVLOG_debug << fmt::format("Energy flow request updates received: {}, published: {}, coalesced: {}",
+                               updates_received, requests_published, coalesced);
+
+    if (mod->info.telemetry_enabled) {
+        mod->telemetry.publish("livedata", "energy_flow_request",
+                               {{"timestamp", Everest::Date::to_rfc3339(date::utc_clock::now())},
+                                {"type", "energy_flow_request"},
+                                {"updates_received", static_cast<int>(updates_received)},
+                                {"requests_published", static_cast<int>(requests_published)},
+                                {"updates_coalesced", static_cast<int>(coalesced)}});
+    }
+}
+
 void energyImpl::publish_complete_energy_object() {
+    requests_published++;
+
+    const bool merge_import =
+        energy_flow_request.schedule_import.has_value() && energy_pricing.schedule_import.has_value();
+    const bool merge_export =
+        energy_flow_request.schedule_export.has_value() && energy_pricing.schedule_export.has_value();
+
+    // Without price information the cached object can be published as is. This avoids copying the complete subtree.
+    if (not merge_import and not merge_export) {
+        publish_energy_flow_request(energy_flow_request);
+        return;
+    }
+
     // join the different schedules to the complete array (with resampling)
     types::energy::EnergyFlowRequest energy_complete = energy_flow_request;
 
-    if (energy_flow_request.schedule_import.has_value() && energy_pricing.schedule_import.has_value()) {
+    if (merge_import) {
         merge_price_into_schedule(energy_complete.schedule_import.value(), energy_pricing.schedule_import.value());
     }
 
-    if (energy_flow_request.schedule_export.has_value() && energy_pricing.schedule_export.has_value()) {
+    if (merge_export) {
         merge_price_into_schedule(energy_complete.schedule_export.value(), energy_pricing.schedule_export.value());
     }
 
@@ -187,6 +258,10 @@ void energyImpl::ready() {
     // publish own limits at least once
     publish_energy_flow_request(energy_flow_request);
     mod->signalExternalLimit.connect([this](types::energy::ExternalLimits& l) { set_external_limits(l); });
+
+    if (coalescer.has_value()) {
+        std::thread([this] { publish_thread(); }).detach();
+    }
 }
 
 void energyImpl::handle_enforce_limits(types::energy::EnforcedLimits& value) {
@@ -14,7 +14,12 @@
 
 // ev@75ac1216-19eb-4182-a85c-820f1fc2c091:v1
 // insert your custom include headers here
+#include <condition_variable>
+#include <map>
 #include <mutex>
+#include <optional>
+
+#include "../PublishCoalescer.hpp"
 // ev@75ac1216-19eb-4182-a85c-820f1fc2c091:v1
 
 namespace module {
@@ -51,12 +56,25 @@ private:
     std::mutex energy_mutex;
     // subtree including children
     types::energy::EnergyFlowRequest energy_flow_request;
+    // maps the uuid of a child to its index in energy_flow_request.children
+    std::map<std::string, std::size_t> child_index;
+
+    // coalescing of updates, only used if request_publish_interval_ms > 0
+    std::condition_variable publish_cv;
+    std::optional<PublishCoalescer> coalescer;
+
+    // statistics, protected by energy_mutex
+    uint64_t updates_received{0};
+    uint64_t requests_published{0};
 
     // contains only the pricing informations last update
     types::energy_price_information::EnergyPriceSchedule energy_pricing;
 
     types::energy::ScheduleReqEntry get_local_schedule();
     void publish_complete_energy_object();
+    void request_publish(bool priority);
+    void publish_thread();
+    void publish_statistics();
     void set_external_limits(types::energy::ExternalLimits& l);
     void merge_price_into_schedule(std::vector<types::energy::ScheduleReqEntry>& schedule,
                                    const std::vector<types::energy_price_information::PricePerkWh>& price);
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include <gtest/gtest.h>
+
+#include "PublishCoalescer.hpp"
+
+namespace {
+
+using module::PublishCoalescer;
+using namespace std::chrono_literals;
+
+constexpr auto c_interval = 100ms;
+
+TEST(PublishCoalescerTest, first_update_is_published_immediately) {
+    PublishCoalescer coalescer(c_interval);
+    const auto start = PublishCoalescer::clock::now();
+
+    EXPECT_FALSE(coalescer.due(start));
+    EXPECT_FALSE(coalescer.next_publish().has_value());
+
+    EXPECT_TRUE(coalescer.update(false));
+    EXPECT_TRUE(coalescer.due(start));
+    coalescer.published(start);
+    EXPECT_FALSE(coalescer.due(start));
+
+    // nothing happens for longer than the interval, the next update is sent right away as well
+    const auto later = start + 3 * c_interval;
+    EXPECT_TRUE(coalescer.update(false));
+    EXPECT_TRUE(coalescer.due(later));
+}
+
+TEST(PublishCoalescerTest, updates_within_the_interval_are_coalesced) {
+    PublishCoalescer coalescer(c_interval);
+    const auto start = PublishCoalescer::clock::now();
+
+    coalescer.update(false);
+    coalescer.published(start);
+
+    // only the first update after a publication needs to wake up the publishing thread
+    EXPECT_TRUE(coalescer.update(false));
+    EXPECT_FALSE(coalescer.update(false));
+    EXPECT_FALSE(coalescer.update(false));
+
+    EXPECT_FALSE(coalescer.due(start + c_interval / 2));
+    ASSERT_TRUE(coalescer.next_publish().has_value());
+    EXPECT_EQ(coalescer.next_publish().value(), start + c_interval);
+
+    // all three updates go out with one publication
+    EXPECT_TRUE(coalescer.due(start + c_interval));
+    coalescer.published(start + c_interval);
+    EXPECT_FALSE(coalescer.due(start + 2 * c_interval));
+    EXPECT_FALSE(coalescer.next_publish().has_value());
+}
+
+TEST(PublishCoalescerTest, priority_updates_are_not_delayed) {
+    PublishCoalescer coalescer(c_interval);
+    const auto start = PublishCoalescer::clock::now();
+
+    coalescer.update(false);
+    coalescer.published(start);
+
+    EXPECT_TRUE(coalescer.update(false));
+    EXPECT_FALSE(coalescer.due(start + 1ms));
+
+    // a priority update wakes up the publishing thread even if an update is already pending
+    EXPECT_TRUE(coalescer.update(true));
+    EXPECT_FALSE(coalescer.update(true));
+    EXPECT_TRUE(coalescer.due(start + 1ms));
+    coalescer.published(start + 1ms);
+
+    // the interval starts again with the priority publication
+    coalescer.update(false);
+    EXPECT_FALSE(coalescer.due(start + c_interval));
+    EXPECT_TRUE(coalescer.due(start + 1ms + c_interval));
+}
+
+} // namespace
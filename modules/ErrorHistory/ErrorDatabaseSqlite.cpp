@@ -13,8 +13,18 @@
 
 namespace module {
 
-ErrorDatabaseSqlite::ErrorDatabaseSqlite(const fs::path& db_path_, const bool reset_) :
-    db_path(fs::absolute(db_path_)) {
+namespace {
+// maximum number of errors written in one transaction
+const std::size_t max_batch_size = 1000;
+
+// column order of all SELECT statements
+const std::string select_columns = "SELECT uuid, type, description, message, origin_module, origin_implementation, "
+                                   "timestamp, severity, state, sub_type, vendor_id FROM errors";
+} // namespace
+
+ErrorDatabaseSqlite::ErrorDatabaseSqlite(const fs::path& db_path_, const bool reset_,
+                                         const std::chrono::milliseconds flush_interval_) :
+    db_path(fs::absolute(db_path_)), flush_interval(flush_interval_) {
     BOOST_LOG_FUNCTION();
     std::lock_guard<std::mutex> lock(this->db_mutex);
 
@@ -32,6 +42,43 @@ ErrorDatabaseSqlite::ErrorDatabaseSqlite(const fs::path& db_path_, const bool re
             this->reset_database();
         }
     }
+    this->open_database();
+
+    if (this->flush_interval.count() > 0) {
+        this->flush_thread_handle = std::thread(&ErrorDatabaseSqlite::flush_thread, this);
+    }
+}
+
+ErrorDatabaseSqlite::~ErrorDatabaseSqlite() {
+    {
+        std::lock_guard<std::mutex> lock(this->db_mutex);
+        this->stop_flush_thread = true;
+    }
+    this->flush_cv.notify_all();
+    if (this->flush_thread_handle.joinable()) {
+        this->flush_thread_handle.join();
+    }
+
+    std::lock_guard<std::mutex> lock(this->db_mutex);
+    this->flush_without_mutex();
+    // statements have to be finalized before the database is closed
+    this->statements.clear();
+}
+
+void ErrorDatabaseSqlite::open_database() {
+    BOOST_LOG_FUNCTION();
+    try {
+        this->db = std::make_unique<SQLite::Database>(this->db_path.string(), SQLite::OPEN_READWRITE);
+        // WAL mode: commits do not rewrite the database file and readers do not block the writer
+        this->db->exec("PRAGMA journal_mode=WAL;");
+        this->db->exec("PRAGMA synchronous=NORMAL;");
+        this->db->exec("CREATE INDEX IF NOT EXISTS errors_state ON errors(state);");
+        this->db->exec("CREATE INDEX IF NOT EXISTS errors_type ON errors(type);");
+        this->db->exec("CREATE INDEX IF NOT EXISTS errors_origin ON errors(origin_module, origin_implementation);");
+    } catch (std::exception& e) {
+        EVLOG_error << "Error opening database: " << e.what();
+        throw;
+    }
 }
 
 void ErrorDatabaseSqlite::check_database() {
@@ -84,8 +131,11 @@ void ErrorDatabaseSqlite::reset_database() {
     if (!fs::exists(database_directory)) {
         fs::create_directories(database_directory);
     }
-    if (fs::exists(this->db_path)) {
-        fs::remove(this->db_path);
+    for (const auto& suffix : {"", "-wal", "-shm"}) {
+        const fs::path path = this->db_path.string() + suffix;
+        if (fs::exists(path)) {
+            fs::remove(path);
+        }
     }
     try {
         SQLite::Database db(this->db_path.string(), SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
@@ -115,86 +165,175 @@ void ErrorDatabaseSqlite::add_error(Everest::error::ErrorPtr error) {
 
 void ErrorDatabaseSqlite::add_error_without_mutex(Everest::error::ErrorPtr error) {
     BOOST_LOG_FUNCTION();
+    if (this->flush_interval.count() == 0) {
+        try {
+            this->insert_error(error);
+        } catch (std::exception& e) {
+            EVLOG_error << "Error adding error to database: " << e.what();
+            throw;
+        }
+        return;
+    }
+
+    // copy, the error is written later
+    this->pending_errors.push_back(std::make_shared<Everest::error::Error>(*error));
+    if (this->pending_errors.size() == 1 || this->pending_errors.size() >= max_batch_size) {
+        this->flush_cv.notify_all();
+    }
+}
+
+void ErrorDatabaseSqlite::insert_error(const Everest::error::ErrorPtr& error) const {
+    SQLite::Statement& stmt =
+        this->get_statement("INSERT INTO errors(uuid, type, description, message, origin_module, "
+                            "origin_implementation, timestamp, severity, state, sub_type, vendor_id) "
+                            "VALUES(?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11);");
+    stmt.reset();
+    stmt.bind(1, error->uuid.to_string());
+    stmt.bind(2, error->type);
+    stmt.bind(3, error->description);
+    stmt.bind(4, error->message);
+    stmt.bind(5, error->origin.module_id);
+    stmt.bind(6, error->origin.implementation_id);
+    stmt.bind(7, Everest::Date::to_rfc3339(error->timestamp));
+    stmt.bind(8, Everest::error::severity_to_string(error->severity));
+    stmt.bind(9, Everest::error::state_to_string(error->state));
+    stmt.bind(10, error->sub_type);
+    stmt.bind(11, error->vendor_id);
+    stmt.exec();
+}
+
+void ErrorDatabaseSqlite::flush() {
+    std::lock_guard<std::mutex> lock(this->db_mutex);
+    this->flush_without_mutex();
+}
+
+void ErrorDatabaseSqlite::flush_without_mutex() const {
+    BOOST_LOG_FUNCTION();
+    if (this->pending_errors.empty()) {
+        return;
+    }
+
+    // errors that cannot be written are dropped, otherwise one bad error would block all others
+    std::vector<Everest::error::ErrorPtr> errors;
+    errors.swap(this->pending_errors);
     try {
-        SQLite::Database db(this->db_path.string(), SQLite::OPEN_READWRITE);
-        std::string sql = "INSERT INTO errors(uuid, type, description, message, origin_module, origin_implementation, "
-                          "timestamp, severity, state, sub_type, vendor_id) VALUES(";
-        sql += "?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11);";
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, error->uuid.to_string());
-        stmt.bind(2, error->type);
-        stmt.bind(3, error->description);
-        stmt.bind(4, error->message);
-        stmt.bind(5, error->origin.module_id);
-        stmt.bind(6, error->origin.implementation_id);
-        stmt.bind(7, Everest::Date::to_rfc3339(error->timestamp));
-        stmt.bind(8, Everest::error::severity_to_string(error->severity));
-        stmt.bind(9, Everest::error::state_to_string(error->state));
-        stmt.bind(10, error->sub_type);
-        stmt.bind(11, error->vendor_id);
-        stmt.exec();
+        SQLite::Transaction transaction(*this->db);
+        for (const Everest::error::ErrorPtr& error : errors) {
+            this->insert_error(error);
+        }
+        transaction.commit();
+        return;
     } catch (std::exception& e) {
-        EVLOG_error << "Error adding error to database: " << e.what();
-        throw;
+        EVLOG_warning << "Error adding " << errors.size()
+                      << " errors to database, adding them one by one: " << e.what();
+    }
+
+    // the transaction has been rolled back, write every error on its own so only the bad ones are lost
+    for (const Everest::error::ErrorPtr& error : errors) {
+        try {
+            this->insert_error(error);
+        } catch (std::exception& e) {
+            EVLOG_error << "Error adding error " << error->uuid.to_string()
+                        << " to database, dropping it: " << e.what();
+        }
+    }
+}
+
+void ErrorDatabaseSqlite::flush_thread() {
+    std::unique_lock<std::mutex> lock(this->db_mutex);
+    while (!this->stop_flush_thread) {
+        this->flush_cv.wait(lock, [this] { return this->stop_flush_thread || !this->pending_errors.empty(); });
+        // collect errors for one flush interval, unless the batch is full already
+        this->flush_cv.wait_for(lock, this->flush_interval, [this] {
+            return this->stop_flush_thread || this->pending_errors.size() >= max_batch_size;
+        });
+        this->flush_without_mutex();
     }
 }
 
-std::string ErrorDatabaseSqlite::filter_to_sql_condition(const Everest::error::ErrorFilter& filter) {
+SQLite::Statement& ErrorDatabaseSqlite::get_statement(const std::string& sql) const {
+    auto it = this->statements.find(sql);
+    if (it == this->statements.end()) {
+        EVLOG_debug << "Preparing SQL statement: " << sql;
+        it = this->statements.emplace(sql, std::make_unique<SQLite::Statement>(*this->db, sql)).first;
+    }
+    return *it->second;
+}
+
+void ErrorDatabaseSqlite::bind_values(SQLite::Statement& stmt, const std::optional<SqlCondition>& condition) {
+    stmt.reset();
+    if (condition.has_value()) {
+        for (std::size_t i = 0; i < condition->values.size(); i++) {
+            stmt.bind(static_cast<int>(i + 1), condition->values[i]);
+        }
+    }
+}
+
+std::string ErrorDatabaseSqlite::filter_to_sql_condition(const Everest::error::ErrorFilter& filter,
+                                                         std::vector<std::string>& values) {
+    // adds a value and returns its parameter
+    const auto param = [&values](const std::string& value) {
+        values.push_back(value);
+        return "?" + std::to_string(values.size());
+    };
+
     std::string condition = "";
     switch (filter.get_filter_type()) {
     case Everest::error::FilterType::State: {
-        condition = "(state = '" + Everest::error::state_to_string(filter.get_state_filter()) + "')";
+        condition = "(state = " + param(Everest::error::state_to_string(filter.get_state_filter())) + ")";
     } break;
     case Everest::error::FilterType::Origin: {
-        condition = "(origin_module = '" + filter.get_origin_filter().module_id + "' AND " +
-                    "origin_implementation = '" + filter.get_origin_filter().implementation_id + "')";
+        condition = "(origin_module = " + param(filter.get_origin_filter().module_id) +
+                    " AND origin_implementation = " + param(filter.get_origin_filter().implementation_id) + ")";
     } break;
     case Everest::error::FilterType::Type: {
-        condition = "(type = '" + filter.get_type_filter().value + "')";
+        condition = "(type = " + param(filter.get_type_filter().value) + ")";
     } break;
     case Everest::error::FilterType::Severity: {
         switch (filter.get_severity_filter()) {
         case Everest::error::SeverityFilter::LOW_GE: {
-            condition = "(severity = '" + Everest::error::severity_to_string(Everest::error::Severity::Low) +
-                        "' OR severity = '" + Everest::error::severity_to_string(Everest::error::Severity::Medium) +
-                        "' OR severity = '" + Everest::error::severity_to_string(Everest::error::Severity::High) + "')";
+            condition = "(severity IN (" + param(Everest::error::severity_to_string(Everest::error::Severity::Low)) +
+                        ", " + param(Everest::error::severity_to_string(Everest::error::Severity::Medium)) + ", " +
+                        param(Everest::error::severity_to_string(Everest::error::Severity::High)) + "))";
         } break;
         case Everest::error::SeverityFilter::MEDIUM_GE: {
-            condition = "(severity = '" + Everest::error::severity_to_string(Everest::error::Severity::Medium) +
-                        "' OR severity = '" + Everest::error::severity_to_string(Everest::error::Severity::High) + "')";
+            condition =
+                "(severity IN (" + param(Everest::error::severity_to_string(Everest::error::Severity::Medium)) + ", " +
+                param(Everest::error::severity_to_string(Everest::error::Severity::High)) + "))";
         } break;
         case Everest::error::SeverityFilter::HIGH_GE: {
-            condition = "(severity = '" + Everest::error::severity_to_string(Everest::error::Severity::High) + "')";
+            condition = "(severity = " + param(Everest::error::severity_to_string(Everest::error::Severity::High)) +
+                        ")";
         } break;
         }
     } break;
     case Everest::error::FilterType::TimePeriod: {
-        condition = "(timestamp BETWEEN '" + Everest::Date::to_rfc3339(filter.get_time_period_filter().from) +
-                    "' AND '" + Everest::Date::to_rfc3339(filter.get_time_period_filter().to) + "')";
+        condition = "(timestamp BETWEEN " + param(Everest::Date::to_rfc3339(filter.get_time_period_filter().from)) +
+                    " AND " + param(Everest::Date::to_rfc3339(filter.get_time_period_filter().to)) + ")";
     } break;
     case Everest::error::FilterType::Handle: {
-        condition = "(uuid = '" + filter.get_handle_filter().to_string() + "')";
+        condition = "(uuid = " + param(filter.get_handle_filter().to_string()) + ")";
     } break;
     case Everest::error::FilterType::SubType: {
-        condition = "(sub_type = '" + filter.get_sub_type_filter().value + "')";
+        condition = "(sub_type = " + param(filter.get_sub_type_filter().value) + ")";
     } break;
     case Everest::error::FilterType::VendorId: {
-        condition = "(vendor_id = '" + filter.get_vendor_id_filter().value + "')";
+        condition = "(vendor_id = " + param(filter.get_vendor_id_filter().value) + ")";
     } break;
     }
     return condition;
 }
 
-std::optional<std::string>
+std::optional<ErrorDatabaseSqlite::SqlCondition>
 ErrorDatabaseSqlite::filters_to_sql_condition(const std::list<Everest::error::ErrorFilter>& filters) {
-    std::optional<std::string> condition = std::nullopt;
+    std::optional<SqlCondition> condition = std::nullopt;
     if (!filters.empty()) {
-        auto it = filters.begin();
-        condition = filter_to_sql_condition(*it);
-        it++;
-        while (it != filters.end()) {
-            condition = condition.value() + " AND " + ErrorDatabaseSqlite::filter_to_sql_condition(*it);
-            it++;
+        condition = SqlCondition();
+        for (const Everest::error::ErrorFilter& filter : filters) {
+            if (!condition->sql.empty()) {
+                condition->sql += " AND ";
+            }
+            condition->sql += ErrorDatabaseSqlite::filter_to_sql_condition(filter, condition->values);
         }
     }
     return condition;
@@ -203,40 +342,42 @@ ErrorDatabaseSqlite::filters_to_sql_condition(const std::list<Everest::error::Er
 std::list<Everest::error::ErrorPtr>
 ErrorDatabaseSqlite::get_errors(const std::list<Everest::error::ErrorFilter>& filters) const {
     std::lock_guard<std::mutex> lock(this->db_mutex);
+    this->flush_without_mutex();
     return this->get_errors(ErrorDatabaseSqlite::filters_to_sql_condition(filters));
 }
 
-std::list<Everest::error::ErrorPtr> ErrorDatabaseSqlite::get_errors(const std::optional<std::string>& condition) const {
+std::list<Everest::error::ErrorPtr>
+ErrorDatabaseSqlite::get_errors(const std::optional<SqlCondition>& condition) const {
     BOOST_LOG_FUNCTION();
     std::list<Everest::error::ErrorPtr> result;
     try {
-        SQLite::Database db(this->db_path.string(), SQLite::OPEN_READONLY);
-        std::string sql = "SELECT * FROM errors";
+        std::string sql = select_columns;
         if (condition.has_value()) {
-            sql += " WHERE " + condition.value();
+            sql += " WHERE " + condition->sql;
         }
-        EVLOG_debug << "Executing SQL statement: " << sql;
-        SQLite::Statement stmt(db, sql);
+        SQLite::Statement& stmt = this->get_statement(sql);
+        ErrorDatabaseSqlite::bind_values(stmt, condition);
         while (stmt.executeStep()) {
-            const Everest::error::ErrorType err_type(stmt.getColumn("type").getText());
-            const std::string err_description = stmt.getColumn("description").getText();
-            const std::string err_msg = stmt.getColumn("message").getText();
-            const std::string err_origin_module_id = stmt.getColumn("origin_module").getText();
-            const std::string err_origin_impl_id = stmt.getColumn("origin_implementation").getText();
+            const Everest::error::ErrorType err_type(stmt.getColumn(1).getText());
+            const std::string err_description = stmt.getColumn(2).getText();
+            const std::string err_msg = stmt.getColumn(3).getText();
+            const std::string err_origin_module_id = stmt.getColumn(4).getText();
+            const std::string err_origin_impl_id = stmt.getColumn(5).getText();
             const ImplementationIdentifier err_origin(err_origin_module_id, err_origin_impl_id);
             const Everest::error::Error::time_point err_timestamp =
-                Everest::Date::from_rfc3339(stmt.getColumn("timestamp").getText());
+                Everest::Date::from_rfc3339(stmt.getColumn(6).getText());
             const Everest::error::Severity err_severity =
-                Everest::error::string_to_severity(stmt.getColumn("severity").getText());
-            const Everest::error::State err_state = Everest::error::string_to_state(stmt.getColumn("state").getText());
-            const Everest::error::ErrorHandle err_handle(Everest::error::ErrorHandle(stmt.getColumn("uuid").getText()));
-            const Everest::error::ErrorSubType err_sub_type(stmt.getColumn("sub_type").getText());
-            const std::string err_vendor_id = stmt.getColumn("vendor_id").getText();
+                Everest::error::string_to_severity(stmt.getColumn(7).getText());
+            const Everest::error::State err_state = Everest::error::string_to_state(stmt.getColumn(8).getText());
+            const Everest::error::ErrorHandle err_handle(Everest::error::ErrorHandle(stmt.getColumn(0).getText()));
+            const Everest::error::ErrorSubType err_sub_type(stmt.getColumn(9).getText());
+            const std::string err_vendor_id = stmt.getColumn(10).getText();
             Everest::error::ErrorPtr error = std::make_shared<Everest::error::Error>(
                 err_type, err_sub_type, err_msg, err_description, err_origin, err_vendor_id, err_severity,
                 err_timestamp, err_handle, err_state);
             result.push_back(error);
         }
+        stmt.reset();
     } catch (std::exception& e) {
         EVLOG_error << "Error getting errors from database: " << e.what();
         throw;
@@ -247,10 +388,19 @@ std::list<Everest::error::ErrorPtr> ErrorDatabaseSqlite::get_errors(const std::o
 std::list<Everest::error::ErrorPtr>
 ErrorDatabaseSqlite::edit_errors(const std::list<Everest::error::ErrorFilter>& filters, EditErrorFunc edit_func) {
     std::lock_guard<std::mutex> lock(this->db_mutex);
-    std::list<Everest::error::ErrorPtr> result = this->remove_errors_without_mutex(filters);
-    for (Everest::error::ErrorPtr& error : result) {
-        edit_func(error);
-        this->add_error_without_mutex(error);
+    this->flush_without_mutex();
+    std::list<Everest::error::ErrorPtr> result;
+    try {
+        SQLite::Transaction transaction(*this->db);
+        result = this->remove_errors_without_mutex(filters);
+        for (Everest::error::ErrorPtr& error : result) {
+            edit_func(error);
+            this->insert_error(error);
+        }
+        transaction.commit();
+    } catch (std::exception& e) {
+        EVLOG_error << "Error editing errors in database: " << e.what();
+        throw;
     }
     return result;
 }
@@ -258,21 +408,23 @@ ErrorDatabaseSqlite::edit_errors(const std::list<Everest::error::ErrorFilter>& f
 std::list<Everest::error::ErrorPtr>
 ErrorDatabaseSqlite::remove_errors(const std::list<Everest::error::ErrorFilter>& filters) {
     std::lock_guard<std::mutex> lock(this->db_mutex);
+    this->flush_without_mutex();
     return this->remove_errors_without_mutex(filters);
 }
 
 std::list<Everest::error::ErrorPtr>
 ErrorDatabaseSqlite::remove_errors_without_mutex(const std::list<Everest::error::ErrorFilter>& filters) {
     BOOST_LOG_FUNCTION();
-    std::optional<std::string> condition = ErrorDatabaseSqlite::filters_to_sql_condition(filters);
+    std::optional<SqlCondition> condition = ErrorDatabaseSqlite::filters_to_sql_condition(filters);
     std::list<Everest::error::ErrorPtr> result = this->get_errors(condition);
     try {
-        SQLite::Database db(this->db_path.string(), SQLite::OPEN_READWRITE);
         std::string sql = "DELETE FROM errors";
         if (condition.has_value()) {
-            sql += " WHERE " + condition.value();
+            sql += " WHERE " + condition->sql;
         }
-        db.exec(sql);
+        SQLite::Statement& stmt = this->get_statement(sql);
+        ErrorDatabaseSqlite::bind_values(stmt, condition);
+        stmt.exec();
     } catch (std::exception& e) {
         EVLOG_error << "Error removing errors from database: " << e.what();
         throw;
@@ -6,15 +6,34 @@
 
 #include <utils/error/error_database.hpp>
 
+#include <chrono>
+#include <condition_variable>
 #include <filesystem>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
 
 namespace fs = std::filesystem;
 
+namespace SQLite {
+class Database;
+class Statement;
+} // namespace SQLite
+
 namespace module {
 
+///
+/// \brief Error database backed by a SQLite database in WAL mode
+/// The database connection and the prepared statements are kept open for the lifetime of the object.
+/// If a flush interval is given, added errors are collected and written in one transaction at most one flush
+/// interval later. Pending errors are always written before the database is queried or modified otherwise.
+///
 class ErrorDatabaseSqlite : public Everest::error::ErrorDatabase {
 public:
-    explicit ErrorDatabaseSqlite(const fs::path& db_path_, const bool reset_ = false);
+    explicit ErrorDatabaseSqlite(const fs::path& db_path_, const bool reset_ = false,
+                                 const std::chrono::milliseconds flush_interval_ = std::chrono::milliseconds(0));
+    ~ErrorDatabaseSqlite();
 
     std::list<Everest::error::ErrorPtr>
     get_errors(const std::list<Everest::error::ErrorFilter>& filters) const override;
@@ -24,18 +43,49 @@ public:
                                                     EditErrorFunc edit_func) override;
     std::list<Everest::error::ErrorPtr> remove_errors(const std::list<Everest::error::ErrorFilter>& filters) override;
 
+    ///
+    /// \brief writes all pending errors to the database
+    /// Errors that cannot be written are logged and dropped, this never throws.
+    ///
+    void flush();
+
 private:
+    ///
+    /// \brief SQL condition with ?NNN parameters and the values to bind to them
+    ///
+    struct SqlCondition {
+        std::string sql;
+        std::vector<std::string> values;
+    };
+
     void add_error_without_mutex(Everest::error::ErrorPtr error);
+    void insert_error(const Everest::error::ErrorPtr& error) const;
+    void flush_without_mutex() const;
+    void flush_thread();
     std::list<Everest::error::ErrorPtr>
     remove_errors_without_mutex(const std::list<Everest::error::ErrorFilter>& filters);
-    std::list<Everest::error::ErrorPtr> get_errors(const std::optional<std::string>& condition) const;
-    static std::string filter_to_sql_condition(const Everest::error::ErrorFilter& filter);
-    static std::optional<std::string> filters_to_sql_condition(const std::list<Everest::error::ErrorFilter>& filters);
+    std::list<Everest::error::ErrorPtr> get_errors(const std::optional<SqlCondition>& condition) const;
+    SQLite::Statement& get_statement(const std::string& sql) const;
+    static void bind_values(SQLite::Statement& stmt, const std::optional<SqlCondition>& condition);
+    static std::string filter_to_sql_condition(const Everest::error::ErrorFilter& filter,
+                                               std::vector<std::string>& values);
+    static std::optional<SqlCondition> filters_to_sql_condition(const std::list<Everest::error::ErrorFilter>& filters);
 
     void reset_database();
     void check_database();
+    void open_database();
     const fs::path db_path;
+    const std::chrono::milliseconds flush_interval;
     mutable std::mutex db_mutex;
+
+    std::unique_ptr<SQLite::Database> db;
+    // prepared statements by their SQL text
+    mutable std::map<std::string, std::unique_ptr<SQLite::Statement>> statements;
+
+    mutable std::vector<Everest::error::ErrorPtr> pending_errors;
+    std::condition_variable flush_cv;
+    bool stop_flush_thread{false};
+    std::thread flush_thread_handle;
 };
 
 } // namespace module
@@ -12,7 +12,8 @@ namespace module {
 namespace error_history {
 
 void error_historyImpl::init() {
-    this->db = std::make_shared<ErrorDatabaseSqlite>(this->config.database_path);
+    this->db = std::make_shared<ErrorDatabaseSqlite>(this->config.database_path, false,
+                                                     std::chrono::milliseconds(this->config.flush_interval_ms));
 
     Everest::error::StateFilter state_filter(Everest::error::State::Active);
     Everest::error::ErrorFilter error_filter(state_filter);
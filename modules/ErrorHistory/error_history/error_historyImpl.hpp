@@ -21,6 +21,7 @@ namespace error_history {
 
 struct Conf {
     std::string database_path;
+    int flush_interval_ms;
 };
 
 class error_historyImpl : public error_historyImplBase {
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+// Measures insert and query throughput of ErrorDatabaseSqlite for growing databases.
+// Errors are inserted one by one (every error is committed immediately) and with a flush interval (errors are written
+// in batches), afterwards the filters used by the error_history interface are queried.
+
+#include "../ErrorDatabaseSqlite.hpp"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+constexpr int c_queries = 20;
+
+Everest::error::ErrorPtr create_error(int i) {
+    const Everest::error::Severity severities[] = {Everest::error::Severity::Low, Everest::error::Severity::Medium,
+                                                   Everest::error::Severity::High};
+    const std::string module = fmt::format("module_{}", i % 10);
+    return std::make_shared<Everest::error::Error>(
+        fmt::format("type_{}", i % 50), "sub_type", "message", "description",
+        ImplementationIdentifier(module, "implementation"), "everest-benchmark",
+        severities[i % 3], date::utc_clock::now(), Everest::error::UUID(),
+        (i % 100 == 0) ? Everest::error::State::Active : Everest::error::State::ClearedByModule);
+}
+
+double insert_benchmark(const fs::path& db_path, int number_of_errors, std::chrono::milliseconds flush_interval) {
+    module::ErrorDatabaseSqlite db(db_path, true, flush_interval);
+    const auto t = std::chrono::steady_clock::now();
+    for (int i = 0; i < number_of_errors; i++) {
+        db.add_error(create_error(i));
+    }
+    db.flush();
+    const std::chrono::duration<double> d = std::chrono::steady_clock::now() - t;
+    return number_of_errors / d.count();
+}
+
+double query_benchmark(const fs::path& db_path, const std::list<Everest::error::ErrorFilter>& filters) {
+    module::ErrorDatabaseSqlite db(db_path);
+    const auto t = std::chrono::steady_clock::now();
+    for (int i = 0; i < c_queries; i++) {
+        db.get_errors(filters);
+    }
+    const std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - t;
+    return d.count() / c_queries;
+}
+
+void error_database_benchmark(int number_of_errors) {
+    const fs::path db_path =
+        fs::temp_directory_path() / fmt::format("error_database_benchmark_{}.db", number_of_errors);
+
+    const auto immediate = insert_benchmark(db_path, number_of_errors, std::chrono::milliseconds(0));
+    const auto batched = insert_benchmark(db_path, number_of_errors, std::chrono::milliseconds(100));
+
+    const auto state = query_benchmark(db_path, {Everest::error::ErrorFilter(Everest::error::StateFilter::Active)});
+    const auto origin = query_benchmark(
+        db_path, {Everest::error::ErrorFilter(Everest::error::OriginFilter("module_3", "implementation"))});
+    const auto type =
+        query_benchmark(db_path, {Everest::error::ErrorFilter(Everest::error::TypeFilter("type_7")),
+                                  Everest::error::ErrorFilter(Everest::error::SeverityFilter::HIGH_GE)});
+
+    std::cout << fmt::format("{:>8} errors: insert immediate {:>9.0f}/s batched {:>9.0f}/s | query state "
+                             "{:>8.3f}ms origin {:>8.3f}ms type+severity {:>8.3f}ms\n",
+                             number_of_errors, immediate, batched, state, origin, type);
+
+    fs::remove(db_path);
+    fs::remove(db_path.string() + "-wal");
+    fs::remove(db_path.string() + "-shm");
+}
+
+} // namespace
+
+int main() {
+    for (int number_of_errors : {10000, 100000, 1000000}) {
+        error_database_benchmark(number_of_errors);
+    }
+    return 0;
+}
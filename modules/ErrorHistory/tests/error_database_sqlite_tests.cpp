@@ -286,3 +286,77 @@ SCENARIO("Check ErrorDatabaseSqlite class", "[!throws]") {
         }
     }
 }
+
+SCENARIO("Check ErrorDatabaseSqlite class with flush interval", "[!throws]") {
+    GIVEN("An ErrorDatabaseSqlite object with a long flush interval") {
+        const std::string bin_dir = get_bin_dir().string() + "/";
+        const std::string db_name = get_unique_db_name();
+        TestDatabase db(bin_dir + "/databases/" + db_name, true, std::chrono::hours(1));
+        std::vector<Everest::error::ErrorPtr> test_errors = get_test_errors();
+        for (Everest::error::ErrorPtr error : test_errors) {
+            db.add_error(error);
+        }
+        WHEN("Getting all errors before the flush interval expired") {
+            auto errors = db.get_errors(std::list<Everest::error::ErrorFilter>());
+            THEN("The result should contain all 12 errors") {
+                check_expected_errors_in_list(test_errors, errors);
+            }
+        }
+        WHEN("Editing an error before the flush interval expired") {
+            std::list<Everest::error::ErrorFilter> filters = {
+                Everest::error::ErrorFilter(Everest::error::HandleFilter(test_errors[4]->uuid))};
+            auto edited = db.edit_errors(
+                filters, [](Everest::error::ErrorPtr error) { error->state = Everest::error::State::ClearedByModule; });
+            THEN("The pending error should be edited") {
+                REQUIRE(edited.size() == 1);
+                auto errors = db.get_errors(filters);
+                REQUIRE(errors.size() == 1);
+                REQUIRE(errors.front()->state == Everest::error::State::ClearedByModule);
+            }
+        }
+        WHEN("Adding an error that cannot be written before the flush interval expired") {
+            // same uuid as a pending error, the batch insert violates the primary key
+            db.add_error(test_errors[0]);
+            THEN("Only the bad error should be dropped and reading should not fail") {
+                std::list<Everest::error::ErrorPtr> errors;
+                REQUIRE_NOTHROW(errors = db.get_errors(std::list<Everest::error::ErrorFilter>()));
+                check_expected_errors_in_list(test_errors, errors);
+            }
+        }
+        WHEN("Reopening the database before the flush interval expired") {
+            db.reopen();
+            THEN("All errors should have been written") {
+                auto errors = db.get_errors(std::list<Everest::error::ErrorFilter>());
+                check_expected_errors_in_list(test_errors, errors);
+            }
+        }
+        WHEN("Adding an error after the pending errors have been flushed") {
+            db.flush();
+            std::vector<Everest::error::ErrorPtr> new_errors = {std::make_shared<Everest::error::Error>(
+                "test_type", "test_sub_type", "test_message", "test_description",
+                ImplementationIdentifier("test_origin_module", "test_origin_implementation"), "everest-test",
+                Everest::error::Severity::Low, date::utc_clock::now(), Everest::error::UUID(),
+                Everest::error::State::Active)};
+            db.add_error(new_errors.at(0));
+            THEN("The database should contain all errors") {
+                new_errors.insert(new_errors.end(), test_errors.begin(), test_errors.end());
+                check_expected_errors_in_list(new_errors, db.get_errors(std::list<Everest::error::ErrorFilter>()));
+            }
+        }
+    }
+    GIVEN("An ErrorDatabaseSqlite object with a short flush interval") {
+        const std::string bin_dir = get_bin_dir().string() + "/";
+        const std::string db_name = get_unique_db_name();
+        TestDatabase db(bin_dir + "/databases/" + db_name, true, std::chrono::milliseconds(10));
+        std::vector<Everest::error::ErrorPtr> test_errors = get_test_errors();
+        for (Everest::error::ErrorPtr error : test_errors) {
+            db.add_error(error);
+        }
+        WHEN("Waiting for the flush interval to expire") {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            THEN("The errors should be in the database") {
+                check_expected_errors_in_list(test_errors, db.get_errors(std::list<Everest::error::ErrorFilter>()));
+            }
+        }
+    }
+}
@@ -107,12 +107,16 @@ void check_expected_errors_in_list(const std::vector<Everest::error::ErrorPtr>&
     }
 }
 
-TestDatabase::TestDatabase(const fs::path& db_path_, const bool reset_) :
-    db_path(db_path_), db(std::make_unique<module::ErrorDatabaseSqlite>(db_path_, reset_)) {
+TestDatabase::TestDatabase(const fs::path& db_path_, const bool reset_,
+                           const std::chrono::milliseconds flush_interval_) :
+    db_path(db_path_), db(std::make_unique<module::ErrorDatabaseSqlite>(db_path_, reset_, flush_interval_)) {
 }
 
 TestDatabase::~TestDatabase() {
+    db.reset();
     fs::remove(db_path);
+    fs::remove(db_path.string() + "-wal");
+    fs::remove(db_path.string() + "-shm");
 }
 
 void TestDatabase::add_error(Everest::error::ErrorPtr error) {
@@ -132,3 +136,12 @@ std::list<Everest::error::ErrorPtr> TestDatabase::edit_errors(const std::list<Ev
 std::list<Everest::error::ErrorPtr> TestDatabase::remove_errors(const std::list<Everest::error::ErrorFilter>& filters) {
     return db->remove_errors(filters);
 }
+
+void TestDatabase::flush() {
+    db->flush();
+}
+
+void TestDatabase::reopen(const std::chrono::milliseconds flush_interval_) {
+    db.reset();
+    db = std::make_unique<module::ErrorDatabaseSqlite>(db_path, false, flush_interval_);
+}
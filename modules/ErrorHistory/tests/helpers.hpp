@@ -40,17 +40,23 @@ void check_expected_errors_in_list(const std::vector<Everest::error::ErrorPtr>&
 /// \brief wrapper class for the ErrorDatabaseSqlite class
 /// This class is used to test the ErrorDatabaseSqlite class
 /// It proxies the ErrorDatabaseSqlite class, but
-/// the destructor deletes the database file
+/// the destructor deletes the database files
 ///
 class TestDatabase {
 public:
-    explicit TestDatabase(const fs::path& db_path_, const bool reset_ = false);
+    explicit TestDatabase(const fs::path& db_path_, const bool reset_ = false,
+                          const std::chrono::milliseconds flush_interval_ = std::chrono::milliseconds(0));
     ~TestDatabase();
     void add_error(Everest::error::ErrorPtr error);
     std::list<Everest::error::ErrorPtr> get_errors(const std::list<Everest::error::ErrorFilter>& filters) const;
     std::list<Everest::error::ErrorPtr> edit_errors(const std::list<Everest::error::ErrorFilter>& filters,
                                                     Everest::error::ErrorDatabase::EditErrorFunc edit_func);
     std::list<Everest::error::ErrorPtr> remove_errors(const std::list<Everest::error::ErrorFilter>& filters);
+    void flush();
+    ///
+    /// \brief closes the database and opens it again, without deleting the database file
+    ///
+    void reopen(const std::chrono::milliseconds flush_interval_ = std::chrono::milliseconds(0));
 
 private:
     std::unique_ptr<module::ErrorDatabaseSqlite> db;
@@ -10,6 +10,7 @@
 
 #include "Charger.hpp"
 #include <generated/types/powermeter.hpp>
+#include <algorithm>
 #include <math.h>
 #include <string.h>
 #include <thread>
@@ -67,26 +68,30 @@ Charger::Charger(const std::unique_ptr<IECStateMachine>& bsp, const std::unique_
     // create thread for processing errors/error clearings
     std::thread error_thread([this]() {
         for (;;) {
-            auto events = this->error_handling_event_queue.wait();
-            if (!events.empty()) {
-                Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_signal_loop);
-                for (auto& event : events) {
-                    switch (event) {
-                    case ErrorHandlingEvents::PreventCharging:
-                        shared_context.error_prevent_charging_flag = true;
-                        break;
-                    case ErrorHandlingEvents::AllErrorsPreventingChargingCleared:
-                        shared_context.error_prevent_charging_flag = false;
-                        break;
-                    case ErrorHandlingEvents::AllErrorCleared:
-                        shared_context.error_prevent_charging_flag = false;
-                        break;
-                    default:
-                        EVLOG_error << "ErrorHandlingEvents invalid value: "
-                                    << static_cast<std::underlying_type_t<ErrorHandlingEvents>>(event);
-                        break;
-                    }
-                }
+            ErrorHandlingEvents event;
+            {
+                std::unique_lock lock(error_handling_event_mutex);
+                error_handling_event_cv.wait(lock, [this]() { return error_handling_event.has_value(); });
+                event = error_handling_event.value();
+                error_handling_event.reset();
+            }
+
+            Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_signal_loop);
+            wakeup_main_loop();
+            switch (event) {
+            case ErrorHandlingEvents::PreventCharging:
+                shared_context.error_prevent_charging_flag = true;
+                break;
+            case ErrorHandlingEvents::AllErrorsPreventingChargingCleared:
+                shared_context.error_prevent_charging_flag = false;
+                break;
+            case ErrorHandlingEvents::AllErrorCleared:
+                shared_context.error_prevent_charging_flag = false;
+                break;
+            default:
+                EVLOG_error << "ErrorHandlingEvents invalid value: "
+                            << static_cast<std::underlying_type_t<ErrorHandlingEvents>>(event);
+                break;
             }
         }
     });
@@ -96,19 +101,27 @@ Charger::Charger(const std::unique_ptr<IECStateMachine>& bsp, const std::unique_
     error_handling->signal_error.connect([this](const bool prevent_charging) {
         if (prevent_charging) {
             // raise external error to signal we cannot charge anymore
-            error_handling_event_queue.push(ErrorHandlingEvents::PreventCharging);
+            push_error_handling_event(ErrorHandlingEvents::PreventCharging);
         } else {
             EVLOG_info << "All errors cleared that prevented charging";
-            error_handling_event_queue.push(ErrorHandlingEvents::AllErrorsPreventingChargingCleared);
+            push_error_handling_event(ErrorHandlingEvents::AllErrorsPreventingChargingCleared);
         }
     });
 
     error_handling->signal_all_errors_cleared.connect([this]() {
         EVLOG_info << "All errors cleared";
-        error_handling_event_queue.push(ErrorHandlingEvents::AllErrorCleared);
+        push_error_handling_event(ErrorHandlingEvents::AllErrorCleared);
     });
 }
 
+void Charger::push_error_handling_event(ErrorHandlingEvents event) {
+    {
+        std::scoped_lock lock(error_handling_event_mutex);
+        error_handling_event = event;
+    }
+    error_handling_event_cv.notify_one();
+}
+
 Charger::~Charger() {
     pwm_F();
 }
@@ -122,12 +135,22 @@ void Charger::main_thread() {
     signal_max_current(get_max_current_internal());
     signal_state(shared_context.current_state);
 
+    auto poll_interval = std::chrono::milliseconds(MAINLOOP_UPDATE_RATE);
+    auto next_latency_report = std::chrono::steady_clock::now() + EVENT_LATENCY_REPORT_INTERVAL;
+
     while (true) {
         if (main_thread_handle.shouldExit()) {
             break;
         }
 
-        std::this_thread::sleep_for(MAINLOOP_UPDATE_RATE);
+        // Sleep until the next poll interval or until an event arrives
+        std::optional<std::chrono::steady_clock::time_point> event_received;
+        {
+            std::unique_lock lock(main_loop_mutex);
+            main_loop_cv.wait_for(lock, poll_interval, [this]() { return main_loop_wakeup; });
+            main_loop_wakeup = false;
+            event_received.swap(main_loop_event_received);
+        }
 
         {
             Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_mainloop);
@@ -136,10 +159,63 @@ void Charger::main_thread() {
             // Run our own state machine update (i.e. run everything that needs
             // to be done on regular intervals independent from events)
             run_state_machine();
+            poll_interval = main_loop_poll_interval();
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (event_received.has_value()) {
+            event_latency.add(now - event_received.value());
+        }
+
+        if (now > next_latency_report) {
+            next_latency_report = now + EVENT_LATENCY_REPORT_INTERVAL;
+            EVLOG_debug << "Charger event latency: " << event_latency.to_string();
         }
     }
 }
 
+void Charger::wakeup_main_loop() {
+    {
+        std::scoped_lock lock(main_loop_mutex);
+        main_loop_wakeup = true;
+        if (not main_loop_event_received.has_value()) {
+            main_loop_event_received = std::chrono::steady_clock::now();
+        }
+    }
+    main_loop_cv.notify_one();
+}
+
+// States that have timers or need to poll the BSP are run at MAINLOOP_UPDATE_RATE, all others only change on events
+// and are polled less often. The expiry of the power budget and the AC with SoC timeout are no events, so the main
+// loop wakes up when they expire.
+std::chrono::milliseconds Charger::main_loop_poll_interval() {
+    auto poll_interval = MAINLOOP_UPDATE_RATE;
+
+    switch (shared_context.current_state) {
+    case EvseState::Disabled:
+    case EvseState::Idle:
+    case EvseState::Replug:
+    case EvseState::ChargingPausedEVSE:
+    case EvseState::WaitingForEnergy:
+        poll_interval = MAINLOOP_IDLE_UPDATE_RATE;
+        if (shared_context.max_current > 0.) {
+            const auto valid_for = std::chrono::ceil<std::chrono::milliseconds>(
+                shared_context.max_current_valid_until - date::utc_clock::now());
+            poll_interval = std::clamp(valid_for, std::chrono::milliseconds(1), poll_interval);
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (shared_context.ac_with_soc_timeout) {
+        const auto expires_in = std::chrono::ceil<std::chrono::milliseconds>(shared_context.ac_with_soc_deadline -
+                                                                             std::chrono::steady_clock::now());
+        poll_interval = std::clamp(expires_in, std::chrono::milliseconds(1), poll_interval);
+    }
+    return poll_interval;
+}
+
 void Charger::run_state_machine() {
 
     constexpr int max_mainloop_runs = 10;
@@ -165,9 +241,10 @@ void Charger::run_state_machine() {
 
         auto now = std::chrono::system_clock::now();
 
-        if (shared_context.ac_with_soc_timeout and (shared_context.ac_with_soc_timer -= 50) < 0) {
+        if (shared_context.ac_with_soc_timeout and
+            (std::chrono::steady_clock::now() >= shared_context.ac_with_soc_deadline)) {
             shared_context.ac_with_soc_timeout = false;
-            shared_context.ac_with_soc_timer = 3600000;
+            shared_context.ac_with_soc_deadline = std::chrono::steady_clock::now() + AC_WITH_SOC_TIMEOUT;
             signal_ac_with_soc_timeout();
             return;
         }
@@ -201,7 +278,7 @@ void Charger::run_state_machine() {
                 signal_simple_event(types::evse_manager::SessionEventEnum::ReplugStarted);
                 // start timer in case we need to
                 if (shared_context.ac_with_soc_timeout) {
-                    shared_context.ac_with_soc_timer = 120000;
+                    shared_context.ac_with_soc_deadline = std::chrono::steady_clock::now() + AC_WITH_SOC_REPLUG_TIMEOUT;
                 }
             }
             // simply wait here until BSP informs us that replugging was finished
@@ -803,6 +880,8 @@ void Charger::run_state_machine() {
 }
 
 void Charger::process_event(CPEvent cp_event) {
+    const auto event_received = std::chrono::steady_clock::now();
+
     switch (cp_event) {
     case CPEvent::CarPluggedIn:
     case CPEvent::CarRequestedPower:
@@ -837,6 +916,8 @@ void Charger::process_event(CPEvent cp_event) {
     process_cp_events_state(cp_event);
 
     run_state_machine();
+
+    event_latency.add(std::chrono::steady_clock::now() - event_received);
 }
 
 void Charger::process_cp_events_state(CPEvent cp_event) {
@@ -1046,6 +1127,7 @@ bool Charger::set_max_current(float c, std::chrono::time_point<date::utc_clock>
             {
                 Everest::scoped_lock_timeout lock(state_machine_mutex,
                                                   Everest::MutexDescription::Charger_pause_charging);
+                wakeup_main_loop();
                 shared_context.max_current = c;
                 shared_context.max_current_valid_until = validUntil;
             }
@@ -1060,6 +1142,7 @@ bool Charger::set_max_current(float c, std::chrono::time_point<date::utc_clock>
 // pause if currently charging, else do nothing.
 bool Charger::pause_charging() {
     Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_pause_charging);
+    wakeup_main_loop();
     if (shared_context.current_state == EvseState::Charging) {
         shared_context.legacy_wakeup_done = false;
         shared_context.current_state = EvseState::ChargingPausedEVSE;
@@ -1070,6 +1153,7 @@ bool Charger::pause_charging() {
 
 bool Charger::resume_charging() {
     Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_resume_charging);
+    wakeup_main_loop();
 
     if (shared_context.hlc_charging_active and shared_context.transaction_active and
         shared_context.current_state == EvseState::ChargingPausedEVSE) {
@@ -1088,6 +1172,7 @@ bool Charger::resume_charging() {
 // pause charging since no power is available at the moment
 bool Charger::pause_charging_wait_for_power() {
     Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_waiting_for_power);
+    wakeup_main_loop();
     return pause_charging_wait_for_power_internal();
 }
 
@@ -1104,6 +1189,7 @@ bool Charger::pause_charging_wait_for_power_internal() {
 // resume charging since power became available. Does not resume if user paused charging.
 bool Charger::resume_charging_power_available() {
     Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_resume_power_available);
+    wakeup_main_loop();
 
     if (shared_context.transaction_active and shared_context.current_state == EvseState::WaitingForEnergy and
         power_available()) {
@@ -1127,6 +1213,7 @@ bool Charger::evse_replug() {
 // Cancel transaction/charging from external EvseManager interface (e.g. via OCPP)
 bool Charger::cancel_transaction(const types::evse_manager::StopTransactionRequest& request) {
     Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_cancel_transaction);
+    wakeup_main_loop();
 
     if (shared_context.transaction_active) {
         if (shared_context.hlc_charging_active) {
@@ -1296,6 +1383,7 @@ std::optional<types::units_signed::SignedMeterValue> Charger::get_start_signed_m
 }
 
 bool Charger::switch_three_phases_while_charging(bool n) {
+    wakeup_main_loop();
     if (shared_context.hlc_charging_active) {
         return false;
     }
@@ -1336,7 +1424,7 @@ void Charger::setup(bool has_ventilation, const ChargeMode _charge_mode, bool _a
     config_context.ac_enforce_hlc = _ac_enforce_hlc;
     config_context.soft_over_current_timeout_ms = _soft_over_current_timeout_ms;
     shared_context.ac_with_soc_timeout = _ac_with_soc_timeout;
-    shared_context.ac_with_soc_timer = 3600000;
+    shared_context.ac_with_soc_deadline = std::chrono::steady_clock::now() + AC_WITH_SOC_TIMEOUT;
     soft_over_current_tolerance_percent = _soft_over_current_tolerance_percent;
     soft_over_current_measurement_noise_A = _soft_over_current_measurement_noise_A;
 
@@ -1394,6 +1482,7 @@ std::string Charger::get_session_id() const {
 
 void Charger::authorize(bool a, const types::authorization::ProvidedIdToken& token) {
     Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_authorize);
+    wakeup_main_loop();
     if (a) {
         shared_context.id_token = token;
         // First user interaction was auth? Then start session already here and not at plug in
@@ -1414,6 +1503,7 @@ void Charger::authorize(bool a, const types::authorization::ProvidedIdToken& tok
 
 bool Charger::deauthorize() {
     Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_deauthorize);
+    wakeup_main_loop();
     return deauthorize_internal();
 }
 
@@ -1439,6 +1529,7 @@ bool Charger::deauthorize_internal() {
 
 bool Charger::enable_disable(int connector_id, const types::evse_manager::EnableDisableSource& source) {
     Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_disable);
+    wakeup_main_loop();
 
     // insert the new request into the table
     bool replaced = false;
@@ -1566,6 +1657,7 @@ bool Charger::parse_enable_disable_source_table() {
 
 void Charger::set_faulted() {
     Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_set_faulted);
+    wakeup_main_loop();
     shared_context.error_prevent_charging_flag = true;
 }
 
@@ -1704,6 +1796,7 @@ bool Charger::power_available() {
 
 void Charger::request_error_sequence() {
     Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_request_error_sequence);
+    wakeup_main_loop();
     if (shared_context.current_state == EvseState::WaitingForAuthentication or
         shared_context.current_state == EvseState::PrepareCharging) {
         internal_context.t_step_EF_return_state = shared_context.current_state;
@@ -1720,12 +1813,14 @@ void Charger::request_error_sequence() {
 
 void Charger::set_matching_started(bool m) {
     Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_set_matching_started);
+    wakeup_main_loop();
     shared_context.matching_started = m;
 }
 
 void Charger::notify_currentdemand_started() {
     Everest::scoped_lock_timeout lock(state_machine_mutex,
                                       Everest::MutexDescription::Charger_notify_currentdemand_started);
+    wakeup_main_loop();
     if (shared_context.current_state == EvseState::PrepareCharging) {
         signal_simple_event(types::evse_manager::SessionEventEnum::ChargingStarted);
         shared_context.current_state = EvseState::Charging;
@@ -1736,6 +1831,7 @@ void Charger::inform_new_evse_max_hlc_limits(
     const types::iso15118_charger::DcEvseMaximumLimits& _currentEvseMaxLimits) {
     Everest::scoped_lock_timeout lock(state_machine_mutex,
                                       Everest::MutexDescription::Charger_inform_new_evse_max_hlc_limits);
+    wakeup_main_loop();
     shared_context.current_evse_max_limits = _currentEvseMaxLimits;
 }
 
@@ -1747,6 +1843,7 @@ types::iso15118_charger::DcEvseMaximumLimits Charger::get_evse_max_hlc_limits()
 // HLC stack signalled a pause request for the lower layers.
 void Charger::dlink_pause() {
     Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_dlink_pause);
+    wakeup_main_loop();
     shared_context.hlc_allow_close_contactor = false;
     pwm_off();
     shared_context.hlc_charging_terminate_pause = HlcTerminatePause::Pause;
@@ -1755,6 +1852,7 @@ void Charger::dlink_pause() {
 // HLC requested end of charging session, so we can stop the 5% PWM
 void Charger::dlink_terminate() {
     Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_dlink_terminate);
+    wakeup_main_loop();
     shared_context.hlc_allow_close_contactor = false;
     pwm_off();
     shared_context.hlc_charging_terminate_pause = HlcTerminatePause::Terminate;
@@ -1762,6 +1860,7 @@ void Charger::dlink_terminate() {
 
 void Charger::dlink_error() {
     Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_dlink_error);
+    wakeup_main_loop();
 
     shared_context.hlc_allow_close_contactor = false;
 
@@ -1810,17 +1909,20 @@ void Charger::dlink_error() {
 
 void Charger::set_hlc_charging_active() {
     Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_set_hlc_charging_active);
+    wakeup_main_loop();
     shared_context.hlc_charging_active = true;
 }
 
 void Charger::set_hlc_allow_close_contactor(bool on) {
     Everest::scoped_lock_timeout lock(state_machine_mutex,
                                       Everest::MutexDescription::Charger_set_hlc_allow_close_contactor);
+    wakeup_main_loop();
     shared_context.hlc_allow_close_contactor = on;
 }
 
 void Charger::set_hlc_error() {
     Everest::scoped_lock_timeout lock(state_machine_mutex, Everest::MutexDescription::Charger_set_hlc_error);
+    wakeup_main_loop();
     shared_context.error_prevent_charging_flag = true;
 }
 
@@ -27,6 +27,7 @@
 #include "ld-ev.hpp"
 #include "utils/thread.hpp"
 #include <chrono>
+#include <condition_variable>
 #include <date/date.h>
 #include <date/tz.h>
 #include <generated/interfaces/ISO15118_charger/Interface.hpp>
@@ -43,8 +44,8 @@
 #include <vector>
 
 #include "ErrorHandling.hpp"
-#include "EventQueue.hpp"
 #include "IECStateMachine.hpp"
+#include "LatencyHistogram.hpp"
 #include "PersistentStore.hpp"
 #include "scoped_lock_timeout.hpp"
 #include "utils.hpp"
@@ -220,6 +221,12 @@ public:
 
     void cleanup_transactions_on_startup();
 
+    /// @brief Returns the histogram of the latencies from an incoming event (CP event or external request) until the
+    /// state machine has processed it.
+    const LatencyHistogram& get_event_latency_histogram() const {
+        return event_latency;
+    }
+
 private:
     utils::Stopwatch stopwatch;
 
@@ -251,6 +258,9 @@ private:
     void run_state_machine();
 
     void main_thread();
+    // wake up the main loop immediately instead of waiting for the next poll interval
+    void wakeup_main_loop();
+    std::chrono::milliseconds main_loop_poll_interval();
 
     void graceful_stop_charging();
 
@@ -299,7 +309,7 @@ private:
         float current_drawn_by_vehicle[3];
         bool error_prevent_charging_flag{false};
         bool last_error_prevent_charging_flag{false};
-        int ac_with_soc_timer;
+        std::chrono::steady_clock::time_point ac_with_soc_deadline;
         // non standard compliant option: time out after a while and switch back to DC to get SoC update
         bool ac_with_soc_timeout;
         bool contactor_welded{false};
@@ -375,6 +385,12 @@ private:
 
     // main Charger thread
     Everest::Thread main_thread_handle;
+    std::mutex main_loop_mutex;
+    std::condition_variable main_loop_cv;
+    bool main_loop_wakeup{false};
+    // arrival time of the oldest event that has not been processed by the main loop yet
+    std::optional<std::chrono::steady_clock::time_point> main_loop_event_received;
+    LatencyHistogram event_latency;
 
     const std::unique_ptr<IECStateMachine>& bsp;
     const std::unique_ptr<ErrorHandling>& error_handling;
@@ -391,7 +407,12 @@ private:
         AllErrorCleared
     };
 
-    EventQueue<ErrorHandlingEvents> error_handling_event_queue;
+    // All events set the flag that prevents charging, so only the latest one matters. It is kept instead of being
+    // queued, a burst of errors must not drop it like the bounded EventQueue would.
+    std::mutex error_handling_event_mutex;
+    std::condition_variable error_handling_event_cv;
+    std::optional<ErrorHandlingEvents> error_handling_event;
+    void push_error_handling_event(ErrorHandlingEvents event);
 
     // constants
     static constexpr float CHARGER_ABSOLUTE_MAX_CURRENT{1000.};
@@ -406,7 +427,14 @@ private:
     static constexpr auto TT_EVSE_VALD_TOGGLE =
         std::chrono::milliseconds(3500 + 200); // We give 200 msecs tolerance to the norm values (table 3 ISO15118-3)
     static constexpr auto SLEEP_BEFORE_ENABLING_PWM_HLC_MODE = std::chrono::seconds(1);
+    // Poll interval of the main loop in states with timers. Events always wake up the main loop immediately.
     static constexpr auto MAINLOOP_UPDATE_RATE = std::chrono::milliseconds(100);
+    // Poll interval of the main loop in states that only change on events
+    static constexpr auto MAINLOOP_IDLE_UPDATE_RATE = std::chrono::milliseconds(1000);
+    static constexpr auto EVENT_LATENCY_REPORT_INTERVAL = std::chrono::minutes(10);
+    // switch back to DC for an SoC update after charging with AC for this long, or after a replug that takes this long
+    static constexpr auto AC_WITH_SOC_TIMEOUT = std::chrono::hours(1);
+    static constexpr auto AC_WITH_SOC_REPLUG_TIMEOUT = std::chrono::minutes(2);
     static constexpr float PWM_5_PERCENT = 0.05;
     static constexpr int T_REPLUG_MS = 4000;
     // 3 seconds according to IEC61851-1
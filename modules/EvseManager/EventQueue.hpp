@@ -3,46 +3,196 @@
 #ifndef EVENTQUEUE_HPP
 #define EVENTQUEUE_HPP
 
+#include <array>
+#include <atomic>
 #include <condition_variable>
 #include <cstdint>
 #include <mutex>
+#include <thread>
+#include <utility>
 #include <vector>
 
 namespace module {
 
-template <typename E> class EventQueue {
+/*
+ Bounded lock free event queue for multiple producers.
+ Events are stored in a ring buffer of fixed capacity (bounded MPMC queue with per cell sequence numbers), so push()
+ never allocates and never blocks. If the queue is full, the event is dropped and push() returns false, so it must
+ only be used for events that may be lost.
+ The consumer drains the queue in batches into a caller provided vector. The mutex and condition variable are only
+ used to put a waiting consumer to sleep; only the first producer after the consumer went to sleep touches them.
+*/
+template <typename E, std::size_t capacity = 64> class EventQueue {
+    static_assert(capacity >= 2 and (capacity & (capacity - 1)) == 0, "EventQueue capacity must be a power of two");
+
 public:
     using events_t = std::vector<E>;
 
-private:
-    events_t pending;
-    std::mutex mux;
-    std::condition_variable cv;
+    EventQueue() {
+        for (std::size_t i = 0; i < capacity; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
 
-public:
-    void push(const E& event) {
-        {
-            std::lock_guard<std::mutex> lock(mux);
-            pending.push_back(event);
+    EventQueue(const EventQueue&) = delete;
+    EventQueue& operator=(const EventQueue&) = delete;
+
+    // Returns false if the queue was full and the event has been dropped
+    bool push(const E& event) {
+        return emplace(event);
+    }
+
+    // Moves the event into the queue, returns false if the queue was full and the event has been dropped
+    bool push(E&& event) {
+        return emplace(std::move(event));
+    }
+
+    // Moves up to max_events pending events into events (which is cleared first) and returns the number of events.
+    // Does not allocate once events has reached the capacity of the queue.
+    std::size_t get_events(events_t& events, std::size_t max_events = capacity) {
+        events.clear();
+        if (events.capacity() < capacity) {
+            events.reserve(capacity);
         }
-        cv.notify_all();
+
+        E event;
+        while (events.size() < max_events and pop(event)) {
+            events.push_back(std::move(event));
+        }
+        return events.size();
     }
 
     events_t get_events() {
-        std::lock_guard<std::mutex> lock(mux);
         events_t active;
-        pending.swap(active);
+        get_events(active);
         return active;
     }
 
+    // Blocks until at least one event is pending and moves up to max_events events into events
+    std::size_t wait(events_t& events, std::size_t max_events = capacity) {
+        while (get_events(events, max_events) == 0) {
+            if (enqueue_pos.load(std::memory_order_relaxed) != dequeue_pos.load(std::memory_order_relaxed)) {
+                // a producer has reserved a cell but not yet published the event, it will be there soon
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> ul(mux);
+            cv.wait(ul, [this]() {
+                // (re-)announce that we are going to sleep before checking, also after spurious wake ups
+                consumer_sleeping.store(true, std::memory_order_seq_cst);
+                return not empty();
+            });
+            consumer_sleeping.store(false, std::memory_order_relaxed);
+        }
+        return events.size();
+    }
+
     events_t wait() {
-        std::unique_lock<std::mutex> ul(mux);
-        cv.wait(ul, [this]() { return !pending.empty(); });
         events_t active;
-        pending.swap(active);
-        ul.unlock();
+        wait(active);
         return active;
     }
+
+    bool empty() const {
+        const auto pos = dequeue_pos.load(std::memory_order_relaxed);
+        return cells[pos & mask].sequence.load(std::memory_order_seq_cst) != pos + 1;
+    }
+
+    // number of events dropped because the queue was full
+    std::uint64_t dropped() const {
+        return dropped_events.load(std::memory_order_relaxed);
+    }
+
+    // maximum number of pending events seen so far
+    std::size_t high_watermark() const {
+        return max_pending.load(std::memory_order_relaxed);
+    }
+
+private:
+    template <typename T> bool emplace(T&& event) {
+        auto pos = enqueue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            auto& cell = cells[pos & mask];
+            const auto seq = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.event = std::forward<T>(event);
+                    // seq_cst pairs with wait(): either the consumer sees the new event or we see the waiting consumer
+                    cell.sequence.store(pos + 1, std::memory_order_seq_cst);
+                    break;
+                }
+            } else if (diff < 0) {
+                // queue is full
+                dropped_events.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        const auto consumed = dequeue_pos.load(std::memory_order_relaxed);
+        if (pos + 1 > consumed and pos + 1 - consumed > max_pending.load(std::memory_order_relaxed)) {
+            update_high_watermark(pos + 1 - consumed);
+        }
+
+        // only the first producer after the consumer went to sleep needs to wake it up
+        if (consumer_sleeping.load(std::memory_order_seq_cst) and
+            consumer_sleeping.exchange(false, std::memory_order_seq_cst)) {
+            {
+                std::lock_guard<std::mutex> lock(mux);
+            }
+            cv.notify_all();
+        }
+        return true;
+    }
+
+    bool pop(E& event) {
+        auto pos = dequeue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            auto& cell = cells[pos & mask];
+            const auto seq = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    event = std::move(cell.event);
+                    cell.sequence.store(pos + capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // queue is empty
+                return false;
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void update_high_watermark(std::size_t pending) {
+        auto current = max_pending.load(std::memory_order_relaxed);
+        while (pending > current and
+               not max_pending.compare_exchange_weak(current, pending, std::memory_order_relaxed)) {
+        }
+    }
+
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        E event;
+    };
+
+    static constexpr std::size_t mask = capacity - 1;
+
+    std::array<Cell, capacity> cells;
+    alignas(64) std::atomic<std::size_t> enqueue_pos{0};
+    alignas(64) std::atomic<std::size_t> dequeue_pos{0};
+
+    alignas(64) std::atomic_bool consumer_sleeping{false};
+
+    alignas(64) std::atomic<std::uint64_t> dropped_events{0};
+    std::atomic<std::size_t> max_pending{0};
+
+    std::mutex mux;
+    std::condition_variable cv;
 };
 
 } // namespace module
@@ -43,6 +43,11 @@ inline static types::authorization::ProvidedIdToken create_autocharge_token(std:
 
 void EvseManager::init() {
 
+    if (config.lock_profiling_report_interval_s > 0) {
+        EVLOG_info << "Lock contention profiling enabled";
+        Everest::LockProfiler::enable(true);
+    }
+
     store = std::unique_ptr<PersistentStore>(new PersistentStore(r_store, info.id));
 
     random_delay_enabled = config.uk_smartcharging_random_delay_enable;
@@ -57,6 +62,8 @@ void EvseManager::init() {
         std::string hlc_log_topic = "everest_api/" + this->info.id + "/var/hlc_log";
         mqtt.publish(hlc_log_topic, data.dump());
     });
+    session_log.setFormat(config.session_logging_format == "binary" ? SessionLog::Format::Binary
+                                                                    : SessionLog::Format::HtmlCsv);
     if (config.session_logging) {
         session_log.enable();
     }
@@ -946,6 +953,16 @@ void EvseManager::ready() {
         }
     });
 
+    if (config.lock_profiling_report_interval_s > 0) {
+        lockProfilingThreadHandle = std::thread([this]() {
+            const std::string lock_profile_topic = "everest_api/" + this->info.id + "/var/lock_profile";
+            while (not lockProfilingThreadHandle.shouldExit()) {
+                sleep(config.lock_profiling_report_interval_s);
+                mqtt.publish(lock_profile_topic, Everest::LockProfiler::report().dump());
+            }
+        });
+    }
+
     {
         // wait for first powermeter value
         std::unique_lock<std::mutex> lk(powermeter_mutex);
@@ -974,6 +991,11 @@ void EvseManager::ready() {
     }
 }
 
+EvseManager::~EvseManager() {
+    // the session log publishes over the mqtt of this module, stop its writer thread while the module still exists
+    session_log.stop();
+}
+
 void EvseManager::ready_to_start_charging() {
     timepoint_ready_for_charging = std::chrono::steady_clock::now();
     charger->run();
@@ -61,6 +61,7 @@ struct Conf {
     bool session_logging;
     std::string session_logging_path;
     bool session_logging_xml;
+    std::string session_logging_format;
     bool has_ventilation;
     double max_current_import_A;
     double max_current_export_A;
@@ -100,6 +101,7 @@ struct Conf {
     int soft_over_current_timeout_ms;
     bool lock_connector_in_state_b;
     int state_F_after_fault_ms;
+    int lock_profiling_report_interval_s;
 };
 
 class EvseManager : public Everest::ModuleBase {
@@ -156,6 +158,7 @@ public:
 
     // ev@1fce4c5e-0ab8-41bb-90f7-14277703d2ac:v1
     // insert your public definitions here
+    ~EvseManager();
     std::unique_ptr<Charger> charger;
     sigslot::signal<int> signalNrOfPhasesAvailable;
     types::powermeter::Powermeter get_latest_powermeter_data_billing();
@@ -326,6 +329,7 @@ private:
     void imd_stop();
     void imd_start();
     Everest::Thread telemetryThreadHandle;
+    Everest::Thread lockProfilingThreadHandle;
 
     void fail_cable_check();
 
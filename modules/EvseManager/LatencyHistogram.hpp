@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include <fmt/core.h>
+
+namespace module {
+
+/*
+ Lock free histogram of latencies with power of two buckets in microseconds.
+ Bucket 0 counts everything below 64us, bucket i counts [2^(i+5), 2^(i+6)) us and the last bucket counts everything
+ above. Can be written from multiple threads.
+*/
+class LatencyHistogram {
+public:
+    static constexpr std::size_t number_of_buckets = 16;
+
+    void add(std::chrono::nanoseconds latency) {
+        const std::int64_t us =
+            std::max<std::int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+        buckets[bucket_index(static_cast<std::uint64_t>(us))].fetch_add(1, std::memory_order_relaxed);
+        sum_us.fetch_add(us, std::memory_order_relaxed);
+
+        auto current_max = max_us.load(std::memory_order_relaxed);
+        while (us > current_max and
+               not max_us.compare_exchange_weak(current_max, us, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::uint64_t count() const {
+        std::uint64_t c = 0;
+        for (const auto& b : buckets) {
+            c += b.load(std::memory_order_relaxed);
+        }
+        return c;
+    }
+
+    std::uint64_t bucket(std::size_t index) const {
+        return buckets.at(index).load(std::memory_order_relaxed);
+    }
+
+    // upper bound in microseconds of the given bucket
+    static std::uint64_t bucket_upper_bound_us(std::size_t index) {
+        return std::uint64_t{1} << (index + first_bucket_bits);
+    }
+
+    // Returns the upper bound of the bucket containing the given percentile (0..100). This is an approximation
+    // with a maximum error of a factor of two.
+    std::chrono::microseconds percentile(double p) const {
+        const auto total = count();
+        if (total == 0) {
+            return std::chrono::microseconds(0);
+        }
+
+        const auto target = static_cast<std::uint64_t>(total * p / 100.);
+        std::uint64_t c = 0;
+        for (std::size_t i = 0; i < number_of_buckets - 1; i++) {
+            c += bucket(i);
+            if (c > target) {
+                return std::chrono::microseconds(bucket_upper_bound_us(i));
+            }
+        }
+        return max();
+    }
+
+    std::chrono::microseconds max() const {
+        return std::chrono::microseconds(max_us.load(std::memory_order_relaxed));
+    }
+
+    // sum of all recorded latencies
+    std::chrono::microseconds total() const {
+        return std::chrono::microseconds(sum_us.load(std::memory_order_relaxed));
+    }
+
+    // adds all samples of another histogram to this one
+    void merge(const LatencyHistogram& other) {
+        for (std::size_t i = 0; i < number_of_buckets; i++) {
+            buckets[i].fetch_add(other.bucket(i), std::memory_order_relaxed);
+        }
+        sum_us.fetch_add(other.total().count(), std::memory_order_relaxed);
+
+        const auto other_max = other.max().count();
+        auto current_max = max_us.load(std::memory_order_relaxed);
+        while (other_max > current_max and
+               not max_us.compare_exchange_weak(current_max, other_max, std::memory_order_relaxed)) {
+        }
+    }
+
+    void reset() {
+        for (auto& b : buckets) {
+            b.store(0, std::memory_order_relaxed);
+        }
+        max_us.store(0, std::memory_order_relaxed);
+        sum_us.store(0, std::memory_order_relaxed);
+    }
+
+    std::string to_string() const {
+        return fmt::format("n={} p50<={}us p90<={}us p99<={}us max={}us", count(), percentile(50).count(),
+                           percentile(90).count(), percentile(99).count(), max().count());
+    }
+
+private:
+    static constexpr std::size_t first_bucket_bits = 6;
+
+    static std::size_t bucket_index(std::uint64_t us) {
+        std::size_t index = 0;
+        us >>= first_bucket_bits;
+        while (us > 0 and index < number_of_buckets - 1) {
+            us >>= 1;
+            index++;
+        }
+        return index;
+    }
+
+    std::array<std::atomic<std::uint64_t>, number_of_buckets> buckets{};
+    std::atomic<std::int64_t> max_us{0};
+    std::atomic<std::int64_t> sum_us{0};
+};
+
+} // namespace module
+#endif
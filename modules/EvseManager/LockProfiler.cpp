@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include "LockProfiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <vector>
+
+#include "LatencyHistogram.hpp"
+#include "scoped_lock_timeout.hpp"
+
+namespace Everest {
+
+namespace {
+
+struct ThreadHistograms {
+    std::array<module::LatencyHistogram, mutex_description_count> wait;
+    std::array<module::LatencyHistogram, mutex_description_count> hold;
+
+    void merge(const ThreadHistograms& other) {
+        for (std::size_t i = 0; i < mutex_description_count; i++) {
+            wait[i].merge(other.wait[i]);
+            hold[i].merge(other.hold[i]);
+        }
+    }
+
+    void reset() {
+        for (std::size_t i = 0; i < mutex_description_count; i++) {
+            wait[i].reset();
+            hold[i].reset();
+        }
+    }
+};
+
+// Histograms of all running threads. When a thread exits, its samples are merged into retired, so they are still part
+// of the report without keeping one set of histograms per thread that ever existed.
+std::mutex registry_mutex;
+std::vector<ThreadHistograms*> registry;
+ThreadHistograms retired;
+
+struct ThreadRegistration {
+    ThreadHistograms histograms;
+
+    ThreadRegistration() {
+        std::scoped_lock lock(registry_mutex);
+        registry.push_back(&histograms);
+    }
+
+    ~ThreadRegistration() {
+        std::scoped_lock lock(registry_mutex);
+        retired.merge(histograms);
+        registry.erase(std::remove(registry.begin(), registry.end(), &histograms), registry.end());
+    }
+};
+
+ThreadHistograms& thread_histograms() {
+    thread_local ThreadRegistration registration;
+    return registration.histograms;
+}
+
+nlohmann::json histogram_to_json(const module::LatencyHistogram& h) {
+    return {{"total_us", h.total().count()},
+            {"p50_us", h.percentile(50).count()},
+            {"p99_us", h.percentile(99).count()},
+            {"max_us", h.max().count()}};
+}
+
+} // namespace
+
+void LockProfiler::record(MutexDescription description, std::chrono::nanoseconds wait,
+                          std::chrono::nanoseconds hold) {
+    const auto index = static_cast<std::size_t>(description);
+    if (index >= mutex_description_count) {
+        return;
+    }
+
+    auto& h = thread_histograms();
+    h.wait[index].add(wait);
+    h.hold[index].add(hold);
+}
+
+nlohmann::json LockProfiler::report() {
+    ThreadHistograms sum;
+    {
+        std::scoped_lock lock(registry_mutex);
+        sum.merge(retired);
+        for (const auto* h : registry) {
+            sum.merge(*h);
+        }
+    }
+
+    std::vector<std::size_t> used;
+    for (std::size_t i = 0; i < mutex_description_count; i++) {
+        if (sum.wait[i].count() > 0) {
+            used.push_back(i);
+        }
+    }
+
+    std::sort(used.begin(), used.end(),
+              [&sum](std::size_t a, std::size_t b) { return sum.wait[a].total() > sum.wait[b].total(); });
+
+    auto result = nlohmann::json::array();
+    for (const auto i : used) {
+        result.push_back({{"mutex", to_string(static_cast<MutexDescription>(i))},
+                          {"count", sum.wait[i].count()},
+                          {"wait", histogram_to_json(sum.wait[i])},
+                          {"hold", histogram_to_json(sum.hold[i])}});
+    }
+    return result;
+}
+
+void LockProfiler::reset() {
+    std::scoped_lock lock(registry_mutex);
+    retired.reset();
+    for (auto* h : registry) {
+        h->reset();
+    }
+}
+
+std::size_t LockProfiler::active_threads() {
+    std::scoped_lock lock(registry_mutex);
+    return registry.size();
+}
+
+} // namespace Everest
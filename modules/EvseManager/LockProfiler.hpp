@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef EVEREST_LOCK_PROFILER
+#define EVEREST_LOCK_PROFILER
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+#include <nlohmann/json.hpp>
+
+/*
+ Optional lock contention profiler for scoped_lock_timeout.
+ When enabled, every scoped_lock_timeout records the time it waited for the mutex and the time it held it, tagged
+ with its MutexDescription. Samples are written into per thread histograms without any locking, report() sums up the
+ histograms of all threads.
+*/
+namespace Everest {
+
+enum class MutexDescription;
+
+class LockProfiler {
+public:
+    static void enable(bool e) {
+        enabled_flag.store(e, std::memory_order_relaxed);
+    }
+
+    static bool enabled() {
+        return enabled_flag.load(std::memory_order_relaxed);
+    }
+
+    static void record(MutexDescription description, std::chrono::nanoseconds wait, std::chrono::nanoseconds hold);
+
+    // Returns one entry per MutexDescription that was used since the last reset, sorted by total wait time
+    static nlohmann::json report();
+
+    static void reset();
+
+    // Number of threads that currently have their own histograms. The histograms of exited threads are merged.
+    static std::size_t active_threads();
+
+private:
+    static inline std::atomic_bool enabled_flag{false};
+};
+
+} // namespace Everest
+
+#endif
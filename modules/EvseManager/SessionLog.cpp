@@ -2,30 +2,34 @@
 // Copyright 2020 - 2022 Pionix GmbH and Contributors to EVerest
 #include "SessionLog.hpp"
 #include "everest/logging.hpp"
-#include "v2gMessage.hpp"
 #include <chrono>
 #include <date/date.h>
 #include <date/tz.h>
 #include <filesystem>
+#include <nlohmann/json.hpp>
 #include <utils/date.hpp>
+#include <vector>
 
-#include <boost/algorithm/string.hpp>
 #include <fmt/core.h>
 
 namespace module {
 
+using session_log_format::Origin;
+using session_log_format::Record;
+
 SessionLog session_log;
 
 SessionLog::SessionLog() {
     session_active = false;
     enabled = false;
     xmloutput = true;
+    format = Format::HtmlCsv;
 }
 
 SessionLog::~SessionLog() {
-    if (logfile_csv.is_open()) {
-        logfile_csv.close();
-    }
+    // EVLOG and the module owning the mqtt callback may already be destroyed, do not write the queued messages
+    discard = true;
+    stop();
 }
 
 void SessionLog::setPath(const std::string& path) {
@@ -36,7 +40,15 @@ void SessionLog::setMqtt(const std::function<void(nlohmann::json data)>& mqtt_pr
     mqtt = mqtt_provider;
 }
 
+void SessionLog::setFormat(Format f) {
+    format = f;
+}
+
 void SessionLog::enable() {
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    if (not writer.joinable()) {
+        writer = std::thread([this]() { run_writer(); });
+    }
     enabled = true;
 }
 
@@ -57,45 +69,14 @@ std::optional<std::string> SessionLog::startSession(const std::string& suffix_st
         if (!std::filesystem::exists(logpath))
             std::filesystem::create_directories(logpath);
 
-        // open new file
-        fn = fmt::format("{}/incomplete-eventlog.csv", logpath);
-        fnhtml = fmt::format("{}/incomplete-eventlog.html", logpath);
-        fn_complete = fmt::format("{}/eventlog.csv", logpath);
-        fnhtml_complete = fmt::format("{}/eventlog.html", logpath);
+        // the files are opened by the writer thread
+        Entry entry;
+        entry.command = Command::StartSession;
+        entry.logpath = logpath;
+        entry.title = suffix_string;
+        push_command(std::move(entry));
+        session_active = true;
 
-        try {
-            logfile_csv.open(fn);
-            logfile_html.open(fnhtml);
-            session_active = true;
-        } catch (const std::ofstream::failure& e) {
-            EVLOG_error << fmt::format("Cannot open {} of {} for writing", fn, fnhtml);
-            session_active = false;
-        }
-        logfile_html << fmt::format("<html><head><title>EVerest log session {}</title>\n", suffix_string);
-        logfile_html << "<style>"
-                        ".log {"
-                        "  font-family: Arial, Helvetica, sans-serif;"
-                        "  border-collapse: collapse;"
-                        "  width: 100%;"
-                        "}"
-                        ".log td, .log th {"
-                        "  border: 1px solid #ddd;"
-                        "  padding: 8px;"
-                        "  vertical-align: top;"
-                        "}"
-                        ".log tr.CAR{background-color: #E4E6F2;}"
-                        ".log tr.EVSE{background-color: #F2F0E4;}"
-                        ".log tr.SYS{background-color: white;}"
-                        ".log th {"
-                        "  padding-top: 12px;"
-                        "  padding-bottom: 12px;"
-                        "  text-align: left;"
-                        "  vertical-align: top;"
-                        "  background-color: #04AA6D;"
-                        "  color: white;"
-                        "}"
-                        "</style>";
-        logfile_html << "</head><body><table class=\"log\">\n";
         sys("Session logging started.");
         return logpath;
     }
@@ -106,30 +87,11 @@ std::optional<std::string> SessionLog::startSession(const std::string& suffix_st
 void SessionLog::stopSession() {
     if (enabled) {
         sys("Session logging stopped.");
-
-        logfile_html << "</table></body></html>\n";
-
-        if (logfile_csv.is_open()) {
-            logfile_csv.close();
-        }
-        if (logfile_html.is_open()) {
-            logfile_html.close();
-        }
-
-        // rename files to indicate they are finished now
-        try {
-            std::filesystem::rename(fn, fn_complete);
-        } catch (const std::filesystem::filesystem_error& fs_err) {
-            EVLOG_error << "Could not rename " << fn << ": " << fs_err.what();
-        }
-
-        try {
-            std::filesystem::rename(fnhtml, fnhtml_complete);
-        } catch (const std::filesystem::filesystem_error& fs_err) {
-            EVLOG_error << "Could not rename " << fnhtml << ": " << fs_err.what();
-        }
-
         session_active = false;
+
+        Entry entry;
+        entry.command = Command::StopSession;
+        push_command(std::move(entry));
     }
 }
 
@@ -143,70 +105,78 @@ void SessionLog::car(bool iso15118, const std::string& msg) {
 
 void SessionLog::evse(bool iso15118, const std::string& msg, const std::string& xml, const std::string& xml_hex,
                       const std::string& xml_base64, const std::string& json_str) {
-    output(0, iso15118, msg, xml, xml_hex, xml_base64, json_str);
+    output(Origin::EVSE, iso15118, msg, xml, xml_hex, xml_base64, json_str);
 }
 
 void SessionLog::car(bool iso15118, const std::string& msg, const std::string& xml, const std::string& xml_hex,
                      const std::string& xml_base64, const std::string& json_str) {
-    output(1, iso15118, msg, xml, xml_hex, xml_base64, json_str);
+    output(Origin::CAR, iso15118, msg, xml, xml_hex, xml_base64, json_str);
 }
 
-void SessionLog::output(unsigned int typ, bool iso15118, const std::string& msg, const std::string& xml,
+void SessionLog::output(Origin origin, bool iso15118, const std::string& msg, const std::string& xml,
                         const std::string& xml_hex, const std::string& xml_base64, const std::string& json_str) {
     if (enabled && session_active) {
-        std::string ts = Everest::Date::to_rfc3339(date::utc_clock::now());
-
-        std::string xml_pretty;
-        v2g_message v2g;
-        if (!xml.empty()) {
-            v2g.from_xml(xml);
-            xml_pretty = v2g.to_xml();
-        } else if (!json_str.empty()) {
-            v2g.from_json(json_str);
-            xml_pretty = v2g.to_json();
+        const auto size = msg.size() + xml.size() + xml_hex.size() + xml_base64.size() + json_str.size();
+        if (queued_bytes.fetch_add(size) + size > max_queued_bytes) {
+            queued_bytes.fetch_sub(size);
+            dropped_messages++;
+            return;
         }
 
-        // output to EVerest log
-        std::string log = msg;
-        std::string origin, target;
-        if (xmloutput) {
-            log += xml_pretty;
-        }
-        if (typ == 0) {
-            origin = "EVSE";
-            target = "CAR";
-            EVLOG_info << "\033[1;34mEVSE " << (iso15118 ? "ISO" : "IEC") << " " << log << "\033[1;0m";
-        } else if (typ == 1) {
-            origin = "CAR";
-            target = "EVSE";
-            EVLOG_info << "                                    \033[1;33mCAR " << (iso15118 ? "ISO" : "IEC") << " "
-                       << log << "\033[1;0m";
-        } else {
-            origin = "SYS";
-            target = "";
-            EVLOG_info << "SYS  " << msg;
+        Entry entry;
+        entry.record.origin = origin;
+        entry.record.iso15118 = iso15118;
+        entry.record.timestamp = std::chrono::system_clock::now();
+        entry.record.msg = msg;
+        entry.record.xml = xml;
+        entry.record.xml_hex = xml_hex;
+        entry.record.xml_base64 = xml_base64;
+        entry.record.json_str = json_str;
+
+        if (not queue.push(std::move(entry))) {
+            queued_bytes.fetch_sub(size);
+            dropped_messages++;
         }
+    }
+}
+
+void SessionLog::push_command(Entry&& entry) {
+    // commands must not be lost, the writer thread frees a slot soon
+    while (not queue.push(std::move(entry))) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
 
-        // output to session log file
-        logfile_csv << fmt::format("\"{}\",\"{}\",\"{}\",\"{}\"\n", ts, origin, msg, xml_pretty);
-        logfile_csv.flush();
+void SessionLog::flush() {
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex);
+        if (not writer.joinable()) {
+            return;
+        }
+    }
 
-        // output to session html file
-        logfile_html << fmt::format("<tr class=\"{}\"> <td>{}</td> <td>{}</td> <td><b>{}</b></td><td><b>{}</b></td> "
-                                    "<td><pre lang=\"xml\">{}</pre></td> <td><pre lang=\"xml\">{}</pre></td> <td><pre "
-                                    "lang=\"xml\">{}</pre></td> </tr>\n",
-                                    origin, ts, origin + "&gt;" + target, (typ == 0 || typ == 2 ? msg : ""),
-                                    (typ == 1 ? msg : ""), html_encode(xml_pretty), xml_hex, xml_base64);
-        logfile_html.flush();
+    Entry entry;
+    entry.command = Command::Flush;
+    entry.done = std::make_shared<std::promise<void>>();
+    auto done = entry.done->get_future();
+    push_command(std::move(entry));
+    done.wait();
+}
 
-        // output to api
-        nlohmann::json data;
-        data["origin"] = origin;
-        data["target"] = target;
-        data["iso15118"] = iso15118;
-        data["msg"] = msg;
-        this->mqtt(data);
+void SessionLog::stop() {
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    if (writer.joinable()) {
+        Entry entry;
+        entry.command = Command::Exit;
+        push_command(std::move(entry));
+        writer.join();
     }
+    enabled = false;
+    session_active = false;
+}
+
+std::uint64_t SessionLog::dropped() const {
+    return dropped_messages;
 }
 
 void SessionLog::xmlOutput(bool e) {
@@ -214,14 +184,173 @@ void SessionLog::xmlOutput(bool e) {
 }
 
 void SessionLog::sys(const std::string& msg) {
-    output(2, false, msg, "", "", "", "");
+    output(Origin::SYS, false, msg, "", "", "", "");
+}
+
+void SessionLog::run_writer() {
+    EventQueue<Entry, queue_size>::events_t entries;
+
+    while (true) {
+        queue.wait(entries);
+
+        bool stop = false;
+        std::vector<std::shared_ptr<std::promise<void>>> flushed;
+        for (auto& entry : entries) {
+            switch (entry.command) {
+            case Command::Message:
+                if (not discard) {
+                    write_message(entry.record);
+                }
+                queued_bytes.fetch_sub(entry.record.payload_size());
+                break;
+            case Command::StartSession:
+                write_start(entry);
+                break;
+            case Command::StopSession:
+                write_stop();
+                break;
+            case Command::Flush:
+                flushed.push_back(std::move(entry.done));
+                break;
+            case Command::Exit:
+                stop = true;
+                break;
+            }
+        }
+
+        // buffered output, written once per batch instead of once per message
+        write_dropped();
+        if (files_open) {
+            logfile_csv.flush();
+            logfile_html.flush();
+            logfile_bin.flush();
+        }
+        for (auto& done : flushed) {
+            done->set_value();
+        }
+
+        if (stop) {
+            return;
+        }
+    }
 }
 
-std::string SessionLog::html_encode(const std::string& msg) {
-    std::string out = msg;
-    boost::replace_all(out, "<", "&lt;");
-    boost::replace_all(out, ">", "&gt;");
-    return out;
+void SessionLog::write_start(const Entry& entry) {
+    if (files_open) {
+        write_stop();
+    }
+
+    fn = fmt::format("{}/incomplete-eventlog.csv", entry.logpath);
+    fnhtml = fmt::format("{}/incomplete-eventlog.html", entry.logpath);
+    fnbin = fmt::format("{}/incomplete-eventlog.bin", entry.logpath);
+    fn_complete = fmt::format("{}/eventlog.csv", entry.logpath);
+    fnhtml_complete = fmt::format("{}/eventlog.html", entry.logpath);
+    fnbin_complete = fmt::format("{}/eventlog.bin", entry.logpath);
+
+    if (format == Format::Binary) {
+        logfile_bin.open(fnbin, std::ios::binary);
+        files_open = logfile_bin.is_open();
+        if (files_open) {
+            session_log_format::write_header(logfile_bin);
+        } else {
+            EVLOG_error << fmt::format("Cannot open {} for writing", fnbin);
+        }
+    } else {
+        logfile_csv.open(fn);
+        logfile_html.open(fnhtml);
+        files_open = logfile_csv.is_open() && logfile_html.is_open();
+        if (files_open) {
+            logfile_html << session_log_format::html_header(entry.title);
+        } else {
+            EVLOG_error << fmt::format("Cannot open {} of {} for writing", fn, fnhtml);
+            logfile_csv.close();
+            logfile_html.close();
+        }
+    }
+}
+
+void SessionLog::write_stop() {
+    if (not files_open) {
+        return;
+    }
+    write_dropped();
+
+    const auto rename = [](const std::string& from, const std::string& to) {
+        // rename files to indicate they are finished now
+        try {
+            std::filesystem::rename(from, to);
+        } catch (const std::filesystem::filesystem_error& fs_err) {
+            EVLOG_error << "Could not rename " << from << ": " << fs_err.what();
+        }
+    };
+
+    if (logfile_bin.is_open()) {
+        logfile_bin.close();
+        rename(fnbin, fnbin_complete);
+    }
+    if (logfile_csv.is_open()) {
+        logfile_csv.close();
+        rename(fn, fn_complete);
+    }
+    if (logfile_html.is_open()) {
+        logfile_html << session_log_format::html_footer();
+        logfile_html.close();
+        rename(fnhtml, fnhtml_complete);
+    }
+
+    files_open = false;
+}
+
+void SessionLog::write_message(const Record& record) {
+    // the XML is only parsed if it is logged or written to the csv and html files
+    const bool text_files = files_open && not logfile_bin.is_open();
+    std::string pretty;
+    if (xmloutput || text_files) {
+        pretty = session_log_format::pretty_message(record);
+    }
+
+    // output to EVerest log
+    std::string log = record.msg;
+    if (xmloutput) {
+        log += pretty;
+    }
+    if (record.origin == Origin::EVSE) {
+        EVLOG_info << "\033[1;34mEVSE " << (record.iso15118 ? "ISO" : "IEC") << " " << log << "\033[1;0m";
+    } else if (record.origin == Origin::CAR) {
+        EVLOG_info << "                                    \033[1;33mCAR " << (record.iso15118 ? "ISO" : "IEC")
+                   << " " << log << "\033[1;0m";
+    } else {
+        EVLOG_info << "SYS  " << record.msg;
+    }
+
+    // output to session log files
+    if (text_files) {
+        logfile_csv << session_log_format::csv_line(record, pretty);
+        logfile_html << session_log_format::html_line(record, pretty);
+    } else if (files_open) {
+        session_log_format::write_record(logfile_bin, record);
+    }
+
+    // output to api
+    nlohmann::json data;
+    data["origin"] = session_log_format::origin_to_string(record.origin);
+    data["target"] = session_log_format::target_to_string(record.origin);
+    data["iso15118"] = record.iso15118;
+    data["msg"] = record.msg;
+    if (mqtt) {
+        mqtt(data);
+    }
+}
+
+void SessionLog::write_dropped() {
+    const std::uint64_t dropped = dropped_messages;
+    if (dropped > reported_dropped and not discard) {
+        Record record;
+        record.timestamp = std::chrono::system_clock::now();
+        record.msg = fmt::format("Session log could not keep up, {} messages dropped.", dropped - reported_dropped);
+        reported_dropped = dropped;
+        write_message(record);
+    }
 }
 
 } // namespace module
@@ -3,24 +3,42 @@
 #ifndef SESSION_LOG_HPP
 #define SESSION_LOG_HPP
 
+#include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <nlohmann/json_fwd.hpp>
 #include <optional>
 #include <string>
+#include <thread>
+
+#include "EventQueue.hpp"
+#include "SessionLogFormat.hpp"
 
 namespace module {
 /*
  Simple session logger that outputs to one file per session and EVLOG
+
+ The logging functions only queue the message, formatting, file output, EVLOG and MQTT are done by a writer thread.
+ The queue is bounded in the number of messages and in bytes, messages that do not fit are dropped and counted.
 */
 
 class SessionLog {
 public:
+    enum class Format {
+        HtmlCsv, // eventlog.csv and eventlog.html
+        Binary,  // eventlog.bin, convert with session_log_convert
+    };
+
     SessionLog();
     ~SessionLog();
 
     void setPath(const std::string& path);
     void setMqtt(const std::function<void(nlohmann::json data)>& mqtt_provider);
+    void setFormat(Format f);
     void enable();
     std::optional<std::string> startSession(const std::string& suffix_string);
     void stopSession();
@@ -37,20 +55,70 @@ public:
 
     void sys(const std::string& msg);
 
+    // blocks until the writer thread has written all messages queued before
+    void flush();
+
+    // writes all queued messages and stops the writer thread, must be called before the module providing the mqtt
+    // callback is destroyed
+    void stop();
+
+    // number of messages dropped because the queue was full
+    std::uint64_t dropped() const;
+
+    static constexpr std::size_t queue_size = 512;
+    static constexpr std::size_t max_queued_bytes = 4 * 1024 * 1024;
+
 private:
-    void output(unsigned int evse, bool iso15118, const std::string& msg, const std::string& xml,
+    enum class Command {
+        Message,
+        StartSession,
+        StopSession,
+        Flush,
+        Exit,
+    };
+
+    struct Entry {
+        Command command{Command::Message};
+        session_log_format::Record record;
+        std::string logpath;                      // StartSession
+        std::string title;                        // StartSession
+        std::shared_ptr<std::promise<void>> done; // Flush
+    };
+
+    void output(session_log_format::Origin origin, bool iso15118, const std::string& msg, const std::string& xml,
                 const std::string& xml_hex, const std::string& xml_base64, const std::string& json_str);
-    std::string html_encode(const std::string& msg);
-    bool xmloutput;
-    bool session_active;
-    bool enabled;
+    // queues commands, waits for space instead of dropping them
+    void push_command(Entry&& entry);
+
+    void run_writer();
+    void write_start(const Entry& entry);
+    void write_stop();
+    void write_message(const session_log_format::Record& record);
+    void write_dropped();
+
+    std::atomic_bool xmloutput;
+    // set if the writer thread was not stopped before the static destruction, queued messages are discarded then
+    std::atomic_bool discard{false};
+    std::atomic_bool session_active;
+    std::atomic_bool enabled;
+    Format format;
     std::string logpath_root;
     std::string logpath;
-    std::string fn, fnhtml, fn_complete, fnhtml_complete;
+    std::function<void(nlohmann::json data)> mqtt;
+
+    EventQueue<Entry, queue_size> queue;
+    std::atomic<std::size_t> queued_bytes{0};
+    std::atomic<std::uint64_t> dropped_messages{0};
+    std::thread writer;
+    std::mutex writer_mutex;
 
+    // owned by the writer thread
+    bool files_open{false};
+    std::uint64_t reported_dropped{0};
+    std::string fn, fnhtml, fnbin, fn_complete, fnhtml_complete, fnbin_complete;
     std::ofstream logfile_csv;
     std::ofstream logfile_html;
-    std::function<void(nlohmann::json data)> mqtt;
+    std::ofstream logfile_bin;
 };
 
 extern SessionLog session_log;
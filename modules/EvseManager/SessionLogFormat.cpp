@@ -0,0 +1,263 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include "SessionLogFormat.hpp"
+#include "v2gMessage.hpp"
+#include <algorithm>
+#include <array>
+#include <date/date.h>
+#include <date/tz.h>
+#include <fstream>
+#include <utils/date.hpp>
+
+#include <boost/algorithm/string.hpp>
+#include <fmt/core.h>
+
+namespace module::session_log_format {
+
+namespace {
+constexpr std::array<char, 4> magic{'E', 'V', 'S', 'L'};
+constexpr std::uint8_t format_version = 1;
+
+constexpr std::uint8_t origin_mask = 0x03;
+constexpr std::uint8_t iso15118_flag = 0x04;
+
+// limit for a single string, protects against reading garbage as a huge length
+constexpr std::uint64_t max_string_size = 16 * 1024 * 1024;
+
+void write_varint(std::ostream& out, std::uint64_t value) {
+    std::array<char, 10> buffer;
+    std::size_t len = 0;
+    do {
+        auto byte = static_cast<std::uint8_t>(value & 0x7f);
+        value >>= 7;
+        if (value != 0) {
+            byte |= 0x80;
+        }
+        buffer[len++] = static_cast<char>(byte);
+    } while (value != 0);
+    out.write(buffer.data(), len);
+}
+
+bool read_varint(std::istream& in, std::uint64_t& value) {
+    value = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7) {
+        const auto c = in.get();
+        if (c == std::istream::traits_type::eof()) {
+            return false;
+        }
+        value |= static_cast<std::uint64_t>(c & 0x7f) << shift;
+        if ((c & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void write_string(std::ostream& out, const std::string& str) {
+    write_varint(out, str.size());
+    out.write(str.data(), str.size());
+}
+
+bool read_string(std::istream& in, std::string& str) {
+    std::uint64_t size = 0;
+    if (not read_varint(in, size) or size > max_string_size) {
+        return false;
+    }
+    str.resize(size);
+    in.read(str.data(), size);
+    return static_cast<std::uint64_t>(in.gcount()) == size;
+}
+
+std::string html_encode(const std::string& msg) {
+    std::string out = msg;
+    boost::replace_all(out, "<", "&lt;");
+    boost::replace_all(out, ">", "&gt;");
+    return out;
+}
+} // namespace
+
+std::size_t Record::payload_size() const {
+    return msg.size() + xml.size() + xml_hex.size() + xml_base64.size() + json_str.size();
+}
+
+std::string origin_to_string(Origin origin) {
+    switch (origin) {
+    case Origin::EVSE:
+        return "EVSE";
+    case Origin::CAR:
+        return "CAR";
+    case Origin::SYS:
+    default:
+        return "SYS";
+    }
+}
+
+std::string target_to_string(Origin origin) {
+    switch (origin) {
+    case Origin::EVSE:
+        return "CAR";
+    case Origin::CAR:
+        return "EVSE";
+    case Origin::SYS:
+    default:
+        return "";
+    }
+}
+
+std::string timestamp_to_string(const Record& record) {
+    return Everest::Date::to_rfc3339(date::utc_clock::from_sys(record.timestamp));
+}
+
+std::string pretty_message(const Record& record) {
+    v2g_message v2g;
+    if (not record.xml.empty()) {
+        v2g.from_xml(record.xml);
+        return v2g.to_xml();
+    } else if (not record.json_str.empty()) {
+        try {
+            v2g.from_json(record.json_str);
+            return v2g.to_json();
+        } catch (const std::exception&) {
+            return record.json_str;
+        }
+    }
+    return {};
+}
+
+std::string csv_line(const Record& record, const std::string& pretty) {
+    return fmt::format("\"{}\",\"{}\",\"{}\",\"{}\"\n", timestamp_to_string(record), origin_to_string(record.origin),
+                       record.msg, pretty);
+}
+
+std::string html_header(const std::string& title) {
+    return fmt::format("<html><head><title>EVerest log session {}</title>\n", title) +
+           "<style>"
+           ".log {"
+           "  font-family: Arial, Helvetica, sans-serif;"
+           "  border-collapse: collapse;"
+           "  width: 100%;"
+           "}"
+           ".log td, .log th {"
+           "  border: 1px solid #ddd;"
+           "  padding: 8px;"
+           "  vertical-align: top;"
+           "}"
+           ".log tr.CAR{background-color: #E4E6F2;}"
+           ".log tr.EVSE{background-color: #F2F0E4;}"
+           ".log tr.SYS{background-color: white;}"
+           ".log th {"
+           "  padding-top: 12px;"
+           "  padding-bottom: 12px;"
+           "  text-align: left;"
+           "  vertical-align: top;"
+           "  background-color: #04AA6D;"
+           "  color: white;"
+           "}"
+           "</style>"
+           "</head><body><table class=\"log\">\n";
+}
+
+std::string html_line(const Record& record, const std::string& pretty) {
+    const auto origin = origin_to_string(record.origin);
+    return fmt::format("<tr class=\"{}\"> <td>{}</td> <td>{}</td> <td><b>{}</b></td><td><b>{}</b></td> "
+                       "<td><pre lang=\"xml\">{}</pre></td> <td><pre lang=\"xml\">{}</pre></td> <td><pre "
+                       "lang=\"xml\">{}</pre></td> </tr>\n",
+                       origin, timestamp_to_string(record), origin + "&gt;" + target_to_string(record.origin),
+                       (record.origin != Origin::CAR ? record.msg : ""),
+                       (record.origin == Origin::CAR ? record.msg : ""), html_encode(pretty), record.xml_hex,
+                       record.xml_base64);
+}
+
+std::string html_footer() {
+    return "</table></body></html>\n";
+}
+
+void write_header(std::ostream& out) {
+    out.write(magic.data(), magic.size());
+    out.put(static_cast<char>(format_version));
+}
+
+void write_record(std::ostream& out, const Record& record) {
+    auto flags = static_cast<std::uint8_t>(static_cast<std::uint8_t>(record.origin) & origin_mask);
+    if (record.iso15118) {
+        flags |= iso15118_flag;
+    }
+    out.put(static_cast<char>(flags));
+    const auto ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(record.timestamp.time_since_epoch()).count();
+    write_varint(out, static_cast<std::uint64_t>(ms));
+    for (const auto* str : {&record.msg, &record.xml, &record.xml_hex, &record.xml_base64, &record.json_str}) {
+        write_string(out, *str);
+    }
+}
+
+bool read_header(std::istream& in) {
+    std::array<char, magic.size() + 1> header{};
+    in.read(header.data(), header.size());
+    if (in.gcount() != static_cast<std::streamsize>(header.size())) {
+        return false;
+    }
+    return std::equal(magic.begin(), magic.end(), header.begin()) and
+           static_cast<std::uint8_t>(header.back()) == format_version;
+}
+
+bool read_record(std::istream& in, Record& record) {
+    const auto flags = in.get();
+    if (flags == std::istream::traits_type::eof()) {
+        return false;
+    }
+    record.origin = static_cast<Origin>(flags & origin_mask);
+    record.iso15118 = (flags & iso15118_flag) != 0;
+
+    std::uint64_t ms = 0;
+    if (not read_varint(in, ms)) {
+        return false;
+    }
+    record.timestamp = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::milliseconds(ms)));
+
+    for (auto* str : {&record.msg, &record.xml, &record.xml_hex, &record.xml_base64, &record.json_str}) {
+        if (not read_string(in, *str)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int convert(const std::string& binary_file, const std::string& csv_file, const std::string& html_file,
+            const std::string& title) {
+    std::ifstream in(binary_file, std::ios::binary);
+    if (not in.is_open() or not read_header(in)) {
+        return -1;
+    }
+
+    std::ofstream csv;
+    std::ofstream html;
+    if (not csv_file.empty()) {
+        csv.open(csv_file);
+    }
+    if (not html_file.empty()) {
+        html.open(html_file);
+        html << html_header(title);
+    }
+
+    int records = 0;
+    Record record;
+    while (read_record(in, record)) {
+        const auto pretty = pretty_message(record);
+        if (csv.is_open()) {
+            csv << csv_line(record, pretty);
+        }
+        if (html.is_open()) {
+            html << html_line(record, pretty);
+        }
+        records++;
+    }
+
+    if (html.is_open()) {
+        html << html_footer();
+    }
+    return records;
+}
+
+} // namespace module::session_log_format
@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef SESSION_LOG_FORMAT_HPP
+#define SESSION_LOG_FORMAT_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace module::session_log_format {
+/*
+ Records of the session log and their output formats.
+
+ The binary format is a header ("EVSL" and a version byte) followed by the records:
+   flags     1 byte   origin (bits 0-1), iso15118 (bit 2)
+   timestamp varint   milliseconds since the unix epoch
+   5 strings varint length followed by the bytes: msg, xml, xml_hex, xml_base64, json_str
+ XML and JSON are stored as received and only pretty printed when converting to CSV and HTML.
+*/
+
+enum class Origin : std::uint8_t {
+    EVSE = 0,
+    CAR = 1,
+    SYS = 2,
+};
+
+struct Record {
+    Origin origin{Origin::SYS};
+    bool iso15118{false};
+    std::chrono::system_clock::time_point timestamp;
+    std::string msg;
+    std::string xml;
+    std::string xml_hex;
+    std::string xml_base64;
+    std::string json_str;
+
+    // bytes used by the strings of the record
+    std::size_t payload_size() const;
+};
+
+std::string origin_to_string(Origin origin);
+std::string target_to_string(Origin origin);
+
+// RFC 3339 timestamp of the record in UTC
+std::string timestamp_to_string(const Record& record);
+
+// pretty printed XML or JSON of the record, empty if the record has neither
+std::string pretty_message(const Record& record);
+
+std::string csv_line(const Record& record, const std::string& pretty);
+std::string html_header(const std::string& title);
+std::string html_line(const Record& record, const std::string& pretty);
+std::string html_footer();
+
+void write_header(std::ostream& out);
+void write_record(std::ostream& out, const Record& record);
+
+// returns false if the stream does not start with a supported header
+bool read_header(std::istream& in);
+// returns false at the end of the stream or if the record is truncated
+bool read_record(std::istream& in, Record& record);
+
+/*
+ Converts a binary session log into the CSV and HTML files, an empty file name skips that output.
+ Returns the number of converted records or -1 if the binary log cannot be read.
+*/
+int convert(const std::string& binary_file, const std::string& csv_file, const std::string& html_file,
+            const std::string& title);
+
+} // namespace module::session_log_format
+
+#endif // SESSION_LOG_FORMAT_HPP
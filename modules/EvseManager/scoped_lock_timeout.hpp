@@ -5,9 +5,11 @@
 
 #include "everest/exceptions.hpp"
 #include "everest/logging.hpp"
+#include <chrono>
 #include <mutex>
 #include <signal.h>
 
+#include "LockProfiler.hpp"
 #include "backtrace.hpp"
 
 /*
@@ -89,9 +91,14 @@ enum class MutexDescription {
     EVSE_get_hlc_enabled,
     EVSE_get_hlc_waiting_for_auth_pnc,
     EVSE_charger_was_authorized,
-    EVSE_get_ev_info
+    EVSE_get_ev_info,
+    // not a mutex, needs to stay the last entry
+    Count
 };
 
+// number of entries in MutexDescription
+constexpr std::size_t mutex_description_count = static_cast<std::size_t>(MutexDescription::Count);
+
 static std::string to_string(MutexDescription d) {
     switch (d) {
     case MutexDescription::Undefined:
@@ -242,6 +249,8 @@ static std::string to_string(MutexDescription d) {
         return "EvseManager.cpp: charger_was_authorized";
     case MutexDescription::EVSE_get_ev_info:
         return "EvseManager.cpp: get_ev_info";
+    case MutexDescription::Count:
+        break;
     }
     return "Undefined";
 }
@@ -256,7 +265,13 @@ public:
 
 template <typename mutex_type> class scoped_lock_timeout {
 public:
-    explicit scoped_lock_timeout(mutex_type& __m, MutexDescription description) : mutex(__m) {
+    explicit scoped_lock_timeout(mutex_type& __m, MutexDescription description) :
+        mutex(__m), description(description) {
+        const bool profile = LockProfiler::enabled();
+        if (profile) {
+            wait_started = std::chrono::steady_clock::now();
+        }
+
         if (not mutex.try_lock_for(deadlock_timeout)) {
 #ifdef EVEREST_USE_BACKTRACES
             request_backtrace(pthread_self());
@@ -276,6 +291,10 @@ public:
 #endif
         } else {
             locked = true;
+            if (profile) {
+                locked_at = std::chrono::steady_clock::now();
+                profiling = true;
+            }
 #ifdef EVEREST_USE_BACKTRACES
             mutex.description = description;
             mutex.p_id = pthread_self();
@@ -286,6 +305,10 @@ public:
     ~scoped_lock_timeout() {
         if (locked) {
             mutex.unlock();
+            if (profiling) {
+                LockProfiler::record(description, locked_at - wait_started,
+                                     std::chrono::steady_clock::now() - locked_at);
+            }
         }
     }
 
@@ -295,6 +318,12 @@ public:
 private:
     bool locked{false};
     mutex_type& mutex;
+    const MutexDescription description;
+
+    // only used if the LockProfiler is enabled
+    bool profiling{false};
+    std::chrono::steady_clock::time_point wait_started;
+    std::chrono::steady_clock::time_point locked_at;
 
     // This should be lower then command timeouts from framework (by default 300s)
     static constexpr auto deadlock_timeout = std::chrono::seconds(120);
@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+// Converts binary session logs (eventlog.bin) of the EvseManager into eventlog.csv and eventlog.html
+
+#include <SessionLogFormat.hpp>
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <eventlog.bin> [<eventlog.bin> ...]" << std::endl;
+        std::cerr << "Writes eventlog.csv and eventlog.html next to each binary session log." << std::endl;
+        return 1;
+    }
+
+    int result = 0;
+    for (int i = 1; i < argc; i++) {
+        const std::filesystem::path binary_file(argv[i]);
+        auto csv_file = binary_file;
+        auto html_file = binary_file;
+        csv_file.replace_extension(".csv");
+        html_file.replace_extension(".html");
+        // the session directory is named after the start time and the session id
+        const auto title = std::filesystem::absolute(binary_file).parent_path().filename().string();
+
+        const auto records =
+            module::session_log_format::convert(binary_file.string(), csv_file.string(), html_file.string(), title);
+        if (records < 0) {
+            std::cerr << binary_file.string() << ": not a binary session log" << std::endl;
+            result = 1;
+        } else {
+            std::cout << binary_file.string() << ": " << records << " messages converted to " << csv_file.string()
+                      << " and " << html_file.string() << std::endl;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+// Compares the lock free EventQueue with the previous mutex/vector implementation.
+// The load resembles the BSP events seen by IECStateMachine: producers push short bursts of events (e.g. CP state
+// change followed by PowerOn) and a single consumer drains them.
+
+#include <EventQueue.hpp>
+
+#include <fmt/core.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// previous implementation, kept here as reference
+template <typename E> class MutexEventQueue {
+public:
+    using events_t = std::vector<E>;
+
+    bool push(const E& event) {
+        {
+            std::lock_guard<std::mutex> lock(mux);
+            pending.push_back(event);
+        }
+        cv.notify_all();
+        return true;
+    }
+
+    std::size_t wait(events_t& events) {
+        std::unique_lock<std::mutex> ul(mux);
+        cv.wait(ul, [this]() { return !pending.empty(); });
+        events_t active;
+        pending.swap(active);
+        ul.unlock();
+        events = std::move(active);
+        return events.size();
+    }
+
+private:
+    events_t pending;
+    std::mutex mux;
+    std::condition_variable cv;
+};
+
+enum class BspEvent : std::uint8_t {
+    A,
+    B,
+    C,
+    PowerOn,
+    PowerOff
+};
+
+constexpr int c_bursts = 200000;
+constexpr int c_burst_size = 3;
+
+template <typename Queue> void run(const char* name, int producers) {
+    Queue queue;
+    std::atomic<long> dropped{0};
+    const long total = static_cast<long>(producers) * c_bursts * c_burst_size;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&queue, &dropped]() {
+            for (int i = 0; i < c_bursts; i++) {
+                for (auto e : {BspEvent::B, BspEvent::C, BspEvent::PowerOn}) {
+                    while (not queue.push(e)) {
+                        dropped++;
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        });
+    }
+
+    long received = 0;
+    long drains = 0;
+    typename Queue::events_t events;
+    while (received < total) {
+        received += queue.wait(events);
+        drains++;
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    const auto duration = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    fmt::print("{:<10} producers {} : {:>8.1f} ns/event, {:>6.1f} events/drain, {} full retries\n", name, producers,
+               duration / total, static_cast<double>(received) / drains, dropped.load());
+}
+
+// Paced load closer to real BSP event rates: one burst every interval, measures the time from the first push of a
+// burst until the consumer has the complete burst.
+template <typename Queue> void run_paced(const char* name, std::chrono::microseconds interval) {
+    constexpr int bursts = 2000;
+    Queue queue;
+    std::atomic<std::int64_t> burst_pushed_ns{0};
+
+    std::thread producer([&queue, &burst_pushed_ns, interval]() {
+        for (int i = 0; i < bursts; i++) {
+            burst_pushed_ns = std::chrono::steady_clock::now().time_since_epoch().count();
+            for (auto e : {BspEvent::B, BspEvent::C, BspEvent::PowerOn}) {
+                queue.push(e);
+            }
+            std::this_thread::sleep_for(interval);
+        }
+    });
+
+    long received = 0;
+    double latency_sum_ns = 0;
+    typename Queue::events_t events;
+    while (received < bursts * c_burst_size) {
+        received += queue.wait(events);
+        if (received % c_burst_size == 0) {
+            latency_sum_ns += std::chrono::steady_clock::now().time_since_epoch().count() - burst_pushed_ns;
+        }
+    }
+    producer.join();
+
+    fmt::print("{:<10} paced {:>5}us : {:>8.1f} us burst latency\n", name, interval.count(),
+               latency_sum_ns / bursts / 1000.);
+}
+
+} // namespace
+
+int main() {
+    for (int producers : {1, 2, 4}) {
+        run<MutexEventQueue<BspEvent>>("mutex", producers);
+        run<module::EventQueue<BspEvent, 1024>>("lock free", producers);
+    }
+
+    for (auto interval : {std::chrono::microseconds(100), std::chrono::microseconds(1000)}) {
+        run_paced<MutexEventQueue<BspEvent>>("mutex", interval);
+        run_paced<module::EventQueue<BspEvent, 1024>>("lock free", interval);
+    }
+    return 0;
+}
@@ -6,6 +6,7 @@
 #include <condition_variable>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 namespace {
 
@@ -91,4 +92,78 @@ TEST(EventQueue, wait) {
     wait_thread.join();
 }
 
+TEST(EventQueue, overflow) {
+    module::EventQueue<int, 4> queue;
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.push(i));
+    }
+    EXPECT_FALSE(queue.push(4));
+    EXPECT_EQ(queue.dropped(), 1);
+    EXPECT_EQ(queue.high_watermark(), 4);
+
+    module::EventQueue<int, 4>::events_t events;
+    ASSERT_EQ(queue.get_events(events), 4);
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(events[i], i);
+    }
+
+    // space is available again after draining
+    EXPECT_TRUE(queue.push(5));
+    ASSERT_EQ(queue.get_events(events), 1);
+    EXPECT_EQ(events[0], 5);
+}
+
+TEST(EventQueue, batch) {
+    module::EventQueue<int, 8> queue;
+    for (int i = 0; i < 5; i++) {
+        queue.push(i);
+    }
+
+    module::EventQueue<int, 8>::events_t events;
+    ASSERT_EQ(queue.get_events(events, 2), 2);
+    EXPECT_EQ(events[0], 0);
+    EXPECT_EQ(events[1], 1);
+
+    const auto data = events.data();
+    ASSERT_EQ(queue.wait(events, 2), 2);
+    EXPECT_EQ(events[0], 2);
+    EXPECT_EQ(events[1], 3);
+    // the buffer of the vector is reused
+    EXPECT_EQ(events.data(), data);
+
+    ASSERT_EQ(queue.get_events(events), 1);
+    EXPECT_EQ(events[0], 4);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(EventQueue, multiple_producers) {
+    constexpr int producers = 4;
+    constexpr int events_per_producer = 10000;
+    module::EventQueue<int, 256> queue;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&queue]() {
+            for (int i = 0; i < events_per_producer; i++) {
+                while (not queue.push(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    long received = 0;
+    module::EventQueue<int, 256>::events_t events;
+    while (received < producers * events_per_producer) {
+        received += queue.wait(events);
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(received, producers * events_per_producer);
+    EXPECT_TRUE(queue.empty());
+}
+
 } // namespace
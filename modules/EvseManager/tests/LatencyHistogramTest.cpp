@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include <LatencyHistogram.hpp>
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+TEST(LatencyHistogram, empty) {
+    module::LatencyHistogram h;
+    EXPECT_EQ(h.count(), 0);
+    EXPECT_EQ(h.percentile(50), 0us);
+    EXPECT_EQ(h.max(), 0us);
+}
+
+TEST(LatencyHistogram, buckets) {
+    module::LatencyHistogram h;
+    h.add(10us);
+    h.add(100us);
+    h.add(1ms);
+    h.add(1h);
+
+    EXPECT_EQ(h.count(), 4);
+    EXPECT_EQ(h.bucket(0), 1);
+    // 100us is in [64, 128)
+    EXPECT_EQ(h.bucket(1), 1);
+    // 1000us is in [512, 1024)
+    EXPECT_EQ(h.bucket(4), 1);
+    // everything large ends up in the last bucket
+    EXPECT_EQ(h.bucket(module::LatencyHistogram::number_of_buckets - 1), 1);
+    EXPECT_EQ(h.max(), std::chrono::microseconds(1h));
+}
+
+TEST(LatencyHistogram, percentile) {
+    module::LatencyHistogram h;
+    for (int i = 0; i < 99; i++) {
+        h.add(100us);
+    }
+    h.add(50ms);
+
+    EXPECT_EQ(h.percentile(50), 128us);
+    EXPECT_EQ(h.percentile(99), 65536us);
+    EXPECT_EQ(h.max(), 50ms);
+
+    h.reset();
+    EXPECT_EQ(h.count(), 0);
+    EXPECT_EQ(h.max(), 0us);
+}
+
+TEST(LatencyHistogram, concurrent) {
+    module::LatencyHistogram h;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&h, t]() {
+            for (int i = 0; i < 1000; i++) {
+                h.add(std::chrono::microseconds(i * (t + 1)));
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(h.count(), 4000);
+    EXPECT_EQ(h.max(), 3996us);
+}
+
+} // namespace
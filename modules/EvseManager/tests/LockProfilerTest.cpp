@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include <LockProfiler.hpp>
+#include <gtest/gtest.h>
+#include <scoped_lock_timeout.hpp>
+
+#include <thread>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+class LockProfilerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Everest::LockProfiler::reset();
+    }
+
+    void TearDown() override {
+        Everest::LockProfiler::enable(false);
+        Everest::LockProfiler::reset();
+    }
+};
+
+TEST_F(LockProfilerTest, disabled) {
+    Everest::timed_mutex_traceable mutex;
+    {
+        Everest::scoped_lock_timeout lock(mutex, Everest::MutexDescription::Charger_mainloop);
+    }
+    EXPECT_TRUE(Everest::LockProfiler::report().empty());
+}
+
+TEST_F(LockProfilerTest, wait_and_hold) {
+    Everest::LockProfiler::enable(true);
+    Everest::timed_mutex_traceable mutex;
+
+    std::thread holder([&mutex]() {
+        Everest::scoped_lock_timeout lock(mutex, Everest::MutexDescription::Charger_mainloop);
+        std::this_thread::sleep_for(50ms);
+    });
+
+    // make sure the other thread has the lock
+    std::this_thread::sleep_for(10ms);
+    {
+        Everest::scoped_lock_timeout lock(mutex, Everest::MutexDescription::Charger_get_max_current);
+    }
+    holder.join();
+
+    const auto report = Everest::LockProfiler::report();
+    ASSERT_EQ(report.size(), 2);
+
+    // sorted by total wait time, so the waiting caller comes first
+    EXPECT_EQ(report[0].at("mutex"), Everest::to_string(Everest::MutexDescription::Charger_get_max_current));
+    EXPECT_EQ(report[0].at("count"), 1);
+    EXPECT_GE(report[0].at("wait").at("total_us").get<int>(), 20000);
+
+    EXPECT_EQ(report[1].at("mutex"), Everest::to_string(Everest::MutexDescription::Charger_mainloop));
+    EXPECT_GE(report[1].at("hold").at("total_us").get<int>(), 40000);
+}
+
+TEST_F(LockProfilerTest, exited_threads_are_merged) {
+    Everest::LockProfiler::enable(true);
+    Everest::timed_mutex_traceable mutex;
+    const auto threads_before = Everest::LockProfiler::active_threads();
+
+    for (int i = 0; i < 10; i++) {
+        std::thread([&mutex]() {
+            Everest::scoped_lock_timeout lock(mutex, Everest::MutexDescription::Charger_mainloop);
+        }).join();
+    }
+
+    // the histograms of the exited threads are not kept, but their samples are still reported
+    EXPECT_EQ(Everest::LockProfiler::active_threads(), threads_before);
+
+    const auto report = Everest::LockProfiler::report();
+    ASSERT_EQ(report.size(), 1);
+    EXPECT_EQ(report[0].at("count"), 10);
+
+    Everest::LockProfiler::reset();
+    EXPECT_TRUE(Everest::LockProfiler::report().empty());
+}
+
+TEST_F(LockProfilerTest, every_description_is_counted) {
+    Everest::LockProfiler::enable(true);
+    Everest::timed_mutex_traceable mutex;
+    {
+        Everest::scoped_lock_timeout lock(mutex, Everest::MutexDescription::EVSE_get_ev_info);
+    }
+
+    const auto report = Everest::LockProfiler::report();
+    ASSERT_EQ(report.size(), 1);
+    EXPECT_EQ(report[0].at("mutex"), Everest::to_string(Everest::MutexDescription::EVSE_get_ev_info));
+    EXPECT_EQ(Everest::mutex_description_count, static_cast<std::size_t>(Everest::MutexDescription::Count));
+}
+
+} // namespace
@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+// Cost per logged message on the thread that logs (e.g. the V2G thread in the CurrentDemand loop).
+// Compares the previous synchronous SessionLog output (pretty print, format, write and flush on the calling thread)
+// with the queued SessionLog in both file formats.
+
+#include <SessionLog.hpp>
+#include <SessionLogFormat.hpp>
+
+#include <boost/log/core.hpp>
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int c_messages = 20000;
+
+const std::string c_xml =
+    "<?xml version=\"1.0\"?><V2G_Message><Header><SessionID>0102030405060708</SessionID></Header><Body>"
+    "<CurrentDemandReq><DC_EVStatus><EVReady>true</EVReady><EVErrorCode>NO_ERROR</EVErrorCode><EVRESSSOC>42"
+    "</EVRESSSOC></DC_EVStatus><EVTargetCurrent><Multiplier>0</Multiplier><Unit>A</Unit><Value>125</Value>"
+    "</EVTargetCurrent><EVMaximumVoltageLimit><Multiplier>0</Multiplier><Unit>V</Unit><Value>450</Value>"
+    "</EVMaximumVoltageLimit><ChargingComplete>false</ChargingComplete><EVTargetVoltage><Multiplier>0"
+    "</Multiplier><Unit>V</Unit><Value>400</Value></EVTargetVoltage></CurrentDemandReq></Body></V2G_Message>";
+const std::string c_hex = "809802010203040506070851e0200000004083e8004085048088120404c1c80";
+const std::string c_base64 = "gJgCAQIDBAUGBwhR4CAAAABAg+gAQIUEgIgSBATByA==";
+
+struct Result {
+    double mean_ns;
+    double p99_ns;
+    double max_ns;
+    double total_ms;
+};
+
+Result evaluate(std::vector<double>& samples, std::chrono::steady_clock::duration total) {
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (auto s : samples) {
+        sum += s;
+    }
+    return {sum / samples.size(), samples.at(samples.size() * 99 / 100), samples.back(),
+            std::chrono::duration<double, std::milli>(total).count()};
+}
+
+void print(const char* name, const Result& r, std::uint64_t dropped) {
+    fmt::print("{:<12} : {:>9.1f} ns/msg mean, {:>9.1f} ns p99, {:>10.1f} ns max, {:>7.1f} ms until written, {} "
+               "dropped\n",
+               name, r.mean_ns, r.p99_ns, r.max_ns, r.total_ms, dropped);
+}
+
+// previous implementation, kept here as reference
+void run_synchronous(const std::filesystem::path& dir) {
+    std::filesystem::create_directories(dir);
+    std::ofstream csv(dir / "eventlog.csv");
+    std::ofstream html(dir / "eventlog.html");
+    html << module::session_log_format::html_header("benchmark");
+
+    std::vector<double> samples;
+    samples.reserve(c_messages);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < c_messages; i++) {
+        const auto t0 = std::chrono::steady_clock::now();
+        module::session_log_format::Record record;
+        record.origin = module::session_log_format::Origin::CAR;
+        record.iso15118 = true;
+        record.timestamp = std::chrono::system_clock::now();
+        record.msg = "V2G CurrentDemandReq";
+        record.xml = c_xml;
+        record.xml_hex = c_hex;
+        record.xml_base64 = c_base64;
+        const auto pretty = module::session_log_format::pretty_message(record);
+        csv << module::session_log_format::csv_line(record, pretty);
+        csv.flush();
+        html << module::session_log_format::html_line(record, pretty);
+        html.flush();
+        samples.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count());
+    }
+    print("synchronous", evaluate(samples, std::chrono::steady_clock::now() - start), 0);
+}
+
+void run_queued(const char* name, const std::filesystem::path& dir, module::SessionLog::Format format,
+                std::chrono::microseconds interval) {
+    module::SessionLog log;
+    log.setPath(dir.string());
+    log.setFormat(format);
+    log.xmlOutput(false);
+    log.enable();
+    log.startSession("benchmark");
+
+    std::vector<double> samples;
+    samples.reserve(c_messages);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < c_messages; i++) {
+        const auto t0 = std::chrono::steady_clock::now();
+        log.car(true, "V2G CurrentDemandReq", c_xml, c_hex, c_base64, "");
+        samples.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count());
+        if (interval.count() > 0) {
+            std::this_thread::sleep_for(interval);
+        }
+    }
+    log.stopSession();
+    log.flush();
+    print(name, evaluate(samples, std::chrono::steady_clock::now() - start), log.dropped());
+}
+
+} // namespace
+
+int main() {
+    // the EVLOG output of the writer thread is not part of the benchmark
+    boost::log::core::get()->set_logging_enabled(false);
+
+    const auto dir = std::filesystem::temp_directory_path() / "session_log_benchmark";
+    std::filesystem::remove_all(dir);
+
+    fmt::print("{} messages as fast as possible\n", c_messages);
+    run_synchronous(dir / "synchronous");
+    run_queued("html_csv", dir / "html_csv", module::SessionLog::Format::HtmlCsv, std::chrono::microseconds(0));
+    run_queued("binary", dir / "binary", module::SessionLog::Format::Binary, std::chrono::microseconds(0));
+
+    fmt::print("{} messages, one every 50us\n", c_messages);
+    run_queued("html_csv", dir / "html_csv", module::SessionLog::Format::HtmlCsv, std::chrono::microseconds(50));
+    run_queued("binary", dir / "binary", module::SessionLog::Format::Binary, std::chrono::microseconds(50));
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include <SessionLog.hpp>
+#include <SessionLogFormat.hpp>
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+using module::session_log_format::Origin;
+using module::session_log_format::Record;
+
+const std::string c_xml = "<?xml version=\"1.0\"?><V2G_Message><Body><CurrentDemandReq><EVTargetCurrent>"
+                          "<Value>125</Value></EVTargetCurrent></CurrentDemandReq></Body></V2G_Message>";
+
+Record make_record(Origin origin, const std::string& msg) {
+    Record record;
+    record.origin = origin;
+    record.iso15118 = origin != Origin::SYS;
+    record.timestamp = std::chrono::system_clock::time_point(std::chrono::milliseconds(1700000000123));
+    record.msg = msg;
+    return record;
+}
+
+std::string read_file(const std::filesystem::path& file) {
+    std::ifstream in(file);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+class SessionLogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root = std::filesystem::temp_directory_path() /
+               ("session_log_test_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) + "_" +
+                ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        std::filesystem::remove_all(root);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(root);
+    }
+
+    std::filesystem::path root;
+};
+
+TEST(SessionLogFormat, binary_round_trip) {
+    auto evse = make_record(Origin::EVSE, "V2G CurrentDemandRes");
+    evse.xml = c_xml;
+    evse.xml_hex = "8098021050908c0c0c0c0c51";
+    evse.xml_base64 = "gJgCEFCQjAwMDAxR";
+    auto car = make_record(Origin::CAR, "V2G CurrentDemandReq");
+    car.json_str = "{\"a\": 1}";
+    const auto sys = make_record(Origin::SYS, std::string(300, 'x'));
+
+    std::stringstream stream;
+    module::session_log_format::write_header(stream);
+    for (const auto& record : {evse, car, sys}) {
+        module::session_log_format::write_record(stream, record);
+    }
+
+    ASSERT_TRUE(module::session_log_format::read_header(stream));
+    for (const auto& expected : {evse, car, sys}) {
+        Record record;
+        ASSERT_TRUE(module::session_log_format::read_record(stream, record));
+        EXPECT_EQ(record.origin, expected.origin);
+        EXPECT_EQ(record.iso15118, expected.iso15118);
+        EXPECT_EQ(record.timestamp, expected.timestamp);
+        EXPECT_EQ(record.msg, expected.msg);
+        EXPECT_EQ(record.xml, expected.xml);
+        EXPECT_EQ(record.xml_hex, expected.xml_hex);
+        EXPECT_EQ(record.xml_base64, expected.xml_base64);
+        EXPECT_EQ(record.json_str, expected.json_str);
+    }
+    Record record;
+    EXPECT_FALSE(module::session_log_format::read_record(stream, record));
+}
+
+TEST(SessionLogFormat, truncated_record) {
+    std::stringstream stream;
+    module::session_log_format::write_header(stream);
+    module::session_log_format::write_record(stream, make_record(Origin::EVSE, "D-LINK_READY (true)"));
+    const auto data = stream.str();
+
+    std::stringstream truncated(data.substr(0, data.size() - 3));
+    ASSERT_TRUE(module::session_log_format::read_header(truncated));
+    Record record;
+    EXPECT_FALSE(module::session_log_format::read_record(truncated, record));
+
+    std::stringstream no_header("<html>");
+    EXPECT_FALSE(module::session_log_format::read_header(no_header));
+}
+
+TEST(SessionLogFormat, csv_and_html) {
+    auto record = make_record(Origin::CAR, "V2G CurrentDemandReq");
+    const auto pretty = module::session_log_format::pretty_message(record);
+    EXPECT_TRUE(pretty.empty());
+
+    EXPECT_EQ(module::session_log_format::csv_line(record, pretty),
+              "\"2023-11-14T22:13:20.123Z\",\"CAR\",\"V2G CurrentDemandReq\",\"\"\n");
+
+    record.xml = c_xml;
+    const auto html = module::session_log_format::html_line(record, module::session_log_format::pretty_message(record));
+    EXPECT_NE(html.find("<tr class=\"CAR\">"), std::string::npos);
+    EXPECT_NE(html.find("CAR&gt;EVSE"), std::string::npos);
+    EXPECT_NE(html.find("&lt;CurrentDemandReq&gt;"), std::string::npos);
+}
+
+TEST_F(SessionLogTest, html_csv) {
+    module::SessionLog log;
+    log.setPath(root.string());
+    log.enable();
+
+    const auto path = log.startSession("session-1");
+    ASSERT_TRUE(path.has_value());
+    log.evse(true, "V2G CurrentDemandRes", c_xml, "", "", "");
+    log.car(true, "V2G CurrentDemandReq");
+    log.flush();
+
+    // files are complete only after the session has been stopped
+    EXPECT_TRUE(std::filesystem::exists(std::filesystem::path(path.value()) / "incomplete-eventlog.csv"));
+    log.stopSession();
+    log.flush();
+
+    const std::filesystem::path dir(path.value());
+    EXPECT_FALSE(std::filesystem::exists(dir / "incomplete-eventlog.csv"));
+    const auto csv = read_file(dir / "eventlog.csv");
+    const auto started = csv.find("Session logging started.");
+    const auto evse = csv.find("V2G CurrentDemandRes");
+    const auto car = csv.find("V2G CurrentDemandReq");
+    const auto stopped = csv.find("Session logging stopped.");
+    ASSERT_NE(stopped, std::string::npos);
+    EXPECT_LT(started, evse);
+    EXPECT_LT(evse, car);
+    EXPECT_LT(car, stopped);
+    const auto html = read_file(dir / "eventlog.html");
+    EXPECT_NE(html.find("EVerest log session session-1"), std::string::npos);
+    EXPECT_NE(html.find("</html>"), std::string::npos);
+    EXPECT_EQ(log.dropped(), 0);
+}
+
+TEST_F(SessionLogTest, binary) {
+    module::SessionLog log;
+    log.setPath(root.string());
+    log.setFormat(module::SessionLog::Format::Binary);
+    log.enable();
+
+    const auto path = log.startSession("session-2");
+    ASSERT_TRUE(path.has_value());
+    for (int i = 0; i < 10; i++) {
+        log.car(true, "V2G CurrentDemandReq", c_xml, "", "", "");
+    }
+    log.stopSession();
+    log.flush();
+
+    const std::filesystem::path dir(path.value());
+    EXPECT_FALSE(std::filesystem::exists(dir / "eventlog.csv"));
+    ASSERT_TRUE(std::filesystem::exists(dir / "eventlog.bin"));
+
+    const auto records = module::session_log_format::convert(
+        (dir / "eventlog.bin").string(), (dir / "eventlog.csv").string(), (dir / "eventlog.html").string(), "s");
+    EXPECT_EQ(records, 12);
+    const auto csv = read_file(dir / "eventlog.csv");
+    EXPECT_NE(csv.find("Session logging started."), std::string::npos);
+    EXPECT_NE(csv.find("<CurrentDemandReq>"), std::string::npos);
+}
+
+TEST_F(SessionLogTest, messages_exceeding_the_memory_limit_are_dropped) {
+    module::SessionLog log;
+    log.setPath(root.string());
+    log.enable();
+
+    const auto path = log.startSession("session-3");
+    log.evse(false, std::string(module::SessionLog::max_queued_bytes + 1, 'x'));
+    log.evse(false, "still logged");
+    EXPECT_EQ(log.dropped(), 1);
+    log.stopSession();
+    log.flush();
+
+    const auto csv = read_file(std::filesystem::path(path.value()) / "eventlog.csv");
+    EXPECT_NE(csv.find("still logged"), std::string::npos);
+    EXPECT_NE(csv.find("1 messages dropped"), std::string::npos);
+}
+
+TEST_F(SessionLogTest, stop_writes_queued_messages) {
+    module::SessionLog log;
+    log.setPath(root.string());
+    std::atomic<int> published{0};
+    log.setMqtt([&published](nlohmann::json) { published++; });
+    log.enable();
+
+    const auto path = log.startSession("session-5");
+    for (int i = 0; i < 10; i++) {
+        log.evse(false, "queued");
+    }
+    log.stop();
+    EXPECT_EQ(published, 11);
+
+    // nothing is queued once the writer has stopped
+    EXPECT_EQ(log.startSession("session-6"), std::string());
+    log.evse(false, "not logged");
+    log.flush();
+    EXPECT_EQ(published, 11);
+}
+
+TEST_F(SessionLogTest, disabled) {
+    module::SessionLog log;
+    log.setPath(root.string());
+    EXPECT_EQ(log.startSession("session-4"), std::string());
+    log.evse(false, "not logged");
+    log.flush();
+    EXPECT_FALSE(std::filesystem::exists(root));
+}
+
+} // namespace
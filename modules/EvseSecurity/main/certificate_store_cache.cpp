@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include "certificate_store_cache.hpp"
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <everest/logging.hpp>
+
+namespace module {
+namespace main {
+
+static constexpr std::uint32_t watch_mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM |
+                                            IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF;
+
+CertificateStoreWatcher::CertificateStoreWatcher(const std::vector<std::filesystem::path>& _paths) : paths(_paths) {
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd == -1) {
+        EVLOG_warning << "Cannot watch the certificate store, queries will not be cached: " << strerror(errno);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    watching = true;
+    for (const auto& path : paths) {
+        add_watches(path);
+    }
+}
+
+CertificateStoreWatcher::~CertificateStoreWatcher() {
+    if (inotify_fd != -1) {
+        close(inotify_fd);
+    }
+}
+
+bool CertificateStoreWatcher::is_watching() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (not watching and (inotify_fd != -1)) {
+        rewatch();
+    }
+    read_events();
+    return watching;
+}
+
+std::uint64_t CertificateStoreWatcher::generation() {
+    std::lock_guard<std::mutex> lock(mutex);
+    read_events();
+    return current_generation;
+}
+
+void CertificateStoreWatcher::invalidate() {
+    std::lock_guard<std::mutex> lock(mutex);
+    current_generation++;
+}
+
+void CertificateStoreWatcher::add_watches(const std::filesystem::path& path) {
+    std::error_code ec;
+    if (std::filesystem::is_directory(path, ec)) {
+        add_watch(path, true);
+    } else if (std::filesystem::is_directory(path.parent_path(), ec)) {
+        // the file may be replaced or created later, OCSP responses are stored in subdirectories next to it
+        add_watch(path.parent_path(), true);
+    } else {
+        stop_watching("Cannot watch " + path.string());
+    }
+}
+
+void CertificateStoreWatcher::add_watch(const std::filesystem::path& directory, bool recursive) {
+    if (not watching) {
+        return;
+    }
+
+    const auto wd = inotify_add_watch(inotify_fd, directory.c_str(), watch_mask);
+    if (wd == -1) {
+        stop_watching("Cannot watch " + directory.string() + ": " + strerror(errno));
+        return;
+    }
+    watches[wd] = directory;
+
+    if (not recursive) {
+        return;
+    }
+
+    std::error_code ec;
+    for (auto entry = std::filesystem::recursive_directory_iterator(
+             directory, std::filesystem::directory_options::skip_permission_denied, ec);
+         entry != std::filesystem::recursive_directory_iterator(); entry.increment(ec)) {
+        if (ec) {
+            break;
+        }
+        if (entry->is_directory(ec) and not entry->is_symlink(ec)) {
+            add_watch(entry->path(), false);
+        }
+    }
+}
+
+void CertificateStoreWatcher::read_events() {
+    if (not watching) {
+        return;
+    }
+
+    bool changed = false;
+    bool rewatch = false;
+    alignas(inotify_event) std::array<char, 4096> buffer;
+
+    ssize_t len = 0;
+    while ((len = read(inotify_fd, buffer.data(), buffer.size())) > 0) {
+        for (ssize_t offset = 0; offset < len;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(&buffer[offset]);
+            offset += sizeof(inotify_event) + event->len;
+            changed = true;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // events were lost, including the creation of directories that need a watch
+                rewatch = true;
+            } else if (event->mask & IN_IGNORED) {
+                // the watched directory was removed or moved away
+                watches.erase(event->wd);
+                rewatch = true;
+            } else if ((event->mask & IN_ISDIR) and (event->mask & (IN_CREATE | IN_MOVED_TO)) and (event->len > 0)) {
+                const auto watch = watches.find(event->wd);
+                if (watch != watches.end()) {
+                    add_watch(watch->second / event->name, true);
+                }
+            }
+        }
+    }
+
+    if (rewatch) {
+        for (const auto& path : paths) {
+            add_watches(path);
+        }
+    }
+
+    if (changed) {
+        current_generation++;
+    }
+}
+
+void CertificateStoreWatcher::rewatch() {
+    watching = true;
+    for (const auto& path : paths) {
+        add_watches(path);
+    }
+
+    if (watching) {
+        // the changes while the store was not watched are unknown
+        current_generation++;
+        warned = false;
+        EVLOG_info << "Watching the certificate store again, queries are cached";
+    }
+}
+
+void CertificateStoreWatcher::stop_watching(const std::string& reason) {
+    if (not warned) {
+        EVLOG_warning << reason << ", certificate store queries will not be cached";
+        warned = true;
+    }
+    watching = false;
+}
+
+} // namespace main
+} // namespace module
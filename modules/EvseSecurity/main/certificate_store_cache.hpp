@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef MAIN_CERTIFICATE_STORE_CACHE_HPP
+#define MAIN_CERTIFICATE_STORE_CACHE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace module {
+namespace main {
+
+/*
+ Detects changes of the certificate store: the CA bundles, the certificate and key directories and the OCSP responses
+ stored next to the certificates.
+
+ Directories are watched recursively with inotify, for files the directory containing them is watched, so files that
+ are replaced or created later are detected as well. There is no watcher thread: pending events are read without
+ blocking whenever the generation is queried. The kernel queues an event before the call that changed the file
+ returns, so a query never misses a change that was completed before it.
+*/
+class CertificateStoreWatcher {
+public:
+    explicit CertificateStoreWatcher(const std::vector<std::filesystem::path>& paths);
+    ~CertificateStoreWatcher();
+
+    CertificateStoreWatcher(const CertificateStoreWatcher&) = delete;
+    CertificateStoreWatcher& operator=(const CertificateStoreWatcher&) = delete;
+
+    // false if the paths cannot be watched, nothing must be cached then. Watching is retried on every call, e.g. after
+    // a directory of the store was missing temporarily
+    bool is_watching();
+
+    // changes with every modification of the watched paths
+    std::uint64_t generation();
+
+    // for changes that have to be visible even before their inotify event was read
+    void invalidate();
+
+private:
+    // must be called with mutex held
+    void add_watches(const std::filesystem::path& path);
+    void add_watch(const std::filesystem::path& directory, bool recursive);
+    void read_events();
+    void rewatch();
+    void stop_watching(const std::string& reason);
+
+    std::mutex mutex;
+    const std::vector<std::filesystem::path> paths;
+    int inotify_fd{-1};
+    bool watching{false};
+    // the warning is logged once until watching works again
+    bool warned{false};
+    std::uint64_t current_generation{0};
+    // watched directories by watch descriptor
+    std::map<int, std::filesystem::path> watches;
+};
+
+/*
+ Results of queries to the certificate store, computed once and reused until the certificate store changes.
+
+ Without a working watcher every query is computed again. The max_age bounds how long a result is reused for queries
+ whose result depends on the current time, e.g. the verification of a certificate that expires.
+*/
+template <typename T> class CertificateQueryCache {
+public:
+    struct Statistics {
+        std::uint64_t hits{0};
+        std::uint64_t misses{0};
+    };
+
+    CertificateQueryCache(CertificateStoreWatcher& watcher, std::size_t max_entries,
+                          std::optional<std::chrono::steady_clock::duration> max_age = std::nullopt) :
+        watcher(watcher), max_entries(max_entries), max_age(max_age) {
+    }
+
+    T get(const std::string& key, const std::function<T()>& load) {
+        if (not watcher.is_watching()) {
+            // nothing is cached, concurrent queries do not have to wait for each other
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                statistics.misses++;
+            }
+            return load();
+        }
+
+        // misses are serialised, so concurrent identical queries do not all walk the certificate store
+        std::lock_guard<std::mutex> lock(mutex);
+
+        const auto generation = watcher.generation();
+        const auto now = std::chrono::steady_clock::now();
+
+        const auto entry = entries.find(key);
+        if (entry != entries.end()) {
+            if ((entry->second.generation == generation) and
+                (not max_age.has_value() or (now - entry->second.created < max_age.value()))) {
+                statistics.hits++;
+                return entry->second.value;
+            }
+            entries.erase(entry);
+        }
+
+        statistics.misses++;
+        auto value = load();
+
+        // the result is not stored if the store changed while it was computed
+        if (watcher.generation() == generation) {
+            if (entries.size() >= max_entries) {
+                evict(generation);
+            }
+            entries.insert_or_assign(key, Entry{value, generation, now});
+        }
+
+        return value;
+    }
+
+    Statistics get_statistics() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return statistics;
+    }
+
+private:
+    struct Entry {
+        T value;
+        std::uint64_t generation;
+        std::chrono::steady_clock::time_point created;
+    };
+
+    // removes outdated entries, or the oldest one if all are current
+    void evict(std::uint64_t generation) {
+        for (auto entry = entries.begin(); entry != entries.end();) {
+            if (entry->second.generation != generation) {
+                entry = entries.erase(entry);
+            } else {
+                ++entry;
+            }
+        }
+
+        if (entries.size() >= max_entries and not entries.empty()) {
+            auto oldest = entries.begin();
+            for (auto entry = entries.begin(); entry != entries.end(); ++entry) {
+                if (entry->second.created < oldest->second.created) {
+                    oldest = entry;
+                }
+            }
+            entries.erase(oldest);
+        }
+    }
+
+    CertificateStoreWatcher& watcher;
+    const std::size_t max_entries;
+    const std::optional<std::chrono::steady_clock::duration> max_age;
+
+    std::mutex mutex;
+    std::map<std::string, Entry> entries;
+    Statistics statistics;
+};
+
+} // namespace main
+} // namespace module
+
+#endif // MAIN_CERTIFICATE_STORE_CACHE_HPP
@@ -7,6 +7,15 @@
 namespace module {
 namespace main {
 
+// bounds the cached verification results, the validity of a certificate depends on the current time
+static constexpr auto verification_cache_max_age = std::chrono::seconds(60);
+static constexpr std::size_t verification_cache_size = 64;
+static constexpr std::size_t query_cache_size = 16;
+
+template <typename T> static std::string to_key(T value) {
+    return std::to_string(static_cast<int>(value));
+}
+
 void evse_securityImpl::init() {
 
     const auto certs_path = this->mod->info.paths.etc / "certs";
@@ -25,6 +34,25 @@ void evse_securityImpl::init() {
     }
 
     this->evse_security = std::make_unique<evse_security::EvseSecurity>(file_paths, private_key_password);
+
+    this->certificate_store_watcher = std::make_unique<CertificateStoreWatcher>(std::vector<std::filesystem::path>{
+        file_paths.csms_ca_bundle, file_paths.mf_ca_bundle, file_paths.mo_ca_bundle, file_paths.v2g_ca_bundle,
+        file_paths.csms_leaf_cert_directory, file_paths.csms_leaf_key_directory, file_paths.secc_leaf_cert_directory,
+        file_paths.secc_leaf_key_directory});
+    this->installed_certificates_cache =
+        std::make_unique<CertificateQueryCache<types::evse_security::GetInstalledCertificatesResult>>(
+            *this->certificate_store_watcher, query_cache_size);
+    this->v2g_ocsp_request_data_cache =
+        std::make_unique<CertificateQueryCache<types::evse_security::OCSPRequestDataList>>(
+            *this->certificate_store_watcher, 1);
+    this->mo_ocsp_request_data_cache =
+        std::make_unique<CertificateQueryCache<types::evse_security::OCSPRequestDataList>>(
+            *this->certificate_store_watcher, query_cache_size);
+    this->verification_cache =
+        std::make_unique<CertificateQueryCache<types::evse_security::CertificateValidationResult>>(
+            *this->certificate_store_watcher, verification_cache_size, verification_cache_max_age);
+    this->ca_installed_cache =
+        std::make_unique<CertificateQueryCache<bool>>(*this->certificate_store_watcher, query_cache_size);
 }
 
 void evse_securityImpl::ready() {
@@ -33,57 +61,75 @@ void evse_securityImpl::ready() {
 types::evse_security::InstallCertificateResult
 evse_securityImpl::handle_install_ca_certificate(std::string& certificate,
                                                  types::evse_security::CaCertificateType& certificate_type) {
-    return conversions::to_everest(
+    const auto result = conversions::to_everest(
         this->evse_security->install_ca_certificate(certificate, conversions::from_everest(certificate_type)));
+    this->certificate_store_watcher->invalidate();
+    return result;
 }
 
 types::evse_security::DeleteCertificateResult
 evse_securityImpl::handle_delete_certificate(types::evse_security::CertificateHashData& certificate_hash_data) {
-    return conversions::to_everest(
+    const auto result = conversions::to_everest(
         this->evse_security->delete_certificate(conversions::from_everest(certificate_hash_data)));
+    this->certificate_store_watcher->invalidate();
+    return result;
 }
 
 types::evse_security::InstallCertificateResult
 evse_securityImpl::handle_update_leaf_certificate(std::string& certificate_chain,
                                                   types::evse_security::LeafCertificateType& certificate_type) {
-    return conversions::to_everest(
+    const auto result = conversions::to_everest(
         this->evse_security->update_leaf_certificate(certificate_chain, conversions::from_everest(certificate_type)));
+    this->certificate_store_watcher->invalidate();
+    return result;
 }
 
 types::evse_security::CertificateValidationResult
 evse_securityImpl::handle_verify_certificate(std::string& certificate_chain,
                                              types::evse_security::LeafCertificateType& certificate_type) {
-    return conversions::to_everest(
-        this->evse_security->verify_certificate(certificate_chain, conversions::from_everest(certificate_type)));
+    return this->verification_cache->get(to_key(certificate_type) + "|" + certificate_chain, [&]() {
+        return conversions::to_everest(
+            this->evse_security->verify_certificate(certificate_chain, conversions::from_everest(certificate_type)));
+    });
 }
 
 types::evse_security::GetInstalledCertificatesResult evse_securityImpl::handle_get_installed_certificates(
     std::vector<types::evse_security::CertificateType>& certificate_types) {
     std::vector<evse_security::CertificateType> _certificate_types;
+    std::string key;
 
     for (const auto& certificate_type : certificate_types) {
         _certificate_types.push_back(conversions::from_everest(certificate_type));
+        key += to_key(certificate_type) + "|";
     }
 
-    return conversions::to_everest(this->evse_security->get_installed_certificates(_certificate_types));
+    return this->installed_certificates_cache->get(key, [&]() {
+        return conversions::to_everest(this->evse_security->get_installed_certificates(_certificate_types));
+    });
 }
 
 types::evse_security::OCSPRequestDataList evse_securityImpl::handle_get_v2g_ocsp_request_data() {
-    return conversions::to_everest(this->evse_security->get_v2g_ocsp_request_data());
+    return this->v2g_ocsp_request_data_cache->get(
+        "", [this]() { return conversions::to_everest(this->evse_security->get_v2g_ocsp_request_data()); });
 }
 
 types::evse_security::OCSPRequestDataList
 evse_securityImpl::handle_get_mo_ocsp_request_data(std::string& certificate_chain) {
-    return conversions::to_everest(this->evse_security->get_mo_ocsp_request_data(certificate_chain));
+    return this->mo_ocsp_request_data_cache->get(certificate_chain, [&]() {
+        return conversions::to_everest(this->evse_security->get_mo_ocsp_request_data(certificate_chain));
+    });
 }
 
 void evse_securityImpl::handle_update_ocsp_cache(types::evse_security::CertificateHashData& certificate_hash_data,
                                                  std::string& ocsp_response) {
     this->evse_security->update_ocsp_cache(conversions::from_everest(certificate_hash_data), ocsp_response);
+    this->certificate_store_watcher->invalidate();
 }
 
 bool evse_securityImpl::handle_is_ca_certificate_installed(types::evse_security::CaCertificateType& certificate_type) {
-    return this->evse_security->is_ca_certificate_installed(conversions::from_everest(certificate_type));
+    return this->ca_installed_cache->get(to_key(certificate_type), [&]() {
+        return this->evse_security->is_ca_certificate_installed(conversions::from_everest(certificate_type));
+    });
 }
 
 types::evse_security::GetCertificateSignRequestResult evse_securityImpl::handle_generate_certificate_signing_request(
@@ -93,6 +139,7 @@ types::evse_security::GetCertificateSignRequestResult evse_securityImpl::handle_
 
     auto csr_response = this->evse_security->generate_certificate_signing_request(
         conversions::from_everest(certificate_type), country, organization, common, use_tpm);
+    this->certificate_store_watcher->invalidate();
 
     response.status = conversions::to_everest(csr_response.status);
 
@@ -14,7 +14,11 @@
 
 // ev@75ac1216-19eb-4182-a85c-820f1fc2c091:v1
 // insert your custom include headers here
+#include <memory>
+
 #include <evse_security/evse_security.hpp>
+
+#include "certificate_store_cache.hpp"
 // ev@75ac1216-19eb-4182-a85c-820f1fc2c091:v1
 
 namespace module {
@@ -79,6 +83,15 @@ private:
     // ev@3370e4dd-95f4-47a9-aaec-ea76f34a66c9:v1
     // insert your private definitions here
     std::unique_ptr<evse_security::EvseSecurity> evse_security;
+
+    // results of the queries that walk and parse the certificate store, reused until the store changes
+    std::unique_ptr<CertificateStoreWatcher> certificate_store_watcher;
+    std::unique_ptr<CertificateQueryCache<types::evse_security::GetInstalledCertificatesResult>>
+        installed_certificates_cache;
+    std::unique_ptr<CertificateQueryCache<types::evse_security::OCSPRequestDataList>> v2g_ocsp_request_data_cache;
+    std::unique_ptr<CertificateQueryCache<types::evse_security::OCSPRequestDataList>> mo_ocsp_request_data_cache;
+    std::unique_ptr<CertificateQueryCache<types::evse_security::CertificateValidationResult>> verification_cache;
+    std::unique_ptr<CertificateQueryCache<bool>> ca_installed_cache;
     // ev@3370e4dd-95f4-47a9-aaec-ea76f34a66c9:v1
 };
 
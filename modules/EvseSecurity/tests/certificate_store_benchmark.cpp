@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+// Cost of the certificate store queries OCPP issues periodically, with 100 to 1000 installed CA certificates.
+// Compares the queries of libevse-security, which walk and parse the certificate store on every call, with the
+// cached queries of the module.
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+
+#include <evse_security/evse_security.hpp>
+
+#include "certificate_store_cache.hpp"
+
+namespace {
+
+constexpr int c_iterations = 20;
+
+using EVP_PKEY_ptr = std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)>;
+using X509_ptr = std::unique_ptr<X509, decltype(&X509_free)>;
+
+EVP_PKEY_ptr generate_key() {
+    EVP_PKEY_ptr key(EVP_PKEY_new(), &EVP_PKEY_free);
+    EC_KEY* ec_key = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1);
+    EC_KEY_generate_key(ec_key);
+    EVP_PKEY_assign_EC_KEY(key.get(), ec_key);
+    return key;
+}
+
+// self signed CA certificate, PEM encoded
+std::string make_root_certificate(EVP_PKEY* key, int serial) {
+    X509_ptr cert(X509_new(), &X509_free);
+    X509_set_version(cert.get(), 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert.get()), serial);
+    X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert.get()), 60L * 60 * 24 * 365);
+    X509_set_pubkey(cert.get(), key);
+
+    X509_NAME* name = X509_get_subject_name(cert.get());
+    const auto common_name = fmt::format("Benchmark Root CA {}", serial);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>(common_name.c_str()),
+                               -1, -1, 0);
+    X509_set_issuer_name(cert.get(), name);
+
+    X509_EXTENSION* ext = X509V3_EXT_conf_nid(nullptr, nullptr, NID_basic_constraints, "critical,CA:TRUE");
+    X509_add_ext(cert.get(), ext, -1);
+    X509_EXTENSION_free(ext);
+
+    X509_sign(cert.get(), key, EVP_sha256());
+
+    BIO* bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_X509(bio, cert.get());
+    char* data = nullptr;
+    const auto len = BIO_get_mem_data(bio, &data);
+    std::string pem(data, len);
+    BIO_free(bio);
+    return pem;
+}
+
+evse_security::FilePaths create_store(const std::filesystem::path& root, int certificates) {
+    std::filesystem::remove_all(root);
+    evse_security::FilePaths paths = {root / "ca" / "csms" / "CSMS_ROOT_CA.pem",
+                                      root / "ca" / "mf" / "MF_ROOT_CA.pem",
+                                      root / "ca" / "mo" / "MO_ROOT_CA.pem",
+                                      root / "ca" / "v2g" / "V2G_ROOT_CA.pem",
+                                      root / "client" / "csms",
+                                      root / "client" / "csms",
+                                      root / "client" / "cso",
+                                      root / "client" / "cso"};
+
+    const auto key = generate_key();
+    int serial = 1;
+    for (const auto& bundle : {paths.csms_ca_bundle, paths.mf_ca_bundle, paths.mo_ca_bundle}) {
+        std::filesystem::create_directories(bundle.parent_path());
+        std::ofstream(bundle) << make_root_certificate(key.get(), serial++);
+    }
+
+    // the installed CA certificates are in the V2G bundle
+    std::filesystem::create_directories(paths.v2g_ca_bundle.parent_path());
+    std::ofstream v2g_bundle(paths.v2g_ca_bundle);
+    for (int i = 0; i < certificates; ++i) {
+        v2g_bundle << make_root_certificate(key.get(), serial++);
+    }
+
+    std::filesystem::create_directories(paths.csms_leaf_cert_directory);
+    std::filesystem::create_directories(paths.secc_leaf_cert_directory);
+    return paths;
+}
+
+// mean time of a query, the first call is not measured, it fills the caches
+double measure_us(const std::function<void()>& query) {
+    query();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < c_iterations; ++i) {
+        query();
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / c_iterations;
+}
+
+void run(const std::filesystem::path& root, int certificates) {
+    const auto paths = create_store(root, certificates);
+    evse_security::EvseSecurity store(paths, std::nullopt);
+
+    module::main::CertificateStoreWatcher watcher(
+        {paths.csms_ca_bundle, paths.mf_ca_bundle, paths.mo_ca_bundle, paths.v2g_ca_bundle,
+         paths.csms_leaf_cert_directory, paths.csms_leaf_key_directory, paths.secc_leaf_cert_directory,
+         paths.secc_leaf_key_directory});
+    module::main::CertificateQueryCache<evse_security::GetInstalledCertificatesResult> installed_cache(watcher, 16);
+    module::main::CertificateQueryCache<evse_security::OCSPRequestDataList> ocsp_cache(watcher, 1);
+    module::main::CertificateQueryCache<bool> installed_ca_cache(watcher, 16);
+
+    const std::vector<evse_security::CertificateType> types = {
+        evse_security::CertificateType::V2GRootCertificate, evse_security::CertificateType::MORootCertificate,
+        evse_security::CertificateType::CSMSRootCertificate, evse_security::CertificateType::V2GCertificateChain,
+        evse_security::CertificateType::MFRootCertificate};
+
+    std::size_t installed = 0;
+    const auto installed_direct = measure_us([&]() {
+        installed = store.get_installed_certificates(types).certificate_hash_data_chain.size();
+    });
+    const auto installed_cached = measure_us([&]() {
+        installed_cache.get("all", [&]() { return store.get_installed_certificates(types); });
+    });
+
+    const auto ocsp_direct = measure_us([&]() { store.get_v2g_ocsp_request_data(); });
+    const auto ocsp_cached =
+        measure_us([&]() { ocsp_cache.get("", [&]() { return store.get_v2g_ocsp_request_data(); }); });
+
+    const auto ca_direct =
+        measure_us([&]() { store.is_ca_certificate_installed(evse_security::CaCertificateType::V2G); });
+    const auto ca_cached = measure_us([&]() {
+        installed_ca_cache.get(
+            "v2g", [&]() { return store.is_ca_certificate_installed(evse_security::CaCertificateType::V2G); });
+    });
+
+    // every query after a change of the store
+    const auto installed_after_change = measure_us([&]() {
+        watcher.invalidate();
+        installed_cache.get("all", [&]() { return store.get_installed_certificates(types); });
+    });
+
+    fmt::print("{:>5} certificates ({:>4} installed): get_installed_certificates {:>10.1f} us direct {:>6.1f} us "
+               "cached {:>10.1f} us after change | get_v2g_ocsp_request_data {:>8.1f} us direct {:>6.1f} us cached | "
+               "is_ca_certificate_installed {:>10.1f} us direct {:>6.1f} us cached\n",
+               certificates, installed, installed_direct, installed_cached, installed_after_change, ocsp_direct,
+               ocsp_cached, ca_direct, ca_cached);
+}
+
+} // namespace
+
+int main() {
+    const auto root = std::filesystem::temp_directory_path() / "certificate_store_benchmark";
+
+    for (const auto certificates : {100, 250, 500, 1000}) {
+        run(root, certificates);
+    }
+
+    std::filesystem::remove_all(root);
+    return 0;
+}
@@ -0,0 +1,192 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "certificate_store_cache.hpp"
+
+namespace {
+
+using module::main::CertificateQueryCache;
+using module::main::CertificateStoreWatcher;
+
+void write_file(const std::filesystem::path& file, const std::string& content) {
+    std::ofstream out(file);
+    out << content;
+}
+
+class CertificateStoreCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root = std::filesystem::temp_directory_path() /
+               ("certificate_store_cache_test_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) +
+                "_" + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(root / "ca" / "v2g");
+        std::filesystem::create_directories(root / "client" / "cso");
+        write_file(root / "ca" / "v2g" / "V2G_ROOT_CA.pem", "root");
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(root);
+    }
+
+    std::vector<std::filesystem::path> paths() const {
+        return {root / "ca" / "v2g" / "V2G_ROOT_CA.pem", root / "client" / "cso"};
+    }
+
+    // counts the loads, returns the number of the load
+    std::function<int()> loader() {
+        return [this]() { return ++loads; };
+    }
+
+    std::filesystem::path root;
+    int loads{0};
+};
+
+TEST_F(CertificateStoreCacheTest, reused_until_the_store_changes) {
+    CertificateStoreWatcher watcher(paths());
+    ASSERT_TRUE(watcher.is_watching());
+    CertificateQueryCache<int> cache(watcher, 4);
+
+    EXPECT_EQ(cache.get("a", loader()), 1);
+    EXPECT_EQ(cache.get("a", loader()), 1);
+    EXPECT_EQ(cache.get("b", loader()), 2);
+    EXPECT_EQ(cache.get("b", loader()), 2);
+
+    // new leaf certificate
+    write_file(root / "client" / "cso" / "SECC_LEAF.pem", "leaf");
+    EXPECT_EQ(cache.get("a", loader()), 3);
+    EXPECT_EQ(cache.get("a", loader()), 3);
+
+    // the bundle is replaced
+    write_file(root / "ca" / "v2g" / "V2G_ROOT_CA.pem.tmp", "new root");
+    std::filesystem::rename(root / "ca" / "v2g" / "V2G_ROOT_CA.pem.tmp", root / "ca" / "v2g" / "V2G_ROOT_CA.pem");
+    EXPECT_EQ(cache.get("a", loader()), 4);
+
+    std::filesystem::remove(root / "client" / "cso" / "SECC_LEAF.pem");
+    EXPECT_EQ(cache.get("a", loader()), 5);
+
+    watcher.invalidate();
+    EXPECT_EQ(cache.get("a", loader()), 6);
+    EXPECT_EQ(cache.get("b", loader()), 7);
+
+    const auto statistics = cache.get_statistics();
+    EXPECT_EQ(statistics.hits, 3);
+    EXPECT_EQ(statistics.misses, 7);
+}
+
+TEST_F(CertificateStoreCacheTest, new_directories_are_watched) {
+    CertificateStoreWatcher watcher(paths());
+    CertificateQueryCache<int> cache(watcher, 4);
+
+    std::filesystem::create_directories(root / "client" / "cso" / "ocsp");
+    EXPECT_EQ(cache.get("a", loader()), 1);
+
+    write_file(root / "client" / "cso" / "ocsp" / "response.der", "ocsp");
+    EXPECT_EQ(cache.get("a", loader()), 2);
+
+    // the directory is removed and created again
+    std::filesystem::remove_all(root / "client" / "cso");
+    EXPECT_EQ(cache.get("a", loader()), 3);
+    std::filesystem::create_directories(root / "client" / "cso");
+    EXPECT_EQ(cache.get("a", loader()), 4);
+    write_file(root / "client" / "cso" / "SECC_LEAF.pem", "leaf");
+    EXPECT_EQ(cache.get("a", loader()), 5);
+    EXPECT_TRUE(watcher.is_watching());
+}
+
+TEST_F(CertificateStoreCacheTest, changes_while_loading_are_not_cached) {
+    CertificateStoreWatcher watcher(paths());
+    CertificateQueryCache<int> cache(watcher, 4);
+
+    EXPECT_EQ(cache.get("a",
+                        [this]() {
+                            write_file(root / "client" / "cso" / "SECC_LEAF.pem", "leaf");
+                            return ++loads;
+                        }),
+              1);
+    EXPECT_EQ(cache.get("a", loader()), 2);
+    EXPECT_EQ(cache.get("a", loader()), 2);
+}
+
+TEST_F(CertificateStoreCacheTest, max_age_and_size) {
+    CertificateStoreWatcher watcher(paths());
+    CertificateQueryCache<int> cache(watcher, 2, std::chrono::milliseconds(50));
+
+    EXPECT_EQ(cache.get("a", loader()), 1);
+    EXPECT_EQ(cache.get("a", loader()), 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_EQ(cache.get("a", loader()), 2);
+
+    // the oldest entry is dropped
+    EXPECT_EQ(cache.get("b", loader()), 3);
+    EXPECT_EQ(cache.get("c", loader()), 4);
+    EXPECT_EQ(cache.get("c", loader()), 4);
+    EXPECT_EQ(cache.get("b", loader()), 3);
+    EXPECT_EQ(cache.get("a", loader()), 5);
+}
+
+TEST_F(CertificateStoreCacheTest, nothing_is_cached_without_watcher) {
+    CertificateStoreWatcher watcher({root / "does" / "not" / "exist.pem"});
+    EXPECT_FALSE(watcher.is_watching());
+    CertificateQueryCache<int> cache(watcher, 4);
+
+    EXPECT_EQ(cache.get("a", loader()), 1);
+    EXPECT_EQ(cache.get("a", loader()), 2);
+}
+
+TEST_F(CertificateStoreCacheTest, watching_is_retried) {
+    CertificateStoreWatcher watcher(paths());
+    CertificateQueryCache<int> cache(watcher, 4);
+    EXPECT_EQ(cache.get("a", loader()), 1);
+
+    // the directory and its parent are gone for a while
+    std::filesystem::remove_all(root / "client");
+    EXPECT_FALSE(watcher.is_watching());
+    EXPECT_EQ(cache.get("a", loader()), 2);
+    EXPECT_EQ(cache.get("a", loader()), 3);
+
+    std::filesystem::create_directories(root / "client" / "cso");
+    EXPECT_TRUE(watcher.is_watching());
+    EXPECT_EQ(cache.get("a", loader()), 4);
+    EXPECT_EQ(cache.get("a", loader()), 4);
+    write_file(root / "client" / "cso" / "SECC_LEAF.pem", "leaf");
+    EXPECT_EQ(cache.get("a", loader()), 5);
+}
+
+TEST_F(CertificateStoreCacheTest, uncached_queries_run_concurrently) {
+    CertificateStoreWatcher watcher({root / "does" / "not" / "exist.pem"});
+    CertificateQueryCache<int> cache(watcher, 4);
+
+    std::atomic<int> running{0};
+    std::atomic<int> max_running{0};
+    const auto load = [&running, &max_running]() {
+        const auto now_running = ++running;
+        int expected = max_running;
+        while (now_running > expected and not max_running.compare_exchange_weak(expected, now_running)) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        running--;
+        return 0;
+    };
+
+    std::vector<std::thread> queries;
+    for (int i = 0; i < 4; i++) {
+        queries.emplace_back([&cache, &load]() { cache.get("a", load); });
+    }
+    for (auto& query : queries) {
+        query.join();
+    }
+    EXPECT_GT(max_running, 1);
+    EXPECT_EQ(cache.get_statistics().misses, 4);
+}
+
+} // namespace
@@ -45,6 +45,10 @@ void EvseV2G::init() {
     v2g_ctx->tls_server = &tls_server;
 #endif // EVEREST_MBED_TLS
 
+    /* the tracer thread is started by the setup command if debug mode is enabled */
+    tracer.configure_sampling(config.v2g_message_trace_sampling);
+    v2g_ctx->tracer = &tracer;
+
     invoke_init(*p_charger);
 }
 
@@ -77,21 +81,47 @@ void EvseV2G::ready() {
 
     invoke_ready(*p_charger);
 
-    rv = sdp_listen(v2g_ctx);
+    if (v2g_ctx->connection_event_loop) {
+        rv = connection_event_loop(v2g_ctx);
 
-    if (rv == -1) {
-        dlog(DLOG_LEVEL_ERROR, "sdp_listen() failed");
-        goto err_out;
+        if (rv == -1) {
+            dlog(DLOG_LEVEL_ERROR, "connection_event_loop() failed");
+            goto err_out;
+        }
+    } else {
+        rv = sdp_listen(v2g_ctx);
+
+        if (rv == -1) {
+            dlog(DLOG_LEVEL_ERROR, "sdp_listen() failed");
+            goto err_out;
+        }
     }
 
     return;
 
 err_out:
+#ifndef EVEREST_MBED_TLS
+    tls_server.stop_update_on_change();
+#endif // EVEREST_MBED_TLS
     v2g_ctx_free(v2g_ctx);
 }
 
 EvseV2G::~EvseV2G() {
+#ifndef EVEREST_MBED_TLS
+    // the watcher rebuilds the TLS configuration from v2g_ctx
+    tls_server.stop_update_on_change();
+#endif // EVEREST_MBED_TLS
     v2g_ctx_free(v2g_ctx);
 }
 
+void EvseV2G::enable_v2g_message_tracing(bool enable) {
+    if (enable) {
+        tracer.start([this](const types::iso15118_charger::V2gMessages& v2g_message) {
+            p_charger->publish_v2g_messages(v2g_message);
+        });
+    } else {
+        tracer.stop();
+    }
+}
+
 } // namespace module
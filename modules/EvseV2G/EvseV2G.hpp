@@ -19,6 +19,7 @@
 // ev@4bf81b14-a215-475c-a1d3-0a484ae48918:v1
 // insert your custom include headers here
 #include "v2g_ctx.hpp"
+#include "v2g_trace.hpp"
 #ifndef EVEREST_MBED_TLS
 #include <tls.hpp>
 #endif // EVEREST_MBED_TLS
@@ -35,10 +36,13 @@ struct Conf {
     bool tls_key_logging;
     std::string tls_key_logging_path;
     int tls_timeout;
+    int tls_session_timeout;
     bool verify_contract_cert_chain;
     int auth_timeout_pnc;
     int auth_timeout_eim;
     bool enable_sdp_server;
+    bool connection_event_loop;
+    std::string v2g_message_trace_sampling;
 };
 
 class EvseV2G : public Everest::ModuleBase {
@@ -60,6 +64,8 @@ public:
 
     // ev@1fce4c5e-0ab8-41bb-90f7-14277703d2ac:v1
     ~EvseV2G();
+    // starts or stops the thread publishing the V2G messages in debug mode
+    void enable_v2g_message_tracing(bool enable);
     // ev@1fce4c5e-0ab8-41bb-90f7-14277703d2ac:v1
 
 protected:
@@ -77,6 +83,7 @@ private:
 #ifndef EVEREST_MBED_TLS
     tls::Server tls_server;
 #endif // EVEREST_MBED_TLS
+    V2gTracer tracer;
     // ev@211cfdbe-f69a-4cd6-a4ec-f8aaa3d1b6c8:v1
 };
 
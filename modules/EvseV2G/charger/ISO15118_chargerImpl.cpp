@@ -53,6 +53,9 @@ void ISO15118_chargerImpl::init() {
     }
 
     v2g_ctx->network_read_timeout_tls = mod->config.tls_timeout;
+    v2g_ctx->tls_session_timeout = static_cast<uint32_t>(mod->config.tls_session_timeout);
+
+    v2g_ctx->connection_event_loop = mod->config.connection_event_loop;
 
     v2g_ctx->certs_path = mod->info.paths.etc / CERTS_SUB_DIR;
 
@@ -134,6 +137,7 @@ void ISO15118_chargerImpl::handle_setup(
     }
 
     v2g_ctx->debugMode = debug_mode;
+    mod->enable_v2g_message_tracing(debug_mode);
 
     if (sae_j2847_mode == BidiMode::V2H || sae_j2847_mode == BidiMode::V2G) {
         struct iso2_ServiceType sae_service;
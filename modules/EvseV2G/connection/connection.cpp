@@ -8,23 +8,33 @@
 #include "tools.hpp"
 #include "v2g_server.hpp"
 
+#include "sdp.hpp"
+
 #include <arpa/inet.h>
+#include <condition_variable>
 #include <cstring>
 #include <ctype.h>
+#include <deque>
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <fstream>
 #include <inttypes.h>
 #include <iostream>
+#include <mutex>
 #include <net/if.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <time.h>
 #include <unistd.h>
+#include <vector>
 
 #ifdef EVEREST_MBED_TLS
 #include <mbedtls/debug.h>
@@ -39,6 +49,12 @@
 #define DEFAULT_TLS_PORT              64109
 #define ERROR_SESSION_ALREADY_STARTED 2
 
+/* graceful close of a finished TCP connection: wait for the EV to close first, then shutdown() and wait again */
+#define CONNECTION_CLOSE_WAIT_FOR_PEER_MS 2000
+#define CONNECTION_CLOSE_SHUTDOWN_MS      3000
+#define EVENT_LOOP_MAX_EVENTS             8
+#define EVENT_LOOP_POLL_TIMEOUT_MS        100
+
 #ifdef EVEREST_MBED_TLS
 #define MBEDTLS_DEBUG_LEVEL_VERBOSE  4
 #define MBEDTLS_DEBUG_LEVEL_NO_DEBUG 0
@@ -374,17 +390,10 @@ ssize_t connection_read(struct v2g_connection* conn, unsigned char* buf, size_t
             return -1;
 #endif // EVEREST_MBED_TLS
         } else {
-            /* use select for timeout handling */
-            struct timeval tv;
-            fd_set read_fds;
-
-            FD_ZERO(&read_fds);
-            FD_SET(conn->conn.socket_fd, &read_fds);
-
-            tv.tv_sec = conn->ctx->network_read_timeout / 1000;
-            tv.tv_usec = (conn->ctx->network_read_timeout % 1000) * 1000;
+            /* use poll for timeout handling */
+            struct pollfd pollfd = {conn->conn.socket_fd, POLLIN, 0};
 
-            num_of_bytes = select(conn->conn.socket_fd + 1, &read_fds, nullptr, nullptr, &tv);
+            num_of_bytes = poll(&pollfd, 1, conn->ctx->network_read_timeout);
 
             if (num_of_bytes == -1) {
                 if (errno == EINTR)
@@ -697,26 +706,34 @@ reset:
 }
 #endif // EVEREST_MBED_TLS
 
+/**
+ * Handles the v2g-session of a TCP connection, if no other session is running.
+ * Returns \c ERROR_SESSION_ALREADY_STARTED if the connection was rejected, otherwise \c 0.
+ */
+static int connection_handle_tcp_session(struct v2g_connection* conn) {
+    /* check if the v2g-session is already running in another thread, if not, handle v2g-connection */
+    if (conn->ctx->state == 0) {
+        int rv = v2g_handle_connection(conn);
+
+        if (rv != 0) {
+            dlog(DLOG_LEVEL_INFO, "v2g_handle_connection exited with %d", rv);
+        }
+        return 0;
+    }
+
+    dlog(DLOG_LEVEL_WARNING, "%s", "Closing tcp-connection. v2g-session is already running");
+    return ERROR_SESSION_ALREADY_STARTED;
+}
+
 /**
  * This is the 'main' function of a thread, which handles a TCP connection.
  */
 static void* connection_handle_tcp(void* data) {
     struct v2g_connection* conn = static_cast<struct v2g_connection*>(data);
-    int rv = 0;
 
     dlog(DLOG_LEVEL_INFO, "Started new TCP connection thread");
 
-    /* check if the v2g-session is already running in another thread, if not, handle v2g-connection */
-    if (conn->ctx->state == 0) {
-        int rv2 = v2g_handle_connection(conn);
-
-        if (rv2 != 0) {
-            dlog(DLOG_LEVEL_INFO, "v2g_handle_connection exited with %d", rv2);
-        }
-    } else {
-        rv = ERROR_SESSION_ALREADY_STARTED;
-        dlog(DLOG_LEVEL_WARNING, "%s", "Closing tcp-connection. v2g-session is already running");
-    }
+    int rv = connection_handle_tcp_session(conn);
 
     /* tear down connection gracefully */
     dlog(DLOG_LEVEL_INFO, "Closing TCP connection");
@@ -998,6 +1015,8 @@ static void* connection_server(void* data) {
             }
         }
 
+        clock_gettime(CLOCK_MONOTONIC, &conn->ts_accepted);
+
         if (inet_ntop(AF_INET6, &addr, client_addr, sizeof(client_addr)) != NULL) {
             dlog(DLOG_LEVEL_INFO, "Incoming connection on %s from [%s]:%" PRIu16, ctx->if_name, client_addr,
                  ntohs(addr.sin6_port));
@@ -1033,7 +1052,7 @@ thread_exit:
 int connection_start_servers(struct v2g_context* ctx) {
     int rv, tcp_started = 0;
 
-    if (ctx->tcp_socket != -1) {
+    if ((ctx->tcp_socket != -1) && !ctx->connection_event_loop) {
         rv = pthread_create(&ctx->tcp_thread, NULL, connection_server, ctx);
         if (rv != 0) {
             dlog(DLOG_LEVEL_ERROR, "pthread_create(tcp) failed: %s", strerror(errno));
@@ -1044,6 +1063,10 @@ int connection_start_servers(struct v2g_context* ctx) {
 
     if (ctx->tls_socket.fd != -1) {
 #ifdef EVEREST_MBED_TLS
+        if (ctx->connection_event_loop) {
+            /* TLS connections are accepted by connection_event_loop() */
+            return 0;
+        }
         rv = pthread_create(&ctx->tls_thread, NULL, connection_server, ctx);
 #else
         rv = tls::connection_start_server(ctx);
@@ -1061,6 +1084,418 @@ int connection_start_servers(struct v2g_context* ctx) {
     return 0;
 }
 
+/*
+ * Event loop mode: one thread waits with epoll on the listening sockets, the SDP socket and all connections which
+ * are being closed. Accepted connections are handed over to session worker threads, which are kept for the next
+ * connection instead of being created and destroyed for every connection. After the session has ended, the worker
+ * hands the connection back to the event loop, which closes it as soon as the EV has closed its side. Like in
+ * connection_handle_tcp(), connection_teardown() is called after the socket was closed.
+ *
+ * With OpenSSL, TLS connections are accepted and handled by the threads of the TLS server
+ * (tls::connection_start_server()), only MbedTLS connections are accepted by the event loop.
+ */
+
+/* close states of a finished TCP connection */
+enum connection_close_state {
+    CONNECTION_CLOSE_WAIT_FOR_PEER, /* wait for the EV to close the connection */
+    CONNECTION_CLOSE_SHUTDOWN,      /* shutdown() was called, wait for the EV to acknowledge it */
+};
+
+/* a TCP connection whose session has ended */
+struct finished_connection {
+    struct v2g_connection* conn;
+    bool teardown; /* false if the connection was rejected because another session was running */
+};
+
+struct closing_connection {
+    int fd;
+    struct finished_connection finished;
+    enum connection_close_state state;
+    struct timespec deadline;
+};
+
+static struct {
+    std::mutex lock;
+    std::condition_variable cv;
+    std::deque<struct v2g_connection*> pending; /* accepted connections waiting for a session worker */
+    std::vector<finished_connection> finished;  /* finished sessions, to be closed by the event loop */
+    int idle_workers = 0;
+    bool stop = false;
+    int wake_fd = -1; /* eventfd to wake up the event loop if a session has finished */
+} session_workers;
+
+/**
+ * Closes the socket of a finished TCP connection, then cleans up and notifies lower layers.
+ */
+static void connection_release(const struct finished_connection& finished) {
+    if (close(finished.conn->conn.socket_fd) == -1) {
+        dlog(DLOG_LEVEL_ERROR, "close() failed: %s", strerror(errno));
+    }
+    dlog(DLOG_LEVEL_INFO, "TCP connection closed gracefully");
+
+    if (finished.teardown) {
+        connection_teardown(finished.conn);
+    }
+    free(finished.conn);
+}
+
+/**
+ * This is the 'main' function of a session worker thread. It handles one connection after another.
+ */
+static void* connection_session_worker(void* data) {
+    std::unique_lock<std::mutex> lock(session_workers.lock);
+
+    while (1) {
+        session_workers.idle_workers++;
+        session_workers.cv.wait(lock, [] { return session_workers.stop || !session_workers.pending.empty(); });
+        session_workers.idle_workers--;
+
+        if (session_workers.stop) {
+            break;
+        }
+
+        struct v2g_connection* conn = session_workers.pending.front();
+        session_workers.pending.pop_front();
+        lock.unlock();
+
+        struct timespec ts_now;
+        if (clock_gettime(CLOCK_MONOTONIC, &ts_now) == 0) {
+            dlog(DLOG_LEVEL_DEBUG, "Session worker started %lld us after accepting the connection",
+                 timespec_to_us(timespec_sub(ts_now, conn->ts_accepted)));
+        }
+
+        if (conn->is_tls_connection) {
+            /* closes the socket and frees conn */
+            connection_handle_tls(conn);
+            lock.lock();
+            continue;
+        }
+
+        const struct finished_connection finished = {
+            conn, connection_handle_tcp_session(conn) != ERROR_SESSION_ALREADY_STARTED};
+
+        lock.lock();
+        if (session_workers.stop) {
+            connection_release(finished);
+            continue;
+        }
+        session_workers.finished.push_back(finished);
+        const uint64_t one = 1;
+        if (write(session_workers.wake_fd, &one, sizeof(one)) == -1) {
+            dlog(DLOG_LEVEL_ERROR, "write(eventfd) failed: %s", strerror(errno));
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * Hands an accepted connection over to an idle session worker. Starts a new worker if all are busy.
+ */
+static int connection_dispatch(struct v2g_connection* conn) {
+    std::lock_guard<std::mutex> lock(session_workers.lock);
+
+    if (session_workers.idle_workers <= static_cast<int>(session_workers.pending.size())) {
+        pthread_attr_t attr;
+        pthread_t thread_id;
+        int rv;
+
+        /* workers live until the event loop stops, so they are not joined */
+        if (pthread_attr_init(&attr) != 0) {
+            dlog(DLOG_LEVEL_ERROR, "pthread_attr_init failed: %s", strerror(errno));
+            return -1;
+        }
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        rv = pthread_create(&thread_id, &attr, connection_session_worker, nullptr);
+        pthread_attr_destroy(&attr);
+        if (rv != 0) {
+            dlog(DLOG_LEVEL_ERROR, "pthread_create() failed: %s", strerror(rv));
+            return -1;
+        }
+    }
+
+    session_workers.pending.push_back(conn);
+    session_workers.cv.notify_one();
+    return 0;
+}
+
+/**
+ * Accepts all pending connections on a non-blocking listening socket.
+ */
+static void connection_accept(struct v2g_context* ctx, int listen_fd, bool is_tls_connection) {
+    while (1) {
+        char client_addr[INET6_ADDRSTRLEN];
+        struct sockaddr_in6 addr;
+        socklen_t addrlen = sizeof(addr);
+
+        /* accepted sockets are blocking, sessions are handled in worker threads */
+        int fd = accept4(listen_fd, (struct sockaddr*)&addr, &addrlen, SOCK_CLOEXEC);
+        if (fd == -1) {
+            if (errno == EINTR)
+                continue;
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+                dlog(DLOG_LEVEL_ERROR, "Accept(%s) failed: %s", is_tls_connection ? "tls" : "tcp", strerror(errno));
+            return;
+        }
+
+        struct v2g_connection* conn = static_cast<v2g_connection*>(calloc(1, sizeof(*conn)));
+        if (!conn) {
+            dlog(DLOG_LEVEL_ERROR, "Calloc failed: %s", strerror(errno));
+            close(fd);
+            return;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &conn->ts_accepted);
+        conn->ctx = ctx;
+        conn->read = &connection_read;
+        conn->write = &connection_write;
+        conn->is_tls_connection = is_tls_connection;
+
+        if (is_tls_connection) {
+#ifdef EVEREST_MBED_TLS
+            conn->conn.ssl.ssl_config = &ctx->ssl_config;
+            mbedtls_net_init(&conn->conn.ssl.tls_client_fd);
+            conn->conn.ssl.tls_client_fd.fd = fd;
+#endif // EVEREST_MBED_TLS
+        } else {
+            conn->conn.socket_fd = fd;
+        }
+
+        if (inet_ntop(AF_INET6, &addr.sin6_addr, client_addr, sizeof(client_addr)) != NULL) {
+            dlog(DLOG_LEVEL_INFO, "Incoming connection on %s from [%s]:%" PRIu16, ctx->if_name, client_addr,
+                 ntohs(addr.sin6_port));
+        } else {
+            dlog(DLOG_LEVEL_ERROR, "Incoming connection on %s, but inet_ntop failed: %s", ctx->if_name,
+                 strerror(errno));
+        }
+
+        // store the port to create a udp socket
+        ctx->udp_port = ntohs(addr.sin6_port);
+
+        if (connection_dispatch(conn) != 0) {
+            close(fd);
+            free(conn);
+        }
+    }
+}
+
+static int event_loop_add(int epoll_fd, int fd, uint32_t events) {
+    struct epoll_event ev = {};
+    ev.events = events;
+    ev.data.fd = fd;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        dlog(DLOG_LEVEL_ERROR, "epoll_ctl(%d) failed: %s", fd, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+
+    if ((flags == -1) || (fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1)) {
+        dlog(DLOG_LEVEL_ERROR, "fcntl(O_NONBLOCK) failed: %s", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static void connection_close(int epoll_fd, std::vector<closing_connection>& closing, std::size_t idx) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, closing[idx].fd, nullptr);
+    connection_release(closing[idx].finished);
+
+    closing[idx] = closing.back();
+    closing.pop_back();
+}
+
+/**
+ * Handles events on a closing connection. Returns \c true if the EV has closed its side.
+ */
+static bool connection_closing_event(int fd, uint32_t events) {
+    unsigned char buf[256];
+
+    if (events & (EPOLLHUP | EPOLLERR)) {
+        return true;
+    }
+
+    /* discard whatever the EV still sends until it closes the connection */
+    while (1) {
+        ssize_t rv = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (rv > 0)
+            continue;
+        if ((rv == -1) && (errno == EINTR))
+            continue;
+        return !((rv == -1) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)));
+    }
+}
+
+int connection_event_loop(struct v2g_context* ctx) {
+    struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+    std::vector<closing_connection> closing;
+    int tls_fd = -1;
+    int rv = -1;
+
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd == -1) {
+        dlog(DLOG_LEVEL_ERROR, "epoll_create1() failed: %s", strerror(errno));
+        return -1;
+    }
+
+    {
+        /* the event loop may be started again after it returned */
+        std::lock_guard<std::mutex> lock(session_workers.lock);
+        session_workers.stop = false;
+    }
+
+    session_workers.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (session_workers.wake_fd == -1) {
+        dlog(DLOG_LEVEL_ERROR, "eventfd() failed: %s", strerror(errno));
+        goto out;
+    }
+    if (event_loop_add(epoll_fd, session_workers.wake_fd, EPOLLIN) == -1) {
+        goto out;
+    }
+
+    if (ctx->tcp_socket != -1) {
+        if ((set_nonblocking(ctx->tcp_socket) == -1) || (event_loop_add(epoll_fd, ctx->tcp_socket, EPOLLIN) == -1)) {
+            goto out;
+        }
+    }
+
+#ifdef EVEREST_MBED_TLS
+    if (ctx->tls_socket.fd != -1) {
+        if ((set_nonblocking(ctx->tls_socket.fd) == -1) ||
+            (event_loop_add(epoll_fd, ctx->tls_socket.fd, EPOLLIN) == -1)) {
+            goto out;
+        }
+        tls_fd = ctx->tls_socket.fd;
+    }
+#endif // EVEREST_MBED_TLS
+
+    if (ctx->sdp_socket != -1) {
+        if (event_loop_add(epoll_fd, ctx->sdp_socket, EPOLLIN) == -1) {
+            goto out;
+        }
+    }
+
+    dlog(DLOG_LEVEL_INFO, "V2G connection event loop started");
+
+    while (!ctx->shutdown) {
+        struct timespec ts_now;
+        int timeout = EVENT_LOOP_POLL_TIMEOUT_MS;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts_now);
+        for (const auto& c : closing) {
+            long long remaining = timespec_to_ms(timespec_sub(c.deadline, ts_now));
+            if (remaining < timeout)
+                timeout = (remaining > 0) ? static_cast<int>(remaining) : 0;
+        }
+
+        int num_events = epoll_wait(epoll_fd, events, EVENT_LOOP_MAX_EVENTS, timeout);
+        if (num_events == -1) {
+            if (errno == EINTR)
+                continue;
+            dlog(DLOG_LEVEL_ERROR, "epoll_wait() failed: %s", strerror(errno));
+            goto out;
+        }
+
+        for (int i = 0; i < num_events; i++) {
+            int fd = events[i].data.fd;
+
+            if (fd == ctx->tcp_socket) {
+                connection_accept(ctx, fd, false);
+            } else if (fd == tls_fd) {
+                connection_accept(ctx, fd, true);
+            } else if (fd == ctx->sdp_socket) {
+                sdp_handle_request(ctx);
+            } else if (fd == session_workers.wake_fd) {
+                uint64_t count;
+                std::vector<finished_connection> finished;
+
+                if (read(session_workers.wake_fd, &count, sizeof(count)) == -1) {
+                    dlog(DLOG_LEVEL_ERROR, "read(eventfd) failed: %s", strerror(errno));
+                }
+                {
+                    std::lock_guard<std::mutex> lock(session_workers.lock);
+                    finished.swap(session_workers.finished);
+                }
+
+                clock_gettime(CLOCK_MONOTONIC, &ts_now);
+                for (const auto& f : finished) {
+                    dlog(DLOG_LEVEL_INFO, "Closing TCP connection");
+                    struct closing_connection c = {f.conn->conn.socket_fd, f, CONNECTION_CLOSE_WAIT_FOR_PEER, ts_now};
+                    timespec_add_ms(&c.deadline, CONNECTION_CLOSE_WAIT_FOR_PEER_MS);
+                    if (event_loop_add(epoll_fd, c.fd, EPOLLIN | EPOLLRDHUP) == -1) {
+                        connection_release(f);
+                        continue;
+                    }
+                    closing.push_back(c);
+                }
+            } else {
+                for (std::size_t idx = 0; idx < closing.size(); idx++) {
+                    if (closing[idx].fd == fd) {
+                        if (connection_closing_event(fd, events[i].events)) {
+                            connection_close(epoll_fd, closing, idx);
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+
+        /* advance the close state machines on timeout */
+        clock_gettime(CLOCK_MONOTONIC, &ts_now);
+        for (std::size_t idx = 0; idx < closing.size();) {
+            struct closing_connection& c = closing[idx];
+
+            if (timespec_compare(&ts_now, &c.deadline) < 0) {
+                idx++;
+            } else if (c.state == CONNECTION_CLOSE_WAIT_FOR_PEER) {
+                /* send our FIN and give the EV some more time to close its side */
+                if (shutdown(c.fd, SHUT_WR) == -1) {
+                    dlog(DLOG_LEVEL_ERROR, "shutdown() failed: %s", strerror(errno));
+                }
+                c.state = CONNECTION_CLOSE_SHUTDOWN;
+                c.deadline = ts_now;
+                timespec_add_ms(&c.deadline, CONNECTION_CLOSE_SHUTDOWN_MS);
+                idx++;
+            } else {
+                connection_close(epoll_fd, closing, idx);
+            }
+        }
+    }
+
+    rv = 0;
+
+out:
+    {
+        std::lock_guard<std::mutex> lock(session_workers.lock);
+        session_workers.stop = true;
+        for (const auto& f : session_workers.finished) {
+            connection_release(f);
+        }
+        session_workers.finished.clear();
+        if (session_workers.wake_fd != -1) {
+            close(session_workers.wake_fd);
+            session_workers.wake_fd = -1;
+        }
+    }
+    session_workers.cv.notify_all();
+
+    for (const auto& c : closing) {
+        connection_release(c.finished);
+    }
+
+    close(epoll_fd);
+
+    if ((ctx->sdp_socket != -1) && (close(ctx->sdp_socket) == -1)) {
+        dlog(DLOG_LEVEL_ERROR, "close() failed: %s", strerror(errno));
+    }
+
+    return rv;
+}
+
 int create_udp_socket(const uint16_t udp_port, const char* interface_name) {
     constexpr auto LINK_LOCAL_MULTICAST = "ff02::1";
 
@@ -23,6 +23,15 @@ int connection_init(struct v2g_context* ctx);
  * \return 0 on success
  */
 int connection_start_servers(struct v2g_context* ctx);
+
+/*!
+ * \brief accepts TCP (and MbedTLS) connections and answers SDP requests from a single epoll thread until
+ * ctx->shutdown is set. Sessions are handled by reusable worker threads. With OpenSSL, TLS connections are handled
+ * by the threads of the TLS server started by connection_start_servers(). Blocks the calling thread.
+ * \param ctx the V2G context
+ * \return 0 on shutdown, -1 on error
+ */
+int connection_event_loop(struct v2g_context* ctx);
 int create_udp_socket(const uint16_t udp_port, const char* interface_name);
 
 /*!
@@ -47,6 +47,7 @@ void process_connection_thread(std::shared_ptr<tls::ServerConnection> con, struc
 
     openssl::pkey_ptr contract_public_key{nullptr, nullptr};
     auto connection = std::make_unique<v2g_connection>();
+    clock_gettime(CLOCK_MONOTONIC, &connection->ts_accepted);
     connection->ctx = ctx;
     connection->is_tls_connection = true;
     connection->read = &tls::connection_read;
@@ -139,6 +140,7 @@ bool build_config(tls::Server::config_t& config, struct v2g_context* ctx) {
     //                  may be issues with reinitialisation
     config.socket = ctx->tls_socket.fd;
     config.io_timeout_ms = static_cast<std::int32_t>(ctx->network_read_timeout_tls);
+    config.session_resumption.session_timeout_s = ctx->tls_session_timeout;
 
     // information from libevse-security
     const auto cert_info =
@@ -211,14 +213,28 @@ int connection_init(struct v2g_context* ctx) {
 
     // build_config can fail due to issues with Evse Security,
     // this can be retried later. Not treated as an error.
-    (void)build_config(config, ctx);
-
-    // apply config
-    ctx->tls_server->stop();
-    ctx->tls_server->wait_stopped();
-    const auto result = ctx->tls_server->init(config, [ctx]() { return configure_ssl(ctx); });
-    if ((result == state_t::init_complete) || (result == state_t::init_socket)) {
-        res = 0;
+    const bool configured = build_config(config, ctx);
+
+    if (ctx->tls_server->state() == state_t::running) {
+        // keep the listen socket and the active connections, only replace the certificates
+        if (ctx->tls_server->update(config)) {
+            res = 0;
+        }
+    } else {
+        // apply config
+        ctx->tls_server->stop();
+        ctx->tls_server->wait_stopped();
+        const auto result = ctx->tls_server->init(config, [ctx]() { return configure_ssl(ctx); });
+        if ((result == state_t::init_complete) || (result == state_t::init_socket)) {
+            res = 0;
+        }
+    }
+
+    // certificates renewed by Evse Security are loaded without restarting the server,
+    // the configuration is rebuilt so that a certificate stored under a new filename is found
+    if ((res == 0) && configured &&
+        !ctx->tls_server->update_on_change(config, [ctx]() { return configure_ssl(ctx); })) {
+        dlog(DLOG_LEVEL_WARNING, "Unable to watch the TLS certificates, renewed certificates need a restart");
     }
 
     return res;
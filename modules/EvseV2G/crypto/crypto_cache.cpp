@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#include "crypto_cache.hpp"
+
+#include <algorithm>
+
+#include <sys/stat.h>
+
+namespace crypto {
+
+file_id_t file_id(const char* path) {
+    file_id_t result;
+    struct stat file_stat {};
+
+    if ((path != nullptr) && (::stat(path, &file_stat) == 0)) {
+        result.exists = true;
+        result.device = file_stat.st_dev;
+        result.inode = file_stat.st_ino;
+        result.size = file_stat.st_size;
+        result.mtime_ns = static_cast<std::int64_t>(file_stat.st_mtim.tv_sec) * 1000000000 + file_stat.st_mtim.tv_nsec;
+    }
+
+    return result;
+}
+
+VerificationCache::VerificationCache(std::size_t capacity, std::chrono::seconds max_age) :
+    capacity(capacity), max_age(max_age) {
+}
+
+std::optional<verify_result_t> VerificationCache::find(const chain_hash_t& key, clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const auto itt = index.find(key);
+    if (itt == index.end()) {
+        return std::nullopt;
+    }
+
+    if (now >= itt->second->expires) {
+        entries.erase(itt->second);
+        index.erase(itt);
+        return std::nullopt;
+    }
+
+    entries.splice(entries.begin(), entries, itt->second);
+    return itt->second->result;
+}
+
+void VerificationCache::insert(const chain_hash_t& key, verify_result_t result, clock::time_point not_after,
+                               clock::time_point now) {
+    if ((result != verify_result_t::Verified) || (capacity == 0)) {
+        return;
+    }
+
+    const auto expires = std::min(not_after, now + max_age);
+    if (expires <= now) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (const auto itt = index.find(key); itt != index.end()) {
+        itt->second->result = result;
+        itt->second->expires = expires;
+        entries.splice(entries.begin(), entries, itt->second);
+        return;
+    }
+
+    if (entries.size() >= capacity) {
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+
+    entries.push_front({key, result, expires});
+    index.emplace(key, entries.begin());
+}
+
+std::size_t VerificationCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+void VerificationCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+}
+
+} // namespace crypto
@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#ifndef CRYPTO_CACHE_HPP_
+#define CRYPTO_CACHE_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "crypto_common.hpp"
+
+/**
+ * \file caches for the contract certificate verification (Plug & Charge)
+ *
+ * Both caches are independent of the TLS library, the OpenSSL and the Mbed TLS implementation
+ * provide the certificate type, the loader and the hash of the certification path.
+ */
+
+namespace crypto {
+
+/// maximum number of cached verification results
+constexpr std::size_t verification_cache_size = 256;
+/// maximum time a successful verification is reused, bounds how long a withdrawn trust anchor or a
+/// certificate that was revoked in the meantime is still accepted
+constexpr std::chrono::seconds verification_cache_max_age{600};
+
+/// SHA-256 over the DER encoded certification path and the trust store generation
+using chain_hash_t = ::openssl::sha_256_digest_t;
+
+/**
+ * \brief identifies the content of a file without reading it
+ *
+ * Files that are replaced (new inode) or written in place (new size or modification time) get a new id.
+ */
+struct file_id_t {
+    bool exists{false};
+    std::uint64_t device{0};
+    std::uint64_t inode{0};
+    std::int64_t size{0};
+    std::int64_t mtime_ns{0};
+
+    bool operator==(const file_id_t& rhs) const {
+        return (exists == rhs.exists) && (device == rhs.device) && (inode == rhs.inode) && (size == rhs.size) &&
+               (mtime_ns == rhs.mtime_ns);
+    }
+    bool operator!=(const file_id_t& rhs) const {
+        return !(*this == rhs);
+    }
+};
+
+/**
+ * \brief get the id of a file
+ * \param path the file name (may be nullptr)
+ * \return the id, exists is false when there is no such file
+ */
+file_id_t file_id(const char* path);
+
+/**
+ * \brief process wide store of the contract trust anchors
+ *
+ * The trust anchors are loaded on first use and kept until one of the files changes. The file names are
+ * provided with every request, so a stat() per request is used to detect changes instead of a watcher.
+ * A failed load is kept as well and retried when a file changes.
+ *
+ * \tparam T the list of trust anchors of the TLS library
+ */
+template <typename T> class TrustAnchorCache {
+public:
+    using anchors_ptr = std::shared_ptr<T>;
+    using loader_t = std::function<anchors_ptr(const char* v2g_root_cert_path, const char* mo_root_cert_path)>;
+
+    struct entry_t {
+        anchors_ptr anchors;         ///< nullptr when no trust anchor could be loaded
+        std::uint64_t generation{0}; ///< changes whenever the trust anchors are reloaded
+    };
+
+    /**
+     * \brief get the trust anchors, (re)loads them when the file names or the files changed
+     * \param v2g_root_cert_path V2G trust anchor file name
+     * \param mo_root_cert_path mobility operator trust anchor file name
+     * \param loader loads the trust anchors from the files, returns nullptr on error
+     * \return the trust anchors, they stay valid after a reload for as long as the entry is kept
+     */
+    entry_t get(const char* v2g_root_cert_path, const char* mo_root_cert_path, const loader_t& loader) {
+        const std::string v2g_path = (v2g_root_cert_path == nullptr) ? std::string() : v2g_root_cert_path;
+        const std::string mo_path = (mo_root_cert_path == nullptr) ? std::string() : mo_root_cert_path;
+        const auto v2g_id = file_id(v2g_root_cert_path);
+        const auto mo_id = file_id(mo_root_cert_path);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!loaded || (v2g_path != this->v2g_path) || (mo_path != this->mo_path) || (v2g_id != this->v2g_id) ||
+            (mo_id != this->mo_id)) {
+            entry.anchors = loader(v2g_root_cert_path, mo_root_cert_path);
+            entry.generation++;
+            this->v2g_path = v2g_path;
+            this->mo_path = mo_path;
+            this->v2g_id = v2g_id;
+            this->mo_id = mo_id;
+            loaded = true;
+        }
+        return entry;
+    }
+
+    /// \brief drop the trust anchors, the next request loads them again
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        loaded = false;
+        entry.anchors.reset();
+    }
+
+private:
+    std::mutex mutex;
+    bool loaded{false};
+    std::string v2g_path;
+    std::string mo_path;
+    file_id_t v2g_id;
+    file_id_t mo_id;
+    entry_t entry;
+};
+
+/**
+ * \brief bounded cache of successful contract certificate verifications
+ *
+ * Entries expire at the end of the validity period of the certification path or after
+ * verification_cache_max_age, whichever comes first. The least recently used entry is dropped when the
+ * cache is full.
+ */
+class VerificationCache {
+public:
+    using clock = std::chrono::system_clock;
+
+    explicit VerificationCache(std::size_t capacity = verification_cache_size,
+                               std::chrono::seconds max_age = verification_cache_max_age);
+
+    /**
+     * \brief get a cached verification result
+     * \param key hash of the certification path and the trust store generation
+     * \param now the current time
+     * \return the result when it is cached and has not expired
+     */
+    std::optional<verify_result_t> find(const chain_hash_t& key, clock::time_point now = clock::now());
+
+    /**
+     * \brief cache a verification result, only successful verifications are kept
+     * \param key hash of the certification path and the trust store generation
+     * \param result the result of the verification
+     * \param not_after the earliest end of the validity period of the certificates in the path
+     * \param now the current time
+     */
+    void insert(const chain_hash_t& key, verify_result_t result, clock::time_point not_after,
+                clock::time_point now = clock::now());
+
+    std::size_t size() const;
+    void clear();
+
+private:
+    struct entry_t {
+        chain_hash_t key;
+        verify_result_t result;
+        clock::time_point expires;
+    };
+    using list_t = std::list<entry_t>;
+
+    const std::size_t capacity;
+    const std::chrono::seconds max_age;
+
+    mutable std::mutex mutex;
+    list_t entries; // most recently used first
+    std::map<chain_hash_t, list_t::iterator> index;
+};
+
+} // namespace crypto
+
+#endif // CRYPTO_CACHE_HPP_
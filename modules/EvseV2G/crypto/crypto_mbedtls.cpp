@@ -2,9 +2,15 @@
 // Copyright (C) 2023 chargebyte GmbH
 // Copyright (C) 2023 Contributors to EVerest
 
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
+#include <ctime>
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "crypto_cache.hpp"
 #include "crypto_mbedtls.hpp"
 #include "iso_server.hpp"
 #include "log.hpp"
@@ -28,6 +34,39 @@ constexpr std::size_t MAX_EMAID_LEN = 18;
 
 bool getSubjectData(const mbedtls_x509_name* ASubject, const char* AAttrName, const mbedtls_asn1_buf** AVal);
 int debug_verify_cert(void* data, mbedtls_x509_crt* crt, int depth, uint32_t* flags);
+
+crypto::TrustAnchorCache<crypto::mbedtls::Certificate_ptr> trust_anchor_cache;
+crypto::VerificationCache verification_cache;
+
+/// \brief hash the certification path together with the generation of the trust anchors
+void chain_hash(crypto::chain_hash_t& hash, std::uint64_t generation, const mbedtls_x509_crt* crt) {
+    const auto* generation_bytes = reinterpret_cast<const std::uint8_t*>(&generation);
+    std::vector<std::uint8_t> buffer(generation_bytes, generation_bytes + sizeof(generation));
+    while (crt != nullptr && crt->version != 0) {
+        buffer.insert(buffer.end(), crt->raw.p, crt->raw.p + crt->raw.len);
+        crt = crt->next;
+    }
+    mbedtls_sha256(buffer.data(), buffer.size(), hash.data(), 0);
+}
+
+/// \brief the earliest end of the validity period of the certificates in the lists
+crypto::VerificationCache::clock::time_point not_after(const mbedtls_x509_crt* crt,
+                                                       const mbedtls_x509_crt* trust_anchors) {
+    auto result = crypto::VerificationCache::clock::time_point::max();
+    for (const auto* list : {crt, trust_anchors}) {
+        for (; list != nullptr && list->version != 0; list = list->next) {
+            std::tm valid_to{};
+            valid_to.tm_year = list->valid_to.year - 1900;
+            valid_to.tm_mon = list->valid_to.mon - 1;
+            valid_to.tm_mday = list->valid_to.day;
+            valid_to.tm_hour = list->valid_to.hour;
+            valid_to.tm_min = list->valid_to.min;
+            valid_to.tm_sec = list->valid_to.sec;
+            result = std::min(result, crypto::VerificationCache::clock::from_time_t(timegm(&valid_to)));
+        }
+    }
+    return result;
+}
 void printMbedVerifyErrorCode(int AErr, uint32_t AFlags);
 bool base64_decode(const char* text, std::size_t len, std::uint8_t* out_data, std::size_t& out_len);
 std::string base64_encode(const std::uint8_t* data, std::size_t len, bool newLine);
@@ -371,15 +410,30 @@ std::string chain_to_pem(const Certificate_ptr& contract_crt, const void* /* cha
 
 verify_result_t verify_certificate(Certificate_ptr& contract_crt, const void* chain, const char* v2g_root_cert_path,
                                    const char* mo_root_cert_path, bool debugMode) {
-    Certificate_ptr contract_root_crt;
     uint32_t flags;
     verify_result_t result{verify_result_t::Verified};
 
-    /* Load supported V2G/MO root certificates */
-    if (load_contract_root_cert(contract_root_crt, v2g_root_cert_path, mo_root_cert_path)) {
+    /* Load supported V2G/MO root certificates, only read from disk again when the files changed */
+    const auto contract_root_crt =
+        trust_anchor_cache.get(v2g_root_cert_path, mo_root_cert_path, [](const char* v2g_path, const char* mo_path) {
+            auto root_crt = std::make_shared<Certificate_ptr>();
+            if (!load_contract_root_cert(*root_crt, v2g_path, mo_path)) {
+                root_crt.reset();
+            }
+            return root_crt;
+        });
+
+    if (contract_root_crt.anchors != nullptr) {
+        chain_hash_t hash;
+        chain_hash(hash, contract_root_crt.generation, contract_crt.get());
+
+        if (const auto cached = verification_cache.find(hash); cached) {
+            return cached.value();
+        }
+
         // === Verify the retrieved contract ECDSA key against the root cert ===
-        const int err = mbedtls_x509_crt_verify(contract_crt.get(), contract_root_crt.get(), NULL, NULL, &flags,
-                                                (debugMode) ? debug_verify_cert : NULL, NULL);
+        const int err = mbedtls_x509_crt_verify(contract_crt.get(), contract_root_crt.anchors->get(), NULL, NULL,
+                                                &flags, (debugMode) ? debug_verify_cert : NULL, NULL);
         if (err != 0) {
             printMbedVerifyErrorCode(err, flags);
             dlog(DLOG_LEVEL_ERROR, "Validation of the contract certificate failed!");
@@ -392,6 +446,7 @@ verify_result_t verify_certificate(Certificate_ptr& contract_crt, const void* ch
             }
         }
 
+        verification_cache.insert(hash, result, not_after(contract_crt.get(), contract_root_crt.anchors->get()));
     } else {
         result = verify_result_t::NoCertificateAvailable;
     }
@@ -1,9 +1,13 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright 2020 - 2023 Pionix GmbH and Contributors to EVerest
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
+#include <memory>
 
+#include "crypto_cache.hpp"
 #include "crypto_openssl.hpp"
 #include "iso_server.hpp"
 #include "log.hpp"
@@ -20,6 +24,65 @@
 #include <openssl/store.h>
 #include <openssl/x509.h>
 
+namespace {
+
+crypto::TrustAnchorCache<::openssl::certificate_list> trust_anchor_cache;
+crypto::VerificationCache verification_cache;
+
+/// \brief hash the certification path together with the generation of the trust anchors
+bool chain_hash(crypto::chain_hash_t& hash, std::uint64_t generation, const x509_st* cert,
+                const ::openssl::certificate_list& chain) {
+    bool bRes{false};
+    auto* ctx = EVP_MD_CTX_new();
+
+    if ((ctx != nullptr) && (EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr) == 1)) {
+        bRes = EVP_DigestUpdate(ctx, &generation, sizeof(generation)) == 1;
+        const auto add = [ctx, &bRes](const x509_st* crt) {
+            const auto der = ::openssl::certificate_to_der(crt);
+            bRes = bRes && der && (EVP_DigestUpdate(ctx, der.get(), der.size()) == 1);
+        };
+        add(cert);
+        for (const auto& crt : chain) {
+            add(crt.get());
+        }
+        unsigned int len{0};
+        bRes = bRes && (EVP_DigestFinal_ex(ctx, hash.data(), &len) == 1) && (len == hash.size());
+    }
+
+    EVP_MD_CTX_free(ctx);
+    return bRes;
+}
+
+/// \brief the earliest end of the validity period of the certificates
+crypto::VerificationCache::clock::time_point not_after(const x509_st* cert, const ::openssl::certificate_list& chain,
+                                                       const ::openssl::certificate_list& trust_anchors) {
+    const auto now = crypto::VerificationCache::clock::now();
+    auto result = crypto::VerificationCache::clock::time_point::max();
+
+    const auto update = [&now, &result](const x509_st* crt) {
+        int days{0};
+        int seconds{0};
+        // difference between now (nullptr) and the end of the validity period
+        if (ASN1_TIME_diff(&days, &seconds, nullptr, X509_get0_notAfter(crt)) != 1) {
+            result = now;
+        } else {
+            result = std::min(result, now + std::chrono::hours(24) * days + std::chrono::seconds(seconds));
+        }
+    };
+
+    update(cert);
+    for (const auto& crt : chain) {
+        update(crt.get());
+    }
+    for (const auto& crt : trust_anchors) {
+        update(crt.get());
+    }
+
+    return result;
+}
+
+} // namespace
+
 namespace crypto ::openssl {
 using ::openssl::bn_const_t;
 using ::openssl::bn_t;
@@ -195,12 +258,32 @@ verify_result_t verify_certificate(const ::openssl::certificate_ptr& cert, const
     assert(chain != nullptr);
 
     verify_result_t result{verify_result_t::Verified};
-    ::openssl::certificate_list trust_anchors;
 
-    if (!load_contract_root_cert(trust_anchors, v2g_root_cert_path, mo_root_cert_path)) {
+    // the trust anchors are only read from disk again when the files changed
+    const auto trust_anchors =
+        trust_anchor_cache.get(v2g_root_cert_path, mo_root_cert_path, [](const char* v2g_path, const char* mo_path) {
+            auto anchors = std::make_shared<::openssl::certificate_list>();
+            if (!load_contract_root_cert(*anchors, v2g_path, mo_path)) {
+                anchors.reset();
+            }
+            return anchors;
+        });
+
+    if (trust_anchors.anchors == nullptr) {
         result = verify_result_t::NoCertificateAvailable;
     } else {
-        result = ::openssl::verify_certificate(cert.get(), trust_anchors, *chain);
+        chain_hash_t hash;
+        const bool cacheable = chain_hash(hash, trust_anchors.generation, cert.get(), *chain);
+        const auto cached = (cacheable) ? verification_cache.find(hash) : std::nullopt;
+
+        if (cached) {
+            result = cached.value();
+        } else {
+            result = ::openssl::verify_certificate(cert.get(), *trust_anchors.anchors, *chain);
+            if (cacheable) {
+                verification_cache.insert(hash, result, not_after(cert.get(), *chain, *trust_anchors.anchors));
+            }
+        }
     }
 
     return result;
@@ -265,19 +265,54 @@ int sdp_init(struct v2g_context* v2g_ctx) {
     return 0;
 }
 
+int sdp_handle_request(struct v2g_context* v2g_ctx) {
+    uint8_t buffer[SDP_HEADER_LEN + SDP_REQUEST_PAYLOAD_LEN];
+    char addrbuf[INET6_ADDRSTRLEN] = {0};
+    const char* addr = addrbuf;
+    struct sdp_query sdp_query = {
+        .v2g_ctx = v2g_ctx,
+    };
+    socklen_t addrlen = sizeof(sdp_query.remote_addr);
+
+    ssize_t len = recvfrom(v2g_ctx->sdp_socket, buffer, sizeof(buffer), MSG_DONTWAIT,
+                           (struct sockaddr*)&sdp_query.remote_addr, &addrlen);
+    if (len == -1) {
+        if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
+            return 0;
+        dlog(DLOG_LEVEL_ERROR, "recvfrom() failed: %s", strerror(errno));
+        return -1;
+    }
+
+    addr = inet_ntop(AF_INET6, &sdp_query.remote_addr.sin6_addr, addrbuf, sizeof(addrbuf));
+
+    if (len != sizeof(buffer)) {
+        dlog(DLOG_LEVEL_WARNING, "Discarded packet from [%s]:%" PRIu16 " due to unexpected length %zd", addr,
+             ntohs(sdp_query.remote_addr.sin6_port), len);
+        return 0;
+    }
+
+    if (sdp_validate_header(buffer, SDP_REQUEST_TYPE, SDP_REQUEST_PAYLOAD_LEN)) {
+        dlog(DLOG_LEVEL_WARNING, "Packet with invalid SDP header received from [%s]:%" PRIu16, addr,
+             ntohs(sdp_query.remote_addr.sin6_port));
+        return 0;
+    }
+
+    sdp_query.security_requested = (sdp_security)buffer[SDP_HEADER_LEN + 0];
+    sdp_query.proto_requested = (sdp_transport_protocol)buffer[SDP_HEADER_LEN + 1];
+
+    dlog(DLOG_LEVEL_INFO, "Received packet from [%s]:%" PRIu16 " with security 0x%02x and protocol 0x%02x", addr,
+         ntohs(sdp_query.remote_addr.sin6_port), sdp_query.security_requested, sdp_query.proto_requested);
+
+    sdp_send_response(v2g_ctx->sdp_socket, &sdp_query);
+
+    return 0;
+}
+
 int sdp_listen(struct v2g_context* v2g_ctx) {
     /* Init pollfd struct */
     struct pollfd pollfd = {v2g_ctx->sdp_socket, POLLIN, 0};
 
     while (!v2g_ctx->shutdown) {
-        uint8_t buffer[SDP_HEADER_LEN + SDP_REQUEST_PAYLOAD_LEN];
-        char addrbuf[INET6_ADDRSTRLEN] = {0};
-        const char* addr = addrbuf;
-        struct sdp_query sdp_query = {
-            .v2g_ctx = v2g_ctx,
-        };
-        socklen_t addrlen = sizeof(sdp_query.remote_addr);
-
         /* Check if data was received on socket */
         signed status = poll(&pollfd, 1, POLL_TIMEOUT);
 
@@ -291,35 +326,7 @@ int sdp_listen(struct v2g_context* v2g_ctx) {
         }
         /* If new data was received, handle sdp request */
         if (status > 0) {
-            ssize_t len = recvfrom(v2g_ctx->sdp_socket, buffer, sizeof(buffer), 0,
-                                   (struct sockaddr*)&sdp_query.remote_addr, &addrlen);
-            if (len == -1) {
-                if (errno != EINTR)
-                    dlog(DLOG_LEVEL_ERROR, "recvfrom() failed: %s", strerror(errno));
-                continue;
-            }
-
-            addr = inet_ntop(AF_INET6, &sdp_query.remote_addr.sin6_addr, addrbuf, sizeof(addrbuf));
-
-            if (len != sizeof(buffer)) {
-                dlog(DLOG_LEVEL_WARNING, "Discarded packet from [%s]:%" PRIu16 " due to unexpected length %zd", addr,
-                     ntohs(sdp_query.remote_addr.sin6_port), len);
-                continue;
-            }
-
-            if (sdp_validate_header(buffer, SDP_REQUEST_TYPE, SDP_REQUEST_PAYLOAD_LEN)) {
-                dlog(DLOG_LEVEL_WARNING, "Packet with invalid SDP header received from [%s]:%" PRIu16, addr,
-                     ntohs(sdp_query.remote_addr.sin6_port));
-                continue;
-            }
-
-            sdp_query.security_requested = (sdp_security)buffer[SDP_HEADER_LEN + 0];
-            sdp_query.proto_requested = (sdp_transport_protocol)buffer[SDP_HEADER_LEN + 1];
-
-            dlog(DLOG_LEVEL_INFO, "Received packet from [%s]:%" PRIu16 " with security 0x%02x and protocol 0x%02x",
-                 addr, ntohs(sdp_query.remote_addr.sin6_port), sdp_query.security_requested, sdp_query.proto_requested);
-
-            sdp_send_response(v2g_ctx->sdp_socket, &sdp_query);
+            sdp_handle_request(v2g_ctx);
         }
     }
 
@@ -9,4 +9,12 @@
 int sdp_init(struct v2g_context* v2g_ctx);
 int sdp_listen(struct v2g_context* v2g_ctx);
 
+/*!
+ * \brief sdp_handle_request receives one pending datagram from the SDP socket and answers it if it is a valid
+ * SDP request. Does not block if no datagram is pending.
+ * \param v2g_ctx the V2G context
+ * \return 0 on success or if nothing was pending, -1 on receive errors
+ */
+int sdp_handle_request(struct v2g_context* v2g_ctx);
+
 #endif /* SDP_H */
@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include "ISO15118_chargerImplStub.hpp"
+#include "evse_securityIntfStub.hpp"
+
+#include <connection.hpp>
+#include <v2g_ctx.hpp>
+
+using namespace std::chrono_literals;
+
+namespace {
+std::atomic_int sessions{0};
+} // namespace
+
+// needs to be in the global namespace
+int sdp_handle_request(struct v2g_context* v2g_ctx) {
+    return 0;
+}
+
+// needs to be in the global namespace
+// echoes blocks of 4 bytes until the EV closes the connection or sends "stop"
+int v2g_handle_connection(struct v2g_connection* conn) {
+    sessions++;
+    conn->ctx->state = 1; // session is running, reset by connection_teardown()
+
+    unsigned char buffer[4];
+    while (true) {
+        const ssize_t readbytes = conn->read(conn, buffer, sizeof(buffer));
+        if ((readbytes != sizeof(buffer)) or (memcmp(buffer, "stop", sizeof(buffer)) == 0)) {
+            return 0;
+        }
+        if (conn->write(conn, buffer, readbytes) != readbytes) {
+            return -1;
+        }
+    }
+}
+
+namespace {
+
+class ConnectionEventLoopTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        sessions = 0;
+
+        ctx = v2g_ctx_create(&charger, &security);
+        ASSERT_NE(ctx, nullptr);
+        ctx->connection_event_loop = true;
+        ctx->is_connection_terminated = false;
+
+        listen_fd = socket(AF_INET6, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        ASSERT_NE(listen_fd, -1);
+        struct sockaddr_in6 addr = {};
+        addr.sin6_family = AF_INET6;
+        addr.sin6_addr = in6addr_loopback;
+        socklen_t addrlen = sizeof(addr);
+        ASSERT_EQ(bind(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)), 0);
+        ASSERT_EQ(listen(listen_fd, 3), 0);
+        ASSERT_EQ(getsockname(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), &addrlen), 0);
+        port = ntohs(addr.sin6_port);
+        ctx->tcp_socket = listen_fd;
+
+        ASSERT_EQ(connection_start_servers(ctx), 0);
+        loop = std::thread([this]() { loop_result = connection_event_loop(ctx); });
+    }
+
+    void TearDown() override {
+        if (ctx != nullptr) {
+            ctx->is_connection_terminated = true;
+            ctx->shutdown = true;
+            if (loop.joinable()) {
+                loop.join();
+            }
+            EXPECT_EQ(loop_result, 0);
+            v2g_ctx_free(ctx);
+        }
+        if (listen_fd != -1) {
+            close(listen_fd);
+        }
+    }
+
+    int connect_ev() {
+        int fd = socket(AF_INET6, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        struct sockaddr_in6 addr = {};
+        addr.sin6_family = AF_INET6;
+        addr.sin6_addr = in6addr_loopback;
+        addr.sin6_port = htons(port);
+        EXPECT_EQ(connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)), 0);
+        return fd;
+    }
+
+    // waits until the SECC closes the connection, returns false on timeout
+    static bool wait_for_close(int fd, std::chrono::milliseconds timeout) {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        char buffer[16];
+        return (poll(&pfd, 1, static_cast<int>(timeout.count())) == 1) and (read(fd, buffer, sizeof(buffer)) == 0);
+    }
+
+    bool wait_for_teardown(std::chrono::milliseconds timeout) {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (ctx->state != 0) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(10ms);
+        }
+        return true;
+    }
+
+    module::stub::ISO15118_chargerImplStub charger;
+    module::stub::evse_securityIntfStub security;
+    struct v2g_context* ctx{nullptr};
+    int listen_fd{-1};
+    uint16_t port{0};
+    std::thread loop;
+    int loop_result{-1};
+};
+
+TEST_F(ConnectionEventLoopTest, session_and_close_by_ev) {
+    for (int i = 0; i < 3; i++) {
+        const int fd = connect_ev();
+        char buffer[4];
+        ASSERT_EQ(write(fd, "ping", 4), 4);
+        ASSERT_EQ(read(fd, buffer, sizeof(buffer)), 4);
+        EXPECT_EQ(memcmp(buffer, "ping", 4), 0);
+
+        // the EV closes first, the connection is released right away instead of after the close timeouts
+        close(fd);
+        EXPECT_TRUE(wait_for_teardown(1s));
+    }
+    EXPECT_EQ(sessions, 3);
+}
+
+TEST_F(ConnectionEventLoopTest, close_by_secc_and_teardown_after_close) {
+    const int fd = connect_ev();
+    ASSERT_EQ(write(fd, "stop", 4), 4);
+
+    // the session has ended, but the EV keeps the connection open: the SECC closes its side after the wait time
+    EXPECT_FALSE(wait_for_close(fd, 1s));
+
+    // connection_teardown() is only called after the socket was closed, until then new sessions are rejected
+    EXPECT_NE(ctx->state, 0);
+    const int rejected = connect_ev();
+    EXPECT_TRUE(wait_for_close(rejected, 3s));
+    close(rejected);
+    EXPECT_EQ(sessions, 1);
+
+    EXPECT_TRUE(wait_for_close(fd, 3s));
+    close(fd);
+    EXPECT_TRUE(wait_for_teardown(1s));
+
+    const int next = connect_ev();
+    char buffer[4];
+    ASSERT_EQ(write(next, "next", 4), 4);
+    ASSERT_EQ(read(next, buffer, sizeof(buffer)), 4);
+    close(next);
+    EXPECT_EQ(sessions, 2);
+}
+
+} // namespace
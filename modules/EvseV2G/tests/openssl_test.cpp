@@ -1,11 +1,14 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright 2020 - 2023 Pionix GmbH and Contributors to EVerest
 
+#include "crypto_cache.hpp"
 #include "crypto_common.hpp"
 #include "gtest/gtest.h"
 #include <crypto_openssl.hpp>
 #include <cstddef>
+#include <cstdio>
 #include <cstring>
+#include <filesystem>
 #include <iso_server.hpp>
 #include <openssl/bio.h>
 #include <openssl/pem.h>
@@ -162,4 +165,88 @@ TEST(isoExi, signature) {
     EVP_PKEY_free(pkey);
 }
 
+crypto::chain_hash_t test_key(std::uint8_t value) {
+    crypto::chain_hash_t key{};
+    key.fill(value);
+    return key;
+}
+
+TEST(verificationCache, lru) {
+    using namespace std::chrono_literals;
+    crypto::VerificationCache cache(2, 600s);
+    const auto now = crypto::VerificationCache::clock::now();
+    const auto not_after = now + 24h;
+
+    cache.insert(test_key(1), crypto::verify_result_t::Verified, not_after, now);
+    cache.insert(test_key(2), crypto::verify_result_t::Verified, not_after, now);
+    EXPECT_EQ(cache.size(), 2);
+
+    // key 1 is used more recently than key 2, key 2 is dropped
+    EXPECT_EQ(cache.find(test_key(1), now), crypto::verify_result_t::Verified);
+    cache.insert(test_key(3), crypto::verify_result_t::Verified, not_after, now);
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_TRUE(cache.find(test_key(1), now));
+    EXPECT_FALSE(cache.find(test_key(2), now));
+    EXPECT_TRUE(cache.find(test_key(3), now));
+
+    // failed verifications are not cached
+    cache.insert(test_key(4), crypto::verify_result_t::CertChainError, not_after, now);
+    EXPECT_FALSE(cache.find(test_key(4), now));
+    EXPECT_TRUE(cache.find(test_key(3), now));
+}
+
+TEST(verificationCache, expiry) {
+    using namespace std::chrono_literals;
+    crypto::VerificationCache cache(10, 600s);
+    const auto now = crypto::VerificationCache::clock::now();
+
+    // limited by the maximum age
+    cache.insert(test_key(1), crypto::verify_result_t::Verified, now + 24h, now);
+    EXPECT_TRUE(cache.find(test_key(1), now + 599s));
+    EXPECT_FALSE(cache.find(test_key(1), now + 600s));
+
+    // limited by the validity of the certificates
+    cache.insert(test_key(2), crypto::verify_result_t::Verified, now + 60s, now);
+    EXPECT_TRUE(cache.find(test_key(2), now + 59s));
+    EXPECT_FALSE(cache.find(test_key(2), now + 60s));
+
+    // already expired
+    cache.insert(test_key(3), crypto::verify_result_t::Verified, now - 1s, now);
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(openssl, verifyContractCertificateCached) {
+    constexpr const char* root_file = "contract_root_cert.pem";
+    const auto replace_root = [root_file](const char* source) {
+        // replace the file like a certificate installation would (new file and rename)
+        std::filesystem::copy_file(source, "contract_root_cert.tmp", std::filesystem::copy_options::overwrite_existing);
+        std::filesystem::rename("contract_root_cert.tmp", root_file);
+    };
+
+    auto leaf = ::openssl::load_certificates("server_cert.pem");
+    auto chain = ::openssl::load_certificates("server_ca_cert.pem");
+    ASSERT_EQ(leaf.size(), 1);
+    ASSERT_EQ(chain.size(), 1);
+    const auto& cert = leaf.front();
+
+    replace_root("server_root_cert.pem");
+    EXPECT_EQ(crypto::openssl::verify_certificate(cert, &chain, root_file, "missing_mo_root.pem", false),
+              crypto::verify_result_t::Verified);
+    EXPECT_EQ(crypto::openssl::verify_certificate(cert, &chain, root_file, "missing_mo_root.pem", false),
+              crypto::verify_result_t::Verified);
+
+    // a different trust anchor is picked up and the cached result is not used (issuer not found)
+    replace_root("client_root_cert.pem");
+    EXPECT_EQ(crypto::openssl::verify_certificate(cert, &chain, root_file, "missing_mo_root.pem", false),
+              crypto::verify_result_t::NoCertificateAvailable);
+
+    replace_root("server_root_cert.pem");
+    EXPECT_EQ(crypto::openssl::verify_certificate(cert, &chain, root_file, "missing_mo_root.pem", false),
+              crypto::verify_result_t::Verified);
+
+    std::remove(root_file);
+    EXPECT_EQ(crypto::openssl::verify_certificate(cert, &chain, root_file, "missing_mo_root.pem", false),
+              crypto::verify_result_t::NoCertificateAvailable);
+}
+
 } // namespace
@@ -26,6 +26,11 @@
 
 using namespace std::chrono_literals;
 
+// needs to be in the global namespace
+int sdp_handle_request(struct v2g_context* v2g_ctx) {
+    return 0;
+}
+
 // needs to be in the global namespace
 int v2g_handle_connection(struct v2g_connection* conn) {
     assert(conn != nullptr);
@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <v2g_trace.hpp>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+std::string hex(const std::string& data) {
+    std::string out(2 * data.size(), '\0');
+    v2g_trace_hex_encode(reinterpret_cast<const uint8_t*>(data.data()), data.size(), &out[0]);
+    return out;
+}
+
+std::string base64(const std::string& data) {
+    std::string out(v2g_trace_base64_length(data.size()), '\0');
+    const auto len = v2g_trace_base64_encode(reinterpret_cast<const uint8_t*>(data.data()), data.size(), &out[0]);
+    EXPECT_EQ(len, out.size());
+    return out;
+}
+
+struct Collector {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<types::iso15118_charger::V2gMessages> messages;
+
+    void add(const types::iso15118_charger::V2gMessages& msg) {
+        std::lock_guard<std::mutex> lock(mutex);
+        messages.push_back(msg);
+        cv.notify_all();
+    }
+
+    bool wait_for(std::size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, 1s, [this, count] { return messages.size() >= count; });
+    }
+};
+
+TEST(V2gTrace, hex) {
+    EXPECT_EQ(hex(""), "");
+    EXPECT_EQ(hex(std::string("\x01\xfe\x80\x02\x00\x0a", 6)), "01fe8002000a");
+}
+
+TEST(V2gTrace, base64) {
+    // RFC 4648 test vectors
+    EXPECT_EQ(base64(""), "");
+    EXPECT_EQ(base64("f"), "Zg==");
+    EXPECT_EQ(base64("fo"), "Zm8=");
+    EXPECT_EQ(base64("foo"), "Zm9v");
+    EXPECT_EQ(base64("foob"), "Zm9vYg==");
+    EXPECT_EQ(base64("fooba"), "Zm9vYmE=");
+    EXPECT_EQ(base64("foobar"), "Zm9vYmFy");
+    EXPECT_EQ(base64(std::string("\xff\xfe\x00", 3)), "//4A");
+}
+
+TEST(V2gTrace, publish) {
+    Collector collector;
+    V2gTracer tracer;
+    tracer.start([&collector](const types::iso15118_charger::V2gMessages& msg) { collector.add(msg); });
+
+    const uint8_t data[] = {0x01, 0xfe, 0x80, 0x02};
+    tracer.trace(V2G_SESSION_SETUP_MSG, types::iso15118_charger::V2gMessageId::SessionSetupReq, true, data,
+                 sizeof(data));
+
+    ASSERT_TRUE(collector.wait_for(1));
+    EXPECT_EQ(collector.messages[0].id, types::iso15118_charger::V2gMessageId::SessionSetupReq);
+    EXPECT_EQ(collector.messages[0].exi, "01fe8002");
+    EXPECT_EQ(collector.messages[0].exi_base64, "Af6AAg==");
+}
+
+TEST(V2gTrace, sampling) {
+    Collector collector;
+    V2gTracer tracer;
+    EXPECT_TRUE(tracer.configure_sampling("CurrentDemand:3, charging status:0"));
+    tracer.start([&collector](const types::iso15118_charger::V2gMessages& msg) { collector.add(msg); });
+
+    const uint8_t data[] = {0x01};
+    for (int i = 0; i < 6; i++) {
+        tracer.trace(V2G_CURRENT_DEMAND_MSG, types::iso15118_charger::V2gMessageId::CurrentDemandReq, true, data,
+                     sizeof(data));
+        tracer.trace(V2G_CURRENT_DEMAND_MSG, types::iso15118_charger::V2gMessageId::CurrentDemandRes, false, data,
+                     sizeof(data));
+        tracer.trace(V2G_CHARGING_STATUS_MSG, types::iso15118_charger::V2gMessageId::ChargingStatusReq, true, data,
+                     sizeof(data));
+    }
+    tracer.trace(V2G_SESSION_STOP_MSG, types::iso15118_charger::V2gMessageId::SessionStopReq, true, data,
+                 sizeof(data));
+
+    ASSERT_TRUE(collector.wait_for(5));
+    tracer.stop();
+
+    // every 3rd CurrentDemand request with its response, no ChargingStatus
+    ASSERT_EQ(collector.messages.size(), 5u);
+    EXPECT_EQ(collector.messages[0].id, types::iso15118_charger::V2gMessageId::CurrentDemandReq);
+    EXPECT_EQ(collector.messages[1].id, types::iso15118_charger::V2gMessageId::CurrentDemandRes);
+    EXPECT_EQ(collector.messages[2].id, types::iso15118_charger::V2gMessageId::CurrentDemandReq);
+    EXPECT_EQ(collector.messages[3].id, types::iso15118_charger::V2gMessageId::CurrentDemandRes);
+    EXPECT_EQ(collector.messages[4].id, types::iso15118_charger::V2gMessageId::SessionStopReq);
+}
+
+TEST(V2gTrace, invalid_sampling) {
+    V2gTracer tracer;
+    EXPECT_FALSE(tracer.configure_sampling("CurrentDemand"));
+    EXPECT_FALSE(tracer.configure_sampling("NoSuchMessage:2"));
+    EXPECT_FALSE(tracer.configure_sampling("CurrentDemand:x"));
+    EXPECT_TRUE(tracer.configure_sampling(""));
+}
+
+TEST(V2gTrace, queue_full) {
+    std::mutex block;
+    Collector collector;
+    V2gTracer tracer;
+
+    std::unique_lock<std::mutex> blocked(block);
+    tracer.start([&](const types::iso15118_charger::V2gMessages& msg) {
+        std::lock_guard<std::mutex> lock(block);
+        collector.add(msg);
+    });
+
+    const uint8_t data[] = {0x01};
+    const std::size_t count = V2gTracer::queue_size + 4;
+    for (std::size_t i = 0; i < count; i++) {
+        tracer.trace(V2G_CURRENT_DEMAND_MSG, types::iso15118_charger::V2gMessageId::CurrentDemandReq, true, data,
+                     sizeof(data));
+    }
+    // the publish thread may already hold one message
+    EXPECT_GE(tracer.dropped(), count - V2gTracer::queue_size - 1);
+    EXPECT_LE(tracer.dropped(), count - V2gTracer::queue_size);
+
+    blocked.unlock();
+    ASSERT_TRUE(collector.wait_for(count - tracer.dropped()));
+}
+
+} // namespace
@@ -39,6 +39,8 @@
 #include <event2/event.h>
 #include <event2/thread.h>
 
+#include "v2g_msg_type.hpp"
+
 /* timeouts in milliseconds */
 #define V2G_SEQUENCE_TIMEOUT_60S              60000 /* [V2G2-443] et.al. */
 #define V2G_SEQUENCE_TIMEOUT_10S              10000
@@ -73,8 +75,6 @@
 #define FORCE_PUB_MSG           25 // max msg cycles when topics values must be udpated
 #define MAX_PCID_LEN            17
 
-#define DEFAULT_BUFFER_SIZE 8192
-
 #define DEBUG 1
 
 enum tls_security_level {
@@ -122,31 +122,6 @@ enum charging_phase {
     PHASE_LENGTH
 };
 
-/*!
- * \brief The res_msg_ids enum is a list of response msg ids
- */
-enum V2gMsgTypeId {
-    V2G_SUPPORTED_APP_PROTOCOL_MSG = 0,
-    V2G_SESSION_SETUP_MSG,
-    V2G_SERVICE_DISCOVERY_MSG,
-    V2G_SERVICE_DETAIL_MSG,
-    V2G_PAYMENT_SERVICE_SELECTION_MSG,
-    V2G_PAYMENT_DETAILS_MSG,
-    V2G_AUTHORIZATION_MSG,
-    V2G_CHARGE_PARAMETER_DISCOVERY_MSG,
-    V2G_METERING_RECEIPT_MSG,
-    V2G_CERTIFICATE_UPDATE_MSG,
-    V2G_CERTIFICATE_INSTALLATION_MSG,
-    V2G_CHARGING_STATUS_MSG,
-    V2G_CABLE_CHECK_MSG,
-    V2G_PRE_CHARGE_MSG,
-    V2G_POWER_DELIVERY_MSG,
-    V2G_CURRENT_DEMAND_MSG,
-    V2G_WELDING_DETECTION_MSG,
-    V2G_SESSION_STOP_MSG,
-    V2G_UNKNOWN_MSG
-};
-
 /* EVSE ID */
 struct v2g_evse_id {
     uint8_t bytes[iso2_EVSEID_CHARACTER_SIZE];
@@ -203,6 +178,7 @@ struct v2g_context {
 
     uint32_t network_read_timeout;     /* in milli seconds */
     uint32_t network_read_timeout_tls; /* in milli seconds */
+    uint32_t tls_session_timeout;      /* in seconds, 0 disables session resumption */
 
     enum tls_security_level tls_security;
 
@@ -213,6 +189,7 @@ struct v2g_context {
     int udp_socket;
 
     pthread_t tcp_thread;
+    bool connection_event_loop; /* accept connections and answer SDP requests from one epoll thread */
 
 #ifdef EVEREST_MBED_TLS
     mbedtls_ssl_config ssl_config;
@@ -249,6 +226,7 @@ struct v2g_context {
     bool is_dc_charger;         /* Is set to true if it is a DC charger. Value is configured after configuration of the
                                    supported energy type */
     bool debugMode;             /* To activate/deactivate the debug mode */
+    class V2gTracer* tracer;    /* publishes the raw V2G messages in debug mode */
     int8_t supported_protocols; /* Is an bit mask and holds the supported app protocols. See v2g_protocol enum */
     enum v2g_protocol selected_protocol; /* Holds the selected protocole after supported app protocol */
     std::atomic<bool>
@@ -385,6 +363,8 @@ struct v2g_connection {
     pthread_t thread_id;
     struct v2g_context* ctx;
 
+    struct timespec ts_accepted; /* monotonic time at which the connection was accepted */
+
     bool is_tls_connection;
 
 #ifdef EVEREST_MBED_TLS
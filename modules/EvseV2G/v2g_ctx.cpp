@@ -321,6 +321,7 @@ struct v2g_context* v2g_ctx_create(ISO15118_chargerImplBase* p_chargerImplBase,
 
     ctx->network_read_timeout = 1000;
     ctx->network_read_timeout_tls = 5000;
+    ctx->tls_session_timeout = 0; /* no session resumption unless configured */
 
     ctx->sdp_socket = -1;
     ctx->tcp_socket = -1;
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2023 chargebyte GmbH
+// Copyright (C) 2023 Contributors to EVerest
+#ifndef V2G_MSG_TYPE_H
+#define V2G_MSG_TYPE_H
+
+/* V2G message types, without the TLS and EXI dependencies of v2g.hpp */
+
+#define DEFAULT_BUFFER_SIZE 8192
+
+/*!
+ * \brief The res_msg_ids enum is a list of response msg ids
+ */
+enum V2gMsgTypeId {
+    V2G_SUPPORTED_APP_PROTOCOL_MSG = 0,
+    V2G_SESSION_SETUP_MSG,
+    V2G_SERVICE_DISCOVERY_MSG,
+    V2G_SERVICE_DETAIL_MSG,
+    V2G_PAYMENT_SERVICE_SELECTION_MSG,
+    V2G_PAYMENT_DETAILS_MSG,
+    V2G_AUTHORIZATION_MSG,
+    V2G_CHARGE_PARAMETER_DISCOVERY_MSG,
+    V2G_METERING_RECEIPT_MSG,
+    V2G_CERTIFICATE_UPDATE_MSG,
+    V2G_CERTIFICATE_INSTALLATION_MSG,
+    V2G_CHARGING_STATUS_MSG,
+    V2G_CABLE_CHECK_MSG,
+    V2G_PRE_CHARGE_MSG,
+    V2G_POWER_DELIVERY_MSG,
+    V2G_CURRENT_DEMAND_MSG,
+    V2G_WELDING_DETECTION_MSG,
+    V2G_SESSION_STOP_MSG,
+    V2G_UNKNOWN_MSG
+};
+
+static const char* const v2g_msg_type[] = {
+    "Supported App Protocol",
+    "Session Setup",
+    "Service Discovery",
+    "Service Detail",
+    "Payment Service Selection",
+    "Payment Details",
+    "Authorization",
+    "Charge Parameter Discovery",
+    "Metering Receipt",
+    "Certificate Update",
+    "Certificate Installation",
+    "Charging Status",
+    "Cable Check",
+    "Pre Charge",
+    "Power Delivery",
+    "Current Demand",
+    "Welding Detection",
+    "Session Stop",
+    "Unknown",
+};
+
+#endif /* V2G_MSG_TYPE_H */
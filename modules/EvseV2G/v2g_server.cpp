@@ -9,10 +9,6 @@
 #include <string.h>
 #include <unistd.h>
 
-#ifdef EVEREST_MBED_TLS
-#include <mbedtls/base64.h>
-#endif // EVEREST_MBED_TLS
-
 #include <cbv2g/app_handshake/appHand_Decoder.h>
 #include <cbv2g/app_handshake/appHand_Encoder.h>
 #include <cbv2g/common/exi_basetypes.h>
@@ -27,6 +23,7 @@
 #include "iso_server.hpp"
 #include "log.hpp"
 #include "tools.hpp"
+#include "v2g_trace.hpp"
 
 #define MAX_RES_TIME 98
 
@@ -102,52 +99,19 @@ static types::iso15118_charger::V2gMessageId get_v2g_message_id(enum V2gMsgTypeI
 }
 
 /*!
- * \brief publish_var_V2G_Message This function fills a V2gMessages type with the V2G EXI message as HEX and Base64
+ * \brief publish_var_V2G_Message This function hands the V2G EXI message over to the tracer, which publishes it as
+ * HEX and Base64 string from its own thread.
  * \param conn hold the context of the V2G-connection.
  * \param is_req if it is a V2G request or response: 'true' if a request, and 'false' if a response
  */
 static void publish_var_V2G_Message(v2g_connection* conn, bool is_req) {
-    types::iso15118_charger::V2gMessages v2g_message;
-
-    u_int8_t* tempbuff = conn->buffer;
-    std::string msg_as_hex_string;
-    for (int i = 0; ((tempbuff != NULL) && (i < conn->payload_len + V2GTP_HEADER_LENGTH)); i++) {
-        char hex[4];
-        snprintf(hex, 4, "%x", *tempbuff); // to hex
-        if (std::string(hex).size() == 1)
-            msg_as_hex_string += '0';
-        msg_as_hex_string += hex;
-        tempbuff++;
-    }
-
-    std::string EXI_Base64;
-
-#ifdef EVEREST_MBED_TLS
-    unsigned char* base64_buffer = NULL;
-    size_t base64_buffer_len = 0;
-    mbedtls_base64_encode(NULL, 0, &base64_buffer_len, conn->buffer, (size_t)conn->payload_len + V2GTP_HEADER_LENGTH);
-    base64_buffer = static_cast<unsigned char*>(malloc(base64_buffer_len));
-    if ((base64_buffer == NULL) || (mbedtls_base64_encode(base64_buffer, base64_buffer_len, &base64_buffer_len,
-                                                          static_cast<unsigned char*>(conn->buffer),
-                                                          (size_t)conn->payload_len + V2GTP_HEADER_LENGTH) != 0)) {
-        dlog(DLOG_LEVEL_WARNING, "Unable to base64 encode EXI buffer");
-    }
-
-    EXI_Base64 = std::string(reinterpret_cast<char const*>(base64_buffer), base64_buffer_len);
-    if (base64_buffer != NULL) {
-        free(base64_buffer);
-    }
-#else
-    EXI_Base64 = openssl::base64_encode(conn->buffer, conn->payload_len + V2GTP_HEADER_LENGTH);
-    if (EXI_Base64.size() == 0) {
-        dlog(DLOG_LEVEL_WARNING, "Unable to base64 encode EXI buffer");
+    if (conn->ctx->tracer == nullptr) {
+        return;
     }
-#endif // EVEREST_MBED_TLS
 
-    v2g_message.exi_base64 = EXI_Base64;
-    v2g_message.id = get_v2g_message_id(conn->ctx->current_v2g_msg, conn->ctx->selected_protocol, is_req);
-    v2g_message.exi = msg_as_hex_string;
-    conn->ctx->p_charger->publish_v2g_messages(v2g_message);
+    conn->ctx->tracer->trace(conn->ctx->current_v2g_msg,
+                             get_v2g_message_id(conn->ctx->current_v2g_msg, conn->ctx->selected_protocol, is_req),
+                             is_req, conn->buffer, (size_t)conn->payload_len + V2GTP_HEADER_LENGTH);
 }
 
 /*!
@@ -434,6 +398,13 @@ int v2g_handle_connection(struct v2g_connection* conn) {
             dlog(DLOG_LEVEL_ERROR, "v2g_outgoing_v2gtp() failed");
             goto error_out;
         }
+
+        /* session setup time from accepting the connection until the supportedAppRes is sent */
+        struct timespec ts_now;
+        if ((conn->ts_accepted.tv_sec != 0) && (clock_gettime(CLOCK_MONOTONIC, &ts_now) == 0)) {
+            dlog(DLOG_LEVEL_INFO, "supportedAppProtocol handshake finished %lld ms after accepting the connection",
+                 timespec_to_ms(timespec_sub(ts_now, conn->ts_accepted)));
+        }
     }
 
     /* terminate connection, if supportedApp handshake has failed */
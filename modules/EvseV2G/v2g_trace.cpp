@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include "v2g_trace.hpp"
+#include "log.hpp"
+#include "v2g_msg_type.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+static const char hex_digits[] = "0123456789abcdef";
+static const char base64_digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+std::size_t v2g_trace_hex_encode(const uint8_t* data, std::size_t len, char* out) {
+    for (std::size_t i = 0; i < len; i++) {
+        out[2 * i] = hex_digits[data[i] >> 4];
+        out[2 * i + 1] = hex_digits[data[i] & 0x0f];
+    }
+    return 2 * len;
+}
+
+std::size_t v2g_trace_base64_length(std::size_t len) {
+    return ((len + 2) / 3) * 4;
+}
+
+std::size_t v2g_trace_base64_encode(const uint8_t* data, std::size_t len, char* out) {
+    std::size_t o = 0;
+    std::size_t i = 0;
+
+    for (; i + 2 < len; i += 3) {
+        const uint32_t v = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+        out[o++] = base64_digits[(v >> 18) & 0x3f];
+        out[o++] = base64_digits[(v >> 12) & 0x3f];
+        out[o++] = base64_digits[(v >> 6) & 0x3f];
+        out[o++] = base64_digits[v & 0x3f];
+    }
+
+    if (i < len) {
+        const bool two_bytes = (i + 1 < len);
+        const uint32_t v = (data[i] << 16) | (two_bytes ? (data[i + 1] << 8) : 0);
+        out[o++] = base64_digits[(v >> 18) & 0x3f];
+        out[o++] = base64_digits[(v >> 12) & 0x3f];
+        out[o++] = two_bytes ? base64_digits[(v >> 6) & 0x3f] : '=';
+        out[o++] = '=';
+    }
+
+    return o;
+}
+
+/* compares a configured message name with an entry of v2g_msg_type, ignoring spaces and case */
+static bool message_name_equals(const std::string& name, const char* msg_type) {
+    std::size_t n = 0;
+    for (const char* c = msg_type; *c != '\0'; c++) {
+        if (*c == ' ') {
+            continue;
+        }
+        if ((n >= name.size()) || (std::tolower(name[n]) != std::tolower(*c))) {
+            return false;
+        }
+        n++;
+    }
+    return n == name.size();
+}
+
+V2gTracer::V2gTracer() : queue(queue_size) {
+    sample_interval.fill(1);
+}
+
+V2gTracer::~V2gTracer() {
+    stop();
+}
+
+bool V2gTracer::configure_sampling(const std::string& sampling) {
+    bool result = true;
+    std::size_t pos = 0;
+
+    while (pos < sampling.size()) {
+        std::size_t end = sampling.find(',', pos);
+        if (end == std::string::npos) {
+            end = sampling.size();
+        }
+
+        std::string entry = sampling.substr(pos, end - pos);
+        entry.erase(std::remove_if(entry.begin(), entry.end(), [](unsigned char c) { return std::isspace(c); }),
+                    entry.end());
+        pos = end + 1;
+
+        if (entry.empty()) {
+            continue;
+        }
+
+        const auto colon = entry.find(':');
+        const std::string name = entry.substr(0, colon);
+        std::size_t type = 0;
+        while ((type < number_of_message_types) && !message_name_equals(name, v2g_msg_type[type])) {
+            type++;
+        }
+
+        unsigned long interval = 0;
+        char* interval_end = nullptr;
+        if (colon != std::string::npos) {
+            interval = std::strtoul(entry.c_str() + colon + 1, &interval_end, 10);
+        }
+
+        if ((type == number_of_message_types) || (interval_end == nullptr) || (*interval_end != '\0') ||
+            (interval_end == entry.c_str() + colon + 1)) {
+            dlog(DLOG_LEVEL_WARNING, "Ignoring invalid V2G message trace sampling entry \"%s\"", entry.c_str());
+            result = false;
+            continue;
+        }
+
+        sample_interval[type] = static_cast<std::uint32_t>(interval);
+        if (interval == 0) {
+            dlog(DLOG_LEVEL_INFO, "Tracing of %s messages is disabled", v2g_msg_type[type]);
+        } else {
+            dlog(DLOG_LEVEL_INFO, "Tracing every %lu. %s message", interval, v2g_msg_type[type]);
+        }
+    }
+
+    return result;
+}
+
+void V2gTracer::start(PublishCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) {
+        return;
+    }
+
+    publish = std::move(callback);
+    hex.reserve(2 * DEFAULT_BUFFER_SIZE);
+    base64.reserve(v2g_trace_base64_length(DEFAULT_BUFFER_SIZE));
+    running = true;
+    thread = std::thread(&V2gTracer::publish_thread, this);
+}
+
+void V2gTracer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    cv.notify_one();
+
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+bool V2gTracer::sample(V2gMsgTypeId type, bool is_req) {
+    const std::size_t idx = std::min<std::size_t>(type, number_of_message_types - 1);
+
+    if (!is_req) {
+        /* trace the response together with its request */
+        return request_sampled[idx].load(std::memory_order_relaxed);
+    }
+
+    const auto interval = sample_interval[idx];
+    const bool sampled =
+        (interval != 0) && ((sample_counter[idx].fetch_add(1, std::memory_order_relaxed) % interval) == 0);
+    request_sampled[idx].store(sampled, std::memory_order_relaxed);
+    return sampled;
+}
+
+void V2gTracer::trace(V2gMsgTypeId type, types::iso15118_charger::V2gMessageId id, bool is_req, const uint8_t* data,
+                      std::size_t len) {
+    if ((data == nullptr) || !sample(type, is_req)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+        if (head - tail == queue_size) {
+            dropped_messages.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        Message& msg = queue[head % queue_size];
+        msg.id = id;
+        msg.len = std::min<std::size_t>(len, msg.data.size());
+        std::memcpy(msg.data.data(), data, msg.len);
+        head++;
+    }
+    cv.notify_one();
+}
+
+void V2gTracer::publish_thread() {
+    std::uint64_t reported_drops = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        cv.wait(lock, [this] { return !running || (head != tail); });
+        if (head == tail) {
+            break;
+        }
+
+        /* the slot stays reserved until tail is advanced, so it can be read without holding the lock */
+        const Message& msg = queue[tail % queue_size];
+        lock.unlock();
+
+        hex.resize(2 * msg.len);
+        v2g_trace_hex_encode(msg.data.data(), msg.len, &hex[0]);
+        base64.resize(v2g_trace_base64_length(msg.len));
+        v2g_trace_base64_encode(msg.data.data(), msg.len, &base64[0]);
+
+        types::iso15118_charger::V2gMessages v2g_message;
+        v2g_message.id = msg.id;
+        v2g_message.exi = hex;
+        v2g_message.exi_base64 = base64;
+        publish(v2g_message);
+
+        const auto drops = dropped();
+        if (drops != reported_drops) {
+            dlog(DLOG_LEVEL_WARNING, "Dropped %" PRIu64 " V2G messages, tracing cannot keep up",
+                 drops - reported_drops);
+            reported_drops = drops;
+        }
+
+        lock.lock();
+        tail++;
+    }
+}
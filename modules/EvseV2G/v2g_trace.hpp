@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef V2G_TRACE_HPP
+#define V2G_TRACE_HPP
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <generated/types/iso15118_charger.hpp>
+
+#include "v2g_msg_type.hpp"
+
+/*!
+ * \brief v2g_trace_hex_encode writes the lower case hex representation of data to out. No terminating zero is
+ * written.
+ * \param data bytes to encode
+ * \param len number of bytes to encode
+ * \param out output buffer with space for at least 2 * len characters
+ * \return number of characters written
+ */
+std::size_t v2g_trace_hex_encode(const uint8_t* data, std::size_t len, char* out);
+
+/*!
+ * \brief v2g_trace_base64_length returns the length of the base64 representation of len bytes
+ */
+std::size_t v2g_trace_base64_length(std::size_t len);
+
+/*!
+ * \brief v2g_trace_base64_encode writes the base64 representation (with padding and without line breaks) of data
+ * to out. No terminating zero is written.
+ * \param data bytes to encode
+ * \param len number of bytes to encode
+ * \param out output buffer with space for at least v2g_trace_base64_length(len) characters
+ * \return number of characters written
+ */
+std::size_t v2g_trace_base64_encode(const uint8_t* data, std::size_t len, char* out);
+
+/*
+ Publishes the raw V2G messages (as hex and base64 string) for debugging.
+ trace() is called from the V2G connection thread. It only copies the message into one of the preallocated queue
+ slots; encoding and publishing is done from the tracer's own thread. If the queue is full, the message is dropped.
+ Every message type can be sampled (only every n-th request/response pair is traced) or disabled.
+*/
+class V2gTracer {
+public:
+    using PublishCallback = std::function<void(const types::iso15118_charger::V2gMessages&)>;
+
+    static constexpr std::size_t queue_size = 16;
+
+    V2gTracer();
+    ~V2gTracer();
+
+    V2gTracer(const V2gTracer&) = delete;
+    V2gTracer& operator=(const V2gTracer&) = delete;
+
+    /*!
+     * \brief configure_sampling sets the sample interval per message type. Must be called before start().
+     * \param sampling comma separated list of <message>:<n>, e.g. "CurrentDemand:10,ChargingStatus:0". Only every
+     * n-th request/response pair of a message is traced, 0 disables tracing of the message. Message names are
+     * compared ignoring spaces and case. Messages not in the list are always traced.
+     * \return false if the list could not be parsed completely, valid entries are applied anyway
+     */
+    bool configure_sampling(const std::string& sampling);
+
+    void start(PublishCallback callback);
+    void stop();
+
+    /*!
+     * \brief trace queues a copy of a V2G message for publishing. Does not allocate memory and does not wait for
+     * the message to be published.
+     * \param type the V2G message type, used for sampling
+     * \param id the message id to publish
+     * \param is_req true for requests, a response is only traced if its request was traced
+     * \param data the V2GTP header and EXI payload
+     * \param len length of data
+     */
+    void trace(V2gMsgTypeId type, types::iso15118_charger::V2gMessageId id, bool is_req, const uint8_t* data,
+               std::size_t len);
+
+    // number of messages dropped because the queue was full
+    std::uint64_t dropped() const {
+        return dropped_messages.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Message {
+        types::iso15118_charger::V2gMessageId id;
+        std::size_t len;
+        std::array<uint8_t, DEFAULT_BUFFER_SIZE> data;
+    };
+
+    static constexpr std::size_t number_of_message_types = V2G_UNKNOWN_MSG + 1;
+
+    bool sample(V2gMsgTypeId type, bool is_req);
+    void publish_thread();
+
+    PublishCallback publish;
+
+    std::vector<Message> queue;
+    std::size_t head{0};
+    std::size_t tail{0};
+    bool running{false};
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread thread;
+
+    std::array<std::uint32_t, number_of_message_types> sample_interval;
+    std::array<std::atomic<std::uint32_t>, number_of_message_types> sample_counter{};
+    std::array<std::atomic_bool, number_of_message_types> request_sampled{};
+
+    std::atomic<std::uint64_t> dropped_messages{0};
+
+    // encoding buffers of the publish thread
+    std::string hex;
+    std::string base64;
+};
+
+#endif // V2G_TRACE_HPP
@@ -3,6 +3,7 @@
 
 #include "powermeterImpl.hpp"
 #include <fmt/core.h>
+#include <optional>
 #include <thread>
 #include <utils/date.hpp>
 #include <utils/yaml_loader.hpp>
@@ -32,15 +33,23 @@ void powermeterImpl::init() {
                         << "\" failed: " << e.what();
             throw std::runtime_error("Module \"GenericPowermeter\" could not be initialized!");
         }
+
+        if (this->config_loaded_successfully && !this->init_register_planner()) {
+            // do not poll an incomplete set of registers
+            this->config_loaded_successfully = false;
+            throw std::runtime_error("Module \"GenericPowermeter\" could not be initialized!");
+        }
     }
 }
 
 void powermeterImpl::ready() {
     if (this->config_loaded_successfully) {
         std::thread t([this] {
-            while (true) {
+            this->planner.start(RegisterPlanner::Clock::now());
+            this->bus_load_since = RegisterPlanner::Clock::now();
+            while (this->planner.size() > 0) {
+                std::this_thread::sleep_until(this->planner.next_deadline());
                 read_powermeter_values();
-                sleep(1);
             }
         });
         t.detach();
@@ -271,6 +280,7 @@ int powermeterImpl::assign_register_data(const json& registers, const Powermeter
                 data.exponent_register_function =
                     select_modbus_function((const uint8_t)registers.at(register_selector).at("function_code_exp_reg"));
                 data.multiplier = registers.at(register_selector).at("multiplier");
+                data.poll_interval = select_poll_interval(registers.at(register_selector), register_type);
                 pm_configuration.push_back(data);
             }
             if (registers.at(register_selector).contains("L1")) {
@@ -311,6 +321,13 @@ void powermeterImpl::assign_register_sublevel_data(const json& registers, const
     sublevel_data.exponent_register_function = select_modbus_function(
         (const uint8_t)registers.at(register_selector).at(sublevel_selector).at("function_code_exp_reg"));
     sublevel_data.multiplier = registers.at(register_selector).at(sublevel_selector).at("multiplier");
+    // a poll interval of the sublevel takes precedence over the one of its dataset
+    if (registers.at(register_selector).at(sublevel_selector).contains("poll_interval_ms")) {
+        sublevel_data.poll_interval =
+            select_poll_interval(registers.at(register_selector).at(sublevel_selector), sublevel_data.type);
+    } else {
+        sublevel_data.poll_interval = select_poll_interval(registers.at(register_selector), sublevel_data.type);
+    }
     pm_configuration.push_back(sublevel_data);
 }
 
@@ -331,44 +348,158 @@ powermeterImpl::ModbusFunctionType powermeterImpl::select_modbus_function(const
     return REGISTER_TYPE_UNDEFINED;
 }
 
-void powermeterImpl::read_powermeter_values() {
-    for (auto& register_data : this->pm_configuration) {
-        readRegister(register_data);
+std::chrono::milliseconds powermeterImpl::select_poll_interval(const json& registers,
+                                                               const PowermeterRegisters register_type) {
+    if (registers.contains("poll_interval_ms")) {
+        return std::chrono::milliseconds(registers.at("poll_interval_ms").get<int>());
     }
-    this->pm_last_values.timestamp = Everest::Date::to_rfc3339(date::utc_clock::now());
-    this->publish_powermeter(this->pm_last_values);
+    if (register_type <= ENERGY_WH_EXPORT_L3) {
+        return std::chrono::milliseconds(config.energy_poll_interval_ms);
+    }
+    return std::chrono::milliseconds(config.poll_interval_ms);
 }
 
-void powermeterImpl::readRegister(const RegisterData& register_config) {
+bool powermeterImpl::init_register_planner() {
+    this->planner = RegisterPlanner(config.max_register_gap);
 
-    types::serial_comm_hub_requests::Result register_response{};
-    types::serial_comm_hub_requests::Result exponent_response{};
+    const auto polled_range = [this](uint16_t start_register, ModbusFunctionType function, uint16_t num_registers,
+                                     std::chrono::milliseconds interval) {
+        // only input registers are addressed relative to the base address
+        if (function == READ_INPUT_REGISTER) {
+            return PolledRange{ModbusFunction::ReadInputRegisters,
+                               static_cast<uint16_t>(start_register - config.modbus_base_address), num_registers,
+                               interval};
+        }
+        return PolledRange{ModbusFunction::ReadHoldingRegisters, start_register, num_registers, interval};
+    };
 
-    if (register_config.start_register_function == READ_HOLDING_REGISTER) {
-        register_response = mod->r_serial_comm_hub->call_modbus_read_holding_registers(
-            config.powermeter_device_id, register_config.start_register, register_config.num_registers);
+    for (auto& register_data : this->pm_configuration) {
+        try {
+            register_data.start_range =
+                this->planner.add(polled_range(register_data.start_register, register_data.start_register_function,
+                                               register_data.num_registers, register_data.poll_interval));
+            if (register_data.exponent_register != 0) {
+                // the exponent is a single int16 register
+                register_data.exponent_range = this->planner.add(
+                    polled_range(register_data.exponent_register, register_data.exponent_register_function, 1,
+                                 register_data.poll_interval));
+            }
+        } catch (const std::exception& e) {
+            EVLOG_error << "Cannot poll register " << register_data.start_register << " of model \"" << config.model
+                        << "\": " << e.what();
+            return false;
+        }
     }
 
-    if (register_config.start_register_function == READ_INPUT_REGISTER) {
-        register_response = mod->r_serial_comm_hub->call_modbus_read_input_registers(
-            config.powermeter_device_id, register_config.start_register - config.modbus_base_address,
-            register_config.num_registers);
+    std::size_t unmerged_requests = 0;
+    for (const auto& register_data : this->pm_configuration) {
+        const auto polls_per_minute = std::chrono::milliseconds(std::chrono::minutes(1)) / register_data.poll_interval;
+        unmerged_requests += (register_data.exponent_register != 0 ? 2 : 1) * polls_per_minute;
     }
 
-    if (register_config.exponent_register != 0) {
-        if (register_config.exponent_register_function == READ_HOLDING_REGISTER) {
-            exponent_response = mod->r_serial_comm_hub->call_modbus_read_holding_registers(
-                config.powermeter_device_id, register_config.exponent_register, register_config.num_registers);
+    const auto minute = this->planner.expected_load(std::chrono::minutes(1));
+    EVLOG_info << fmt::format("Polling {} register ranges with {} Modbus requests per minute, {} without merging "
+                              "({} registers, {} bytes on the bus)",
+                              this->planner.size(), minute.requests, unmerged_requests, minute.registers,
+                              minute.frame_bytes);
+    return true;
+}
+
+void powermeterImpl::read_powermeter_values() {
+    const auto& blocks = this->planner.poll(RegisterPlanner::Clock::now());
+
+    // split the responses of the merged reads into the responses of the single ranges
+    std::vector<std::optional<types::serial_comm_hub_requests::Result>> responses(this->planner.size());
+    for (const auto& block : blocks) {
+        const auto block_response = readBlock(block);
+        if (block_response.status_code != types::serial_comm_hub_requests::StatusCodeEnum::Success &&
+            block.ranges.size() > 1) {
+            // e.g. a register in between is not readable, a failing range must not fail the others
+            EVLOG_debug << "Reading " << block.count << " registers from address " << block.address
+                        << " failed, reading its " << block.ranges.size() << " ranges one by one";
+            for (const auto range_id : block.ranges) {
+                const auto& range = this->planner.range(range_id);
+                responses[range_id] = readBlock(ReadBlock{range.function, range.address, range.count, {range_id}});
+            }
+            continue;
+        }
+        for (const auto range_id : block.ranges) {
+            const auto& range = this->planner.range(range_id);
+            types::serial_comm_hub_requests::Result response{block_response.status_code};
+            if (block_response.status_code == types::serial_comm_hub_requests::StatusCodeEnum::Success) {
+                const auto first = block_response.value->begin() + (range.address - block.address);
+                response.value.emplace(first, first + range.count);
+            } else {
+                response.value = block_response.value;
+            }
+            responses[range_id] = std::move(response);
         }
+    }
 
-        if (register_config.exponent_register_function == READ_INPUT_REGISTER) {
-            exponent_response = mod->r_serial_comm_hub->call_modbus_read_input_registers(
-                config.powermeter_device_id, register_config.exponent_register - config.modbus_base_address,
-                register_config.num_registers);
+    for (const auto& register_data : this->pm_configuration) {
+        const auto& register_response = responses[register_data.start_range];
+        if (!register_response.has_value()) {
+            // not due yet
+            continue;
+        }
+        types::serial_comm_hub_requests::Result exponent_response{};
+        if (register_data.exponent_register != 0 && responses[register_data.exponent_range].has_value()) {
+            exponent_response = responses[register_data.exponent_range].value();
         }
+        process_response(register_data, register_response.value(), std::move(exponent_response));
     }
 
-    process_response(register_config, std::move(register_response), std::move(exponent_response));
+    this->pm_last_values.timestamp = Everest::Date::to_rfc3339(date::utc_clock::now());
+    this->publish_powermeter(this->pm_last_values);
+
+    report_bus_load();
+}
+
+types::serial_comm_hub_requests::Result powermeterImpl::readBlock(const ReadBlock& block) {
+    types::serial_comm_hub_requests::Result response{};
+
+    const auto begin = RegisterPlanner::Clock::now();
+    if (block.function == ModbusFunction::ReadHoldingRegisters) {
+        response = mod->r_serial_comm_hub->call_modbus_read_holding_registers(config.powermeter_device_id,
+                                                                             block.address, block.count);
+    } else {
+        response = mod->r_serial_comm_hub->call_modbus_read_input_registers(config.powermeter_device_id,
+                                                                           block.address, block.count);
+    }
+    const auto elapsed = RegisterPlanner::Clock::now() - begin;
+
+    if (response.status_code == types::serial_comm_hub_requests::StatusCodeEnum::Success &&
+        (!response.value.has_value() || response.value->size() != block.count)) {
+        EVLOG_debug << "Expected " << block.count << " registers from address " << block.address << ", received "
+                    << (response.value.has_value() ? response.value->size() : 0);
+        response.status_code = types::serial_comm_hub_requests::StatusCodeEnum::Error;
+    }
+
+    this->bus_load.add(block, response.status_code == types::serial_comm_hub_requests::StatusCodeEnum::Success,
+                       elapsed);
+    return response;
+}
+
+void powermeterImpl::report_bus_load() {
+    if (config.bus_report_interval_s <= 0) {
+        return;
+    }
+
+    const auto now = RegisterPlanner::Clock::now();
+    const auto elapsed = std::chrono::duration<double>(now - this->bus_load_since).count();
+    if (elapsed < config.bus_report_interval_s) {
+        return;
+    }
+
+    EVLOG_info << fmt::format("Bus utilization of meter {}: {:.2f} requests/s ({} failed), {:.1f} registers/s, "
+                              "{:.0f} bytes/s, {:.1f}% of the time waiting for responses",
+                              config.powermeter_device_id, this->bus_load.requests / elapsed,
+                              this->bus_load.failed_requests, this->bus_load.registers / elapsed,
+                              this->bus_load.frame_bytes / elapsed,
+                              100.0 * std::chrono::duration<double>(this->bus_load.busy).count() / elapsed);
+
+    this->bus_load = {};
+    this->bus_load_since = now;
 }
 
 void powermeterImpl::process_response(const RegisterData& register_data,
@@ -14,6 +14,8 @@
 
 // ev@75ac1216-19eb-4182-a85c-820f1fc2c091:v1
 // insert your custom include headers here
+#include "../register_planner.hpp"
+#include <chrono>
 // ev@75ac1216-19eb-4182-a85c-820f1fc2c091:v1
 
 namespace module {
@@ -23,6 +25,10 @@ struct Conf {
     std::string model;
     int powermeter_device_id;
     int modbus_base_address;
+    int poll_interval_ms;
+    int energy_poll_interval_ms;
+    int max_register_gap;
+    int bus_report_interval_s;
 };
 
 class powermeterImpl : public powermeterImplBase {
@@ -99,6 +105,9 @@ private:
         uint16_t exponent_register;
         ModbusFunctionType exponent_register_function;
         uint16_t num_registers;
+        std::chrono::milliseconds poll_interval;
+        std::size_t start_range;    // id of the value registers in the planner
+        std::size_t exponent_range; // id of the exponent register in the planner, if exponent_register != 0
     };
 
     std::vector<RegisterData> pm_configuration;
@@ -108,6 +117,10 @@ private:
 
     std::thread output_thread;
 
+    RegisterPlanner planner;
+    BusLoad bus_load;
+    RegisterPlanner::Clock::time_point bus_load_since;
+
     /// @brief Remember whether we already logged the meter's unavailability.
     bool meter_is_unavailable{false};
 
@@ -119,8 +132,12 @@ private:
                                        const std::string& register_selector, const std::string& sublevel_selector,
                                        const uint8_t offset);
     powermeterImpl::ModbusFunctionType select_modbus_function(const uint8_t function_code);
+    std::chrono::milliseconds select_poll_interval(const json& registers, const PowermeterRegisters register_type);
+    // false if a configured register cannot be polled
+    bool init_register_planner();
     void read_powermeter_values();
-    void readRegister(const RegisterData& register_config);
+    types::serial_comm_hub_requests::Result readBlock(const ReadBlock& block);
+    void report_bus_load();
     void process_response(const RegisterData& message_type,
                           const types::serial_comm_hub_requests::Result register_message,
                           const types::serial_comm_hub_requests::Result exponent_message);
@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include "register_planner.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace module {
+
+void BusLoad::add(const ReadBlock& block, bool success, std::chrono::steady_clock::duration elapsed) {
+    this->requests++;
+    if (!success) {
+        this->failed_requests++;
+    }
+    this->registers += block.count;
+    this->frame_bytes += rtu_frame_bytes(block.count);
+    this->busy += elapsed;
+}
+
+std::size_t BusLoad::rtu_frame_bytes(std::uint16_t count) {
+    // request: address, function, start address, count, crc
+    // response: address, function, byte count, data, crc
+    return 8 + 5 + 2 * static_cast<std::size_t>(count);
+}
+
+RegisterPlanner::RegisterPlanner(std::uint16_t max_gap, std::uint16_t max_registers) :
+    max_gap(max_gap), max_registers(std::min(max_registers, MAX_READ_REGISTERS)) {
+}
+
+std::size_t RegisterPlanner::add(const PolledRange& range) {
+    if (range.count == 0 || range.count > this->max_registers) {
+        throw std::runtime_error("Invalid number of registers for a single read: " + std::to_string(range.count));
+    }
+    if (range.interval.count() <= 0) {
+        throw std::runtime_error("Poll interval has to be positive");
+    }
+
+    for (std::size_t id = 0; id < this->ranges.size(); id++) {
+        auto& existing = this->ranges[id];
+        if (existing.function == range.function && existing.address == range.address &&
+            existing.count == range.count && existing.interval == range.interval) {
+            return id;
+        }
+    }
+
+    this->ranges.push_back(range);
+    this->plans.clear();
+    return this->ranges.size() - 1;
+}
+
+void RegisterPlanner::start(Clock::time_point now) {
+    this->deadlines.clear();
+    for (const auto& range : this->ranges) {
+        this->deadlines[range.interval] = now;
+    }
+}
+
+RegisterPlanner::Clock::time_point RegisterPlanner::next_deadline() const {
+    if (this->deadlines.empty()) {
+        return Clock::time_point::max();
+    }
+    auto next = Clock::time_point::max();
+    for (const auto& [interval, deadline] : this->deadlines) {
+        next = std::min(next, deadline);
+    }
+    return next;
+}
+
+const std::vector<ReadBlock>& RegisterPlanner::poll(Clock::time_point now) {
+    std::vector<bool> due(this->ranges.size(), false);
+    for (std::size_t id = 0; id < this->ranges.size(); id++) {
+        const auto it = this->deadlines.find(this->ranges[id].interval);
+        due[id] = (it != this->deadlines.end() && it->second <= now);
+    }
+
+    for (auto& [interval, deadline] : this->deadlines) {
+        if (deadline > now) {
+            continue;
+        }
+        // keep the period stable, but do not try to catch up on missed deadlines
+        deadline += interval;
+        if (deadline <= now) {
+            deadline = now + interval;
+        }
+    }
+
+    return plan(due);
+}
+
+const std::vector<ReadBlock>& RegisterPlanner::plan(const std::vector<bool>& due) {
+    auto it = this->plans.find(due);
+    if (it == this->plans.end()) {
+        it = this->plans.emplace(due, merge(due)).first;
+    }
+    return it->second;
+}
+
+BusLoad RegisterPlanner::expected_load(Clock::duration duration) const {
+    // simulate the schedule on a copy, so neither the deadlines nor the cached plans are touched
+    RegisterPlanner simulation(*this);
+    BusLoad load;
+
+    const auto begin = Clock::time_point{};
+    simulation.start(begin);
+    for (auto now = simulation.next_deadline(); now < begin + duration; now = simulation.next_deadline()) {
+        for (const auto& block : simulation.poll(now)) {
+            load.add(block, true, Clock::duration::zero());
+        }
+    }
+    return load;
+}
+
+std::vector<ReadBlock> RegisterPlanner::merge(const std::vector<bool>& due) const {
+    std::vector<std::size_t> ids;
+    for (std::size_t id = 0; id < this->ranges.size() && id < due.size(); id++) {
+        if (due[id]) {
+            ids.push_back(id);
+        }
+    }
+
+    std::sort(ids.begin(), ids.end(), [this](std::size_t a, std::size_t b) {
+        const auto& range_a = this->ranges[a];
+        const auto& range_b = this->ranges[b];
+        if (range_a.function != range_b.function) {
+            return range_a.function < range_b.function;
+        }
+        return range_a.address < range_b.address;
+    });
+
+    std::vector<ReadBlock> blocks;
+    std::uint32_t block_end = 0;
+    for (const auto id : ids) {
+        const auto& range = this->ranges[id];
+        const std::uint32_t range_end = static_cast<std::uint32_t>(range.address) + range.count;
+
+        if (!blocks.empty()) {
+            auto& block = blocks.back();
+            const auto merged_end = std::max(block_end, range_end);
+            if (block.function == range.function && range.address <= block_end + this->max_gap &&
+                merged_end - block.address <= this->max_registers) {
+                block_end = merged_end;
+                block.count = static_cast<std::uint16_t>(block_end - block.address);
+                block.ranges.push_back(id);
+                continue;
+            }
+        }
+
+        blocks.push_back({range.function, range.address, range.count, {id}});
+        block_end = range_end;
+    }
+
+    return blocks;
+}
+
+} // namespace module
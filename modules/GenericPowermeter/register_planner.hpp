@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef GENERIC_POWERMETER_REGISTER_PLANNER_HPP
+#define GENERIC_POWERMETER_REGISTER_PLANNER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace module {
+
+enum class ModbusFunction {
+    ReadHoldingRegisters,
+    ReadInputRegisters,
+};
+
+/// \brief A range of registers that is polled in a fixed interval
+struct PolledRange {
+    ModbusFunction function;
+    std::uint16_t address; ///< address as sent on the bus
+    std::uint16_t count;
+    std::chrono::milliseconds interval;
+};
+
+/// \brief A single Modbus read request covering one or more ranges
+struct ReadBlock {
+    ModbusFunction function;
+    std::uint16_t address;
+    std::uint16_t count;
+    std::vector<std::size_t> ranges; ///< ids of the ranges covered by this read
+};
+
+/// \brief Traffic on the serial bus, either planned or measured
+struct BusLoad {
+    std::size_t requests{0};
+    std::size_t failed_requests{0};
+    std::size_t registers{0};                    ///< registers transferred, including unused ones in between
+    std::size_t frame_bytes{0};                  ///< bytes of the RTU request and response frames
+    std::chrono::steady_clock::duration busy{0}; ///< time spent waiting for the responses
+
+    void add(const ReadBlock& block, bool success, std::chrono::steady_clock::duration elapsed);
+
+    /// \brief Size of the RTU request and response frames of a read of \p count registers
+    static std::size_t rtu_frame_bytes(std::uint16_t count);
+};
+
+/// \brief Merges the configured register ranges into as few Modbus reads as possible and schedules them.
+///
+/// Every range has its own poll interval. Ranges with the same interval share a steady_clock deadline, all ranges that
+/// are due at the same time are merged into reads of at most MAX_READ_REGISTERS registers. Ranges of the same
+/// function code are merged when they overlap, are adjacent or are at most max_gap registers apart. The reads for a
+/// set of due ranges are computed once and cached.
+class RegisterPlanner {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// maximum number of registers of a single read holding/input registers request
+    static constexpr std::uint16_t MAX_READ_REGISTERS = 125;
+
+    explicit RegisterPlanner(std::uint16_t max_gap = 0, std::uint16_t max_registers = MAX_READ_REGISTERS);
+
+    /// \brief Adds a range and returns its id. Adding a range with the same registers and interval as an existing one
+    /// returns the id of the existing range.
+    std::size_t add(const PolledRange& range);
+
+    const PolledRange& range(std::size_t id) const {
+        return ranges.at(id);
+    }
+
+    std::size_t size() const {
+        return ranges.size();
+    }
+
+    /// \brief Makes all ranges due at \p now
+    void start(Clock::time_point now);
+
+    /// \brief The next point in time at which ranges are due
+    Clock::time_point next_deadline() const;
+
+    /// \brief Returns the reads for all ranges that are due at \p now and schedules their next deadline. Deadlines
+    /// that were missed completely are skipped.
+    const std::vector<ReadBlock>& poll(Clock::time_point now);
+
+    /// \brief Returns the reads for the ranges with \p due set
+    const std::vector<ReadBlock>& plan(const std::vector<bool>& due);
+
+    /// \brief The bus traffic caused by polling all ranges for \p duration
+    BusLoad expected_load(Clock::duration duration = std::chrono::seconds(60)) const;
+
+private:
+    std::vector<ReadBlock> merge(const std::vector<bool>& due) const;
+
+    std::uint16_t max_gap;
+    std::uint16_t max_registers;
+    std::vector<PolledRange> ranges;
+    std::map<std::chrono::milliseconds, Clock::time_point> deadlines;
+    std::map<std::vector<bool>, std::vector<ReadBlock>> plans;
+};
+
+} // namespace module
+
+#endif // GENERIC_POWERMETER_REGISTER_PLANNER_HPP
@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <stdexcept>
+
+#include <register_planner.hpp>
+
+namespace module {
+
+using namespace std::chrono_literals;
+
+namespace {
+PolledRange input(std::uint16_t address, std::uint16_t count, std::chrono::milliseconds interval = 1000ms) {
+    return {ModbusFunction::ReadInputRegisters, address, count, interval};
+}
+
+PolledRange holding(std::uint16_t address, std::uint16_t count, std::chrono::milliseconds interval = 1000ms) {
+    return {ModbusFunction::ReadHoldingRegisters, address, count, interval};
+}
+} // namespace
+
+TEST(RegisterPlannerTest, adjacent_ranges_are_merged) {
+    RegisterPlanner planner;
+    // voltage, current and power of an Eastron meter
+    for (std::uint16_t address = 0; address < 18; address += 2) {
+        planner.add(input(address, 2));
+    }
+    planner.add(input(70, 2));
+
+    planner.start(RegisterPlanner::Clock::time_point{});
+    const auto& blocks = planner.poll(RegisterPlanner::Clock::time_point{});
+    ASSERT_EQ(blocks.size(), 2);
+    EXPECT_EQ(blocks.at(0).address, 0);
+    EXPECT_EQ(blocks.at(0).count, 18);
+    EXPECT_EQ(blocks.at(0).ranges.size(), 9);
+    EXPECT_EQ(blocks.at(1).address, 70);
+    EXPECT_EQ(blocks.at(1).count, 2);
+}
+
+TEST(RegisterPlannerTest, nearby_ranges_are_merged_up_to_max_gap) {
+    RegisterPlanner planner(4);
+    planner.add(input(0, 2));
+    planner.add(input(6, 2));   // gap of 4
+    planner.add(input(13, 2));  // gap of 5
+    planner.add(holding(8, 1)); // other function code
+
+    const auto& blocks = planner.plan({true, true, true, true});
+    ASSERT_EQ(blocks.size(), 3);
+    EXPECT_EQ(blocks.at(0).function, ModbusFunction::ReadHoldingRegisters);
+    EXPECT_EQ(blocks.at(1).function, ModbusFunction::ReadInputRegisters);
+    EXPECT_EQ(blocks.at(1).address, 0);
+    EXPECT_EQ(blocks.at(1).count, 8);
+    EXPECT_EQ(blocks.at(2).address, 13);
+}
+
+TEST(RegisterPlannerTest, reads_are_limited_to_125_registers) {
+    RegisterPlanner planner;
+    for (std::uint16_t address = 0; address < 300; address += 2) {
+        planner.add(input(address, 2));
+    }
+
+    const auto& blocks = planner.plan(std::vector<bool>(planner.size(), true));
+    ASSERT_EQ(blocks.size(), 3);
+    for (const auto& block : blocks) {
+        EXPECT_LE(block.count, RegisterPlanner::MAX_READ_REGISTERS);
+    }
+    EXPECT_EQ(blocks.at(0).count, 124);
+    EXPECT_EQ(blocks.at(1).address, 124);
+    EXPECT_THROW(planner.add(input(400, 126)), std::runtime_error);
+}
+
+TEST(RegisterPlannerTest, overlapping_and_identical_ranges) {
+    RegisterPlanner planner;
+    const auto exponent = planner.add(input(10, 1));
+    EXPECT_EQ(planner.add(input(10, 1)), exponent);
+    EXPECT_NE(planner.add(input(10, 1, 5000ms)), exponent);
+    planner.add(input(9, 2));
+
+    const auto& blocks = planner.plan(std::vector<bool>(planner.size(), true));
+    ASSERT_EQ(blocks.size(), 1);
+    EXPECT_EQ(blocks.at(0).address, 9);
+    EXPECT_EQ(blocks.at(0).count, 2);
+    EXPECT_EQ(blocks.at(0).ranges.size(), 3);
+}
+
+TEST(RegisterPlannerTest, ranges_are_polled_at_their_interval) {
+    RegisterPlanner planner;
+    const auto power = planner.add(input(12, 2, 1000ms));
+    const auto energy = planner.add(input(72, 2, 5000ms));
+
+    const auto start = RegisterPlanner::Clock::time_point{};
+    planner.start(start);
+
+    std::size_t power_polls = 0;
+    std::size_t energy_polls = 0;
+    for (auto now = planner.next_deadline(); now < start + 10s; now = planner.next_deadline()) {
+        for (const auto& block : planner.poll(now)) {
+            for (const auto id : block.ranges) {
+                power_polls += (id == power);
+                energy_polls += (id == energy);
+            }
+        }
+    }
+    EXPECT_EQ(power_polls, 10);
+    EXPECT_EQ(energy_polls, 2);
+}
+
+TEST(RegisterPlannerTest, missed_deadlines_are_skipped) {
+    RegisterPlanner planner;
+    planner.add(input(0, 2, 1000ms));
+
+    const auto start = RegisterPlanner::Clock::time_point{};
+    planner.start(start);
+    EXPECT_EQ(planner.poll(start).size(), 1);
+    EXPECT_EQ(planner.next_deadline(), start + 1s);
+
+    // polled late, but within the period: the period stays aligned
+    planner.poll(start + 1200ms);
+    EXPECT_EQ(planner.next_deadline(), start + 2s);
+
+    // a whole period was missed
+    planner.poll(start + 4500ms);
+    EXPECT_EQ(planner.next_deadline(), start + 5500ms);
+    EXPECT_TRUE(planner.poll(start + 5s).empty());
+}
+
+TEST(RegisterPlannerTest, expected_load) {
+    RegisterPlanner planner;
+    planner.add(input(0, 2, 1000ms));
+    planner.add(input(2, 2, 1000ms));
+    planner.add(input(72, 2, 5000ms));
+
+    const auto load = planner.expected_load(std::chrono::minutes(1));
+    EXPECT_EQ(load.requests, 60 + 12);
+    EXPECT_EQ(load.registers, 60 * 4 + 12 * 2);
+    EXPECT_EQ(load.frame_bytes, 60 * BusLoad::rtu_frame_bytes(4) + 12 * BusLoad::rtu_frame_bytes(2));
+}
+
+} // namespace module
@@ -28,12 +28,15 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <cbv2g/exi_v2gtp.h>
+
 #include "proxy.hpp"
 
 #define DEFAULT_SOCKET_BACKLOG        3
 #define DEFAULT_TCP_PORT              61342
 #define DEFAULT_TLS_PORT              64110
 #define ERROR_SESSION_ALREADY_STARTED 2
+#define TCP_CLOSE_TIMEOUT_MS          5000
 
 /*!
  * \brief connection_create_socket This function creates a tcp/tls socket
@@ -353,6 +356,39 @@ ssize_t connection_write(struct v2g_connection* conn, unsigned char* buf, size_t
     return (ssize_t)bytes_written;
 }
 
+/*!
+ * \brief connection_wait_closed This function discards received data until the peer closed the
+ * connection or the timeout expired
+ * \param fd is the socket after shutdown(SHUT_WR)
+ * \param timeout_ms is the maximum time to wait
+ */
+static void connection_wait_closed(int fd, int timeout_ms) {
+    struct timespec ts_start;
+    struct timespec ts_current;
+    unsigned char buf[512];
+
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+    ts_current = ts_start;
+
+    for (int remaining = timeout_ms; remaining > 0;
+         remaining = timeout_ms - (int)timespec_to_ms(timespec_sub(ts_current, ts_start))) {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        const int ret = poll(&pfd, 1, remaining);
+        if (ret == 0) {
+            dlog(DLOG_LEVEL_WARNING, "Multiplexer: TCP peer did not close the connection");
+            break;
+        }
+        if (ret == -1 && errno != EINTR) {
+            break;
+        }
+        if (ret > 0 && read(fd, buf, sizeof(buf)) <= 0) {
+            /* connection closed by peer (or failed) */
+            break;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &ts_current);
+    }
+}
+
 /**
  * This is the 'main' function of a thread, which handles a TCP connection.
  */
@@ -362,14 +398,12 @@ void* connection_handle_tcp(void* data) {
     /* tear down connection gracefully */
     dlog(DLOG_LEVEL_INFO, "Multiplexer: Closing TCP connection");
 
-    std::this_thread::sleep_for(std::chrono::seconds(2));
-
-    if (shutdown(conn->conn.socket_fd, SHUT_RDWR) == -1) {
+    if (shutdown(conn->conn.socket_fd, SHUT_WR) == -1) {
         dlog(DLOG_LEVEL_ERROR, "shutdown() failed: %s", strerror(errno));
     }
 
     // Waiting for client closing the connection
-    std::this_thread::sleep_for(std::chrono::seconds(3));
+    connection_wait_closed(conn->conn.socket_fd, TCP_CLOSE_TIMEOUT_MS);
 
     if (close(conn->conn.socket_fd) == -1) {
         dlog(DLOG_LEVEL_ERROR, "close() failed: %s", strerror(errno));
@@ -425,66 +459,27 @@ int connection_proxy(struct v2g_connection* conn, int proxy_fd) {
 
     dlog(DLOG_LEVEL_INFO, "Multiplexer: Proxy TCP->TCP");
 
-    int ev_fd = conn->conn.socket_fd;
-
     // SupportedAppProtocolReq message is still in buffer, we need to forward it to the external stack
-    write(proxy_fd, conn->buffer, conn->payload_len + 8);
-
-    struct pollfd poll_list[2];
-    poll_list[0].fd = proxy_fd;
-    poll_list[1].fd = ev_fd;
-    poll_list[0].events = POLLIN;
-    poll_list[1].events = POLLIN;
-
-    unsigned char buf[2048];
-
-    while (true) {
-
-        int ret = poll(poll_list, 2, -1);
-
-        if (ret == -1) {
-            return -1; // poll error
-        }
-
-        // Timed out, but we blocked forever. This could be a spurious wakeup, so just try again.
-        if (ret == 0) {
+    const std::size_t len = conn->payload_len + V2GTP_HEADER_LENGTH;
+    std::size_t written = 0;
+    while (written < len) {
+        const ssize_t rv = write(proxy_fd, &conn->buffer[written], len - written);
+        if (rv == -1 && errno == EINTR) {
             continue;
         }
-
-        if (poll_list[0].revents & POLLIN) {
-            // we can read from proxy (connection to local ISO module)
-            int nrbytes = read(proxy_fd, buf, sizeof(buf));
-
-            if (nrbytes == 0) {
-                break;
-            }
-            // write data to EV
-            nrbytes = conn->write(conn, buf, nrbytes);
-        }
-
-        if (poll_list[0].revents & POLLERR or poll_list[0].revents & POLLHUP or poll_list[0].revents & POLLNVAL) {
-            // something is wrong with the TCP connection to the ISO module
-            return -1;
-        }
-
-        if (poll_list[1].revents & POLLIN) {
-            // we can read from EV
-            int nrbytes = conn->read(conn, buf, sizeof(buf), false);
-            if (nrbytes == 0) {
-                break;
-            }
-            // write data to proxy
-            nrbytes = write(proxy_fd, buf, nrbytes);
-        }
-
-        if (poll_list[1].revents & POLLERR or poll_list[1].revents & POLLHUP or poll_list[1].revents & POLLNVAL) {
-            // something is wrong with the TCP connection to the EV
+        if (rv <= 0) {
+            dlog(DLOG_LEVEL_ERROR, "write(proxy) failed: %s", strerror(errno));
+            close(proxy_fd);
             return -1;
         }
+        written += rv;
     }
 
+    // data is forwarded in the kernel in both directions
+    const int rv = proxy_splice(conn->conn.socket_fd, proxy_fd);
+
     close(proxy_fd);
-    return 0;
+    return rv;
 }
 
 static void* connection_server(void* data) {
@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <initializer_list>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "proxy.hpp"
+
+namespace {
+
+/* maximum number of bytes moved by one splice() call, the default pipe capacity */
+constexpr std::size_t SPLICE_CHUNK_SIZE = 64 * 1024;
+
+/* one direction of the proxy: from socket -> pipe -> to socket */
+struct proxy_direction {
+    int from{-1};
+    int to{-1};
+    int pipe_fds[2]{-1, -1};
+    std::size_t pending{0}; /* bytes in the pipe not yet sent */
+    bool eof{false};        /* from socket has been closed by the peer */
+};
+
+/*!
+ * \brief move received data from the source socket into the pipe
+ * \return false on errors
+ */
+bool proxy_fill(proxy_direction& dir) {
+    const ssize_t n =
+        splice(dir.from, nullptr, dir.pipe_fds[1], nullptr, SPLICE_CHUNK_SIZE, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (n > 0) {
+        dir.pending += n;
+    } else if (n == 0) {
+        dir.eof = true;
+    } else if ((errno != EAGAIN) && (errno != EINTR)) {
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief send as much of the pipe content to the destination socket as possible without blocking
+ * \return false on errors
+ */
+bool proxy_drain(proxy_direction& dir) {
+    while (dir.pending > 0) {
+        const ssize_t n =
+            splice(dir.pipe_fds[0], nullptr, dir.to, nullptr, dir.pending, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n > 0) {
+            dir.pending -= n;
+        } else if ((n == -1) && (errno == EINTR)) {
+            continue;
+        } else if ((n == -1) && (errno == EAGAIN)) {
+            /* socket buffer is full, wait for POLLOUT */
+            break;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* the direction is finished when the peer closed it and everything has been forwarded */
+bool proxy_done(const proxy_direction& dir) {
+    return dir.eof && (dir.pending == 0);
+}
+
+} // namespace
+
+int proxy_splice(int ev_fd, int proxy_fd) {
+    proxy_direction to_proxy;
+    to_proxy.from = ev_fd;
+    to_proxy.to = proxy_fd;
+
+    proxy_direction to_ev;
+    to_ev.from = proxy_fd;
+    to_ev.to = ev_fd;
+
+    if ((pipe2(to_proxy.pipe_fds, O_CLOEXEC | O_NONBLOCK) == -1) ||
+        (pipe2(to_ev.pipe_fds, O_CLOEXEC | O_NONBLOCK) == -1)) {
+        perror("pipe2()");
+        for (const int fd : {to_proxy.pipe_fds[0], to_proxy.pipe_fds[1]}) {
+            if (fd != -1) {
+                close(fd);
+            }
+        }
+        return -1;
+    }
+
+    /* SPLICE_F_NONBLOCK only applies to the pipe, the sockets need O_NONBLOCK as well */
+    const int ev_flags = fcntl(ev_fd, F_GETFL);
+    const int proxy_flags = fcntl(proxy_fd, F_GETFL);
+    fcntl(ev_fd, F_SETFL, ev_flags | O_NONBLOCK);
+    fcntl(proxy_fd, F_SETFL, proxy_flags | O_NONBLOCK);
+
+    int rv = 0;
+    struct pollfd poll_list[2];
+
+    /* like the copying proxy: stop as soon as one of the peers closed the connection */
+    while (!proxy_done(to_proxy) && !proxy_done(to_ev)) {
+        /* only read when the pipe is empty, otherwise wait until the destination accepts data */
+        poll_list[0].events = ((!to_proxy.eof && (to_proxy.pending == 0)) ? POLLIN : 0) |
+                              ((to_ev.pending > 0) ? POLLOUT : 0);
+        poll_list[1].events = ((!to_ev.eof && (to_ev.pending == 0)) ? POLLIN : 0) |
+                              ((to_proxy.pending > 0) ? POLLOUT : 0);
+        /* a negative fd is ignored, so a pending POLLHUP doesn't wake us up while only waiting for POLLOUT */
+        poll_list[0].fd = (poll_list[0].events != 0) ? ev_fd : -1;
+        poll_list[1].fd = (poll_list[1].events != 0) ? proxy_fd : -1;
+
+        const int ret = poll(poll_list, 2, -1);
+        if (ret == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            rv = -1;
+            break;
+        }
+
+        if ((poll_list[0].revents & (POLLERR | POLLNVAL)) || (poll_list[1].revents & (POLLERR | POLLNVAL))) {
+            /* something is wrong with one of the TCP connections */
+            rv = -1;
+            break;
+        }
+
+        if ((poll_list[0].revents & (POLLIN | POLLHUP)) && !to_proxy.eof && (to_proxy.pending == 0)) {
+            if (!proxy_fill(to_proxy)) {
+                rv = -1;
+                break;
+            }
+        }
+        if ((poll_list[1].revents & (POLLIN | POLLHUP)) && !to_ev.eof && (to_ev.pending == 0)) {
+            if (!proxy_fill(to_ev)) {
+                rv = -1;
+                break;
+            }
+        }
+
+        /* try to forward right away, this avoids another poll() round trip per message */
+        if (!proxy_drain(to_proxy) || !proxy_drain(to_ev)) {
+            rv = -1;
+            break;
+        }
+    }
+
+    for (const int fd : {to_proxy.pipe_fds[0], to_proxy.pipe_fds[1], to_ev.pipe_fds[0], to_ev.pipe_fds[1]}) {
+        close(fd);
+    }
+
+    fcntl(ev_fd, F_SETFL, ev_flags);
+    fcntl(proxy_fd, F_SETFL, proxy_flags);
+
+    return rv;
+}
@@ -41,4 +41,17 @@ inline int proxy_connect(uint16_t port) {
     return sock_fd;
 }
 
+/*!
+ * \brief forward data between the EV and the local V2G server
+ *
+ * Both directions are served by one poll() loop. The data is moved with
+ * splice() through a pipe per direction, so it stays in the kernel and is
+ * never copied to user space.
+ *
+ * \param ev_fd TCP socket connected to the EV
+ * \param proxy_fd TCP socket connected to the local V2G server
+ * \return 0 when one of the peers closed the connection, -1 on errors
+ */
+int proxy_splice(int ev_fd, int proxy_fd);
+
 #endif /* ISOMUX_PROXY_H */
@@ -0,0 +1,213 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+/*
+ * latency and throughput of the IsoMux TCP proxy
+ *
+ * Compares a direct loopback connection with a connection through the
+ * previous read()/write() proxy loop and through proxy_splice(). Latency is
+ * measured as request/response round trips of V2G sized messages,
+ * throughput as one large transfer from the EV to the V2G server.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <poll.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "tcp_pair.hpp"
+#include <proxy.hpp>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* short_opts = "hn:s:m:";
+std::size_t round_trips{10000};
+std::size_t message_size{256};
+std::size_t transfer_mb{256};
+
+void parse_options(int argc, char** argv) {
+    int c;
+
+    while ((c = getopt(argc, argv, short_opts)) != -1) {
+        switch (c) {
+        case 'n':
+            round_trips = std::max<std::size_t>(1, std::strtoul(optarg, nullptr, 10));
+            break;
+        case 's':
+            message_size = std::max<std::size_t>(1, std::strtoul(optarg, nullptr, 10));
+            break;
+        case 'm':
+            transfer_mb = std::max<std::size_t>(1, std::strtoul(optarg, nullptr, 10));
+            break;
+        case 'h':
+        case '?':
+            std::cout << "Usage: " << argv[0] << " [-n round trips] [-s message size] [-m transfer MiB]" << std::endl;
+            exit(1);
+            break;
+        default:
+            exit(2);
+        }
+    }
+}
+
+/* the proxy loop used before proxy_splice(), copies through a user space buffer */
+int proxy_copy(int ev_fd, int proxy_fd) {
+    struct pollfd poll_list[2];
+    poll_list[0].fd = proxy_fd;
+    poll_list[1].fd = ev_fd;
+    poll_list[0].events = POLLIN;
+    poll_list[1].events = POLLIN;
+
+    unsigned char buf[2048];
+
+    while (true) {
+        if (poll(poll_list, 2, -1) == -1) {
+            return -1;
+        }
+        if (poll_list[0].revents & POLLIN) {
+            const ssize_t n = read(proxy_fd, buf, sizeof(buf));
+            if ((n <= 0) || !write_all(ev_fd, buf, n)) {
+                break;
+            }
+        }
+        if (poll_list[1].revents & POLLIN) {
+            const ssize_t n = read(ev_fd, buf, sizeof(buf));
+            if ((n <= 0) || !write_all(proxy_fd, buf, n)) {
+                break;
+            }
+        }
+    }
+    return 0;
+}
+
+enum class Mode {
+    direct,
+    copy,
+    splice,
+};
+
+struct Path {
+    int ev{-1};
+    int server{-1};
+    std::vector<int> fds;
+    std::thread mux;
+
+    explicit Path(Mode mode) {
+        const auto [ev_side, ev_fd] = tcp_pair();
+        if (mode == Mode::direct) {
+            ev = ev_side;
+            server = ev_fd;
+            fds = {ev, server};
+            return;
+        }
+        const auto [proxy_fd, server_side] = tcp_pair();
+        ev = ev_side;
+        server = server_side;
+        fds = {ev, ev_fd, proxy_fd, server};
+        mux = std::thread([mode, ev_fd = ev_fd, proxy_fd = proxy_fd]() {
+            (mode == Mode::copy) ? proxy_copy(ev_fd, proxy_fd) : proxy_splice(ev_fd, proxy_fd);
+        });
+    }
+
+    ~Path() {
+        shutdown(ev, SHUT_RDWR);
+        if (mux.joinable()) {
+            mux.join();
+        }
+        for (const int fd : fds) {
+            close(fd);
+        }
+    }
+};
+
+double to_us(Clock::duration duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+void latency(Mode mode, const char* name) {
+    Path path(mode);
+    std::vector<std::uint8_t> msg(message_size, 0x5a);
+    std::vector<std::uint8_t> buf(message_size);
+
+    std::thread server([&path, &buf]() {
+        std::vector<std::uint8_t> req(buf.size());
+        for (std::size_t i = 0; i < round_trips; i++) {
+            if (!read_all(path.server, req.data(), req.size()) || !write_all(path.server, req.data(), req.size())) {
+                break;
+            }
+        }
+    });
+
+    std::vector<Clock::duration> durations;
+    durations.reserve(round_trips);
+    for (std::size_t i = 0; i < round_trips; i++) {
+        const auto start = Clock::now();
+        if (!write_all(path.ev, msg.data(), msg.size()) || !read_all(path.ev, buf.data(), buf.size())) {
+            break;
+        }
+        durations.push_back(Clock::now() - start);
+    }
+    server.join();
+
+    std::sort(durations.begin(), durations.end());
+    if (durations.empty()) {
+        std::cout << name << ": no round trips" << std::endl;
+        return;
+    }
+    std::cout << name << ": round trip median " << to_us(durations[durations.size() / 2]) << " us, p99 "
+              << to_us(durations[durations.size() * 99 / 100]) << " us" << std::endl;
+}
+
+void throughput(Mode mode, const char* name) {
+    Path path(mode);
+    const std::size_t total = transfer_mb * 1024 * 1024;
+
+    const auto start = Clock::now();
+    std::thread server([&path, total]() {
+        std::vector<std::uint8_t> buf(64 * 1024);
+        std::size_t received = 0;
+        while (received < total) {
+            const ssize_t n = read(path.server, buf.data(), buf.size());
+            if (n <= 0) {
+                break;
+            }
+            received += n;
+        }
+    });
+
+    std::vector<std::uint8_t> chunk(64 * 1024, 0xa5);
+    for (std::size_t sent = 0; sent < total; sent += chunk.size()) {
+        if (!write_all(path.ev, chunk.data(), chunk.size())) {
+            break;
+        }
+    }
+    server.join();
+    const auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << name << ": " << static_cast<double>(transfer_mb) / seconds << " MiB/s" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    parse_options(argc, argv);
+
+    std::cout << round_trips << " round trips of " << message_size << " bytes" << std::endl;
+    latency(Mode::direct, "direct          ");
+    latency(Mode::copy, "read/write proxy");
+    latency(Mode::splice, "splice proxy    ");
+
+    std::cout << transfer_mb << " MiB from EV to server" << std::endl;
+    throughput(Mode::direct, "direct          ");
+    throughput(Mode::copy, "read/write proxy");
+    throughput(Mode::splice, "splice proxy    ");
+
+    return 0;
+}
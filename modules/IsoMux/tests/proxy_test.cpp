@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <future>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tcp_pair.hpp"
+#include <proxy.hpp>
+
+namespace {
+
+/* EV <-> (ev_fd | mux | proxy_fd) <-> V2G server */
+class ProxyTest : public testing::Test {
+protected:
+    int ev{-1};
+    int ev_fd{-1};
+    int proxy_fd{-1};
+    int server{-1};
+    std::future<int> mux;
+
+    void SetUp() override {
+        std::tie(ev, ev_fd) = tcp_pair();
+        std::tie(proxy_fd, server) = tcp_pair();
+        ASSERT_NE(ev_fd, -1);
+        ASSERT_NE(server, -1);
+        mux = std::async(std::launch::async, [this]() { return proxy_splice(ev_fd, proxy_fd); });
+    }
+
+    void TearDown() override {
+        for (const int fd : {ev, ev_fd, proxy_fd, server}) {
+            if (fd != -1) {
+                close(fd);
+            }
+        }
+    }
+};
+
+TEST_F(ProxyTest, RequestResponse) {
+    const std::string req = "SupportedAppProtocolReq";
+    const std::string res = "SupportedAppProtocolRes";
+    std::string buf;
+
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(write_all(ev, req.data(), req.size()));
+        buf.resize(req.size());
+        ASSERT_TRUE(read_all(server, &buf[0], buf.size()));
+        EXPECT_EQ(buf, req);
+
+        ASSERT_TRUE(write_all(server, res.data(), res.size()));
+        buf.resize(res.size());
+        ASSERT_TRUE(read_all(ev, &buf[0], buf.size()));
+        EXPECT_EQ(buf, res);
+    }
+
+    shutdown(ev, SHUT_WR);
+    EXPECT_EQ(mux.get(), 0);
+}
+
+TEST_F(ProxyTest, LargeTransferBothDirections) {
+    std::vector<std::uint8_t> up(8 * 1024 * 1024);
+    std::vector<std::uint8_t> down(up.size());
+    std::mt19937 rng(42);
+    for (std::size_t i = 0; i < up.size(); i++) {
+        up[i] = rng();
+        down[i] = rng();
+    }
+
+    // both sides write and read at the same time, so the proxy has to serve both directions
+    auto ev_writer = std::async(std::launch::async, [&]() { return write_all(ev, up.data(), up.size()); });
+    auto server_writer =
+        std::async(std::launch::async, [&]() { return write_all(server, down.data(), down.size()); });
+
+    std::vector<std::uint8_t> up_received(up.size());
+    std::vector<std::uint8_t> down_received(down.size());
+    auto server_reader = std::async(std::launch::async,
+                                    [&]() { return read_all(server, up_received.data(), up_received.size()); });
+    ASSERT_TRUE(read_all(ev, down_received.data(), down_received.size()));
+    ASSERT_TRUE(server_reader.get());
+    ASSERT_TRUE(ev_writer.get());
+    ASSERT_TRUE(server_writer.get());
+
+    EXPECT_EQ(up, up_received);
+    EXPECT_EQ(down, down_received);
+
+    shutdown(server, SHUT_WR);
+    EXPECT_EQ(mux.get(), 0);
+}
+
+TEST_F(ProxyTest, ServerCloseForwardsPendingData) {
+    const std::string res = "SessionStopRes";
+    ASSERT_TRUE(write_all(server, res.data(), res.size()));
+    close(server);
+    server = -1;
+
+    EXPECT_EQ(mux.get(), 0);
+
+    std::string buf(res.size(), '\0');
+    ASSERT_TRUE(read_all(ev, &buf[0], buf.size()));
+    EXPECT_EQ(buf, res);
+}
+
+} // namespace
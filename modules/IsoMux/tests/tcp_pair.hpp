@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#ifndef ISOMUX_TESTS_TCP_PAIR_HPP
+#define ISOMUX_TESTS_TCP_PAIR_HPP
+
+#include <arpa/inet.h>
+#include <cstddef>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+
+/*!
+ * \brief create two connected TCP sockets on the IPv6 loopback interface
+ * \return the client and the accepted socket, -1 on errors
+ */
+inline std::pair<int, int> tcp_pair() {
+    std::pair<int, int> result{-1, -1};
+
+    const int listen_fd = socket(AF_INET6, SOCK_STREAM, IPPROTO_TCP);
+    struct sockaddr_in6 addr = {};
+    socklen_t addrlen = sizeof(addr);
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_loopback;
+
+    if ((listen_fd != -1) && (bind(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0) &&
+        (listen(listen_fd, 1) == 0) &&
+        (getsockname(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), &addrlen) == 0)) {
+        result.first = socket(AF_INET6, SOCK_STREAM, IPPROTO_TCP);
+        if (connect(result.first, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0) {
+            result.second = accept(listen_fd, nullptr, nullptr);
+        }
+    }
+
+    if (listen_fd != -1) {
+        close(listen_fd);
+    }
+
+    // V2G messages are small request/response pairs
+    const int enable = 1;
+    for (const int fd : {result.first, result.second}) {
+        if (fd != -1) {
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        }
+    }
+    return result;
+}
+
+/*!
+ * \brief read exactly count bytes
+ * \return false when the connection was closed or failed before
+ */
+inline bool read_all(int fd, void* buf, std::size_t count) {
+    auto* ptr = static_cast<unsigned char*>(buf);
+    while (count > 0) {
+        const ssize_t n = read(fd, ptr, count);
+        if (n <= 0) {
+            return false;
+        }
+        ptr += n;
+        count -= n;
+    }
+    return true;
+}
+
+/*!
+ * \brief write exactly count bytes
+ * \return false on errors
+ */
+inline bool write_all(int fd, const void* buf, std::size_t count) {
+    const auto* ptr = static_cast<const unsigned char*>(buf);
+    while (count > 0) {
+        const ssize_t n = write(fd, ptr, count);
+        if (n <= 0) {
+            return false;
+        }
+        ptr += n;
+        count -= n;
+    }
+    return true;
+}
+
+#endif // ISOMUX_TESTS_TCP_PAIR_HPP
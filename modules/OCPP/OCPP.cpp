@@ -70,35 +70,21 @@ void create_empty_user_config(const fs::path& user_config_path) {
     }
 }
 
-void OCPP::set_external_limits(const std::map<int32_t, ocpp::v16::EnhancedChargingSchedule>& charging_schedules) {
+void OCPP::set_external_limits(const std::map<int32_t, ocpp::v16::EnhancedChargingSchedule>& charging_schedules,
+                               bool publish_all) {
     const auto start_time = ocpp::DateTime();
 
-    // iterate over all schedules reported by the libocpp to create ExternalLimits
-    // for each connector
-    for (auto const& [connector_id, schedule] : charging_schedules) {
-        types::energy::ExternalLimits limits;
-        std::vector<types::energy::ScheduleReqEntry> schedule_import;
-        for (const auto period : schedule.chargingSchedulePeriod) {
-            types::energy::ScheduleReqEntry schedule_req_entry;
-            types::energy::LimitsReq limits_req;
-            const auto timestamp = start_time.to_time_point() + std::chrono::seconds(period.startPeriod);
-            schedule_req_entry.timestamp = ocpp::DateTime(timestamp).to_rfc3339();
-            if (schedule.chargingRateUnit == ocpp::v16::ChargingRateUnit::A) {
-                limits_req.ac_max_current_A = period.limit;
-                if (period.numberPhases.has_value()) {
-                    limits_req.ac_max_phase_count = period.numberPhases.value();
-                }
-                if (schedule.minChargingRate.has_value()) {
-                    limits_req.ac_min_current_A = schedule.minChargingRate.value();
-                }
-            } else {
-                limits_req.total_power_W = period.limit;
-            }
-            schedule_req_entry.limits_to_leaves = limits_req;
-            schedule_import.push_back(schedule_req_entry);
-        }
-        limits.schedule_import.emplace(schedule_import);
+    std::lock_guard<std::mutex> lock(this->external_limits_mutex);
+    if (publish_all) {
+        // other modules may have overwritten the external limits of an EvseManager in the meantime
+        this->external_limits_compiler.reset();
+    }
+    // create ExternalLimits for each connector whose schedule reported by the libocpp changed since the last call
+    const auto changed_limits = this->external_limits_compiler.update(charging_schedules, start_time);
+    EVLOG_debug << "OCPP external limits: " << changed_limits.size() << " of " << charging_schedules.size()
+                << " connectors changed";
 
+    for (auto const& [connector_id, limits] : changed_limits) {
         if (connector_id == 0) {
             if (!this->r_connector_zero_sink.empty()) {
                 EVLOG_debug << "OCPP sets the following external limits for connector 0: \n" << limits;
@@ -670,7 +656,7 @@ void OCPP::ready() {
     this->charging_schedules_timer = std::make_unique<Everest::SteadyTimer>([this]() {
         const auto charging_schedules = this->charge_point->get_all_enhanced_composite_charging_schedules(
             this->config.PublishChargingScheduleDurationS);
-        this->set_external_limits(charging_schedules);
+        this->set_external_limits(charging_schedules, true);
         this->publish_charging_schedules(charging_schedules);
     });
     if (this->config.PublishChargingScheduleIntervalS > 0) {
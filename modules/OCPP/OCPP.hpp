@@ -45,6 +45,8 @@
 #include <ocpp/v16/types.hpp>
 #include <ocpp/v201/ocpp_types.hpp>
 
+#include "external_limits.hpp"
+
 using EvseConnectorMap = std::map<int32_t, std::map<int32_t, int32_t>>;
 using ClearedErrorId = std::string;
 using EventQueue =
@@ -138,7 +140,11 @@ private:
     // ev@211cfdbe-f69a-4cd6-a4ec-f8aaa3d1b6c8:v1
     // insert your private definitions here
     std::filesystem::path ocpp_share_path;
-    void set_external_limits(const std::map<int32_t, ocpp::v16::EnhancedChargingSchedule>& charging_schedules);
+    // sends the limits of the connectors whose schedule changed, or of all connectors if publish_all is set
+    void set_external_limits(const std::map<int32_t, ocpp::v16::EnhancedChargingSchedule>& charging_schedules,
+                             bool publish_all = false);
+    ExternalLimitsCompiler external_limits_compiler;
+    std::mutex external_limits_mutex;
     void publish_charging_schedules(const std::map<int32_t, ocpp::v16::EnhancedChargingSchedule>& charging_schedules);
 
     void init_evse_subscriptions(); // initialize subscriptions to all EVSEs provided by r_evse_manager
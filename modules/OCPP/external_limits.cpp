@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include <external_limits.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+
+namespace module {
+
+namespace {
+
+using TimePoint = decltype(std::declval<ocpp::DateTime>().to_time_point());
+
+std::int64_t to_ms(const TimePoint& time_point) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time_point.time_since_epoch()).count();
+}
+
+TimePoint from_ms(std::int64_t ms) {
+    return TimePoint(std::chrono::duration_cast<TimePoint::duration>(std::chrono::milliseconds(ms)));
+}
+
+void hash_combine(std::size_t& seed, std::size_t value) {
+    seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+std::size_t hash_float(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return std::hash<std::uint32_t>{}(bits);
+}
+
+} // namespace
+
+std::map<int32_t, types::energy::ExternalLimits>
+ExternalLimitsCompiler::update(const std::map<int32_t, ocpp::v16::EnhancedChargingSchedule>& charging_schedules,
+                               const ocpp::DateTime& start_time) {
+    const auto start_ms = to_ms(start_time.to_time_point());
+    std::map<int32_t, types::energy::ExternalLimits> result;
+
+    // only entries used by this update are kept, older timelines are in the past anyway
+    std::unordered_map<std::size_t, CacheEntry> next_cache;
+
+    for (const auto& [connector_id, schedule] : charging_schedules) {
+        auto timeline = to_timeline(schedule, start_ms);
+
+        const auto it = this->published.find(connector_id);
+        if (it != this->published.end() && is_unchanged(it->second, timeline)) {
+            this->statistics.unchanged++;
+            continue;
+        }
+
+        const auto key = hash(timeline);
+        auto cached = next_cache.find(key);
+        if (cached == next_cache.end()) {
+            const auto previous = this->cache.find(key);
+            if (previous != this->cache.end() && previous->second.timeline == timeline) {
+                cached = next_cache.emplace(key, std::move(previous->second)).first;
+                this->cache.erase(previous);
+            }
+        }
+
+        if (cached != next_cache.end() && cached->second.timeline == timeline) {
+            this->statistics.cached++;
+            result.emplace(connector_id, cached->second.limits);
+        } else {
+            this->statistics.compiled++;
+            auto limits = compile(timeline);
+            result.emplace(connector_id, limits);
+            if (cached == next_cache.end()) {
+                next_cache.emplace(key, CacheEntry{timeline, std::move(limits)});
+            }
+        }
+
+        this->published[connector_id] = std::move(timeline);
+    }
+
+    this->cache = std::move(next_cache);
+    return result;
+}
+
+void ExternalLimitsCompiler::reset() {
+    this->published.clear();
+    this->cache.clear();
+}
+
+ExternalLimitsCompiler::Timeline
+ExternalLimitsCompiler::to_timeline(const ocpp::v16::EnhancedChargingSchedule& schedule, std::int64_t start_ms) {
+    Timeline timeline;
+    timeline.unit = schedule.chargingRateUnit;
+    timeline.min_charging_rate = schedule.minChargingRate;
+    timeline.periods.reserve(schedule.chargingSchedulePeriod.size());
+    for (const auto& period : schedule.chargingSchedulePeriod) {
+        timeline.periods.push_back(
+            {start_ms + static_cast<std::int64_t>(period.startPeriod) * 1000, period.limit, period.numberPhases});
+    }
+    return timeline;
+}
+
+std::size_t ExternalLimitsCompiler::hash(const Timeline& timeline) {
+    std::size_t seed = std::hash<int>{}(static_cast<int>(timeline.unit));
+    hash_combine(seed, timeline.min_charging_rate.has_value() ? hash_float(timeline.min_charging_rate.value()) : 0);
+    for (const auto& period : timeline.periods) {
+        hash_combine(seed, std::hash<std::int64_t>{}(period.start_ms));
+        hash_combine(seed, hash_float(period.limit));
+        hash_combine(seed, period.number_phases.has_value() ? std::hash<int32_t>{}(period.number_phases.value()) : 0);
+    }
+    return seed;
+}
+
+types::energy::ExternalLimits ExternalLimitsCompiler::compile(const Timeline& timeline) {
+    types::energy::ExternalLimits limits;
+    std::vector<types::energy::ScheduleReqEntry> schedule_import;
+    schedule_import.reserve(timeline.periods.size());
+    for (const auto& period : timeline.periods) {
+        types::energy::ScheduleReqEntry schedule_req_entry;
+        types::energy::LimitsReq limits_req;
+        schedule_req_entry.timestamp = ocpp::DateTime(from_ms(period.start_ms)).to_rfc3339();
+        if (timeline.unit == ocpp::v16::ChargingRateUnit::A) {
+            limits_req.ac_max_current_A = period.limit;
+            if (period.number_phases.has_value()) {
+                limits_req.ac_max_phase_count = period.number_phases.value();
+            }
+            if (timeline.min_charging_rate.has_value()) {
+                limits_req.ac_min_current_A = timeline.min_charging_rate.value();
+            }
+        } else {
+            limits_req.total_power_W = period.limit;
+        }
+        schedule_req_entry.limits_to_leaves = limits_req;
+        schedule_import.push_back(std::move(schedule_req_entry));
+    }
+    limits.schedule_import.emplace(std::move(schedule_import));
+    return limits;
+}
+
+bool ExternalLimitsCompiler::is_unchanged(const Timeline& published, const Timeline& next) {
+    if (published.unit != next.unit || published.min_charging_rate != next.min_charging_rate) {
+        return false;
+    }
+    if (published.periods.empty() || next.periods.empty()) {
+        return published.periods.empty() && next.periods.empty();
+    }
+
+    // the first period of next starts now, it has to continue the published period that is active now
+    const auto start_ms = next.periods.front().start_ms;
+    std::size_t active = 0;
+    while (active + 1 < published.periods.size() && published.periods[active + 1].start_ms <= start_ms) {
+        active++;
+    }
+    if (published.periods[active].start_ms > start_ms || !published.periods[active].same_limit(next.periods.front())) {
+        return false;
+    }
+
+    // all later periods have to be identical
+    if (published.periods.size() - active != next.periods.size()) {
+        return false;
+    }
+    for (std::size_t i = 1; i < next.periods.size(); i++) {
+        if (!(published.periods[active + i] == next.periods[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace module
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef OCPP_V16_EXTERNAL_LIMITS_HPP
+#define OCPP_V16_EXTERNAL_LIMITS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include <generated/types/energy.hpp>
+
+#include <ocpp/common/types.hpp>
+#include <ocpp/v16/types.hpp>
+
+namespace module {
+
+/// \brief Compiles the composite charging schedules of libocpp into types::energy::ExternalLimits.
+///
+/// libocpp computes the composite schedules relative to the current time, so the schedule of a connector looks
+/// different on every call even when none of its profiles changed. The compiler keeps the absolute timeline that was
+/// last returned for each connector and only returns a connector again when its limits from now on differ.
+/// Connectors with identical timelines (e.g. a TxDefaultProfile on all connectors) are converted only once, the
+/// results are cached by the hash of the timeline.
+class ExternalLimitsCompiler {
+public:
+    struct Statistics {
+        std::size_t compiled{0};  ///< schedules converted to ExternalLimits
+        std::size_t cached{0};    ///< changed schedules taken from the cache
+        std::size_t unchanged{0}; ///< schedules skipped because the effective limits did not change
+    };
+
+    /// \brief Returns the ExternalLimits of the connectors in \p charging_schedules whose effective limits differ
+    /// from the ones returned before. \p start_time is the time the composite schedules were computed for.
+    std::map<int32_t, types::energy::ExternalLimits>
+    update(const std::map<int32_t, ocpp::v16::EnhancedChargingSchedule>& charging_schedules,
+           const ocpp::DateTime& start_time);
+
+    /// \brief Forgets the returned schedules, the next update() returns all connectors.
+    void reset();
+
+    const Statistics& get_statistics() const {
+        return statistics;
+    }
+
+private:
+    struct Period {
+        std::int64_t start_ms; // absolute start time in milliseconds since the epoch
+        float limit;
+        std::optional<int32_t> number_phases;
+
+        bool same_limit(const Period& other) const {
+            return limit == other.limit && number_phases == other.number_phases;
+        }
+        bool operator==(const Period& other) const {
+            return start_ms == other.start_ms && same_limit(other);
+        }
+    };
+
+    struct Timeline {
+        ocpp::v16::ChargingRateUnit unit;
+        std::optional<float> min_charging_rate;
+        std::vector<Period> periods;
+
+        bool operator==(const Timeline& other) const {
+            return unit == other.unit && min_charging_rate == other.min_charging_rate && periods == other.periods;
+        }
+    };
+
+    struct CacheEntry {
+        Timeline timeline;
+        types::energy::ExternalLimits limits;
+    };
+
+    static Timeline to_timeline(const ocpp::v16::EnhancedChargingSchedule& schedule, std::int64_t start_ms);
+    static std::size_t hash(const Timeline& timeline);
+    static types::energy::ExternalLimits compile(const Timeline& timeline);
+
+    /// \brief true when \p next results in the same limits as \p published from the start of \p next on
+    static bool is_unchanged(const Timeline& published, const Timeline& next);
+
+    std::map<int32_t, Timeline> published;
+    std::unordered_map<std::size_t, CacheEntry> cache;
+    Statistics statistics;
+};
+
+} // namespace module
+
+#endif // OCPP_V16_EXTERNAL_LIMITS_HPP
@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+// Compares converting all composite schedules to ExternalLimits on every update (as done before) with the
+// ExternalLimitsCompiler for 1 - 100 connectors and 1 - 20 stacked profiles. Every update advances the time by one
+// second and changes the limit of one connector, the periodic republish of unchanged schedules is measured separately.
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <external_limits.hpp>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Schedules = std::map<int32_t, ocpp::v16::EnhancedChargingSchedule>;
+
+constexpr int UPDATES = 200;
+
+// the composite of stacked profiles: every profile adds a period with its own limit
+Schedules composite_schedules(int connectors, int profiles, int elapsed_s, int changed_connector, int generation) {
+    Schedules result;
+    for (int32_t connector = 1; connector <= connectors; connector++) {
+        ocpp::v16::EnhancedChargingSchedule schedule;
+        schedule.chargingRateUnit = ocpp::v16::ChargingRateUnit::A;
+        schedule.minChargingRate = 6.0F;
+        for (int profile = 0; profile < profiles; profile++) {
+            ocpp::v16::EnhancedChargingSchedulePeriod period;
+            period.startPeriod = (profile == 0) ? 0 : profile * 3600 - elapsed_s;
+            period.limit = 32.0F - static_cast<float>(profile % 4) * 4.0F;
+            if (connector == changed_connector && profile == 0) {
+                period.limit -= static_cast<float>(generation % 2);
+            }
+            period.numberPhases = 3;
+            period.stackLevel = profile;
+            schedule.chargingSchedulePeriod.push_back(period);
+        }
+        result[connector] = schedule;
+    }
+    return result;
+}
+
+// the conversion done by OCPP::set_external_limits before the compiler
+std::map<int32_t, types::energy::ExternalLimits> convert_all(const Schedules& charging_schedules,
+                                                             const ocpp::DateTime& start_time) {
+    std::map<int32_t, types::energy::ExternalLimits> result;
+    for (auto const& [connector_id, schedule] : charging_schedules) {
+        types::energy::ExternalLimits limits;
+        std::vector<types::energy::ScheduleReqEntry> schedule_import;
+        for (const auto period : schedule.chargingSchedulePeriod) {
+            types::energy::ScheduleReqEntry schedule_req_entry;
+            types::energy::LimitsReq limits_req;
+            const auto timestamp = start_time.to_time_point() + std::chrono::seconds(period.startPeriod);
+            schedule_req_entry.timestamp = ocpp::DateTime(timestamp).to_rfc3339();
+            if (schedule.chargingRateUnit == ocpp::v16::ChargingRateUnit::A) {
+                limits_req.ac_max_current_A = period.limit;
+                if (period.numberPhases.has_value()) {
+                    limits_req.ac_max_phase_count = period.numberPhases.value();
+                }
+                if (schedule.minChargingRate.has_value()) {
+                    limits_req.ac_min_current_A = schedule.minChargingRate.value();
+                }
+            } else {
+                limits_req.total_power_W = period.limit;
+            }
+            schedule_req_entry.limits_to_leaves = limits_req;
+            schedule_import.push_back(schedule_req_entry);
+        }
+        limits.schedule_import.emplace(schedule_import);
+        result[connector_id] = limits;
+    }
+    return result;
+}
+
+// size of the JSON published for the set_external_limits calls
+std::size_t json_bytes(const std::map<int32_t, types::energy::ExternalLimits>& limits) {
+    std::size_t bytes = 0;
+    for (const auto& [connector_id, connector_limits] : limits) {
+        const nlohmann::json json = connector_limits;
+        bytes += json.dump().size();
+    }
+    return bytes;
+}
+
+struct Result {
+    double us_per_update{0};
+    std::size_t bytes_per_update{0};
+    std::size_t calls_per_update{0};
+};
+
+template <typename Update> Result run(int connectors, int profiles, bool change, Update&& update) {
+    const ocpp::DateTime start_time;
+    std::size_t bytes = 0;
+    std::size_t calls = 0;
+    Clock::duration elapsed{0};
+
+    for (int i = 0; i <= UPDATES; i++) {
+        const auto schedules = composite_schedules(connectors, profiles, i, change ? (i % connectors) + 1 : 0, i);
+        const ocpp::DateTime now(start_time.to_time_point() + std::chrono::seconds(i));
+
+        const auto begin = Clock::now();
+        const auto limits = update(schedules, now);
+        const auto end = Clock::now();
+
+        // the first update publishes everything in both cases
+        if (i > 0) {
+            elapsed += end - begin;
+            bytes += json_bytes(limits);
+            calls += limits.size();
+        }
+    }
+
+    return {std::chrono::duration<double, std::micro>(elapsed).count() / UPDATES, bytes / UPDATES, calls / UPDATES};
+}
+
+} // namespace
+
+int main() {
+    std::printf("%10s %8s | %-32s | %-32s | %-32s\n", "connectors", "profiles", "convert all", "compiler, one changed",
+                "compiler, periodic republish");
+
+    for (const int connectors : {1, 10, 40, 100}) {
+        for (const int profiles : {1, 5, 10, 20}) {
+            const auto all = run(connectors, profiles, true, convert_all);
+
+            module::ExternalLimitsCompiler changed_compiler;
+            const auto changed = run(connectors, profiles, true, [&changed_compiler](const auto& s, const auto& t) {
+                return changed_compiler.update(s, t);
+            });
+
+            module::ExternalLimitsCompiler periodic_compiler;
+            const auto periodic = run(connectors, profiles, false, [&periodic_compiler](const auto& s, const auto& t) {
+                return periodic_compiler.update(s, t);
+            });
+
+            std::printf("%10d %8d", connectors, profiles);
+            for (const auto& result : {all, changed, periodic}) {
+                std::printf(" | %8.1f us %8zu B %4zu calls", result.us_per_update, result.bytes_per_update,
+                            result.calls_per_update);
+            }
+            std::printf("\n");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <utility>
+#include <vector>
+
+#include <external_limits.hpp>
+
+namespace module {
+
+class ExternalLimitsCompilerTest : public ::testing::Test {
+
+protected:
+    ExternalLimitsCompiler compiler;
+    ocpp::DateTime start_time;
+
+    // composite schedule with (startPeriod, limit) pairs in A
+    static ocpp::v16::EnhancedChargingSchedule schedule(const std::vector<std::pair<int32_t, float>>& periods) {
+        ocpp::v16::EnhancedChargingSchedule result;
+        result.chargingRateUnit = ocpp::v16::ChargingRateUnit::A;
+        for (const auto& [start, limit] : periods) {
+            ocpp::v16::EnhancedChargingSchedulePeriod period;
+            period.startPeriod = start;
+            period.limit = limit;
+            period.stackLevel = 0;
+            result.chargingSchedulePeriod.push_back(period);
+        }
+        return result;
+    }
+
+    ocpp::DateTime later(int32_t seconds) const {
+        return ocpp::DateTime(start_time.to_time_point() + std::chrono::seconds(seconds));
+    }
+};
+
+TEST_F(ExternalLimitsCompilerTest, first_update_returns_all_connectors) {
+    const auto result = compiler.update({{0, schedule({{0, 32}})}, {1, schedule({{0, 16}, {3600, 32}})}}, start_time);
+
+    ASSERT_EQ(result.size(), 2);
+    const auto& entries = result.at(1).schedule_import.value();
+    ASSERT_EQ(entries.size(), 2);
+    EXPECT_EQ(entries.at(0).timestamp, start_time.to_rfc3339());
+    EXPECT_EQ(entries.at(0).limits_to_leaves.ac_max_current_A.value(), 16);
+    EXPECT_EQ(entries.at(1).timestamp, later(3600).to_rfc3339());
+    EXPECT_EQ(entries.at(1).limits_to_leaves.ac_max_current_A.value(), 32);
+}
+
+TEST_F(ExternalLimitsCompilerTest, same_profiles_later_are_unchanged) {
+    compiler.update({{1, schedule({{0, 16}, {3600, 32}})}}, start_time);
+
+    // libocpp computes the composite schedule relative to the current time
+    EXPECT_TRUE(compiler.update({{1, schedule({{0, 16}, {3000, 32}})}}, later(600)).empty());
+    // the second period is active now
+    EXPECT_TRUE(compiler.update({{1, schedule({{0, 32}})}}, later(4000)).empty());
+    EXPECT_EQ(compiler.get_statistics().unchanged, 2);
+}
+
+TEST_F(ExternalLimitsCompilerTest, changed_connectors_are_returned) {
+    compiler.update({{1, schedule({{0, 16}, {3600, 32}})}, {2, schedule({{0, 16}, {3600, 32}})}}, start_time);
+
+    // connector 2 gets a new limit
+    auto result = compiler.update({{1, schedule({{0, 16}, {3000, 32}})}, {2, schedule({{0, 10}, {3000, 32}})}},
+                                  later(600));
+    ASSERT_EQ(result.size(), 1);
+    EXPECT_EQ(result.begin()->first, 2);
+    EXPECT_EQ(result.at(2).schedule_import.value().at(0).timestamp, later(600).to_rfc3339());
+
+    // a period moves into the published duration
+    result = compiler.update({{1, schedule({{0, 16}, {3000, 32}, {80000, 8}})}, {2, schedule({{0, 10}, {3000, 32}})}},
+                             later(600));
+    ASSERT_EQ(result.size(), 1);
+    EXPECT_EQ(result.begin()->first, 1);
+}
+
+TEST_F(ExternalLimitsCompilerTest, removed_schedule_is_returned) {
+    compiler.update({{1, schedule({{0, 16}})}}, start_time);
+
+    auto result = compiler.update({{1, schedule({})}}, later(60));
+    ASSERT_EQ(result.size(), 1);
+    EXPECT_TRUE(result.at(1).schedule_import.value().empty());
+
+    EXPECT_TRUE(compiler.update({{1, schedule({})}}, later(120)).empty());
+}
+
+TEST_F(ExternalLimitsCompilerTest, identical_schedules_are_compiled_once) {
+    std::map<int32_t, ocpp::v16::EnhancedChargingSchedule> schedules;
+    for (int32_t connector = 1; connector <= 40; connector++) {
+        schedules[connector] = schedule({{0, 16}, {3600, 32}});
+    }
+
+    const auto result = compiler.update(schedules, start_time);
+    ASSERT_EQ(result.size(), 40);
+    EXPECT_EQ(compiler.get_statistics().compiled, 1);
+    EXPECT_EQ(compiler.get_statistics().cached, 39);
+    EXPECT_EQ(result.at(40).schedule_import.value().at(1).timestamp, later(3600).to_rfc3339());
+}
+
+TEST_F(ExternalLimitsCompilerTest, reset_returns_all_connectors) {
+    compiler.update({{1, schedule({{0, 16}})}, {2, schedule({{0, 16}})}}, start_time);
+    compiler.reset();
+    EXPECT_EQ(compiler.update({{1, schedule({{0, 16}})}, {2, schedule({{0, 16}})}}, later(1)).size(), 2);
+}
+
+} // namespace module
@@ -1,79 +1,139 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright Pionix GmbH and Contributors to EVerest
 #include "PacketSniffer.hpp"
+#include "PcapngWriter.hpp"
+
+#include <sstream>
 
 #include <fmt/core.h>
 
 namespace module {
 
-const bool PROMISC_MODE = true;
-const int PACKET_BUFFER_TIMEOUT_MS = 1000;
-const int ALL_PACKETS_PROCESSED = -1;
-const int WAIT_FOR_MS = 10;
 const int BUFFERSIZE = 8192;
+const std::size_t RING_BLOCK_SIZE = 64 * 1024;
+const std::uint32_t RING_BLOCK_TIMEOUT_MS = 100;
+
+namespace {
+
+std::vector<std::string> split_devices(const std::string& devices) {
+    std::vector<std::string> result;
+    std::stringstream stream(devices);
+    std::string device;
+    while (std::getline(stream, device, ',')) {
+        const auto first = device.find_first_not_of(" \t");
+        const auto last = device.find_last_not_of(" \t");
+        if (first != std::string::npos) {
+            result.push_back(device.substr(first, last - first + 1));
+        }
+    }
+    return result;
+}
+
+} // namespace
 
 void PacketSniffer::init() {
     invoke_init(*p_main);
 
-    p_handle = pcap_open_live(config.device.c_str(), BUFFERSIZE, PROMISC_MODE, PACKET_BUFFER_TIMEOUT_MS, errbuf);
-    if (p_handle == nullptr) {
-        EVLOG_error << fmt::format("Could not open device {}. Sniffing disabled.", config.device);
+    const auto devices = split_devices(config.device);
+    if (devices.empty()) {
+        EVLOG_error << "No capture device configured. Sniffing disabled.";
         return;
     }
 
-    if (pcap_datalink(p_handle) != DLT_EN10MB) {
-        EVLOG_error << fmt::format("Device {} doesn't provide Ethernet headers - not supported. Sniffing disabled.",
-                                   config.device);
-        return;
-    }
+    for (std::size_t i = 0; i < r_evse_manager.size(); i++) {
+        auto& capture = *captures.emplace_back(std::make_unique<EvseCapture>());
+        capture.index = i;
+        capture.config.device = devices.at(std::min(i, devices.size() - 1));
+        capture.config.filter = config.capture_filter;
+        capture.config.promiscuous = config.promiscuous;
+        capture.config.snaplen = BUFFERSIZE;
+        capture.config.block_size = RING_BLOCK_SIZE;
+        capture.config.block_count =
+            std::max<std::size_t>(2, static_cast<std::size_t>(config.ring_buffer_size_kb) * 1024 / RING_BLOCK_SIZE);
+        capture.config.block_timeout_ms = RING_BLOCK_TIMEOUT_MS;
 
-    r_evse_manager->subscribe_session_event([this](types::evse_manager::SessionEvent session_event) {
-        if (session_event.event == types::evse_manager::SessionEventEnum::SessionStarted) {
-            if (!already_started) {
+        // check device and filter once, the ring is only set up while a session is captured
+        const auto error = capture.ring.open(capture.config);
+        capture.ring.close();
+        if (!error.empty()) {
+            EVLOG_error << fmt::format("{}. Sniffing disabled for EVSE {}.", error, i + 1);
+            continue;
+        }
 
-                capturing_stopped = false;
+        r_evse_manager[i]->subscribe_session_event([this, &capture](types::evse_manager::SessionEvent session_event) {
+            if (session_event.event == types::evse_manager::SessionEventEnum::SessionStarted) {
                 if (session_event.session_started && session_event.session_started->logging_path) {
-                    std::thread(&PacketSniffer::capture, this, session_event.session_started->logging_path.value(),
-                                session_event.uuid)
-                        .detach();
+                    start_capture(capture, session_event.session_started->logging_path.value());
                 }
-            } else {
-                EVLOG_warning << fmt::format("Capturing already started. Ignoring this SessionStarted event");
+            } else if (session_event.event == types::evse_manager::SessionEventEnum::SessionFinished) {
+                stop_capture(capture);
             }
-        } else if (session_event.event == types::evse_manager::SessionEventEnum::SessionFinished) {
-            capturing_stopped = true;
-            pcap_breakloop(p_handle);
-        }
-    });
+        });
+    }
 }
 
 void PacketSniffer::ready() {
     invoke_ready(*p_main);
 }
 
-void PacketSniffer::capture(const std::string& logpath, const std::string& session_id) {
-    already_started = true;
-    EVLOG_info << fmt::format("Start capturing");
-
-    const std::string fn = fmt::format("{}/ethernet-traffic.dump", logpath);
+void PacketSniffer::start_capture(EvseCapture& capture, const std::string& logpath) {
+    std::lock_guard lock(capture.mutex);
+    if (capture.running) {
+        EVLOG_warning << fmt::format("Capturing already started on EVSE {}. Ignoring this SessionStarted event",
+                                     capture.index + 1);
+        return;
+    }
 
-    if ((pdumpfile = pcap_dump_open(p_handle, fn.c_str())) == nullptr) {
-        EVLOG_error << fmt::format("Error opening savefile {} for writing: {}", fn, pcap_geterr(p_handle));
+    // opened here so that a SessionFinished event right after this one stops the capture
+    const auto error = capture.ring.open(capture.config);
+    if (!error.empty()) {
+        EVLOG_error << fmt::format("Could not start capturing on {}: {}", capture.config.device, error);
         return;
     }
 
-    while (!capturing_stopped) {
-        if (pcap_dispatch(p_handle, ALL_PACKETS_PROCESSED, &pcap_dump, (u_char*)pdumpfile) <= PCAP_ERROR) {
-            EVLOG_error << fmt::format("Error reading packets from interface: {}, error: {}", config.device,
-                                       pcap_geterr(p_handle));
-            break;
-        }
-        std::this_thread::sleep_for(std::chrono::milliseconds(WAIT_FOR_MS));
+    capture.running = true;
+    std::thread(&PacketSniffer::capture_session, this, std::ref(capture), logpath).detach();
+}
+
+void PacketSniffer::stop_capture(EvseCapture& capture) {
+    std::lock_guard lock(capture.mutex);
+    if (capture.running) {
+        capture.ring.stop();
+    }
+}
+
+void PacketSniffer::capture_session(EvseCapture& capture, const std::string& logpath) {
+    EVLOG_info << fmt::format("Start capturing on {}", capture.config.device);
+
+    PcapngWriter writer(fmt::format("{}/ethernet-traffic", logpath), capture.config.snaplen,
+                        static_cast<std::size_t>(config.max_file_size_kb) * 1024,
+                        static_cast<std::size_t>(config.max_files));
+
+    if (!writer.open()) {
+        EVLOG_error << fmt::format("Error opening savefile {}/ethernet-traffic for writing", logpath);
+    } else {
+        bool write_error{false};
+        capture.ring.run(
+            [&writer, &write_error, &logpath](std::uint64_t timestamp_ns, const std::uint8_t* data,
+                                              std::uint32_t caplen, std::uint32_t len) {
+                if (!writer.write(timestamp_ns, data, caplen, len) && !write_error) {
+                    EVLOG_error << fmt::format("Error writing savefile in {}", logpath);
+                    write_error = true;
+                }
+            },
+            [&capture](const std::string& error) {
+                EVLOG_warning << fmt::format("Capturing on {}: {}", capture.config.device, error);
+            });
+        writer.close();
     }
 
-    pcap_dump_close(pdumpfile);
-    EVLOG_info << fmt::format("Capturing stopped.");
-    already_started = false;
+    const auto statistics = capture.ring.get_statistics();
+    EVLOG_info << fmt::format("Capturing stopped. {} packets written, {} dropped", writer.get_packets(),
+                              statistics.drops);
+
+    std::lock_guard lock(capture.mutex);
+    capture.ring.close();
+    capture.running = false;
 }
 
 } // namespace module
@@ -18,7 +18,12 @@
 
 // ev@4bf81b14-a215-475c-a1d3-0a484ae48918:v1
 // insert your custom include headers here
-#include <pcap.h>
+#include "RingCapture.hpp"
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 // ev@4bf81b14-a215-475c-a1d3-0a484ae48918:v1
 
 namespace module {
@@ -26,17 +31,22 @@ namespace module {
 struct Conf {
     std::string device;
     std::string session_logging_path;
+    std::string capture_filter;
+    bool promiscuous;
+    int ring_buffer_size_kb;
+    int max_file_size_kb;
+    int max_files;
 };
 
 class PacketSniffer : public Everest::ModuleBase {
 public:
     PacketSniffer() = delete;
     PacketSniffer(const ModuleInfo& info, std::unique_ptr<emptyImplBase> p_main,
-                  std::unique_ptr<evse_managerIntf> r_evse_manager, Conf& config) :
+                  std::vector<std::unique_ptr<evse_managerIntf>> r_evse_manager, Conf& config) :
         ModuleBase(info), p_main(std::move(p_main)), r_evse_manager(std::move(r_evse_manager)), config(config){};
 
     const std::unique_ptr<emptyImplBase> p_main;
-    const std::unique_ptr<evse_managerIntf> r_evse_manager;
+    const std::vector<std::unique_ptr<evse_managerIntf>> r_evse_manager;
     const Conf& config;
 
     // ev@1fce4c5e-0ab8-41bb-90f7-14277703d2ac:v1
@@ -55,12 +65,19 @@ private:
 
     // ev@211cfdbe-f69a-4cd6-a4ec-f8aaa3d1b6c8:v1
     // insert your private definitions here
-    void capture(const std::string& logpath, const std::string& session_id);
-    pcap_t* p_handle{nullptr};
-    pcap_dumper_t* pdumpfile{nullptr};
-    char errbuf[PCAP_ERRBUF_SIZE];
-    std::atomic_bool capturing_stopped{false};
-    std::atomic_bool already_started{false};
+    // one capture per connected evse_manager, so that sessions on different EVSEs are captured concurrently
+    struct EvseCapture {
+        std::size_t index{0};
+        RingCapture::Config config;
+        RingCapture ring;
+        std::mutex mutex;
+        bool running{false};
+    };
+
+    void start_capture(EvseCapture& capture, const std::string& logpath);
+    void stop_capture(EvseCapture& capture);
+    void capture_session(EvseCapture& capture, const std::string& logpath);
+    std::vector<std::unique_ptr<EvseCapture>> captures;
     // ev@211cfdbe-f69a-4cd6-a4ec-f8aaa3d1b6c8:v1
 };
 
@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include "PcapngWriter.hpp"
+
+#include <cstring>
+
+#include <fmt/core.h>
+#include <unistd.h>
+
+namespace module {
+
+namespace {
+
+constexpr std::uint32_t BLOCK_SECTION_HEADER = 0x0A0D0D0A;
+constexpr std::uint32_t BLOCK_INTERFACE_DESCRIPTION = 0x00000001;
+constexpr std::uint32_t BLOCK_ENHANCED_PACKET = 0x00000006;
+constexpr std::uint32_t BYTE_ORDER_MAGIC = 0x1A2B3C4D;
+constexpr std::uint16_t LINKTYPE_ETHERNET = 1;
+constexpr std::uint16_t OPT_ENDOFOPT = 0;
+constexpr std::uint16_t OPT_IF_TSRESOL = 9;
+constexpr std::uint8_t TSRESOL_NANOSECONDS = 9;
+constexpr std::size_t FILE_BUFFER_SIZE = 64 * 1024;
+
+template <typename T> void append(std::vector<std::uint8_t>& buffer, T value) {
+    const auto offset = buffer.size();
+    buffer.resize(offset + sizeof(value));
+    std::memcpy(&buffer[offset], &value, sizeof(value));
+}
+
+void append_padded(std::vector<std::uint8_t>& buffer, const std::uint8_t* data, std::size_t len) {
+    buffer.insert(buffer.end(), data, data + len);
+    buffer.resize(buffer.size() + ((4 - (len % 4)) % 4), 0);
+}
+
+} // namespace
+
+PcapngWriter::PcapngWriter(const std::string& basename, std::uint32_t snaplen, std::size_t max_file_size,
+                           std::size_t max_files) :
+    basename(basename), snaplen(snaplen), max_file_size(max_file_size), max_files(max_files) {
+}
+
+PcapngWriter::~PcapngWriter() {
+    close();
+}
+
+std::string PcapngWriter::file_name(std::size_t index) const {
+    return fmt::format("{}-{:03}.pcapng", basename, index);
+}
+
+bool PcapngWriter::open() {
+    close();
+    file_index = 0;
+    packets = 0;
+    return open_file();
+}
+
+bool PcapngWriter::open_file() {
+    const auto fn = file_name(file_index);
+    file = std::fopen(fn.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    file_buffer.resize(FILE_BUFFER_SIZE);
+    std::setvbuf(file, file_buffer.data(), _IOFBF, file_buffer.size());
+    file_size = 0;
+
+    // drop the oldest file once more than max_files exist
+    if ((max_files > 0) && (file_index >= max_files)) {
+        unlink(file_name(file_index - max_files).c_str());
+    }
+
+    begin_block(BLOCK_SECTION_HEADER);
+    append<std::uint32_t>(block, BYTE_ORDER_MAGIC);
+    append<std::uint16_t>(block, 1); // major version
+    append<std::uint16_t>(block, 0); // minor version
+    append<std::int64_t>(block, -1); // section length not specified
+    append<std::uint32_t>(block, OPT_ENDOFOPT);
+    if (!end_block()) {
+        return false;
+    }
+
+    begin_block(BLOCK_INTERFACE_DESCRIPTION);
+    append<std::uint16_t>(block, LINKTYPE_ETHERNET);
+    append<std::uint16_t>(block, 0); // reserved
+    append<std::uint32_t>(block, snaplen);
+    append<std::uint16_t>(block, OPT_IF_TSRESOL);
+    append<std::uint16_t>(block, sizeof(TSRESOL_NANOSECONDS));
+    append_padded(block, &TSRESOL_NANOSECONDS, sizeof(TSRESOL_NANOSECONDS));
+    append<std::uint32_t>(block, OPT_ENDOFOPT);
+    return end_block();
+}
+
+void PcapngWriter::begin_block(std::uint32_t type) {
+    block.clear();
+    append(block, type);
+    append<std::uint32_t>(block, 0); // block total length, set by end_block()
+}
+
+bool PcapngWriter::end_block() {
+    const std::uint32_t total_length = block.size() + sizeof(total_length);
+    append(block, total_length);
+    std::memcpy(&block[sizeof(std::uint32_t)], &total_length, sizeof(total_length));
+
+    file_size += block.size();
+    return std::fwrite(block.data(), 1, block.size(), file) == block.size();
+}
+
+bool PcapngWriter::write(std::uint64_t timestamp_ns, const std::uint8_t* data, std::uint32_t caplen,
+                         std::uint32_t len) {
+    if (file == nullptr) {
+        return false;
+    }
+
+    if ((max_file_size > 0) && (file_size >= max_file_size)) {
+        std::fclose(file);
+        file = nullptr;
+        file_index++;
+        if (!open_file()) {
+            return false;
+        }
+    }
+
+    begin_block(BLOCK_ENHANCED_PACKET);
+    append<std::uint32_t>(block, 0); // interface id
+    append<std::uint32_t>(block, timestamp_ns >> 32);
+    append<std::uint32_t>(block, timestamp_ns & 0xFFFFFFFF);
+    append<std::uint32_t>(block, caplen);
+    append<std::uint32_t>(block, len);
+    append_padded(block, data, caplen);
+
+    packets++;
+    return end_block();
+}
+
+void PcapngWriter::close() {
+    if (file != nullptr) {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+} // namespace module
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef PACKET_SNIFFER_PCAPNG_WRITER_HPP
+#define PACKET_SNIFFER_PCAPNG_WRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace module {
+
+/*
+ * Writes Ethernet frames into pcapng files with nanosecond timestamps.
+ *
+ * The output is split into files of at most max_file_size bytes named
+ * <basename>-<n>.pcapng. Only the newest max_files files are kept, older ones
+ * are deleted while writing, so a capture never uses more than
+ * max_file_size * max_files bytes. A max_file_size of 0 disables rotation.
+ *
+ * Writes go through a large stdio buffer so that the storage sees few large
+ * writes instead of one write per frame.
+ */
+class PcapngWriter {
+public:
+    PcapngWriter(const std::string& basename, std::uint32_t snaplen, std::size_t max_file_size, std::size_t max_files);
+    ~PcapngWriter();
+
+    PcapngWriter(const PcapngWriter&) = delete;
+    PcapngWriter& operator=(const PcapngWriter&) = delete;
+
+    // opens the first file, returns false on error
+    bool open();
+
+    // appends one frame, returns false on write errors
+    bool write(std::uint64_t timestamp_ns, const std::uint8_t* data, std::uint32_t caplen, std::uint32_t len);
+
+    void close();
+
+    std::uint64_t get_packets() const {
+        return packets;
+    }
+
+private:
+    std::string file_name(std::size_t index) const;
+    bool open_file();
+    // a block is assembled in block and written by end_block()
+    void begin_block(std::uint32_t type);
+    bool end_block();
+
+    const std::string basename;
+    const std::uint32_t snaplen;
+    const std::size_t max_file_size;
+    const std::size_t max_files;
+
+    std::FILE* file{nullptr};
+    std::vector<char> file_buffer;
+    std::vector<std::uint8_t> block;
+    std::size_t file_index{0};
+    std::size_t file_size{0};
+    std::uint64_t packets{0};
+};
+
+} // namespace module
+
+#endif // PACKET_SNIFFER_PCAPNG_WRITER_HPP
@@ -0,0 +1,280 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include "RingCapture.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <optional>
+
+#include <fmt/core.h>
+
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_packet.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <pcap.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace module {
+
+namespace {
+
+// TPACKET_V3 frames have a variable size, the frame size is only checked against the block size
+constexpr unsigned int RING_FRAME_SIZE = 2048;
+
+std::string errno_message(const std::string& what) {
+    return fmt::format("{}: {}", what, std::strerror(errno));
+}
+
+std::string attach_filter(int fd, const std::string& filter, std::uint32_t snaplen) {
+    pcap_t* dead = pcap_open_dead(DLT_EN10MB, snaplen);
+    if (dead == nullptr) {
+        return "pcap_open_dead failed";
+    }
+
+    std::string error;
+    struct bpf_program program {};
+    if (pcap_compile(dead, &program, filter.c_str(), 1, PCAP_NETMASK_UNKNOWN) != 0) {
+        error = fmt::format("Invalid capture filter '{}': {}", filter, pcap_geterr(dead));
+    } else {
+        // struct bpf_insn and struct sock_filter have the same layout
+        struct sock_fprog fprog {};
+        fprog.len = program.bf_len;
+        fprog.filter = reinterpret_cast<struct sock_filter*>(program.bf_insns);
+        if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) != 0) {
+            error = errno_message("SO_ATTACH_FILTER");
+        }
+        pcap_freecode(&program);
+    }
+
+    pcap_close(dead);
+    return error;
+}
+
+} // namespace
+
+RingCapture::~RingCapture() {
+    close();
+}
+
+std::string RingCapture::open(const Config& config) {
+    close();
+
+    struct ifreq ifr {};
+    if (config.device.size() >= sizeof(ifr.ifr_name)) {
+        return fmt::format("Invalid device name {}", config.device);
+    }
+    std::strncpy(ifr.ifr_name, config.device.c_str(), sizeof(ifr.ifr_name) - 1);
+
+    // protocol 0: nothing is received before the filter and the ring are set up and the socket is bound
+    socket_fd = socket(AF_PACKET, SOCK_RAW | SOCK_CLOEXEC, 0);
+    if (socket_fd == -1) {
+        return errno_message("socket");
+    }
+
+    if (ioctl(socket_fd, SIOCGIFINDEX, &ifr) != 0) {
+        const auto error = errno_message(fmt::format("Could not open device {}", config.device));
+        close();
+        return error;
+    }
+    const int ifindex = ifr.ifr_ifindex;
+
+    if ((ioctl(socket_fd, SIOCGIFHWADDR, &ifr) != 0) || (ifr.ifr_hwaddr.sa_family != ARPHRD_ETHER)) {
+        close();
+        return fmt::format("Device {} doesn't provide Ethernet headers - not supported", config.device);
+    }
+
+    auto error = attach_filter(socket_fd, config.filter, config.snaplen);
+    if (!error.empty()) {
+        close();
+        return error;
+    }
+
+    int version = TPACKET_V3;
+    if (setsockopt(socket_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0) {
+        error = errno_message("PACKET_VERSION");
+        close();
+        return error;
+    }
+
+    // the block size has to be a multiple of the page size
+    const std::size_t page_size = sysconf(_SC_PAGESIZE);
+    block_size = ((std::max(config.block_size, page_size) + page_size - 1) / page_size) * page_size;
+    block_count = std::max<std::size_t>(config.block_count, 2);
+
+    struct tpacket_req3 req {};
+    req.tp_block_size = block_size;
+    req.tp_block_nr = block_count;
+    req.tp_frame_size = RING_FRAME_SIZE;
+    req.tp_frame_nr = (block_size / RING_FRAME_SIZE) * block_count;
+    req.tp_retire_blk_tov = config.block_timeout_ms;
+    block_timeout_ms = config.block_timeout_ms;
+    if (setsockopt(socket_fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) != 0) {
+        error = errno_message("PACKET_RX_RING");
+        close();
+        return error;
+    }
+
+    ring_size = block_size * block_count;
+    void* mapped = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, socket_fd, 0);
+    if (mapped == MAP_FAILED) {
+        error = errno_message("mmap");
+        ring_size = 0;
+        close();
+        return error;
+    }
+    ring = static_cast<std::uint8_t*>(mapped);
+
+    if (config.promiscuous) {
+        struct packet_mreq mreq {};
+        mreq.mr_ifindex = ifindex;
+        mreq.mr_type = PACKET_MR_PROMISC;
+        if (setsockopt(socket_fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0) {
+            error = errno_message("PACKET_ADD_MEMBERSHIP");
+            close();
+            return error;
+        }
+    }
+
+    struct sockaddr_ll addr {};
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_ALL);
+    addr.sll_ifindex = ifindex;
+    if (bind(socket_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+        error = errno_message("bind");
+        close();
+        return error;
+    }
+
+    stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (stop_fd == -1) {
+        error = errno_message("eventfd");
+        close();
+        return error;
+    }
+
+    stopping = false;
+    statistics = {};
+    return {};
+}
+
+void RingCapture::run(const PacketHandler& handler, const ErrorHandler& error_handler) {
+    if (ring == nullptr) {
+        return;
+    }
+
+    std::array<struct pollfd, 2> fds = {{{socket_fd, POLLIN, 0}, {stop_fd, POLLIN, 0}}};
+    std::size_t current{0};
+    // set once stopping, frames which have been captured until then are passed on until the deadline
+    std::optional<std::chrono::steady_clock::time_point> drain_deadline;
+
+    for (;;) {
+        if (stopping && !drain_deadline.has_value()) {
+            drain_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(2 * block_timeout_ms);
+        }
+        const auto remaining = drain_deadline.has_value() ? std::chrono::ceil<std::chrono::milliseconds>(
+                                                                *drain_deadline - std::chrono::steady_clock::now())
+                                                          : std::chrono::milliseconds(-1);
+        if (drain_deadline.has_value() && (remaining.count() <= 0)) {
+            break;
+        }
+
+        auto* block = reinterpret_cast<struct tpacket_block_desc*>(ring + current * block_size);
+
+        if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) != 0) {
+            auto* packet = reinterpret_cast<std::uint8_t*>(block) + block->hdr.bh1.offset_to_first_pkt;
+            for (std::uint32_t i = 0; i < block->hdr.bh1.num_pkts; i++) {
+                const auto* hdr = reinterpret_cast<const struct tpacket3_hdr*>(packet);
+                const std::uint64_t timestamp_ns = static_cast<std::uint64_t>(hdr->tp_sec) * 1000000000 + hdr->tp_nsec;
+                handler(timestamp_ns, packet + hdr->tp_mac, hdr->tp_snaplen, hdr->tp_len);
+                packet += hdr->tp_next_offset;
+            }
+
+            // hand the block back to the kernel
+            __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+            current = (current + 1) % block_count;
+            continue;
+        }
+
+        // the kernel still owns the block, wait until it has been filled or retired
+        nfds_t nfds = fds.size();
+        if (drain_deadline.has_value()) {
+            // the kernel only retires blocks that contain frames
+            if (__atomic_load_n(&block->hdr.bh1.num_pkts, __ATOMIC_RELAXED) == 0) {
+                break;
+            }
+            // the stop event stays signalled
+            nfds = 1;
+        }
+
+        if (poll(fds.data(), nfds, static_cast<int>(remaining.count())) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error_handler(errno_message("poll"));
+            break;
+        }
+
+        if ((fds[0].revents & POLLERR) != 0) {
+            // reading the error clears it, otherwise poll() would return at once from now on
+            int error{0};
+            socklen_t len = sizeof(error);
+            if ((getsockopt(socket_fd, SOL_SOCKET, SO_ERROR, &error, &len) != 0) || (error == 0)) {
+                error_handler("Capture socket failed");
+                break;
+            }
+            error_handler(std::strerror(error));
+        }
+        if ((fds[0].revents & (POLLHUP | POLLNVAL)) != 0) {
+            error_handler("Capture socket closed");
+            break;
+        }
+    }
+}
+
+void RingCapture::stop() {
+    stopping = true;
+    if (stop_fd != -1) {
+        const std::uint64_t value{1};
+        (void)write(stop_fd, &value, sizeof(value));
+    }
+}
+
+RingCapture::Statistics RingCapture::get_statistics() {
+    // the kernel resets its counters on every read
+    struct tpacket_stats_v3 stats {};
+    socklen_t len = sizeof(stats);
+    if ((socket_fd != -1) && (getsockopt(socket_fd, SOL_PACKET, PACKET_STATISTICS, &stats, &len) == 0)) {
+        statistics.packets += stats.tp_packets;
+        statistics.drops += stats.tp_drops;
+    }
+    return statistics;
+}
+
+void RingCapture::close() {
+    if (ring != nullptr) {
+        munmap(ring, ring_size);
+        ring = nullptr;
+        ring_size = 0;
+    }
+    if (socket_fd != -1) {
+        ::close(socket_fd);
+        socket_fd = -1;
+    }
+    if (stop_fd != -1) {
+        ::close(stop_fd);
+        stop_fd = -1;
+    }
+}
+
+} // namespace module
@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef PACKET_SNIFFER_RING_CAPTURE_HPP
+#define PACKET_SNIFFER_RING_CAPTURE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace module {
+
+/*
+ * Captures Ethernet frames from one interface through a TPACKET_V3 mmap ring.
+ *
+ * The capture filter is compiled with libpcap and attached to the packet
+ * socket, so frames that don't match are dropped in the kernel. The kernel
+ * fills blocks of the ring with the matching frames and hands a block over
+ * when it is full or the block timeout expired, so run() wakes up once per
+ * block instead of once per frame and reads the frames without copying.
+ */
+class RingCapture {
+public:
+    struct Config {
+        std::string device;
+        std::string filter;
+        bool promiscuous{false};
+        std::uint32_t snaplen{8192};
+        std::size_t block_size{64 * 1024};
+        std::size_t block_count{8};
+        std::uint32_t block_timeout_ms{100};
+    };
+
+    struct Statistics {
+        std::uint64_t packets{0}; // frames that passed the filter
+        std::uint64_t drops{0};   // frames dropped because the ring was full
+    };
+
+    // called for every captured frame, timestamp in nanoseconds since the epoch
+    using PacketHandler = std::function<void(std::uint64_t timestamp_ns, const std::uint8_t* data, std::uint32_t caplen,
+                                             std::uint32_t len)>;
+    // called for errors reported by the socket, e.g. when the interface went down
+    using ErrorHandler = std::function<void(const std::string& error)>;
+
+    RingCapture() = default;
+    ~RingCapture();
+
+    RingCapture(const RingCapture&) = delete;
+    RingCapture& operator=(const RingCapture&) = delete;
+
+    // opens the socket and maps the ring, returns an error message or an empty string
+    std::string open(const Config& config);
+
+    // passes frames to handler until stop() is called or the socket fails. Socket errors which can be cleared
+    // (e.g. the interface went down) are reported to error_handler and capturing continues. After stop() the frames
+    // of the partially filled block are passed on once the kernel retired the block.
+    void run(const PacketHandler& handler, const ErrorHandler& error_handler);
+
+    // makes run() return, can be called from any thread
+    void stop();
+
+    Statistics get_statistics();
+
+    void close();
+
+private:
+    int socket_fd{-1};
+    int stop_fd{-1};
+    std::atomic_bool stopping{false};
+    std::uint8_t* ring{nullptr};
+    std::size_t ring_size{0};
+    std::size_t block_size{0};
+    std::size_t block_count{0};
+    std::uint32_t block_timeout_ms{0};
+    Statistics statistics;
+};
+
+} // namespace module
+
+#endif // PACKET_SNIFFER_RING_CAPTURE_HPP
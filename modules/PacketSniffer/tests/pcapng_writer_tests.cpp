@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "PcapngWriter.hpp"
+
+namespace {
+
+using module::PcapngWriter;
+
+constexpr std::uint32_t c_snaplen = 8192;
+constexpr std::uint32_t c_section_header = 0x0A0D0D0A;
+constexpr std::uint32_t c_interface_description = 0x00000001;
+constexpr std::uint32_t c_enhanced_packet = 0x00000006;
+
+struct Block {
+    std::uint32_t type;
+    std::vector<std::uint8_t> body;
+};
+
+template <typename T> T read_at(const std::vector<std::uint8_t>& data, std::size_t offset) {
+    T value;
+    (void)data.at(offset + sizeof(value) - 1);
+    std::memcpy(&value, data.data() + offset, sizeof(value));
+    return value;
+}
+
+// splits a pcapng file into its blocks, checks the leading and trailing block lengths
+std::vector<Block> read_blocks(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    const std::vector<std::uint8_t> data{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+    std::vector<Block> blocks;
+    std::size_t offset{0};
+    while (offset < data.size()) {
+        const auto type = read_at<std::uint32_t>(data, offset);
+        const auto length = read_at<std::uint32_t>(data, offset + 4);
+        EXPECT_EQ(length % 4, 0);
+        EXPECT_LE(offset + length, data.size());
+        if ((length < 12) || (offset + length > data.size())) {
+            break;
+        }
+        EXPECT_EQ(read_at<std::uint32_t>(data, offset + length - 4), length);
+        blocks.push_back(
+            {type, std::vector<std::uint8_t>(data.begin() + offset + 8, data.begin() + offset + length - 4)});
+        offset += length;
+    }
+    return blocks;
+}
+
+std::vector<std::uint8_t> frame(std::size_t len, std::uint8_t value) {
+    return std::vector<std::uint8_t>(len, value);
+}
+
+class PcapngWriterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::string dir_template = (std::filesystem::temp_directory_path() / "pcapng_writer_XXXXXX").string();
+        ASSERT_NE(mkdtemp(dir_template.data()), nullptr);
+        dir = dir_template;
+        basename = (dir / "capture").string();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::filesystem::path file(std::size_t index) const {
+        return basename + "-00" + std::to_string(index) + ".pcapng";
+    }
+
+    std::filesystem::path dir;
+    std::string basename;
+};
+
+TEST_F(PcapngWriterTest, writes_header_and_frames) {
+    PcapngWriter writer(basename, c_snaplen, 0, 0);
+    ASSERT_TRUE(writer.open());
+
+    const auto first = frame(60, 0x11);
+    const auto second = frame(61, 0x22);
+    const std::uint64_t timestamp_ns = 1700000000123456789;
+    ASSERT_TRUE(writer.write(timestamp_ns, first.data(), first.size(), first.size()));
+    // truncated by the snaplen of the capture
+    ASSERT_TRUE(writer.write(timestamp_ns + 1, second.data(), second.size(), 1500));
+    EXPECT_EQ(writer.get_packets(), 2);
+    writer.close();
+
+    const auto blocks = read_blocks(file(0));
+    ASSERT_EQ(blocks.size(), 4);
+
+    EXPECT_EQ(blocks[0].type, c_section_header);
+    EXPECT_EQ(read_at<std::uint32_t>(blocks[0].body, 0), 0x1A2B3C4D);
+
+    EXPECT_EQ(blocks[1].type, c_interface_description);
+    EXPECT_EQ(read_at<std::uint16_t>(blocks[1].body, 0), 1); // Ethernet
+    EXPECT_EQ(read_at<std::uint32_t>(blocks[1].body, 4), c_snaplen);
+    EXPECT_EQ(read_at<std::uint16_t>(blocks[1].body, 8), 9); // if_tsresol
+    EXPECT_EQ(blocks[1].body.at(12), 9);                     // nanoseconds
+
+    EXPECT_EQ(blocks[2].type, c_enhanced_packet);
+    const auto timestamp = (static_cast<std::uint64_t>(read_at<std::uint32_t>(blocks[2].body, 4)) << 32) |
+                           read_at<std::uint32_t>(blocks[2].body, 8);
+    EXPECT_EQ(timestamp, timestamp_ns);
+    EXPECT_EQ(read_at<std::uint32_t>(blocks[2].body, 12), first.size());
+    EXPECT_EQ(read_at<std::uint32_t>(blocks[2].body, 16), first.size());
+    EXPECT_TRUE(std::equal(first.begin(), first.end(), blocks[2].body.begin() + 20));
+
+    // padded to 32 bits
+    EXPECT_EQ(blocks[3].type, c_enhanced_packet);
+    EXPECT_EQ(read_at<std::uint32_t>(blocks[3].body, 12), second.size());
+    EXPECT_EQ(read_at<std::uint32_t>(blocks[3].body, 16), 1500);
+    EXPECT_EQ(blocks[3].body.size(), 20 + 64);
+    EXPECT_TRUE(std::equal(second.begin(), second.end(), blocks[3].body.begin() + 20));
+}
+
+TEST_F(PcapngWriterTest, rotates_and_keeps_the_newest_files) {
+    constexpr std::size_t max_file_size = 1024;
+    PcapngWriter writer(basename, c_snaplen, max_file_size, 2);
+    ASSERT_TRUE(writer.open());
+
+    const auto data = frame(200, 0x33);
+    for (int i = 0; i < 20; i++) {
+        ASSERT_TRUE(writer.write(i, data.data(), data.size(), data.size()));
+    }
+    writer.close();
+
+    // 5 frames fit into a file before it exceeds the maximum size
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        files.push_back(entry.path());
+    }
+    std::sort(files.begin(), files.end());
+    ASSERT_EQ(files.size(), 2);
+    EXPECT_EQ(files[0], file(2));
+    EXPECT_EQ(files[1], file(3));
+
+    // every file is complete on its own and the frames continue across files
+    std::uint32_t next_timestamp = 10;
+    for (const auto& path : files) {
+        const auto blocks = read_blocks(path);
+        ASSERT_GE(blocks.size(), 3);
+        EXPECT_EQ(blocks[0].type, c_section_header);
+        EXPECT_EQ(blocks[1].type, c_interface_description);
+        for (std::size_t i = 2; i < blocks.size(); i++) {
+            EXPECT_EQ(blocks[i].type, c_enhanced_packet);
+            EXPECT_EQ(read_at<std::uint32_t>(blocks[i].body, 8), next_timestamp++);
+        }
+    }
+    EXPECT_EQ(next_timestamp, 20);
+}
+
+TEST_F(PcapngWriterTest, write_fails_when_not_open) {
+    PcapngWriter writer(basename, c_snaplen, 0, 0);
+    const auto data = frame(60, 0x44);
+    EXPECT_FALSE(writer.write(0, data.data(), data.size(), data.size()));
+
+    ASSERT_TRUE(writer.open());
+    writer.close();
+    EXPECT_FALSE(writer.write(0, data.data(), data.size(), data.size()));
+
+    // the directory does not exist
+    PcapngWriter missing((dir / "missing" / "capture").string(), c_snaplen, 0, 0);
+    EXPECT_FALSE(missing.open());
+}
+
+} // namespace
@@ -0,0 +1,396 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#include "KvsDatabase.hpp"
+
+#include <everest/logging.hpp>
+
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+namespace module {
+
+namespace {
+
+// wake up the flush thread early once this many keys are pending
+constexpr std::size_t max_pending_keys = 1000;
+
+class TypeNameVisitor {
+public:
+    std::string operator()(std::nullptr_t t) const {
+        return "nullptr_t";
+    }
+
+    std::string operator()(const Array& t) const {
+        return "Array";
+    }
+
+    std::string operator()(const Object& t) const {
+        return "Object";
+    }
+
+    std::string operator()(const bool& t) const {
+        return "bool";
+    }
+
+    std::string operator()(const double& t) const {
+        return "double";
+    }
+
+    std::string operator()(const int& t) const {
+        return "int";
+    }
+
+    std::string operator()(const std::string& t) const {
+        return "std::string";
+    }
+};
+
+class StringValueVisitor {
+public:
+    std::string operator()(std::nullptr_t t) const {
+        return "";
+    }
+
+    std::string operator()(const Array& t) const {
+        json a = t;
+        return a.dump();
+    }
+
+    std::string operator()(const Object& t) const {
+        json o = t;
+        return o.dump();
+    }
+
+    std::string operator()(bool t) const {
+        if (t) {
+            return "true";
+        }
+        return "false";
+    }
+
+    std::string operator()(double t) const {
+        // enough digits to read back the exact same value, so cached and stored values do not differ
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.17g", t);
+        return buffer;
+    }
+
+    std::string operator()(int t) const {
+        return std::to_string(t);
+    }
+
+    std::string operator()(const std::string& t) const {
+        return t;
+    }
+};
+
+// releases the parameters and the result of a cached statement when leaving the scope
+class StatementReset {
+public:
+    explicit StatementReset(sqlite3_stmt* statement) : statement(statement) {
+    }
+
+    ~StatementReset() {
+        sqlite3_reset(statement);
+        sqlite3_clear_bindings(statement);
+    }
+
+private:
+    sqlite3_stmt* statement;
+};
+
+json decode_json(sqlite3_stmt* statement, int column) {
+    if (sqlite3_column_type(statement, column) == SQLITE_BLOB) {
+        const auto data = static_cast<const std::uint8_t*>(sqlite3_column_blob(statement, column));
+        const auto size = sqlite3_column_bytes(statement, column);
+        return json::from_cbor(data, data + size);
+    }
+    const auto text = reinterpret_cast<const char*>(sqlite3_column_text(statement, column));
+    return json::parse(text, text + sqlite3_column_bytes(statement, column));
+}
+
+} // namespace
+
+KvsDatabase::KvsDatabase(const fs::path& db_path, const Options& options_) : options(options_) {
+    const fs::path database_directory = db_path.parent_path();
+    if (!database_directory.empty() && !fs::exists(database_directory)) {
+        fs::create_directories(database_directory);
+    }
+
+    sqlite3* handle = nullptr;
+    const int ret = sqlite3_open(db_path.c_str(), &handle);
+    this->db.reset(handle);
+    if (ret != SQLITE_OK) {
+        EVLOG_error << "Error opening PersistentStore database '" << db_path << "': " << sqlite3_errmsg(handle);
+        throw std::runtime_error("Could not open PersistentStore database at provided path.");
+    }
+
+    EVLOG_debug << "Using SQLite version " << sqlite3_libversion();
+
+    // WAL needs one fsync per commit instead of the two of the rollback journal; keeping synchronous=FULL makes
+    // every commit durable, so the write behind interval is the only window in which changes can be lost
+    for (const auto& sql : {"PRAGMA journal_mode=WAL;", "PRAGMA synchronous=FULL;",
+                            "CREATE TABLE IF NOT EXISTS KVS (KEY TEXT UNIQUE, VALUE TEXT, TYPE TEXT);"}) {
+        char* error = nullptr;
+        if (sqlite3_exec(this->db.get(), sql, nullptr, nullptr, &error) != SQLITE_OK) {
+            EVLOG_error << "Could not prepare PersistentStore database (" << sql << "): " << error;
+            sqlite3_free(error);
+            throw std::runtime_error("PersistentStore db access error");
+        }
+    }
+
+    this->insert_statement = prepare("INSERT OR REPLACE INTO KVS (KEY, VALUE, TYPE) VALUES (?1, ?2, ?3)");
+    this->select_statement = prepare("SELECT VALUE, TYPE FROM KVS WHERE KEY = ?1");
+    this->delete_statement = prepare("DELETE FROM KVS WHERE KEY = ?1");
+    this->begin_statement = prepare("BEGIN TRANSACTION");
+    this->commit_statement = prepare("COMMIT TRANSACTION");
+    this->rollback_statement = prepare("ROLLBACK TRANSACTION");
+
+    if (this->options.write_behind_interval.count() > 0) {
+        this->running = true;
+        this->thread = std::thread(&KvsDatabase::flush_thread, this);
+    }
+}
+
+KvsDatabase::~KvsDatabase() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->running = false;
+    }
+    this->cv.notify_one();
+    if (this->thread.joinable()) {
+        this->thread.join();
+    }
+
+    try {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        write_pending();
+    } catch (const std::exception& e) {
+        EVLOG_error << "Could not write pending changes to PersistentStore database: " << e.what();
+    }
+}
+
+KvsDatabase::Statement KvsDatabase::prepare(const std::string& sql) {
+    sqlite3_stmt* statement = nullptr;
+    if (sqlite3_prepare_v2(this->db.get(), sql.c_str(), sql.size(), &statement, nullptr) != SQLITE_OK) {
+        EVLOG_error << "Could not prepare statement '" << sql << "': " << sqlite3_errmsg(this->db.get());
+        throw std::runtime_error("PersistentStore db access error");
+    }
+    return Statement(statement);
+}
+
+void KvsDatabase::step_done(sqlite3_stmt* statement, const char* error_message) {
+    StatementReset reset(statement);
+    const int res = sqlite3_step(statement);
+    if (res != SQLITE_DONE) {
+        EVLOG_error << error_message << ": " << res << " " << sqlite3_errmsg(this->db.get());
+        throw std::runtime_error("PersistentStore db access error");
+    }
+}
+
+void KvsDatabase::store(const std::string& key, const KvsValue& value) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    set(key, value);
+}
+
+KvsValue KvsDatabase::load(const std::string& key) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto entry = get(key);
+    if (!entry.has_value()) {
+        // no key with that name exists in the database
+        return {};
+    }
+    return std::move(entry.value());
+}
+
+void KvsDatabase::remove(const std::string& key) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    set(key, std::nullopt);
+}
+
+bool KvsDatabase::exists(const std::string& key) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return get(key).has_value();
+}
+
+void KvsDatabase::flush() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    write_pending();
+}
+
+void KvsDatabase::write(const std::string& key, const Entry& entry) {
+    if (!entry.has_value()) {
+        sqlite3_bind_text(this->delete_statement.get(), 1, key.c_str(), key.size(), SQLITE_STATIC);
+        step_done(this->delete_statement.get(), "Could not delete from KVS table");
+        return;
+    }
+
+    const auto& value = entry.value();
+    const std::string type = std::visit(TypeNameVisitor(), value);
+
+    // keep the encoded value alive until the statement has been executed
+    std::string string_value;
+    std::vector<std::uint8_t> binary_value;
+
+    auto statement = this->insert_statement.get();
+    sqlite3_bind_text(statement, 1, key.c_str(), key.size(), SQLITE_STATIC);
+    if (this->options.binary_values && std::holds_alternative<Array>(value)) {
+        binary_value = json::to_cbor(json(std::get<Array>(value)));
+    } else if (this->options.binary_values && std::holds_alternative<Object>(value)) {
+        binary_value = json::to_cbor(json(std::get<Object>(value)));
+    } else {
+        string_value = std::visit(StringValueVisitor(), value);
+    }
+
+    if (!binary_value.empty()) {
+        sqlite3_bind_blob(statement, 2, binary_value.data(), binary_value.size(), SQLITE_STATIC);
+    } else {
+        sqlite3_bind_text(statement, 2, string_value.c_str(), string_value.size(), SQLITE_STATIC);
+    }
+    sqlite3_bind_text(statement, 3, type.c_str(), type.size(), SQLITE_STATIC);
+
+    step_done(statement, "Could not insert into KVS table");
+}
+
+void KvsDatabase::write_pending() {
+    if (this->pending.empty()) {
+        return;
+    }
+
+    step_done(this->begin_statement.get(), "Could not begin transaction");
+    try {
+        for (const auto& [key, entry] : this->pending) {
+            write(key, entry);
+        }
+        step_done(this->commit_statement.get(), "Could not commit transaction");
+    } catch (...) {
+        StatementReset reset(this->rollback_statement.get());
+        sqlite3_step(this->rollback_statement.get());
+        throw;
+    }
+
+    this->pending.clear();
+}
+
+KvsDatabase::Entry KvsDatabase::read(const std::string& key) {
+    auto statement = this->select_statement.get();
+    StatementReset reset(statement);
+    sqlite3_bind_text(statement, 1, key.c_str(), key.size(), SQLITE_STATIC);
+
+    const int res = sqlite3_step(statement);
+    if (res == SQLITE_DONE) {
+        return std::nullopt;
+    }
+    if (res != SQLITE_ROW) {
+        EVLOG_error << "Could not select from KVS table: " << res << " " << sqlite3_errmsg(this->db.get());
+        throw std::runtime_error("PersistentStore db access error");
+    }
+
+    KvsValue value;
+
+    const auto type_ptr = sqlite3_column_text(statement, 1);
+    if (sqlite3_column_type(statement, 0) != SQLITE_NULL && type_ptr != nullptr) {
+        const std::string type_str = reinterpret_cast<const char*>(type_ptr);
+        if (type_str == "Array") {
+            value = decode_json(statement, 0).get<Array>();
+        } else if (type_str == "Object") {
+            value = decode_json(statement, 0).get<Object>();
+        } else {
+            const std::string value_str = reinterpret_cast<const char*>(sqlite3_column_text(statement, 0));
+            if (type_str == "bool") {
+                value = (value_str == "true");
+            } else if (type_str == "double") {
+                value = std::stod(value_str);
+            } else if (type_str == "int") {
+                value = std::stoi(value_str);
+            } else if (type_str == "std::string") {
+                value = value_str;
+            }
+        }
+    }
+
+    return value;
+}
+
+KvsDatabase::Entry KvsDatabase::get(const std::string& key) {
+    const auto pending_entry = this->pending.find(key);
+    if (pending_entry != this->pending.end()) {
+        return pending_entry->second;
+    }
+    if (const auto cached = cache_get(key)) {
+        return *cached;
+    }
+
+    auto entry = read(key);
+    cache_put(key, entry);
+    return entry;
+}
+
+void KvsDatabase::set(const std::string& key, Entry entry) {
+    if (this->options.write_behind_interval.count() > 0) {
+        cache_put(key, entry);
+        this->pending.insert_or_assign(key, std::move(entry));
+        if (this->pending.size() >= max_pending_keys) {
+            this->cv.notify_one();
+        }
+        return;
+    }
+
+    write(key, entry);
+    cache_put(key, entry);
+}
+
+const KvsDatabase::Entry* KvsDatabase::cache_get(const std::string& key) {
+    const auto it = this->cache_index.find(key);
+    if (it == this->cache_index.end()) {
+        return nullptr;
+    }
+    this->cache.splice(this->cache.begin(), this->cache, it->second);
+    return &it->second->second;
+}
+
+void KvsDatabase::cache_put(const std::string& key, const Entry& entry) {
+    if (this->options.cache_size == 0) {
+        return;
+    }
+
+    const auto it = this->cache_index.find(key);
+    if (it != this->cache_index.end()) {
+        it->second->second = entry;
+        this->cache.splice(this->cache.begin(), this->cache, it->second);
+        return;
+    }
+
+    if (this->cache.size() >= this->options.cache_size) {
+        this->cache_index.erase(this->cache.back().first);
+        this->cache.pop_back();
+    }
+    this->cache.emplace_front(key, entry);
+    this->cache_index.emplace(key, this->cache.begin());
+}
+
+void KvsDatabase::flush_thread() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    bool failed = false;
+    while (this->running) {
+        // after a failed write only retry after a full interval
+        this->cv.wait_for(lock, this->options.write_behind_interval, [this, failed] {
+            return !this->running || (!failed && this->pending.size() >= max_pending_keys);
+        });
+        if (!this->running) {
+            // the destructor writes what is left
+            break;
+        }
+
+        try {
+            write_pending();
+            failed = false;
+        } catch (const std::exception& e) {
+            EVLOG_error << "Could not write pending changes to PersistentStore database, retrying: " << e.what();
+            failed = true;
+        }
+    }
+}
+
+} // namespace module
@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+#ifndef PERSISTENT_STORE_KVS_DATABASE_HPP
+#define PERSISTENT_STORE_KVS_DATABASE_HPP
+
+#include <utils/types.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+
+#include <sqlite3.h>
+
+namespace fs = std::filesystem;
+
+namespace module {
+
+using KvsValue = std::variant<std::nullptr_t, Array, Object, bool, double, int, std::string>;
+
+///
+/// \brief Key-value store backed by the KVS table of a SQLite database in WAL mode
+/// The database connection and the prepared statements are kept open for the lifetime of the object.
+/// With a write behind interval, stores and deletes are collected in memory and written in one transaction at most
+/// one interval later, so at most one interval of changes is lost on power loss. Decoded values of recently used
+/// keys are kept in a LRU cache. Array and Object values can be stored as CBOR instead of JSON text, values of both
+/// encodings are always readable.
+///
+class KvsDatabase {
+public:
+    struct Options {
+        /// 0 writes every change immediately
+        std::chrono::milliseconds write_behind_interval{0};
+        /// number of keys kept in the read cache, 0 disables the cache
+        std::size_t cache_size{0};
+        /// store Array and Object values as CBOR
+        bool binary_values{false};
+    };
+
+    explicit KvsDatabase(const fs::path& db_path, const Options& options_);
+    ~KvsDatabase();
+
+    KvsDatabase(const KvsDatabase&) = delete;
+    KvsDatabase& operator=(const KvsDatabase&) = delete;
+
+    void store(const std::string& key, const KvsValue& value);
+
+    /// \returns the stored value or nullptr if the key does not exist
+    KvsValue load(const std::string& key);
+
+    void remove(const std::string& key);
+    bool exists(const std::string& key);
+
+    ///
+    /// \brief writes all pending changes to the database
+    ///
+    void flush();
+
+private:
+    struct DatabaseDeleter {
+        void operator()(sqlite3* db) const {
+            sqlite3_close(db);
+        }
+    };
+
+    struct StatementDeleter {
+        void operator()(sqlite3_stmt* statement) const {
+            sqlite3_finalize(statement);
+        }
+    };
+
+    using Statement = std::unique_ptr<sqlite3_stmt, StatementDeleter>;
+
+    // std::nullopt marks a key that does not exist (anymore)
+    using Entry = std::optional<KvsValue>;
+
+    Statement prepare(const std::string& sql);
+    void step_done(sqlite3_stmt* statement, const char* error_message);
+
+    // all of these expect the mutex to be held
+    void write(const std::string& key, const Entry& entry);
+    void write_pending();
+    Entry read(const std::string& key);
+    Entry get(const std::string& key);
+    void set(const std::string& key, Entry entry);
+    const Entry* cache_get(const std::string& key);
+    void cache_put(const std::string& key, const Entry& entry);
+
+    void flush_thread();
+
+    const Options options;
+
+    std::unique_ptr<sqlite3, DatabaseDeleter> db;
+    Statement insert_statement;
+    Statement select_statement;
+    Statement delete_statement;
+    Statement begin_statement;
+    Statement commit_statement;
+    Statement rollback_statement;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool running{false};
+    std::thread thread;
+
+    // changes not yet written to the database
+    std::unordered_map<std::string, Entry> pending;
+
+    // most recently used key first
+    std::list<std::pair<std::string, Entry>> cache;
+    std::unordered_map<std::string, std::list<std::pair<std::string, Entry>>::iterator> cache_index;
+};
+
+} // namespace module
+
+#endif // PERSISTENT_STORE_KVS_DATABASE_HPP
@@ -21,6 +21,9 @@ namespace module {
 
 struct Conf {
     std::string sqlite_db_file_path;
+    int write_behind_interval_ms;
+    int cache_size;
+    bool binary_values;
 };
 
 class PersistentStore : public Everest::ModuleBase {
@@ -14,8 +14,9 @@
 
 // ev@75ac1216-19eb-4182-a85c-820f1fc2c091:v1
 // insert your custom include headers here
-#include <mutex>
-#include <sqlite3.h>
+#include <memory>
+
+#include "../KvsDatabase.hpp"
 // ev@75ac1216-19eb-4182-a85c-820f1fc2c091:v1
 
 namespace module {
@@ -56,8 +57,7 @@ private:
 
     // ev@3370e4dd-95f4-47a9-aaec-ea76f34a66c9:v1
     // insert your private definitions here
-    sqlite3* db;
-    std::mutex db_mutex;
+    std::unique_ptr<KvsDatabase> db;
     // ev@3370e4dd-95f4-47a9-aaec-ea76f34a66c9:v1
 };
 
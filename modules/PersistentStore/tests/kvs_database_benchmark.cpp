@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+// Measures store and load throughput of KvsDatabase with a load similar to the one of EvseManager and OCPP: a few
+// hundred keys holding small session objects that are written and read again and again.
+
+#include "../KvsDatabase.hpp"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+constexpr int c_keys = 200;
+constexpr int c_stores = 2000;
+constexpr int c_loads = 20000;
+
+Object create_session(int i) {
+    return json::object({{"session_id", fmt::format("{:08x}-session", i)},
+                         {"connector", i % 2 + 1},
+                         {"energy_Wh", 1234.5 * i},
+                         {"meter_values", json::array({i, i + 1, i + 2, i + 3})},
+                         {"authorized", true},
+                         {"id_tag", {{"id_token", "DEADBEEF"}, {"type", "ISO14443"}}}});
+}
+
+template <typename F> double ops_per_second(int ops, F&& f) {
+    const auto t = std::chrono::steady_clock::now();
+    f();
+    const std::chrono::duration<double> d = std::chrono::steady_clock::now() - t;
+    return ops / d.count();
+}
+
+void kvs_database_benchmark(const std::string& name, const module::KvsDatabase::Options& options) {
+    const fs::path db_path = fs::temp_directory_path() / "kvs_database_benchmark.db";
+    fs::remove(db_path);
+
+    double store = 0;
+    double load = 0;
+    {
+        module::KvsDatabase db(db_path, options);
+        store = ops_per_second(c_stores, [&db]() {
+            for (int i = 0; i < c_stores; i++) {
+                db.store(fmt::format("key_{}", i % c_keys), create_session(i));
+            }
+            db.flush();
+        });
+
+        load = ops_per_second(c_loads, [&db]() {
+            for (int i = 0; i < c_loads; i++) {
+                db.load(fmt::format("key_{}", i % c_keys));
+            }
+        });
+    }
+
+    std::cout << fmt::format("{:<36} store {:>9.0f}/s load {:>9.0f}/s\n", name, store, load);
+
+    fs::remove(db_path);
+    fs::remove(db_path.string() + "-wal");
+    fs::remove(db_path.string() + "-shm");
+}
+
+} // namespace
+
+int main() {
+    module::KvsDatabase::Options options;
+    kvs_database_benchmark("immediate, no cache, JSON", options);
+
+    options.binary_values = true;
+    kvs_database_benchmark("immediate, no cache, CBOR", options);
+
+    options.cache_size = 256;
+    kvs_database_benchmark("immediate, cache 256, CBOR", options);
+
+    options.write_behind_interval = std::chrono::milliseconds(100);
+    kvs_database_benchmark("write behind 100ms, cache 256, CBOR", options);
+
+    options.binary_values = false;
+    kvs_database_benchmark("write behind 100ms, cache 256, JSON", options);
+    return 0;
+}
@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright Pionix GmbH and Contributors to EVerest
+
+#include <catch2/catch_all.hpp>
+
+#include "../KvsDatabase.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+namespace {
+
+fs::path get_unique_db_path() {
+    static std::atomic<int> counter{0};
+    return fs::temp_directory_path() / ("kvs_database_test_" + std::to_string(::getpid()) + "_" +
+                                        std::to_string(counter++) + ".db");
+}
+
+class TestDatabasePath {
+public:
+    TestDatabasePath() : path(get_unique_db_path()) {
+    }
+
+    ~TestDatabasePath() {
+        fs::remove(path);
+        fs::remove(path.string() + "-wal");
+        fs::remove(path.string() + "-shm");
+    }
+
+    const fs::path path;
+};
+
+void store_legacy_row(const fs::path& path, const std::string& key, const std::string& value,
+                      const std::string& type) {
+    sqlite3* db = nullptr;
+    REQUIRE(sqlite3_open(path.c_str(), &db) == SQLITE_OK);
+    const std::string sql =
+        "INSERT OR REPLACE INTO KVS (KEY, VALUE, TYPE) VALUES ('" + key + "', '" + value + "', '" + type + "');";
+    REQUIRE(sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK);
+    sqlite3_close(db);
+}
+
+} // namespace
+
+SCENARIO("Check KvsDatabase class", "[!throws]") {
+    const auto write_behind = GENERATE(std::chrono::milliseconds(0), std::chrono::milliseconds(50));
+    const auto cache_size = GENERATE(std::size_t(0), std::size_t(2));
+    const auto binary_values = GENERATE(false, true);
+
+    GIVEN("A KvsDatabase object with write behind " + std::to_string(write_behind.count()) + "ms, cache size " +
+          std::to_string(cache_size) + ", binary values " + std::to_string(binary_values)) {
+        TestDatabasePath db_path;
+        module::KvsDatabase::Options options;
+        options.write_behind_interval = write_behind;
+        options.cache_size = cache_size;
+        options.binary_values = binary_values;
+        auto db = std::make_unique<module::KvsDatabase>(db_path.path, options);
+
+        const Array array = json::array({1, "two", 3.5, json::object({{"four", 4}})});
+        const Object object = json::object({{"a", 1}, {"b", json::array({true, false})}, {"c", "text"}});
+
+        WHEN("Loading a key that does not exist") {
+            THEN("It does not exist and the value is null") {
+                REQUIRE_FALSE(db->exists("missing"));
+                REQUIRE(std::holds_alternative<std::nullptr_t>(db->load("missing")));
+            }
+        }
+        WHEN("Storing values of all types") {
+            db->store("null", nullptr);
+            db->store("array", array);
+            db->store("object", object);
+            db->store("bool", true);
+            db->store("double", 0.1);
+            db->store("int", -42);
+            db->store("string", std::string("value"));
+
+            auto check_values = [&](module::KvsDatabase& d) {
+                REQUIRE(d.exists("null"));
+                REQUIRE(std::holds_alternative<std::nullptr_t>(d.load("null")));
+                REQUIRE(std::get<Array>(d.load("array")) == array);
+                REQUIRE(std::get<Object>(d.load("object")) == object);
+                REQUIRE(std::get<bool>(d.load("bool")) == true);
+                REQUIRE(std::get<double>(d.load("double")) == 0.1);
+                REQUIRE(std::get<int>(d.load("int")) == -42);
+                REQUIRE(std::get<std::string>(d.load("string")) == "value");
+            };
+
+            THEN("The same values are loaded") {
+                check_values(*db);
+            }
+            THEN("The same values are loaded after reopening the database") {
+                db.reset();
+                module::KvsDatabase reopened(db_path.path, options);
+                check_values(reopened);
+            }
+        }
+        WHEN("Overwriting and deleting a key") {
+            db->store("key", 1);
+            db->store("key", std::string("two"));
+            REQUIRE(std::get<std::string>(db->load("key")) == "two");
+            db->remove("key");
+            THEN("The key does not exist anymore") {
+                REQUIRE_FALSE(db->exists("key"));
+                db->flush();
+                REQUIRE_FALSE(db->exists("key"));
+                db.reset();
+                module::KvsDatabase reopened(db_path.path, options);
+                REQUIRE_FALSE(reopened.exists("key"));
+            }
+        }
+        WHEN("Storing more keys than fit into the cache") {
+            for (int i = 0; i < 10; i++) {
+                db->store("key_" + std::to_string(i), i);
+            }
+            THEN("All keys can be loaded") {
+                for (int i = 9; i >= 0; i--) {
+                    REQUIRE(std::get<int>(db->load("key_" + std::to_string(i))) == i);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Check KvsDatabase write behind", "[!throws]") {
+    GIVEN("A KvsDatabase object with a long write behind interval") {
+        TestDatabasePath db_path;
+        module::KvsDatabase::Options options;
+        options.write_behind_interval = std::chrono::hours(1);
+        module::KvsDatabase db(db_path.path, options);
+        module::KvsDatabase other(db_path.path, module::KvsDatabase::Options());
+
+        WHEN("Storing a value") {
+            db.store("key", 1);
+            THEN("It is only written to the database when flushed") {
+                REQUIRE(db.exists("key"));
+                REQUIRE_FALSE(other.exists("key"));
+                db.flush();
+                REQUIRE(std::get<int>(other.load("key")) == 1);
+            }
+        }
+    }
+    GIVEN("A KvsDatabase object with a short write behind interval") {
+        TestDatabasePath db_path;
+        module::KvsDatabase::Options options;
+        options.write_behind_interval = std::chrono::milliseconds(10);
+        module::KvsDatabase db(db_path.path, options);
+        module::KvsDatabase other(db_path.path, module::KvsDatabase::Options());
+
+        WHEN("Storing a value") {
+            db.store("key", 1);
+            THEN("It is written to the database after the interval") {
+                const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                while (!other.exists("key") && std::chrono::steady_clock::now() < deadline) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                }
+                REQUIRE(std::get<int>(other.load("key")) == 1);
+            }
+        }
+    }
+}
+
+SCENARIO("Check KvsDatabase with values written by older versions", "[!throws]") {
+    GIVEN("A database with JSON text values") {
+        TestDatabasePath db_path;
+        module::KvsDatabase::Options options;
+        options.binary_values = true;
+        module::KvsDatabase(db_path.path, options).flush();
+
+        store_legacy_row(db_path.path, "array", "[1,2,3]", "Array");
+        store_legacy_row(db_path.path, "object", "{\"a\":true}", "Object");
+        store_legacy_row(db_path.path, "double", "1.500000", "double");
+        store_legacy_row(db_path.path, "bool", "true", "bool");
+
+        WHEN("Loading the values with binary values enabled") {
+            module::KvsDatabase db(db_path.path, options);
+            THEN("The values are decoded") {
+                REQUIRE(std::get<Array>(db.load("array")) == json::array({1, 2, 3}));
+                REQUIRE(std::get<Object>(db.load("object")) == json::object({{"a", true}}));
+                REQUIRE(std::get<double>(db.load("double")) == 1.5);
+                REQUIRE(std::get<bool>(db.load("bool")) == true);
+            }
+        }
+    }
+}
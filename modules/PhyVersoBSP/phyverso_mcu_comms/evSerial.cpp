@@ -10,133 +10,36 @@
 #include <string>
 #include <thread>
 
-#include <fcntl.h>
-#include <unistd.h>
-
 #include <date/date.h>
 #include <date/tz.h>
 
 #include <everest/3rd_party/nanopb/pb_decode.h>
-#include <everest/3rd_party/nanopb/pb_encode.h>
 #include <everest/logging.hpp>
 
 #include "phyverso.pb.h"
 
 #include "bsl_gpio.h"
 
-evSerial::evSerial(evConfig& _verso_config) :
-    fd(0), baud(0), reset_done_flag(false), forced_reset(false), verso_config(_verso_config) {
-    cobs_decode_reset();
+evSerial::evSerial(evConfig& _verso_config, mcu_link::Reactor& _reactor) :
+    reactor(_reactor), reset_done_flag(false), forced_reset(false), verso_config(_verso_config) {
 }
 
 evSerial::~evSerial() {
-    if (fd) {
-        close(fd);
+    if (timeout_timer >= 0) {
+        reactor.remove_timer(timeout_timer);
     }
+    reactor.remove(link);
 }
 
 bool evSerial::open_device(const char* device, int _baud) {
-
-    fd = open(device, O_RDWR | O_NOCTTY | O_SYNC);
-    if (fd < 0) {
+    if (not link.open(device, _baud)) {
         printf("Serial: error %d opening %s: %s\n", errno, device, strerror(errno));
         return false;
-    } // else printf ("Serial: opened %s as %i\n", device, fd);
-    cobs_decode_reset();
-
-    switch (_baud) {
-    case 9600:
-        baud = B9600;
-        break;
-    case 19200:
-        baud = B19200;
-        break;
-    case 38400:
-        baud = B38400;
-        break;
-    case 57600:
-        baud = B57600;
-        break;
-    case 115200:
-        baud = B115200;
-        break;
-    case 230400:
-        baud = B230400;
-        break;
-    default:
-        baud = 0;
-        return false;
-    }
-
-    return set_serial_attributes();
-}
-
-bool evSerial::set_serial_attributes() {
-    struct termios tty;
-    if (tcgetattr(fd, &tty) != 0) {
-        printf("Serial: error %d from tcgetattr\n", errno);
-        return false;
-    }
-
-    cfsetospeed(&tty, baud);
-    cfsetispeed(&tty, baud);
-
-    tty.c_cflag = (tty.c_cflag & ~CSIZE) | CS8; // 8-bit chars
-    // disable IGNBRK for mismatched speed tests; otherwise receive break
-    // as \000 chars
-    tty.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON | IXOFF | IXANY);
-    tty.c_lflag = 0;     // no signaling chars, no echo,
-                         // no canonical processing
-    tty.c_oflag = 0;     // no remapping, no delays
-    tty.c_cc[VMIN] = 0;  // read blocks
-    tty.c_cc[VTIME] = 5; // 0.5 seconds read timeout
-
-    tty.c_cflag |= (CLOCAL | CREAD);   // ignore modem controls,
-                                       // enable reading
-    tty.c_cflag &= ~(PARENB | PARODD); // shut off parity
-    tty.c_cflag &= ~CSTOPB;
-    tty.c_cflag &= ~CRTSCTS;
-
-    if (tcsetattr(fd, TCSANOW, &tty) != 0) {
-        printf("Serial: error %d from tcsetattr\n", errno);
-        return false;
     }
     return true;
 }
 
-void evSerial::cobs_decode_reset() {
-    code = 0xff;
-    block = 0;
-    decode = msg;
-}
-
-uint32_t evSerial::crc32(uint8_t* buf, int len) {
-    int i, j;
-    uint32_t b, crc, msk;
-
-    i = 0;
-    crc = 0xFFFFFFFF;
-    while (i < len) {
-        b = buf[i];
-        crc = crc ^ b;
-        for (j = 7; j >= 0; j--) {
-            msk = -(crc & 1);
-            crc = (crc >> 1) ^ (0xEDB88320 & msk);
-        }
-        i = i + 1;
-    }
-    return crc;
-}
-
-void evSerial::handle_packet(uint8_t* buf, int len) {
-
-    if (crc32(buf, len)) {
-        printf("CRC mismatch\n");
-        return;
-    }
-
-    len -= 4;
-
+void evSerial::handle_packet(const uint8_t* buf, size_t len) {
     if (handle_McuToEverest_packet(buf, len))
         return;
     else if (handle_OpaqueData_packet(buf, len))
@@ -145,7 +48,7 @@ void evSerial::handle_packet(uint8_t* buf, int len) {
         printf("Cannot handle a packet");
 }
 
-bool evSerial::handle_McuToEverest_packet(uint8_t* buf, int len) {
+bool evSerial::handle_McuToEverest_packet(const uint8_t* buf, size_t len) {
     McuToEverest msg_in;
     pb_istream_t istream = pb_istream_from_buffer(buf, len);
 
@@ -200,7 +103,7 @@ bool evSerial::handle_McuToEverest_packet(uint8_t* buf, int len) {
     return true;
 }
 
-bool evSerial::handle_OpaqueData_packet(uint8_t* buf, int len) {
+bool evSerial::handle_OpaqueData_packet(const uint8_t* buf, size_t len) {
     OpaqueData data = OpaqueData_init_default;
     pb_istream_t istream = pb_istream_from_buffer(buf, len);
     if (!pb_decode(&istream, OpaqueData_fields, &data))
@@ -244,133 +147,26 @@ bool evSerial::handle_OpaqueData_packet(uint8_t* buf, int len) {
     return true;
 }
 
-void evSerial::cobs_decode(uint8_t* buf, int len) {
-    for (int i = 0; i < len; i++)
-        cobs_decode_byte(buf[i]);
-}
-
-void evSerial::cobs_decode_byte(uint8_t byte) {
-    // check max length
-    if ((decode - msg == 2048 - 1) && byte != 0x00) {
-        printf("cobsDecode: Buffer overflow\n");
-        cobs_decode_reset();
-    }
-
-    if (block) {
-        // we're currently decoding and should not get a 0
-        if (byte == 0x00) {
-            // probably found some garbage -> reset
-            printf("cobsDecode: Garbage detected\n");
-            cobs_decode_reset();
-            return;
-        }
-        *decode++ = byte;
-    } else {
-        if (code != 0xff) {
-            *decode++ = 0;
-        }
-        block = code = byte;
-        if (code == 0x00) {
-            // we're finished, reset everything and commit
-            if (decode == msg) {
-                // we received nothing, just a 0x00
-                printf("cobsDecode: Received nothing\n");
-            } else {
-                // set back decode with one, as it gets post-incremented
-                handle_packet(msg, decode - 1 - msg);
-            }
-            cobs_decode_reset();
-            return; // need to return here, because of block--
-        }
-    }
-    block--;
-}
-
 void evSerial::run() {
-    read_thread_handle = std::thread(&evSerial::read_thread, this);
-    timeout_detection_thread_handle = std::thread(&evSerial::timeout_detection_thread, this);
-}
-
-void evSerial::timeout_detection_thread() {
-    while (true) {
-        sleep(1);
-        if (timeout_detection_thread_handle.shouldExit())
-            break;
+    link.set_frame_handler([this](const uint8_t* payload, size_t len) { handle_packet(payload, len); });
+    link.set_error_handler([](mcu_link::SerialLink::Error error) {
+        if (error == mcu_link::SerialLink::Error::Crc) {
+            printf("CRC mismatch\n");
+        } else if (error == mcu_link::SerialLink::Error::Io) {
+            printf("Serial: read error %d: %s\n", errno, strerror(errno));
+        }
+    });
+    reactor.add(link);
+    timeout_timer = reactor.add_timer(std::chrono::seconds(1), [this]() {
         if (serial_timed_out())
             signal_connection_timeout();
         // send keep alive
         keep_alive();
-    }
-}
-
-void evSerial::read_thread() {
-    uint8_t buf[2048];
-    int n;
-
-    cobs_decode_reset();
-    while (true) {
-        if (read_thread_handle.shouldExit())
-            break;
-        if (fd > 0) {
-            n = read(fd, buf, sizeof buf);
-            cobs_decode(buf, n);
-        }
-    }
+    });
 }
 
 bool evSerial::link_write(EverestToMcu* m) {
-    if (fd <= 0) {
-        return false;
-    }
-
-    uint8_t tx_packet_buf[1024];
-    uint8_t encode_buf[1500];
-    pb_ostream_t ostream = pb_ostream_from_buffer(tx_packet_buf, sizeof(tx_packet_buf) - 4);
-    bool status = pb_encode(&ostream, EverestToMcu_fields, m);
-
-    if (!status) {
-        // couldn't encode
-        return false;
-    }
-
-    size_t tx_payload_len = ostream.bytes_written;
-
-    // add crc32 (CRC-32/JAMCRC)
-    uint32_t crc = crc32(tx_packet_buf, tx_payload_len);
-
-    for (int byte_pos = 0; byte_pos < 4; ++byte_pos) {
-        tx_packet_buf[tx_payload_len] = (uint8_t)crc & 0xFF;
-        crc = crc >> 8;
-        tx_payload_len++;
-    }
-
-    size_t tx_encode_len = cobs_encode(tx_packet_buf, tx_payload_len, encode_buf);
-    write(fd, encode_buf, tx_encode_len);
-    return true;
-}
-
-size_t evSerial::cobs_encode(const void* data, size_t length, uint8_t* buffer) {
-    uint8_t* encode = buffer;  // Encoded byte pointer
-    uint8_t* codep = encode++; // Output code pointer
-    uint8_t code = 1;          // Code value
-
-    for (const uint8_t* byte = (const uint8_t*)data; length--; ++byte) {
-        if (*byte) // Byte not zero, write it
-            *encode++ = *byte, ++code;
-
-        if (!*byte || code == 0xff) // Input is zero or block completed, restart
-        {
-            *codep = code, code = 1, codep = encode;
-            if (!*byte || length)
-                ++encode;
-        }
-    }
-    *codep = code; // Write final code value
-
-    // add final 0
-    *encode++ = 0x00;
-
-    return encode - buffer;
+    return link.write(EverestToMcu_fields, m);
 }
 
 bool evSerial::serial_timed_out() {
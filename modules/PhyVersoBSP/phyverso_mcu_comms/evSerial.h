@@ -10,13 +10,13 @@
 #include <chrono>
 #include <date/date.h>
 #include <date/tz.h>
+#include <mcu_link/reactor.hpp>
+#include <mcu_link/serial_link.hpp>
 #include <sigslot/signal.hpp>
 #include <stdexcept>
 #include <stdint.h>
-#include <termios.h>
 #include <unordered_map>
 #include <utility>
-#include <utils/thread.hpp>
 #include <vector>
 
 /// @brief Struct to handle the OpaqueData chunks.
@@ -84,15 +84,15 @@ private:
 class evSerial {
 
 public:
-    evSerial(evConfig& _verso_config);
+    explicit evSerial(evConfig& _verso_config, mcu_link::Reactor& _reactor = mcu_link::Reactor::get_default());
     ~evSerial();
 
     bool open_device(const char* device, int baud);
     bool is_open() {
-        return fd > 0;
+        return link.is_open();
     };
 
-    void read_thread();
+    // starts reading, keep alive and connection timeout detection in the reactor thread
     void run();
 
     bool reset(const int reset_pin);
@@ -124,35 +124,20 @@ public:
     sigslot::signal<int, const std::vector<int32_t>&> signal_opaque_data;
 
 private:
-    // Serial interface
-    bool set_serial_attributes();
-    int fd;
-    int baud;
-
-    // COBS de-/encoder
-    void cobs_decode_reset();
-    void handle_packet(uint8_t* buf, int len);
-    bool handle_McuToEverest_packet(uint8_t* buf, int len);
-    bool handle_OpaqueData_packet(uint8_t* buf, int len);
-    void cobs_decode(uint8_t* buf, int len);
-    void cobs_decode_byte(uint8_t byte);
-    size_t cobs_encode(const void* data, size_t length, uint8_t* buffer);
-    uint8_t msg[2048];
-    uint8_t code;
-    uint8_t block;
-    uint8_t* decode;
-    uint32_t crc32(uint8_t* buf, int len);
-
-    // Read thread for serial port
-    Everest::Thread read_thread_handle;
-    Everest::Thread timeout_detection_thread_handle;
+    // Serial interface, read by the (shared) reactor thread
+    mcu_link::SerialLink link;
+    mcu_link::Reactor& reactor;
+    int timeout_timer{-1};
+
+    void handle_packet(const uint8_t* buf, size_t len);
+    bool handle_McuToEverest_packet(const uint8_t* buf, size_t len);
+    bool handle_OpaqueData_packet(const uint8_t* buf, size_t len);
 
     bool link_write(EverestToMcu* m);
     std::atomic_bool reset_done_flag;
     std::atomic_bool forced_reset;
 
     bool serial_timed_out();
-    void timeout_detection_thread();
     std::chrono::time_point<date::utc_clock> last_keep_alive_lo_timestamp;
     /// @brief Maps the connectors to OpaqueDataHandlers.
     std::unordered_map<unsigned, OpaqueDataHandler> opaque_handlers;
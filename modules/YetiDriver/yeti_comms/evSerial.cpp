@@ -9,139 +9,36 @@
 #include <string>
 #include <thread>
 
-#include <fcntl.h>
-#include <unistd.h>
-
 #include <date/date.h>
 #include <date/tz.h>
 
 #include <everest/3rd_party/nanopb/pb_decode.h>
-#include <everest/3rd_party/nanopb/pb_encode.h>
 
 #include <gpio.hpp>
 
 #include "yeti.pb.h"
 
-evSerial::evSerial() {
-    fd = 0;
-    baud = 0;
+evSerial::evSerial(mcu_link::Reactor& _reactor) : reactor(_reactor) {
     reset_done_flag = false;
     forced_reset = false;
-    cobsDecodeReset();
 }
 
 evSerial::~evSerial() {
-    if (fd)
-        close(fd);
+    if (timeout_timer >= 0) {
+        reactor.remove_timer(timeout_timer);
+    }
+    reactor.remove(link);
 }
 
 bool evSerial::openDevice(const char* device, int _baud) {
-
-    fd = open(device, O_RDWR | O_NOCTTY | O_SYNC);
-    if (fd < 0) {
+    if (not link.open(device, _baud)) {
         printf("Serial: error %d opening %s: %s\n", errno, device, strerror(errno));
         return false;
-    } // else printf ("Serial: opened %s as %i\n", device, fd);
-    cobsDecodeReset();
-
-    switch (_baud) {
-    case 9600:
-        baud = B9600;
-        break;
-    case 19200:
-        baud = B19200;
-        break;
-    case 38400:
-        baud = B38400;
-        break;
-    case 57600:
-        baud = B57600;
-        break;
-    case 115200:
-        baud = B115200;
-        break;
-    case 230400:
-        baud = B230400;
-        break;
-    default:
-        baud = 0;
-        return false;
     }
-
-    return setSerialAttributes();
-}
-
-bool evSerial::setSerialAttributes() {
-    struct termios tty;
-    if (tcgetattr(fd, &tty) != 0) {
-        printf("Serial: error %d from tcgetattr\n", errno);
-        return false;
-    }
-
-    cfsetospeed(&tty, baud);
-    cfsetispeed(&tty, baud);
-
-    tty.c_cflag = (tty.c_cflag & ~CSIZE) | CS8; // 8-bit chars
-    // disable IGNBRK for mismatched speed tests; otherwise receive break
-    // as \000 chars
-    tty.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON | IXOFF | IXANY);
-    tty.c_lflag = 0;     // no signaling chars, no echo,
-                         // no canonical processing
-    tty.c_oflag = 0;     // no remapping, no delays
-    tty.c_cc[VMIN] = 0;  // read blocks
-    tty.c_cc[VTIME] = 5; // 0.5 seconds read timeout
-
-    tty.c_cflag |= (CLOCAL | CREAD);   // ignore modem controls,
-                                       // enable reading
-    tty.c_cflag &= ~(PARENB | PARODD); // shut off parity
-    tty.c_cflag &= ~CSTOPB;
-    tty.c_cflag &= ~CRTSCTS;
-
-    if (tcsetattr(fd, TCSANOW, &tty) != 0) {
-        printf("Serial: error %d from tcsetattr\n", errno);
-        return false;
-    }
-    // printf ("Success setting tcsetattr\n");
     return true;
 }
 
-void evSerial::cobsDecodeReset() {
-    code = 0xff;
-    block = 0;
-    decode = msg;
-}
-
-uint32_t evSerial::crc32(uint8_t* buf, int len) {
-    int i, j;
-    uint32_t b, crc, msk;
-
-    i = 0;
-    crc = 0xFFFFFFFF;
-    while (i < len) {
-        b = buf[i];
-        crc = crc ^ b;
-        for (j = 7; j >= 0; j--) {
-            msk = -(crc & 1);
-            crc = (crc >> 1) ^ (0xEDB88320 & msk);
-        }
-        i = i + 1;
-    }
-    // printf("%X",crc);
-    return crc;
-}
-
-void evSerial::handlePacket(uint8_t* buf, int len) {
-    // printf ("packet received len %u\n", len);
-
-    // Check CRC32 (last 4 bytes)
-    //  uint32_t crc = calculateCrc(rx_packet_buf, rx_packet_len);
-    if (crc32(buf, len)) {
-        printf("CRC mismatch\n");
-        return;
-    }
-
-    len -= 4;
-
+void evSerial::handlePacket(const uint8_t* buf, size_t len) {
     McuToEverest msg_in;
     pb_istream_t istream = pb_istream_from_buffer(buf, len);
 
@@ -183,131 +80,24 @@ void evSerial::handlePacket(uint8_t* buf, int len) {
         }
 }
 
-void evSerial::cobsDecode(uint8_t* buf, int len) {
-    for (int i = 0; i < len; i++)
-        cobsDecodeByte(buf[i]);
-}
-
-void evSerial::cobsDecodeByte(uint8_t byte) {
-    // check max length
-    if ((decode - msg == 2048 - 1) && byte != 0x00) {
-        printf("cobsDecode: Buffer overflow\n");
-        cobsDecodeReset();
-    }
-
-    if (block) {
-        // we're currently decoding and should not get a 0
-        if (byte == 0x00) {
-            // probably found some garbage -> reset
-            printf("cobsDecode: Garbage detected\n");
-            cobsDecodeReset();
-            return;
-        }
-        *decode++ = byte;
-    } else {
-        if (code != 0xff) {
-            *decode++ = 0;
-        }
-        block = code = byte;
-        if (code == 0x00) {
-            // we're finished, reset everything and commit
-            if (decode == msg) {
-                // we received nothing, just a 0x00
-                printf("cobsDecode: Received nothing\n");
-            } else {
-                // set back decode with one, as it gets post-incremented
-                handlePacket(msg, decode - 1 - msg);
-            }
-            cobsDecodeReset();
-            return; // need to return here, because of block--
-        }
-    }
-    block--;
-}
-
 void evSerial::run() {
-    readThreadHandle = std::thread(&evSerial::readThread, this);
-    timeoutDetectionThreadHandle = std::thread(&evSerial::timeoutDetectionThread, this);
-}
-
-void evSerial::timeoutDetectionThread() {
-    while (true) {
-        sleep(1);
-        if (timeoutDetectionThreadHandle.shouldExit())
-            break;
+    link.set_frame_handler([this](const uint8_t* payload, size_t len) { handlePacket(payload, len); });
+    link.set_error_handler([](mcu_link::SerialLink::Error error) {
+        if (error == mcu_link::SerialLink::Error::Crc) {
+            printf("CRC mismatch\n");
+        } else if (error == mcu_link::SerialLink::Error::Io) {
+            printf("Serial: read error %d: %s\n", errno, strerror(errno));
+        }
+    });
+    reactor.add(link);
+    timeout_timer = reactor.add_timer(std::chrono::seconds(1), [this]() {
         if (serial_timed_out())
             signalConnectionTimeout();
-    }
-}
-
-void evSerial::readThread() {
-    uint8_t buf[2048];
-    int n;
-
-    cobsDecodeReset();
-    while (true) {
-        if (readThreadHandle.shouldExit())
-            break;
-        if (fd > 0) {
-            n = read(fd, buf, sizeof buf);
-            cobsDecode(buf, n);
-        }
-    }
+    });
 }
 
 bool evSerial::linkWrite(EverestToMcu* m) {
-    if (fd <= 0) {
-        return false;
-    }
-    uint8_t tx_packet_buf[1024];
-    uint8_t encode_buf[1500];
-    pb_ostream_t ostream = pb_ostream_from_buffer(tx_packet_buf, sizeof(tx_packet_buf) - 4);
-    bool status = pb_encode(&ostream, EverestToMcu_fields, m);
-
-    if (!status) {
-        // couldn't encode
-        return false;
-    }
-
-    size_t tx_payload_len = ostream.bytes_written;
-
-    // add crc32 (CRC-32/JAMCRC)
-    uint32_t crc = crc32(tx_packet_buf, tx_payload_len);
-
-    for (int byte_pos = 0; byte_pos < 4; ++byte_pos) {
-        tx_packet_buf[tx_payload_len] = (uint8_t)crc & 0xFF;
-        crc = crc >> 8;
-        tx_payload_len++;
-    }
-
-    size_t tx_encode_len = cobsEncode(tx_packet_buf, tx_payload_len, encode_buf);
-    // std::cout << "Write "<<tx_encode_len<<" bytes to serial port." << std::endl;
-    write(fd, encode_buf, tx_encode_len);
-    return true;
-}
-
-size_t evSerial::cobsEncode(const void* data, size_t length, uint8_t* buffer) {
-    uint8_t* encode = buffer;  // Encoded byte pointer
-    uint8_t* codep = encode++; // Output code pointer
-    uint8_t code = 1;          // Code value
-
-    for (const uint8_t* byte = (const uint8_t*)data; length--; ++byte) {
-        if (*byte) // Byte not zero, write it
-            *encode++ = *byte, ++code;
-
-        if (!*byte || code == 0xff) // Input is zero or block completed, restart
-        {
-            *codep = code, code = 1, codep = encode;
-            if (!*byte || length)
-                ++encode;
-        }
-    }
-    *codep = code; // Write final code value
-
-    // add final 0
-    *encode++ = 0x00;
-
-    return encode - buffer;
+    return link.write(EverestToMcu_fields, m);
 }
 
 bool evSerial::serial_timed_out() {
@@ -6,23 +6,23 @@
 #include "yeti.pb.h"
 #include <date/date.h>
 #include <date/tz.h>
+#include <mcu_link/reactor.hpp>
+#include <mcu_link/serial_link.hpp>
 #include <sigslot/signal.hpp>
 #include <stdint.h>
-#include <termios.h>
-#include <utils/thread.hpp>
 
 class evSerial {
 
 public:
-    evSerial();
+    explicit evSerial(mcu_link::Reactor& _reactor = mcu_link::Reactor::get_default());
     ~evSerial();
 
     bool openDevice(const char* device, int baud);
     bool is_open() {
-        return fd > 0;
+        return link.is_open();
     };
 
-    void readThread();
+    // starts reading and connection timeout detection in the reactor thread
     void run();
 
     bool reset(const std::string& reset_chip, const int reset_line);
@@ -46,33 +46,18 @@ public:
     sigslot::signal<> signalConnectionTimeout;
 
 private:
-    // Serial interface
-    bool setSerialAttributes();
-    int fd;
-    int baud;
+    // Serial interface, read by the (shared) reactor thread
+    mcu_link::SerialLink link;
+    mcu_link::Reactor& reactor;
+    int timeout_timer{-1};
 
-    // COBS de-/encoder
-    void cobsDecodeReset();
-    void handlePacket(uint8_t* buf, int len);
-    void cobsDecode(uint8_t* buf, int len);
-    void cobsDecodeByte(uint8_t byte);
-    size_t cobsEncode(const void* data, size_t length, uint8_t* buffer);
-    uint8_t msg[2048];
-    uint8_t code;
-    uint8_t block;
-    uint8_t* decode;
-    uint32_t crc32(uint8_t* buf, int len);
-
-    // Read thread for serial port
-    Everest::Thread readThreadHandle;
-    Everest::Thread timeoutDetectionThreadHandle;
+    void handlePacket(const uint8_t* buf, size_t len);
 
     bool linkWrite(EverestToMcu* m);
     volatile bool reset_done_flag;
     volatile bool forced_reset;
 
     bool serial_timed_out();
-    void timeoutDetectionThread();
     std::chrono::time_point<date::utc_clock> last_keep_alive_lo_timestamp;
 };
 